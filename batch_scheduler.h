@@ -0,0 +1,138 @@
+/*
+    批量文件的工作窃取调度器
+    文件按轮转方式预先分配到各工作线程的本地队列；线程从自己队列的队头取文件，
+    本地队列为空时从其他线程队列的队尾窃取。
+    处理过程中追加的任务（长视频拆出的分段）放进共享的追加队列，空闲的线程优先处理它们。
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <memory>
+
+class WorkStealingScheduler {
+public:
+    // items：按希望的处理顺序排列的条目（例如文件下标）
+    WorkStealingScheduler(const std::vector<size_t>& items, size_t workerCount)
+        : m_steals(0) {
+        if (workerCount < 1) workerCount = 1;
+        for (size_t w = 0; w < workerCount; ++w) {
+            m_queues.push_back(std::unique_ptr<LocalQueue>(new LocalQueue));
+        }
+        // 连续的条目分配给同一线程，相邻文件（同一分辨率组）倾向于在同一线程上处理
+        size_t per = (items.size() + workerCount - 1) / workerCount;
+        for (size_t i = 0; i < items.size(); ++i) {
+            m_queues[per ? i / per : 0]->items.push_back(items[i]);
+        }
+    }
+
+    size_t WorkerCount() const { return m_queues.size(); }
+
+    // 为 worker 取下一个条目，所有队列都为空时返回 false
+    bool Next(size_t worker, size_t& item) {
+        {
+            LocalQueue& own = *m_queues[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.items.empty()) {
+                item = own.items.front();
+                own.items.pop_front();
+                return true;
+            }
+        }
+        // 从其他线程的队尾窃取
+        for (size_t k = 1; k < m_queues.size(); ++k) {
+            LocalQueue& victim = *m_queues[(worker + k) % m_queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.items.empty()) {
+                item = victim.items.back();
+                victim.items.pop_back();
+                std::lock_guard<std::mutex> statLock(m_statMutex);
+                m_steals++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t StealCount() const {
+        std::lock_guard<std::mutex> lock(m_statMutex);
+        return m_steals;
+    }
+
+private:
+    struct LocalQueue {
+        std::mutex mutex;
+        std::deque<size_t> items;
+    };
+
+    std::vector<std::unique_ptr<LocalQueue>> m_queues;
+    mutable std::mutex m_statMutex;
+    size_t m_steals;
+};
+
+// ==========================================
+// 追加队列：工作线程在处理条目的过程中追加的任务。
+// 还有线程在处理条目（可能继续追加）时，取不到任务的线程等待而不是退出。
+// ==========================================
+template <class T>
+class AppendedTaskQueue {
+public:
+    AppendedTaskQueue() : m_producers(0) {}
+
+    // 开始 / 结束处理一个可能追加任务的条目
+    void BeginProducing() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_producers++;
+    }
+
+    void EndProducing() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_producers--;
+        }
+        m_cond.notify_all();
+    }
+
+    void Push(const T& task) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.push_back(task);
+        }
+        m_cond.notify_one();
+    }
+
+    bool TryPop(T& task) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return PopLocked(task);
+    }
+
+    // 等待任务；没有线程还会追加、或 stop 置位且队列为空时返回 false
+    template <class StopFlag>
+    bool WaitPop(T& task, const StopFlag& stop) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            if (PopLocked(task)) return true;
+            if (m_producers == 0 || stop) return false;
+            // stop 不经过这个条件变量，定时醒来检查
+            m_cond.wait_for(lock, std::chrono::milliseconds(50));
+        }
+    }
+
+private:
+    bool PopLocked(T& task) {
+        if (m_tasks.empty()) return false;
+        task = m_tasks.front();
+        m_tasks.pop_front();
+        return true;
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<T> m_tasks;
+    size_t m_producers;
+};
@@ -0,0 +1,322 @@
+/*
+    YUV -> BGRX 颜色转换内核
+    BT.601 有限范围，8 位定点：
+        C = Y - 16, D = U - 128, E = V - 128
+        R = clamp((298*C + 409*E + 128) >> 8)
+        G = clamp((298*C - 100*D - 208*E + 128) >> 8)
+        B = clamp((298*C + 516*D + 128) >> 8)
+    标量、SSE2、AVX2 三个版本使用完全相同的整数运算，输出逐位一致。
+    灰度输出（ConvertRoiToGray）直接取 Y 平面，只把有限范围扩展到 0-255，不读取色度平面。
+    只转换 ROI 范围内的像素。与平台无关，非 x86 平台只使用标量版本。
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#include "frame_source.h"
+#include "simd_config.h"
+
+// 行内核：把从偶数列开始的 width 个像素转换为 BGRX。
+// NV12：u 指向交错的 UV，v = u + 1，uvStep = 2；I420：u / v 分别指向两个平面，uvStep = 1。
+typedef void (*YuvRowKernel)(const uint8_t* y, const uint8_t* u, const uint8_t* v, int uvStep, int width, uint8_t* dst);
+
+inline uint8_t ClampToByte(int v) {
+    return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+inline void YuvToBgrxPixel(int y, int u, int v, uint8_t* dst) {
+    int c = y - 16, d = u - 128, e = v - 128;
+    dst[0] = ClampToByte((298 * c + 516 * d + 128) >> 8);
+    dst[1] = ClampToByte((298 * c - 100 * d - 208 * e + 128) >> 8);
+    dst[2] = ClampToByte((298 * c + 409 * e + 128) >> 8);
+    dst[3] = 0xFF;
+}
+
+inline void YuvRowToBgrx_Scalar(const uint8_t* y, const uint8_t* u, const uint8_t* v, int uvStep, int width, uint8_t* dst) {
+    for (int x = 0; x < width; x++) {
+        int ci = (x >> 1) * uvStep;
+        YuvToBgrxPixel(y[x], u[ci], v[ci], dst + x * 4);
+    }
+}
+
+#ifdef D2F_X86
+// 8 个像素：c/d/e 为 16 位有符号，返回打包好的 32 字节 BGRX
+inline void YuvToBgrx8_SSE2(__m128i c, __m128i d, __m128i e, uint8_t* dst) {
+    const __m128i kRB = _mm_set1_epi32((409 << 16) | 298);                  // (C, E) · (298, 409)
+    const __m128i kGCD = _mm_set1_epi32((int)(((uint32_t)(uint16_t)-100 << 16) | 298));
+    const __m128i kGE = _mm_set1_epi32((128 << 16) | (uint16_t)-208);       // (E, 1) · (-208, 128)
+    const __m128i kBB = _mm_set1_epi32((516 << 16) | 298);                  // (C, D) · (298, 516)
+    const __m128i kRound = _mm_set1_epi32(128);
+    const __m128i kOne = _mm_set1_epi16(1);
+
+    __m128i ceLo = _mm_unpacklo_epi16(c, e), ceHi = _mm_unpackhi_epi16(c, e);
+    __m128i cdLo = _mm_unpacklo_epi16(c, d), cdHi = _mm_unpackhi_epi16(c, d);
+    __m128i e1Lo = _mm_unpacklo_epi16(e, kOne), e1Hi = _mm_unpackhi_epi16(e, kOne);
+
+    __m128i r = _mm_packs_epi32(
+        _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(ceLo, kRB), kRound), 8),
+        _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(ceHi, kRB), kRound), 8));
+    __m128i g = _mm_packs_epi32(
+        _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(cdLo, kGCD), _mm_madd_epi16(e1Lo, kGE)), 8),
+        _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(cdHi, kGCD), _mm_madd_epi16(e1Hi, kGE)), 8));
+    __m128i b = _mm_packs_epi32(
+        _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(cdLo, kBB), kRound), 8),
+        _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(cdHi, kBB), kRound), 8));
+
+    // packus 的饱和即 clamp(0, 255)
+    __m128i zero = _mm_setzero_si128();
+    __m128i r8 = _mm_packus_epi16(r, zero);
+    __m128i g8 = _mm_packus_epi16(g, zero);
+    __m128i b8 = _mm_packus_epi16(b, zero);
+    __m128i bg = _mm_unpacklo_epi8(b8, g8);
+    __m128i ra = _mm_unpacklo_epi8(r8, _mm_set1_epi8((char)0xFF));
+    _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi16(bg, ra));
+    _mm_storeu_si128((__m128i*)(dst + 16), _mm_unpackhi_epi16(bg, ra));
+}
+
+// 交错的 [u0 v0 u1 v1 ...]（16 位）拆成逐像素复制的 U、V
+inline void SplitUV_SSE2(__m128i uv, __m128i* u, __m128i* v) {
+    __m128i uLow = _mm_and_si128(uv, _mm_set1_epi32(0xFFFF));
+    __m128i vLow = _mm_srli_epi32(uv, 16);
+    *u = _mm_or_si128(uLow, _mm_slli_epi32(uLow, 16));
+    *v = _mm_or_si128(vLow, _mm_slli_epi32(vLow, 16));
+}
+
+inline void YuvRowToBgrx_SSE2(const uint8_t* y, const uint8_t* u, const uint8_t* v, int uvStep, int width, uint8_t* dst) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i k16 = _mm_set1_epi16(16);
+    const __m128i k128 = _mm_set1_epi16(128);
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m128i y16 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(y + x)), zero);
+        __m128i uv8;
+        if (uvStep == 2) {
+            uv8 = _mm_loadl_epi64((const __m128i*)(u + x));
+        }
+        else {
+            int32_t u4, v4;
+            memcpy(&u4, u + x / 2, 4);
+            memcpy(&v4, v + x / 2, 4);
+            uv8 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(u4), _mm_cvtsi32_si128(v4));
+        }
+        __m128i uu, vv;
+        SplitUV_SSE2(_mm_unpacklo_epi8(uv8, zero), &uu, &vv);
+        YuvToBgrx8_SSE2(_mm_sub_epi16(y16, k16), _mm_sub_epi16(uu, k128), _mm_sub_epi16(vv, k128), dst + x * 4);
+    }
+    YuvRowToBgrx_Scalar(y + x, u + (x >> 1) * uvStep, v + (x >> 1) * uvStep, uvStep, width - x, dst + x * 4);
+}
+
+D2F_TARGET_AVX2 inline void YuvRowToBgrx_AVX2(const uint8_t* y, const uint8_t* u, const uint8_t* v, int uvStep, int width, uint8_t* dst) {
+    const __m256i k16 = _mm256_set1_epi16(16);
+    const __m256i k128 = _mm256_set1_epi16(128);
+    const __m256i kRB = _mm256_set1_epi32((409 << 16) | 298);
+    const __m256i kGCD = _mm256_set1_epi32((int)(((uint32_t)(uint16_t)-100 << 16) | 298));
+    const __m256i kGE = _mm256_set1_epi32((128 << 16) | (uint16_t)-208);
+    const __m256i kBB = _mm256_set1_epi32((516 << 16) | 298);
+    const __m256i kRound = _mm256_set1_epi32(128);
+    const __m256i kOne = _mm256_set1_epi16(1);
+    const __m256i kLow16 = _mm256_set1_epi32(0xFFFF);
+    const __m256i kAlpha = _mm256_set1_epi8((char)0xFF);
+    const __m256i zero = _mm256_setzero_si256();
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m256i c = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(y + x))), k16);
+        __m128i uv8;
+        if (uvStep == 2) {
+            uv8 = _mm_loadu_si128((const __m128i*)(u + x));
+        }
+        else {
+            uv8 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(u + x / 2)), _mm_loadl_epi64((const __m128i*)(v + x / 2)));
+        }
+        __m256i uv = _mm256_cvtepu8_epi16(uv8);
+        __m256i uLow = _mm256_and_si256(uv, kLow16);
+        __m256i vLow = _mm256_srli_epi32(uv, 16);
+        __m256i d = _mm256_sub_epi16(_mm256_or_si256(uLow, _mm256_slli_epi32(uLow, 16)), k128);
+        __m256i e = _mm256_sub_epi16(_mm256_or_si256(vLow, _mm256_slli_epi32(vLow, 16)), k128);
+
+        // unpack / packs 都按 128 位通道进行，两次操作的重排互相抵消，结果保持像素顺序
+        __m256i ceLo = _mm256_unpacklo_epi16(c, e), ceHi = _mm256_unpackhi_epi16(c, e);
+        __m256i cdLo = _mm256_unpacklo_epi16(c, d), cdHi = _mm256_unpackhi_epi16(c, d);
+        __m256i e1Lo = _mm256_unpacklo_epi16(e, kOne), e1Hi = _mm256_unpackhi_epi16(e, kOne);
+
+        __m256i r = _mm256_packs_epi32(
+            _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(ceLo, kRB), kRound), 8),
+            _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(ceHi, kRB), kRound), 8));
+        __m256i g = _mm256_packs_epi32(
+            _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(cdLo, kGCD), _mm256_madd_epi16(e1Lo, kGE)), 8),
+            _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(cdHi, kGCD), _mm256_madd_epi16(e1Hi, kGE)), 8));
+        __m256i b = _mm256_packs_epi32(
+            _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(cdLo, kBB), kRound), 8),
+            _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(cdHi, kBB), kRound), 8));
+
+        __m256i bg = _mm256_unpacklo_epi8(_mm256_packus_epi16(b, zero), _mm256_packus_epi16(g, zero));
+        __m256i ra = _mm256_unpacklo_epi8(_mm256_packus_epi16(r, zero), kAlpha);
+        __m256i lo = _mm256_unpacklo_epi16(bg, ra);   // 像素 0-3 | 8-11
+        __m256i hi = _mm256_unpackhi_epi16(bg, ra);   // 像素 4-7 | 12-15
+        _mm256_storeu_si256((__m256i*)(dst + x * 4), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i*)(dst + x * 4 + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    YuvRowToBgrx_SSE2(y + x, u + (x >> 1) * uvStep, v + (x >> 1) * uvStep, uvStep, width - x, dst + x * 4);
+}
+
+inline bool CpuHasAVX2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+// 内核级别：运行时按 CPU 能力选择，也可强制指定（用于逐位一致性校验与基准测试）
+enum ColorKernelLevel {
+    COLOR_KERNEL_AUTO = 0,
+    COLOR_KERNEL_SCALAR,
+    COLOR_KERNEL_SSE2,
+    COLOR_KERNEL_AVX2
+};
+
+inline YuvRowKernel GetYuvRowKernel(ColorKernelLevel level = COLOR_KERNEL_AUTO) {
+#ifdef D2F_X86
+    static const bool hasAVX2 = CpuHasAVX2();
+    if (level == COLOR_KERNEL_AUTO) level = hasAVX2 ? COLOR_KERNEL_AVX2 : COLOR_KERNEL_SSE2;
+    if (level == COLOR_KERNEL_AVX2 && hasAVX2) return YuvRowToBgrx_AVX2;
+    if (level == COLOR_KERNEL_AVX2 || level == COLOR_KERNEL_SSE2) return YuvRowToBgrx_SSE2;
+#else
+    (void)level;
+#endif
+    return YuvRowToBgrx_Scalar;
+}
+
+// NV12 / I420 帧第 sy 行从第 left 列开始的 width 个像素转换为 BGRX（逐行处理 ROI 的调用方使用）
+inline void YuvRoiRowToBgrx(const FrameView& src, int sy, int left, int width, uint8_t* out, YuvRowKernel kernel) {
+    int uvStep = (src.format == FRAME_NV12) ? 2 : 1;
+    int x = left;
+    const uint8_t* yRow = src.data + (ptrdiff_t)sy * src.stride;
+    const uint8_t* uRow = src.plane1 + (ptrdiff_t)(sy >> 1) * src.stride1;
+    const uint8_t* vRow = (src.format == FRAME_NV12) ? uRow + 1 : src.plane2 + (ptrdiff_t)(sy >> 1) * src.stride2;
+    // 奇数起始列：第一个像素单独转换，之后的内核调用都从偶数列开始
+    if (x & 1) {
+        int ci = (x >> 1) * uvStep;
+        YuvToBgrxPixel(yRow[x], uRow[ci], vRow[ci], out);
+        x++;
+        out += 4;
+        width--;
+    }
+    int ci = (x >> 1) * uvStep;
+    kernel(yRow + x, uRow + ci, vRow + ci, uvStep, width, out);
+}
+
+// 把源帧 ROI 内的像素转换（或复制）为 BGRX，写入 dst（行跨度 dstStride）。
+// ROI 会先被调整到画面范围内；返回 false 表示 ROI 为空或格式不支持。
+inline bool ConvertRoiToBgrx(const FrameView& src, RoiRect roi, uint8_t* dst, int dstStride,
+                             ColorKernelLevel level = COLOR_KERNEL_AUTO) {
+    if (!ClampRoi(roi, src.width, src.height)) return false;
+    int w = roi.right - roi.left;
+    int h = roi.bottom - roi.top;
+
+    if (src.format == FRAME_BGRX32) {
+        FrameView roiView;
+        if (!MakeRoiView(src, roi, &roiView)) return false;
+        CopyFrameView(roiView, dst, dstStride);
+        return true;
+    }
+    if (src.format != FRAME_NV12 && src.format != FRAME_I420) return false;
+
+    YuvRowKernel kernel = GetYuvRowKernel(level);
+    for (int r = 0; r < h; r++) YuvRoiRowToBgrx(src, roi.top + r, roi.left, w, dst + (ptrdiff_t)r * dstStride, kernel);
+    return true;
+}
+
+// ==========================================
+// 灰度：YUV 帧只读 Y 平面，gray = clamp((298*C + 128) >> 8)，即 U = V = 128 时 BGRX 结果的任一通道，
+// 与 BGRX 输出的亮度一致（色度项在 BT.601 亮度中相互抵消，只差饱和与舍入）。
+// RGB32 帧按 BT.601 系数求亮度，与灰度张量相同：gray = (29*B + 150*G + 77*R + 128) >> 8
+// ==========================================
+inline void YRowToGray_Scalar(const uint8_t* y, int width, uint8_t* dst) {
+    for (int x = 0; x < width; x++) dst[x] = ClampToByte((298 * (y[x] - 16) + 128) >> 8);
+}
+
+inline void BgrxRowToGray(const uint8_t* src, int width, uint8_t* dst) {
+    for (int x = 0; x < width; x++, src += 4) dst[x] = (uint8_t)((29 * src[0] + 150 * src[1] + 77 * src[2] + 128) >> 8);
+}
+
+#ifdef D2F_X86
+// 每次 16 个像素：(C, 1) · (298, 128) 用 madd 求 32 位结果，与标量版本逐位一致
+inline void YRowToGray_SSE2(const uint8_t* y, int width, uint8_t* dst) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i k16 = _mm_set1_epi16(16);
+    const __m128i kOne = _mm_set1_epi16(1);
+    const __m128i kScale = _mm_set1_epi32((128 << 16) | 298);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(y + x));
+        __m128i c[2] = { _mm_sub_epi16(_mm_unpacklo_epi8(v, zero), k16), _mm_sub_epi16(_mm_unpackhi_epi8(v, zero), k16) };
+        __m128i g[2];
+        for (int h = 0; h < 2; h++) {
+            __m128i lo = _mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(c[h], kOne), kScale), 8);
+            __m128i hi = _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(c[h], kOne), kScale), 8);
+            g[h] = _mm_packs_epi32(lo, hi);
+        }
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(g[0], g[1]));
+    }
+    YRowToGray_Scalar(y + x, width - x, dst + x);
+}
+#endif
+
+typedef void (*GrayRowKernel)(const uint8_t* y, int width, uint8_t* dst);
+
+inline GrayRowKernel GetGrayRowKernel(ColorKernelLevel level = COLOR_KERNEL_AUTO) {
+#ifdef D2F_X86
+    if (level != COLOR_KERNEL_SCALAR) return YRowToGray_SSE2;
+#else
+    (void)level;
+#endif
+    return YRowToGray_Scalar;
+}
+
+// 把源帧 ROI 内的像素转换为 8 位灰度，写入 dst（行跨度 dstStride）；ROI 与返回值同 ConvertRoiToBgrx()
+inline bool ConvertRoiToGray(const FrameView& src, RoiRect roi, uint8_t* dst, int dstStride,
+                             ColorKernelLevel level = COLOR_KERNEL_AUTO) {
+    if (!ClampRoi(roi, src.width, src.height)) return false;
+    int w = roi.right - roi.left;
+    int h = roi.bottom - roi.top;
+
+    if (src.format == FRAME_GRAY8) {
+        FrameView roiView;
+        if (!MakeRoiView(src, roi, &roiView)) return false;
+        CopyFrameView(roiView, dst, dstStride);
+        return true;
+    }
+    if (src.format == FRAME_BGRX32) {
+        for (int r = 0; r < h; r++) {
+            BgrxRowToGray(src.data + (ptrdiff_t)(roi.top + r) * src.stride + (ptrdiff_t)roi.left * 4, w, dst + (ptrdiff_t)r * dstStride);
+        }
+        return true;
+    }
+    if (src.format != FRAME_NV12 && src.format != FRAME_I420) return false;
+
+    GrayRowKernel kernel = GetGrayRowKernel(level);
+    for (int r = 0; r < h; r++) {
+        kernel(src.data + (ptrdiff_t)(roi.top + r) * src.stride + roi.left, w, dst + (ptrdiff_t)r * dstStride);
+    }
+    return true;
+}
+
+// 按输出缓冲的像素格式（FRAME_BGRX32 或 FRAME_GRAY8）转换 ROI
+inline bool ConvertRoi(const FrameView& src, RoiRect roi, int dstFormat, uint8_t* dst, int dstStride,
+                       ColorKernelLevel level = COLOR_KERNEL_AUTO) {
+    if (dstFormat == FRAME_GRAY8) return ConvertRoiToGray(src, roi, dst, dstStride, level);
+    return dstFormat == FRAME_BGRX32 && ConvertRoiToBgrx(src, roi, dst, dstStride, level);
+}
@@ -0,0 +1,469 @@
+/*
+    zlib 格式的 deflate 压缩与 CRC32 / Adler32 校验
+    LZ77（哈希链查找）+ 动态 Huffman。压缩级别的参数与 zlib 相同（goodLength / maxLazy / niceLength / maxChain）：
+    1-3 为贪心匹配，长匹配内部的位置不进哈希表；4-9 为惰性匹配，只有匹配短于 maxLazy 时才查看下一个位置，
+    已有 goodLength 的匹配时下一个位置只查四分之一的链，找到 niceLength 的匹配立即停止。
+    不可压缩的块自动改为存储块。级别 0 只输出存储块。
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <queue>
+#include <algorithm>
+
+inline uint32_t Crc32Update(uint32_t crc, const uint8_t* data, size_t size) {
+    static const struct Table {
+        uint32_t v[256];
+        Table() {
+            for (uint32_t n = 0; n < 256; n++) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : (c >> 1);
+                v[n] = c;
+            }
+        }
+    } table;
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) crc = table.v[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+inline uint32_t Adler32(const uint8_t* data, size_t size) {
+    uint32_t a = 1, b = 0;
+    while (size > 0) {
+        // 5552 是 b 不溢出 32 位的最大块长
+        size_t n = size < 5552 ? size : 5552;
+        size -= n;
+        for (size_t i = 0; i < n; i++) {
+            a += data[i];
+            b += a;
+        }
+        data += n;
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+struct DeflateLevelConfig {
+    int goodLength; // 惰性匹配：当前匹配达到这么长时，下一个位置只查四分之一的链
+    int maxLazy;    // 惰性匹配：当前匹配达到这么长时不再查看下一个位置；贪心匹配：更长的匹配内部不进哈希表
+    int niceLength; // 找到这么长的匹配就停止查找
+    int maxChain;   // 每个位置最多比较的候选数；8、9 级比 zlib 短（zlib 为 1024/4096），
+                    // 在平滑画面的滤波数据上 zlib 的 9 级要比 6 级慢十几倍，只换来约 10% 的体积
+    bool lazy;      // 惰性匹配：下一个位置的匹配更长时先输出字面量
+};
+
+static const DeflateLevelConfig kDeflateLevels[10] = {
+    { 0, 0, 0, 0, false },
+    { 4, 4, 8, 4, false }, { 4, 5, 16, 8, false }, { 4, 6, 32, 32, false },
+    { 4, 4, 16, 16, true }, { 8, 16, 32, 32, true }, { 8, 16, 128, 128, true },
+    { 8, 32, 128, 256, true }, { 16, 128, 258, 384, true }, { 32, 258, 258, 512, true }
+};
+
+// 距离超过这么远的 3 字节匹配不如字面量划算，丢弃（与 zlib 的 TOO_FAR 相同）
+static const int kDeflateTooFar = 4096;
+
+static const uint16_t kDeflateLengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t kDeflateLengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t kDeflateDistBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+    1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t kDeflateDistExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+// 码长码的码长在块头中的排列顺序
+static const uint8_t kDeflateCodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+class DeflateEncoder {
+public:
+    DeflateEncoder() : m_head(1 << kHashBits), m_prev(kWindowSize), m_out(NULL), m_bitBuf(0), m_bitCount(0) {
+        for (int i = 0; i < 29; i++) {
+            for (int len = kDeflateLengthBase[i]; len < (i == 28 ? 259 : kDeflateLengthBase[i + 1]); len++) m_lengthSymbol[len] = (uint8_t)i;
+        }
+        for (int i = 0; i < 30; i++) {
+            int end = (i == 29) ? kWindowSize + 1 : kDeflateDistBase[i + 1];
+            for (int d = kDeflateDistBase[i]; d < end; d++) m_distSymbol[d] = (uint8_t)i;
+        }
+    }
+
+    // 把 data 压缩为完整的 zlib 流（含头部与 Adler32），追加到 out
+    void Compress(const uint8_t* data, size_t size, int level, std::vector<uint8_t>& out) {
+        if (level < 0) level = 0;
+        if (level > 9) level = 9;
+        out.push_back(0x78);
+        out.push_back(level <= 1 ? 0x01 : (level <= 5 ? 0x5E : (level == 6 ? 0x9C : 0xDA)));
+        m_out = &out;
+        m_bitBuf = 0;
+        m_bitCount = 0;
+
+        if (level == 0 || size == 0) {
+            PutStoredBlocks(data, size, true);
+        }
+        else {
+            CompressLz77(data, size, kDeflateLevels[level]);
+        }
+        FlushBits();
+        PutU32(Adler32(data, size));
+        m_out = NULL;
+    }
+
+private:
+    enum { kWindowSize = 32768, kHashBits = 15, kMinMatch = 3, kMaxMatch = 258, kMaxTokens = 1 << 16 };
+
+    struct Token {
+        uint16_t litLen;    // 字面量，或匹配长度（dist > 0 时）
+        uint16_t dist;
+    };
+
+    static uint32_t Hash(const uint8_t* p) {
+        uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+        return (v * 2654435761u) >> (32 - kHashBits);
+    }
+
+    void Insert(const uint8_t* data, size_t pos) {
+        uint32_t h = Hash(data + pos);
+        m_prev[pos & (kWindowSize - 1)] = m_head[h];
+        m_head[h] = (int32_t)pos;
+    }
+
+    // 从 p 与 q 开始相同的字节数，最多 maxLen；每次比较 8 个字节
+    static size_t MatchLength(const uint8_t* p, const uint8_t* q, size_t maxLen) {
+        size_t len = 0;
+        while (len + 8 <= maxLen) {
+            uint64_t a, b;
+            memcpy(&a, p + len, 8);
+            memcpy(&b, q + len, 8);
+            if (a != b) {
+                // 小端：最低的不同字节就是第一个不同的字节
+                uint64_t diff = a ^ b;
+                while (!(diff & 0xFF)) {
+                    diff >>= 8;
+                    len++;
+                }
+                return len;
+            }
+            len += 8;
+        }
+        while (len < maxLen && p[len] == q[len]) len++;
+        return len;
+    }
+
+    static uint16_t Load16(const uint8_t* p) { uint16_t v; memcpy(&v, p, 2); return v; }
+
+    // 沿哈希链查找 pos 处最长的匹配，最多比较 maxChain 个候选
+    int FindMatch(const uint8_t* data, size_t size, size_t pos, int maxChain, int niceLength, int* matchDist) {
+        int best = kMinMatch - 1;
+        size_t maxLen = std::min<size_t>(kMaxMatch, size - pos);
+        if (maxLen < kMinMatch) return 0;
+        const uint8_t* b = data + pos;
+        int32_t cand = m_head[Hash(b)];
+        uint16_t scanStart = Load16(b), scanEnd = Load16(b + best - 1);
+        int chain = maxChain;
+        while (cand >= 0 && chain-- > 0) {
+            size_t dist = pos - (size_t)cand;
+            if (dist == 0 || dist > kWindowSize) break;
+            const uint8_t* a = data + cand;
+            // 先比较当前最长匹配末尾的两个字节与开头两个字节，大部分候选在这里被排除
+            if (Load16(a + best - 1) == scanEnd && Load16(a) == scanStart) {
+                size_t len = MatchLength(a, b, maxLen);
+                if ((int)len > best) {
+                    best = (int)len;
+                    scanEnd = Load16(b + best - 1);
+                    *matchDist = (int)dist;
+                    if (best >= niceLength || len == maxLen) break;
+                }
+            }
+            int32_t next = m_prev[cand & (kWindowSize - 1)];
+            if (next >= cand) break;    // 窗口外的旧链
+            cand = next;
+        }
+        if (best == kMinMatch && *matchDist > kDeflateTooFar) return 0;
+        return best >= kMinMatch ? best : 0;
+    }
+
+    void CompressLz77(const uint8_t* data, size_t size, const DeflateLevelConfig& cfg) {
+        std::fill(m_head.begin(), m_head.end(), -1);
+        m_tokens.clear();
+        size_t blockStart = 0;
+        size_t pos = 0;
+        int pendingLen = 0, pendingDist = 0;   // 惰性匹配时上一位置已找到的匹配
+        while (pos < size) {
+            int dist = 0;
+            int len = 0;
+            if (pos + kMinMatch <= size) {
+                len = pendingLen ? pendingLen : FindMatch(data, size, pos, cfg.maxChain, cfg.niceLength, &dist);
+                if (pendingLen) dist = pendingDist;
+                pendingLen = 0;
+                Insert(data, pos);
+            }
+            if (len && cfg.lazy && len < cfg.maxLazy && pos + 1 + kMinMatch <= size) {
+                int chain = len >= cfg.goodLength ? cfg.maxChain >> 2 : cfg.maxChain;
+                int nextDist = 0;
+                int nextLen = FindMatch(data, size, pos + 1, chain, cfg.niceLength, &nextDist);
+                if (nextLen > len) {
+                    m_tokens.push_back(Token{ data[pos], 0 });
+                    pos++;
+                    pendingLen = nextLen;
+                    pendingDist = nextDist;
+                    len = 0;
+                }
+            }
+            if (len) {
+                m_tokens.push_back(Token{ (uint16_t)len, (uint16_t)dist });
+                // 贪心匹配时长匹配内部的位置不进哈希表，省下插入的时间，代价是之后少一些候选
+                if (cfg.lazy || len <= cfg.maxLazy) {
+                    for (size_t i = pos + 1; i < pos + len && i + kMinMatch <= size; i++) Insert(data, i);
+                }
+                pos += len;
+            }
+            else if (!pendingLen) {
+                m_tokens.push_back(Token{ data[pos], 0 });
+                pos++;
+            }
+            if (m_tokens.size() >= kMaxTokens && !pendingLen) {
+                PutBlock(data + blockStart, pos - blockStart, pos == size);
+                blockStart = pos;
+            }
+        }
+        if (!m_tokens.empty() || blockStart == 0) PutBlock(data + blockStart, pos - blockStart, true);
+    }
+
+    // 由频率构造长度不超过 maxBits 的 Huffman 码长；超长时把频率减半重建
+    static void BuildCodeLengths(const uint32_t* freq, int count, int maxBits, uint8_t* lengths) {
+        std::vector<uint32_t> f(freq, freq + count);
+        for (;;) {
+            memset(lengths, 0, count);
+            typedef std::pair<uint64_t, int> Node;
+            std::priority_queue<Node, std::vector<Node>, std::greater<Node>> heap;
+            std::vector<int> parent(count * 2, -1);
+            int used = 0;
+            for (int i = 0; i < count; i++) {
+                if (f[i]) {
+                    heap.push(Node(f[i], i));
+                    used++;
+                }
+            }
+            if (used == 0) return;
+            if (used == 1) {
+                lengths[heap.top().second] = 1;
+                return;
+            }
+            int next = count;
+            while (heap.size() > 1) {
+                Node a = heap.top(); heap.pop();
+                Node b = heap.top(); heap.pop();
+                parent[a.second] = next;
+                parent[b.second] = next;
+                heap.push(Node(a.first + b.first, next));
+                next++;
+            }
+            int maxLen = 0;
+            for (int i = 0; i < count; i++) {
+                if (!f[i]) continue;
+                int depth = 0;
+                for (int n = i; parent[n] >= 0; n = parent[n]) depth++;
+                lengths[i] = (uint8_t)depth;
+                maxLen = std::max(maxLen, depth);
+            }
+            if (maxLen <= maxBits) return;
+            for (int i = 0; i < count; i++) {
+                if (f[i]) f[i] = (f[i] + 1) >> 1;
+            }
+        }
+    }
+
+    // 由码长生成规范 Huffman 码，并按 deflate 的位序（低位先出）反转
+    static void BuildCodes(const uint8_t* lengths, int count, uint16_t* codes) {
+        int blCount[16] = { 0 };
+        for (int i = 0; i < count; i++) blCount[lengths[i]]++;
+        blCount[0] = 0;
+        int nextCode[16] = { 0 };
+        int code = 0;
+        for (int bits = 1; bits < 16; bits++) {
+            code = (code + blCount[bits - 1]) << 1;
+            nextCode[bits] = code;
+        }
+        for (int i = 0; i < count; i++) {
+            int len = lengths[i];
+            if (!len) continue;
+            int c = nextCode[len]++;
+            int rev = 0;
+            for (int b = 0; b < len; b++) rev |= ((c >> b) & 1) << (len - 1 - b);
+            codes[i] = (uint16_t)rev;
+        }
+    }
+
+    void PutBlock(const uint8_t* raw, size_t rawSize, bool final) {
+        uint32_t litFreq[286] = { 0 }, distFreq[30] = { 0 };
+        for (size_t i = 0; i < m_tokens.size(); i++) {
+            const Token& t = m_tokens[i];
+            if (t.dist) {
+                litFreq[257 + m_lengthSymbol[t.litLen]]++;
+                distFreq[m_distSymbol[t.dist]]++;
+            }
+            else {
+                litFreq[t.litLen]++;
+            }
+        }
+        litFreq[256] = 1;
+        // 没有距离码时放入两个占位码，保证距离码表完整
+        bool anyDist = false;
+        for (int i = 0; i < 30; i++) anyDist = anyDist || distFreq[i];
+        if (!anyDist) distFreq[0] = distFreq[1] = 1;
+
+        uint8_t litLen[286], distLen[30];
+        BuildCodeLengths(litFreq, 286, 15, litLen);
+        BuildCodeLengths(distFreq, 30, 15, distLen);
+        int hlit = 286, hdist = 30;
+        while (hlit > 257 && !litLen[hlit - 1]) hlit--;
+        while (hdist > 1 && !distLen[hdist - 1]) hdist--;
+
+        // 码长序列的游程编码：16 重复前值，17 / 18 重复 0
+        uint8_t all[316];
+        memcpy(all, litLen, hlit);
+        memcpy(all + hlit, distLen, hdist);
+        int total = hlit + hdist;
+        std::vector<uint8_t> rle;       // 符号，紧跟附加位的值
+        uint32_t clFreq[19] = { 0 };
+        for (int i = 0; i < total;) {
+            int v = all[i];
+            int run = 1;
+            while (i + run < total && all[i + run] == v) run++;
+            i += run;
+            if (v == 0) {
+                while (run >= 11) {
+                    int n = std::min(run, 138);
+                    rle.push_back(18); rle.push_back((uint8_t)(n - 11)); clFreq[18]++;
+                    run -= n;
+                }
+                if (run >= 3) {
+                    rle.push_back(17); rle.push_back((uint8_t)(run - 3)); clFreq[17]++;
+                    run = 0;
+                }
+            }
+            else {
+                rle.push_back((uint8_t)v); rle.push_back(0); clFreq[v]++;
+                run--;
+                while (run >= 3) {
+                    int n = std::min(run, 6);
+                    rle.push_back(16); rle.push_back((uint8_t)(n - 3)); clFreq[16]++;
+                    run -= n;
+                }
+            }
+            while (run-- > 0) {
+                rle.push_back((uint8_t)v); rle.push_back(0); clFreq[v]++;
+            }
+        }
+        uint8_t clLen[19];
+        BuildCodeLengths(clFreq, 19, 7, clLen);
+        int hclen = 19;
+        while (hclen > 4 && !clLen[kDeflateCodeLengthOrder[hclen - 1]]) hclen--;
+
+        // 估算动态块大小，不如存储块时直接存储
+        uint64_t bits = 3 + 5 + 5 + 4 + 3 * hclen;
+        for (size_t i = 0; i < rle.size(); i += 2) {
+            int s = rle[i];
+            bits += clLen[s] + (s == 16 ? 2 : (s == 17 ? 3 : (s == 18 ? 7 : 0)));
+        }
+        for (int i = 0; i < 286; i++) bits += (uint64_t)litFreq[i] * litLen[i];
+        for (int i = 0; i < 29; i++) bits += (uint64_t)litFreq[257 + i] * kDeflateLengthExtra[i];
+        if (anyDist) {
+            for (int i = 0; i < 30; i++) bits += (uint64_t)distFreq[i] * (distLen[i] + kDeflateDistExtra[i]);
+        }
+        if (bits / 8 > rawSize + 5 * (rawSize / 65535 + 1)) {
+            PutStoredBlocks(raw, rawSize, final);
+            m_tokens.clear();
+            return;
+        }
+
+        uint16_t litCode[286] = { 0 }, distCode[30] = { 0 }, clCode[19] = { 0 };
+        BuildCodes(litLen, 286, litCode);
+        BuildCodes(distLen, 30, distCode);
+        BuildCodes(clLen, 19, clCode);
+
+        PutBits(final ? 1 : 0, 1);
+        PutBits(2, 2);
+        PutBits(hlit - 257, 5);
+        PutBits(hdist - 1, 5);
+        PutBits(hclen - 4, 4);
+        for (int i = 0; i < hclen; i++) PutBits(clLen[kDeflateCodeLengthOrder[i]], 3);
+        for (size_t i = 0; i < rle.size(); i += 2) {
+            int s = rle[i];
+            PutBits(clCode[s], clLen[s]);
+            if (s == 16) PutBits(rle[i + 1], 2);
+            else if (s == 17) PutBits(rle[i + 1], 3);
+            else if (s == 18) PutBits(rle[i + 1], 7);
+        }
+        for (size_t i = 0; i < m_tokens.size(); i++) {
+            const Token& t = m_tokens[i];
+            if (!t.dist) {
+                PutBits(litCode[t.litLen], litLen[t.litLen]);
+                continue;
+            }
+            int ls = m_lengthSymbol[t.litLen];
+            PutBits(litCode[257 + ls], litLen[257 + ls]);
+            if (kDeflateLengthExtra[ls]) PutBits(t.litLen - kDeflateLengthBase[ls], kDeflateLengthExtra[ls]);
+            int ds = m_distSymbol[t.dist];
+            PutBits(distCode[ds], distLen[ds]);
+            if (kDeflateDistExtra[ds]) PutBits(t.dist - kDeflateDistBase[ds], kDeflateDistExtra[ds]);
+        }
+        PutBits(litCode[256], litLen[256]);
+        m_tokens.clear();
+    }
+
+    void PutStoredBlocks(const uint8_t* data, size_t size, bool final) {
+        do {
+            size_t n = std::min<size_t>(size, 65535);
+            size -= n;
+            PutBits((final && size == 0) ? 1 : 0, 1);
+            PutBits(0, 2);
+            FlushBits();
+            m_out->push_back((uint8_t)n);
+            m_out->push_back((uint8_t)(n >> 8));
+            m_out->push_back((uint8_t)~n);
+            m_out->push_back((uint8_t)(~n >> 8));
+            m_out->insert(m_out->end(), data, data + n);
+            data += n;
+        } while (size > 0);
+    }
+
+    void PutBits(uint32_t bits, int count) {
+        m_bitBuf |= (uint64_t)bits << m_bitCount;
+        m_bitCount += count;
+        while (m_bitCount >= 8) {
+            m_out->push_back((uint8_t)m_bitBuf);
+            m_bitBuf >>= 8;
+            m_bitCount -= 8;
+        }
+    }
+
+    // 补齐到字节边界
+    void FlushBits() {
+        if (m_bitCount > 0) m_out->push_back((uint8_t)m_bitBuf);
+        m_bitBuf = 0;
+        m_bitCount = 0;
+    }
+
+    void PutU32(uint32_t v) {
+        for (int s = 24; s >= 0; s -= 8) m_out->push_back((uint8_t)(v >> s));
+    }
+
+    std::vector<int32_t> m_head;
+    std::vector<int32_t> m_prev;
+    std::vector<Token> m_tokens;
+    uint8_t m_lengthSymbol[259];
+    uint8_t m_distSymbol[kWindowSize + 1];
+
+    std::vector<uint8_t>* m_out;
+    uint64_t m_bitBuf;
+    int m_bitCount;
+};
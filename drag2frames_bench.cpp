@@ -0,0 +1,615 @@
+/*
+    基准测试：用合成视频（synthetic_decoder.h）分别测量各阶段与端到端的速度，结果为 JSON，便于比较不同提交
+    不需要视频文件与解码硬件，可在 Linux 上编译运行：
+        g++ -std=c++14 -O2 drag2frames_bench.cpp -o drag2frames_bench -pthread
+    用法：
+        drag2frames_bench [--quick] [--resolutions 720p,1080p,4k] [--frames N] [--threads 1,8] [--min-time 秒]
+                          [--workdir 目录] [--out 结果.json] [--compare 基线.json] [--threshold 百分比]
+    单阶段（每种分辨率，单线程，重复执行至少 --min-time 秒）：
+        convert_i420 / convert_i420_sse2 / convert_i420_scalar / convert_nv12
+                                                             整帧 YUV -> BGRX（自动选择的内核 / SSE2 / 标量内核）
+        crop_convert_i420                                    只转换中间 1/4 面积的 ROI
+        crop_bgrx                                            RGB32 帧的 ROI 跨步视图复制
+        copy_bgrx                                            从缓冲池取缓冲并复制整帧（相当于原来的 Bitmap::Clone）
+        resize_area_224                                      整帧面积平均缩小到 224x224
+        encode_jpg / encode_png / encode_bmp / encode_ppm    整帧编码到内存
+        encode_png_l0 ... encode_png_l9                      中间 1/4 面积按各压缩级别编码 PNG，另记录输出字节数 output_bytes
+                                                             （4 级起逐行选择过滤器，噪声多的画面上可能比 3 级的 Sub 过滤大）
+        gray_i420 / crop_gray_i420                           灰度输出：整帧 / ROI 直接取 Y 平面
+        resize_area_224_gray                                 灰度整帧面积平均缩小到 224x224
+        encode_jpg_gray / encode_png_gray / ...              灰度整帧编码到内存（单通道）
+        multipass_* / fused_*                                从 I420 帧缩小到 224x224：先转换整个 ROI 再缩放 / 一遍完成，
+                                                             area_224、bilinear_224、crop_area_224（中间 1/4）、area_224_gray
+        write                                                把编码好的 JPEG 写入文件
+        write_behind                                         经写出队列写 16 个文件并等待写完（1 个写出线程）
+        write_slow / write_behind_slow                       模拟每个文件 2ms 延迟的慢速存储：直接写 / 4 个写出线程
+    端到端：每种分辨率 × 跳帧数 × ROI（整帧 / 中间 1/4）× 彩色 / 灰度 × 线程数，两个合成视频经提取引擎输出 JPEG。
+    frames_per_s 为每秒处理的视频帧数，mb_per_s 为对应的 YUV 数据量（端到端）或阶段输入的字节数（单阶段）；
+    颜色转换与取灰度的阶段另有 mpixel_per_s（每秒转换的百万像素数）。
+    --compare 与之前保存的结果逐项比较，速度下降超过阈值（默认 10%）的项标为退化并返回 1。
+*/
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "color_convert.h"
+#include "encoder_factory.h"
+#include "extract_engine.h"
+#include "file_util.h"
+#include "frame_pool.h"
+#include "image_resize.h"
+#include "job_file.h"
+#include "png_encoder.h"
+#include "synthetic_decoder.h"
+#include "write_behind.h"
+
+struct BenchResolution {
+    std::string name;
+    int width;
+    int height;
+};
+
+struct StageResult {
+    std::string resolution;
+    std::string stage;
+    int iterations;
+    double seconds;
+    double bytesPerIteration;
+    double pixelsPerIteration;      // 颜色转换阶段每次转换的像素数，其他阶段为 0
+    double outputBytes;             // 编码阶段输出的字节数（比较压缩级别用），其他阶段为 0
+};
+
+struct EndToEndResult {
+    std::string resolution;
+    int interval;
+    std::string roi;
+    bool gray;              // 灰度输出（channels=gray）
+    int threads;
+    uint64_t frames;        // 两个视频的总帧数
+    uint64_t decoded;
+    uint64_t saved;
+    double seconds;
+    double bytesPerFrame;   // 一帧 YUV 的字节数
+};
+
+static double Now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 先执行一次预热，再重复执行直到至少 minSeconds 秒且至少 3 次（很慢的阶段最多 4 倍 minSeconds）
+template <class Fn>
+StageResult Measure(const std::string& resolution, const std::string& stage, double bytes, double minSeconds, Fn fn,
+                    double pixels = 0.0) {
+    fn();
+    StageResult r;
+    r.resolution = resolution;
+    r.stage = stage;
+    r.iterations = 0;
+    r.bytesPerIteration = bytes;
+    r.pixelsPerIteration = pixels;
+    r.outputBytes = 0.0;
+    double start = Now(), elapsed = 0.0;
+    do {
+        fn();
+        r.iterations++;
+        elapsed = Now() - start;
+    } while (elapsed < minSeconds || (r.iterations < 3 && elapsed < minSeconds * 4));
+    r.seconds = elapsed;
+    fprintf(stderr, "  %-6s %-22s %10.1f 帧/s %10.1f MB/s", resolution.c_str(), stage.c_str(),
+        r.iterations / r.seconds, r.iterations * bytes / r.seconds / 1e6);
+    if (pixels > 0) fprintf(stderr, " %10.1f Mpx/s", r.iterations * pixels / r.seconds / 1e6);
+    fprintf(stderr, "\n");
+    return r;
+}
+
+static bool ParseResolution(const std::string& name, BenchResolution* res) {
+    static const BenchResolution kKnown[] = {
+        { "480p", 854, 480 }, { "720p", 1280, 720 }, { "1080p", 1920, 1080 }, { "1440p", 2560, 1440 }, { "4k", 3840, 2160 },
+    };
+    for (size_t i = 0; i < sizeof(kKnown) / sizeof(kKnown[0]); ++i) {
+        if (name == kKnown[i].name) {
+            *res = kKnown[i];
+            return true;
+        }
+    }
+    res->name = name;
+    return sscanf(name.c_str(), "%dx%d", &res->width, &res->height) == 2 && res->width > 1 && res->height > 1;
+}
+
+static std::vector<std::string> SplitList(const std::string& text) {
+    std::vector<std::string> items;
+    size_t pos = 0;
+    while (pos <= text.size()) {
+        size_t end = text.find(',', pos);
+        if (end == std::string::npos) end = text.size();
+        if (end > pos) items.push_back(text.substr(pos, end - pos));
+        pos = end + 1;
+    }
+    return items;
+}
+
+static const char* ColorKernelName() {
+#ifdef D2F_X86
+    if (GetYuvRowKernel() == YuvRowToBgrx_AVX2) return "avx2";
+    if (GetYuvRowKernel() == YuvRowToBgrx_SSE2) return "sse2";
+#endif
+    return "scalar";
+}
+
+static RoiRect CenterRoi(int width, int height) {
+    RoiRect r = { width / 4, height / 4, width - width / 4, height - height / 4 };
+    return r;
+}
+
+// 单阶段测量：输入为合成视频的第一帧
+static void RunStages(const BenchResolution& res, const std::string& workdir, double minSeconds, std::vector<StageResult>* results) {
+    int w = res.width, h = res.height;
+    SyntheticDecoderBackend backend;
+    SyntheticClip clip;
+    clip.name = "i420";
+    clip.width = w;
+    clip.height = h;
+    clip.frames = 1;
+    backend.AddClip(clip);
+    clip.name = "nv12";
+    clip.format = FRAME_NV12;
+    backend.AddClip(clip);
+
+    std::unique_ptr<IVideoDecoder> i420 = backend.CreateDecoder(), nv12 = backend.CreateDecoder();
+    FrameView i420View, nv12View;
+    if (!i420->Open("i420") || !i420->Advance(NULL) || !i420->LockFrame(&i420View) ||
+        !nv12->Open("nv12") || !nv12->Advance(NULL) || !nv12->LockFrame(&nv12View)) {
+        fprintf(stderr, "无法生成 %s 的合成帧\n", res.name.c_str());
+        return;
+    }
+
+    int stride = w * 4;
+    std::vector<uint8_t> bgrx((size_t)stride * h), scratch((size_t)stride * h);
+    RoiRect full = { 0, 0, w, h };
+    ConvertRoiToBgrx(i420View, full, bgrx.data(), stride);
+    FrameView bgrxView = FrameView();
+    bgrxView.data = bgrx.data();
+    bgrxView.width = w;
+    bgrxView.height = h;
+    bgrxView.stride = stride;
+
+    RoiRect roi = CenterRoi(w, h);
+    double yuvBytes = (double)SyntheticFrameBytes(w, h);
+    double bgrxBytes = (double)stride * h;
+    double roiPixels = (double)(roi.right - roi.left) * (roi.bottom - roi.top);
+    const std::string& n = res.name;
+
+    double framePixels = (double)w * h;
+    results->push_back(Measure(n, "convert_i420", yuvBytes, minSeconds, [&] {
+        ConvertRoiToBgrx(i420View, full, scratch.data(), stride);
+    }, framePixels));
+    results->push_back(Measure(n, "convert_i420_sse2", yuvBytes, minSeconds, [&] {
+        ConvertRoiToBgrx(i420View, full, scratch.data(), stride, COLOR_KERNEL_SSE2);
+    }, framePixels));
+    results->push_back(Measure(n, "convert_i420_scalar", yuvBytes, minSeconds, [&] {
+        ConvertRoiToBgrx(i420View, full, scratch.data(), stride, COLOR_KERNEL_SCALAR);
+    }, framePixels));
+    results->push_back(Measure(n, "convert_nv12", yuvBytes, minSeconds, [&] {
+        ConvertRoiToBgrx(nv12View, full, scratch.data(), stride);
+    }, framePixels));
+    results->push_back(Measure(n, "crop_convert_i420", roiPixels * 1.5, minSeconds, [&] {
+        ConvertRoiToBgrx(i420View, roi, scratch.data(), (roi.right - roi.left) * 4);
+    }, roiPixels));
+    results->push_back(Measure(n, "crop_bgrx", roiPixels * 4, minSeconds, [&] {
+        ConvertRoiToBgrx(bgrxView, roi, scratch.data(), (roi.right - roi.left) * 4);
+    }));
+
+    FramePool pool(2);
+    pool.Configure((size_t)stride * h);
+    results->push_back(Measure(n, "copy_bgrx", bgrxBytes, minSeconds, [&] {
+        FrameBuffer* buffer = pool.Acquire();
+        CopyFrameView(bgrxView, buffer->data, stride);
+        pool.Release(buffer);
+    }));
+
+    ImageResizer resizer;
+    resizer.Configure(w, h, 224, 224, RESIZE_AREA);
+    std::vector<uint8_t> small(224 * 224 * 4);
+    results->push_back(Measure(n, "resize_area_224", bgrxBytes, minSeconds, [&] {
+        resizer.Resize(bgrxView, small.data(), 224 * 4);
+    }));
+
+    static const char* const kFormats[IMAGE_FORMAT_COUNT] = { "encode_jpg", "encode_png", "encode_bmp", "encode_ppm" };
+    std::vector<uint8_t> jpeg, bytes;
+    for (int f = 0; f < IMAGE_FORMAT_COUNT; f++) {
+        EncoderOptions options;
+        options.format = f;
+        std::unique_ptr<IImageEncoder> encoder = CreateImageEncoder(options);
+        results->push_back(Measure(n, kFormats[f], bgrxBytes, minSeconds, [&] { encoder->Encode(bgrxView, bytes); }));
+        if (f == IMAGE_JPEG) jpeg = bytes;
+    }
+
+    // PNG 各压缩级别的速度与体积；9 级在整帧上单次要数秒，只编码中间 1/4 面积
+    FrameView roiView = FrameView();
+    MakeRoiView(bgrxView, roi, &roiView);
+    for (int level = 0; level <= 9; level++) {
+        PngEncoder png(level);
+        char stage[32];
+        snprintf(stage, sizeof(stage), "encode_png_l%d", level);
+        StageResult r = Measure(n, stage, roiPixels * 4, minSeconds, [&] { png.Encode(roiView, bytes); });
+        r.outputBytes = (double)bytes.size();
+        fprintf(stderr, "  %-6s %-22s %10.0f 字节\n", n.c_str(), stage, r.outputBytes);
+        results->push_back(r);
+    }
+
+    // 灰度输出：与上面的彩色阶段一一对应，字节数按输入计（转换为 Y 平面，其余为灰度缓冲）
+    std::vector<uint8_t> gray((size_t)w * h);
+    ConvertRoiToGray(i420View, full, gray.data(), w);
+    FrameView grayView = FrameView();
+    grayView.data = gray.data();
+    grayView.width = w;
+    grayView.height = h;
+    grayView.stride = w;
+    grayView.format = FRAME_GRAY8;
+    double grayBytes = (double)w * h;
+    results->push_back(Measure(n, "gray_i420", grayBytes, minSeconds, [&] {
+        ConvertRoiToGray(i420View, full, scratch.data(), w);
+    }, framePixels));
+    results->push_back(Measure(n, "crop_gray_i420", roiPixels, minSeconds, [&] {
+        ConvertRoiToGray(i420View, roi, scratch.data(), roi.right - roi.left);
+    }, roiPixels));
+    ImageResizer grayResizer;
+    grayResizer.Configure(w, h, 224, 224, RESIZE_AREA, FRAME_GRAY8);
+    results->push_back(Measure(n, "resize_area_224_gray", grayBytes, minSeconds, [&] {
+        grayResizer.Resize(grayView, small.data(), 224);
+    }));
+    for (int f = 0; f < IMAGE_FORMAT_COUNT; f++) {
+        EncoderOptions options;
+        options.format = f;
+        std::unique_ptr<IImageEncoder> encoder = CreateImageEncoder(options);
+        results->push_back(Measure(n, std::string(kFormats[f]) + "_gray", grayBytes, minSeconds, [&] { encoder->Encode(grayView, bytes); }));
+    }
+
+    // 一遍缩放与多遍缩放：多遍先把 ROI 转换为完整的中间图像再缩放，一遍只转换用到的源行并立即缩放
+    // （两者逐位一致，由 tests/image_resize_test.cpp 验证）
+    struct FusedCase {
+        const char* name;
+        RoiRect roi;
+        int filter;
+        int format;
+        double bytes;
+    };
+    const FusedCase fusedCases[] = {
+        { "area_224", full, RESIZE_AREA, FRAME_BGRX32, yuvBytes },
+        { "bilinear_224", full, RESIZE_BILINEAR, FRAME_BGRX32, yuvBytes },
+        { "crop_area_224", roi, RESIZE_AREA, FRAME_BGRX32, roiPixels * 1.5 },
+        { "area_224_gray", full, RESIZE_AREA, FRAME_GRAY8, grayBytes },
+    };
+    std::vector<uint8_t> multiOut(224 * 224 * 4), fusedOut(224 * 224 * 4);
+    for (size_t c = 0; c < sizeof(fusedCases) / sizeof(fusedCases[0]); ++c) {
+        const FusedCase& fc = fusedCases[c];
+        int pixelBytes = FramePixelBytes(fc.format);
+        FrameView converted = FrameView();
+        converted.data = scratch.data();
+        converted.width = fc.roi.right - fc.roi.left;
+        converted.height = fc.roi.bottom - fc.roi.top;
+        converted.stride = converted.width * pixelBytes;
+        converted.format = fc.format;
+        ImageResizer multiResizer, fusedResizer;
+        multiResizer.Configure(converted.width, converted.height, 224, 224, fc.filter, fc.format);
+        fusedResizer.Configure(converted.width, converted.height, 224, 224, fc.filter, fc.format);
+        auto multiPass = [&] {
+            ConvertRoi(i420View, fc.roi, fc.format, scratch.data(), converted.stride);
+            multiResizer.Resize(converted, multiOut.data(), 224 * pixelBytes);
+        };
+        auto fusedPass = [&] { fusedResizer.ResizeRoi(i420View, fc.roi, fusedOut.data(), 224 * pixelBytes); };
+        results->push_back(Measure(n, std::string("multipass_") + fc.name, fc.bytes, minSeconds, multiPass));
+        results->push_back(Measure(n, std::string("fused_") + fc.name, fc.bytes, minSeconds, fusedPass));
+    }
+
+    // 写入：轮流写 16 个文件，包含打开与关闭
+    int next = 0;
+    results->push_back(Measure(n, "write", (double)jpeg.size(), minSeconds, [&] {
+        char name[32];
+        snprintf(name, sizeof(name), "write_%02d.jpg", next++ % 16);
+        FILE* fp = OpenFileUtf8(JoinPath(workdir, name), "wb");
+        if (!fp) return;
+        fwrite(jpeg.data(), 1, jpeg.size(), fp);
+        fclose(fp);
+    }));
+
+    // 写出队列：每次提交 16 个文件并等待写完，缓冲与路径重用
+    DiskFileSink disk;
+    auto writeBatch = [&](WriteBehindQueue& writer) {
+        for (int i = 0; i < 16; i++) {
+            WriteRequest* request = writer.Acquire();
+            char name[32];
+            snprintf(name, sizeof(name), "behind_%02d.jpg", i);
+            request->path = JoinPath(workdir, name);
+            request->bytes.assign(jpeg.begin(), jpeg.end());
+            writer.Submit(request);
+        }
+        writer.Flush();
+    };
+    {
+        WriteBehindQueue writer(disk, DURABILITY_NONE, kDefaultWriteBufferBytes);
+        writer.Start(1);
+        results->push_back(Measure(n, "write_behind", 16.0 * jpeg.size(), minSeconds, [&] { writeBatch(writer); }));
+    }
+
+    // 慢速存储：直接写时每个文件都要等待延迟，写出线程可以同时等待多个文件
+    ThrottledFileSink slow(disk, 0.002, 0.0);
+    results->push_back(Measure(n, "write_slow", 16.0 * jpeg.size(), minSeconds, [&] {
+        for (int i = 0; i < 16; i++) {
+            char name[32];
+            snprintf(name, sizeof(name), "slow_%02d.jpg", i);
+            slow.WriteFile(JoinPath(workdir, name), jpeg.data(), jpeg.size(), DURABILITY_NONE);
+        }
+    }));
+    {
+        WriteBehindQueue writer(slow, DURABILITY_NONE, kDefaultWriteBufferBytes);
+        writer.Start(4);
+        results->push_back(Measure(n, "write_behind_slow", 16.0 * jpeg.size(), minSeconds, [&] { writeBatch(writer); }));
+    }
+}
+
+// 端到端：两个合成视频，提取引擎输出整帧或 ROI 的彩色或灰度 JPEG
+static void RunEndToEnd(const BenchResolution& res, int frames, const std::vector<int>& intervals, const std::vector<int>& threads,
+                        const std::string& workdir, std::vector<EndToEndResult>* results) {
+    SyntheticDecoderBackend backend;
+    ExtractionJob job;
+    for (int i = 0; i < 2; i++) {
+        SyntheticClip clip;
+        clip.name = res.name + (i == 0 ? "_a" : "_b");
+        clip.width = res.width;
+        clip.height = res.height;
+        clip.frames = frames;
+        backend.AddClip(clip);
+        job.files.push_back(clip.name);
+    }
+    job.outputDir = JoinPath(workdir, "e2e");
+    job.resume = false;     // 每次都完整提取
+    job.frameIndex = FRAME_INDEX_OFF;   // 虚拟视频没有文件，不写帧索引；跳转模式自己测量 GOP
+
+    for (size_t iv = 0; iv < intervals.size(); ++iv) {
+        // 整帧彩色、整帧灰度、ROI 彩色、ROI 灰度
+        for (int variant = 0; variant < 4; variant++) {
+            bool useRoi = variant >= 2, gray = (variant & 1) != 0;
+            for (size_t t = 0; t < threads.size(); ++t) {
+                job.sampling = SamplingOptions();
+                job.sampling.interval = intervals[iv];
+                job.outputs.assign(1, OutputSpec());
+                job.outputs[0].useRoi = useRoi;
+                job.outputs[0].roi = CenterRoi(res.width, res.height);
+                job.outputs[0].channels = gray ? CHANNELS_GRAY : CHANNELS_RGB;
+
+                ExtractionEngine engine(backend);
+                engine.SetThreadCounts((size_t)threads[t], (size_t)threads[t]);
+                std::atomic<bool> stop(false);
+                ExtractionStats stats;
+                std::string error;
+                double start = Now();
+                if (!engine.Run(job, stop, &stats, &error)) {
+                    fprintf(stderr, "端到端失败: %s\n", error.c_str());
+                    return;
+                }
+                EndToEndResult r;
+                r.resolution = res.name;
+                r.interval = intervals[iv];
+                r.roi = useRoi ? "center" : "full";
+                r.gray = gray;
+                r.threads = threads[t];
+                r.frames = (uint64_t)frames * job.files.size();
+                r.decoded = stats.framesDecoded;
+                r.saved = stats.framesSaved;
+                r.seconds = Now() - start;
+                r.bytesPerFrame = (double)SyntheticFrameBytes(res.width, res.height);
+                results->push_back(r);
+                fprintf(stderr, "  %-6s 跳帧 %-3d %-6s %-4s %2d 线程 %10.1f 帧/s %10.1f MB/s (解码 %llu, 保存 %llu)\n",
+                    r.resolution.c_str(), r.interval, r.roi.c_str(), r.gray ? "gray" : "rgb", r.threads, r.frames / r.seconds,
+                    r.frames * r.bytesPerFrame / r.seconds / 1e6, (unsigned long long)r.decoded, (unsigned long long)r.saved);
+            }
+        }
+    }
+}
+
+static std::string StageKey(const std::string& resolution, const std::string& stage) {
+    return resolution + " " + stage;
+}
+
+// 彩色输出的键与加入灰度之前相同，旧的基线仍可比较
+static std::string EndToEndKey(const std::string& resolution, int interval, const std::string& roi, bool gray, int threads) {
+    char key[128];
+    snprintf(key, sizeof(key), "%s 跳帧%d %s%s %d线程", resolution.c_str(), interval, roi.c_str(), gray ? " gray" : "", threads);
+    return key;
+}
+
+static void WriteResults(FILE* fp, const std::vector<StageResult>& stages, const std::vector<EndToEndResult>& e2e,
+                         int frames, double minSeconds) {
+    fprintf(fp, "{\n  \"version\": 1,\n");
+    fprintf(fp, "  \"system\": {\"cpu_threads\": %zu, \"color_kernel\": \"%s\", \"pointer_bits\": %d},\n",
+        WorkerPool::DefaultThreadCount(), ColorKernelName(), (int)sizeof(void*) * 8);
+    fprintf(fp, "  \"config\": {\"frames\": %d, \"min_time\": %g},\n", frames, minSeconds);
+    fprintf(fp, "  \"stages\": [");
+    for (size_t i = 0; i < stages.size(); ++i) {
+        const StageResult& r = stages[i];
+        fprintf(fp, "%s\n    {\"resolution\": \"%s\", \"stage\": \"%s\", \"iterations\": %d, \"seconds\": %.6f, "
+            "\"frames_per_s\": %.3f, \"mb_per_s\": %.3f", i ? "," : "", r.resolution.c_str(), r.stage.c_str(), r.iterations,
+            r.seconds, r.iterations / r.seconds, r.iterations * r.bytesPerIteration / r.seconds / 1e6);
+        if (r.pixelsPerIteration > 0) fprintf(fp, ", \"mpixel_per_s\": %.3f", r.iterations * r.pixelsPerIteration / r.seconds / 1e6);
+        if (r.outputBytes > 0) fprintf(fp, ", \"output_bytes\": %.0f", r.outputBytes);
+        fprintf(fp, "}");
+    }
+    fprintf(fp, "\n  ],\n  \"end_to_end\": [");
+    for (size_t i = 0; i < e2e.size(); ++i) {
+        const EndToEndResult& r = e2e[i];
+        fprintf(fp, "%s\n    {\"resolution\": \"%s\", \"interval\": %d, \"roi\": \"%s\", \"channels\": \"%s\", \"threads\": %d, "
+            "\"frames\": %llu, \"decoded\": %llu, \"saved\": %llu, \"seconds\": %.6f, \"frames_per_s\": %.3f, \"mb_per_s\": %.3f}",
+            i ? "," : "", r.resolution.c_str(), r.interval, r.roi.c_str(), r.gray ? "gray" : "rgb", r.threads, (unsigned long long)r.frames,
+            (unsigned long long)r.decoded, (unsigned long long)r.saved, r.seconds, r.frames / r.seconds,
+            r.frames * r.bytesPerFrame / r.seconds / 1e6);
+    }
+    fprintf(fp, "\n  ]\n}\n");
+}
+
+// 读取之前保存的结果：键 -> frames_per_s
+static bool LoadBaseline(const std::string& path, std::map<std::string, double>* baseline, std::string* error) {
+    FILE* fp = OpenFileUtf8(path, "rb");
+    if (!fp) {
+        *error = "无法打开: " + path;
+        return false;
+    }
+    std::string text;
+    char chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0) text.append(chunk, n);
+    fclose(fp);
+
+    JsonValue root;
+    JsonParser parser(text);
+    if (!parser.Parse(&root, error)) return false;
+    auto text_of = [](const JsonValue& item, const char* key) {
+        const JsonValue* v = item.Find(key);
+        return v && v->type == JsonValue::JSON_STRING ? v->text : std::string();
+    };
+    auto number_of = [](const JsonValue& item, const char* key) {
+        const JsonValue* v = item.Find(key);
+        return v && v->type == JsonValue::JSON_NUMBER ? v->number : 0.0;
+    };
+    if (const JsonValue* stages = root.Find("stages")) {
+        for (size_t i = 0; i < stages->items.size(); ++i) {
+            const JsonValue& item = stages->items[i];
+            (*baseline)[StageKey(text_of(item, "resolution"), text_of(item, "stage"))] = number_of(item, "frames_per_s");
+        }
+    }
+    if (const JsonValue* e2e = root.Find("end_to_end")) {
+        for (size_t i = 0; i < e2e->items.size(); ++i) {
+            const JsonValue& item = e2e->items[i];
+            std::string key = EndToEndKey(text_of(item, "resolution"), (int)number_of(item, "interval"), text_of(item, "roi"),
+                text_of(item, "channels") == "gray", (int)number_of(item, "threads"));
+            (*baseline)[key] = number_of(item, "frames_per_s");
+        }
+    }
+    return true;
+}
+
+// 逐项比较，返回退化的项数
+static int Compare(const std::map<std::string, double>& baseline, const std::vector<std::pair<std::string, double>>& current,
+                   double thresholdPercent) {
+    int regressions = 0;
+    fprintf(stderr, "\n%-40s %12s %12s %9s\n", "项目", "基线 帧/s", "当前 帧/s", "变化");
+    for (size_t i = 0; i < current.size(); ++i) {
+        std::map<std::string, double>::const_iterator it = baseline.find(current[i].first);
+        if (it == baseline.end() || it->second <= 0.0) continue;
+        double change = (current[i].second / it->second - 1.0) * 100.0;
+        bool regressed = change < -thresholdPercent;
+        if (regressed) regressions++;
+        fprintf(stderr, "%-40s %12.1f %12.1f %+8.1f%%%s\n", current[i].first.c_str(), it->second, current[i].second, change,
+            regressed ? "  退化" : "");
+    }
+    return regressions;
+}
+
+static int Usage() {
+    fprintf(stderr,
+        "用法:\n"
+        "  drag2frames_bench [--quick] [--resolutions 720p,1080p,4k] [--frames N] [--threads 1,8] [--min-time 秒]\n"
+        "                    [--workdir 目录] [--out 结果.json] [--compare 基线.json] [--threshold 百分比]\n"
+        "分辨率可写 480p、720p、1080p、1440p、4k 或 WxH。\n");
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    std::string resolutionList = "720p,1080p,4k", threadList, workdir = "d2f_bench_tmp", outPath, comparePath;
+    int frames = 120;
+    double minSeconds = 0.5, threshold = 10.0;
+    std::vector<int> intervals;
+    intervals.push_back(0);
+    intervals.push_back(4);
+    intervals.push_back(59);
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--quick") {
+            resolutionList = "720p,1080p";
+            frames = 30;
+            minSeconds = 0.2;
+            intervals.assign(1, 0);
+        }
+        else if (arg == "--resolutions" && hasValue) resolutionList = argv[++i];
+        else if (arg == "--frames" && hasValue) frames = std::max(1, atoi(argv[++i]));
+        else if (arg == "--threads" && hasValue) threadList = argv[++i];
+        else if (arg == "--min-time" && hasValue) minSeconds = atof(argv[++i]);
+        else if (arg == "--workdir" && hasValue) workdir = argv[++i];
+        else if (arg == "--out" && hasValue) outPath = argv[++i];
+        else if (arg == "--compare" && hasValue) comparePath = argv[++i];
+        else if (arg == "--threshold" && hasValue) threshold = atof(argv[++i]);
+        else return Usage();
+    }
+
+    std::vector<BenchResolution> resolutions;
+    std::vector<std::string> names = SplitList(resolutionList);
+    for (size_t i = 0; i < names.size(); ++i) {
+        BenchResolution res;
+        if (!ParseResolution(names[i], &res)) {
+            fprintf(stderr, "无法识别的分辨率: %s\n", names[i].c_str());
+            return 2;
+        }
+        resolutions.push_back(res);
+    }
+    // 默认比较单线程与全部核心
+    std::vector<int> threads;
+    std::vector<std::string> threadItems = SplitList(threadList);
+    for (size_t i = 0; i < threadItems.size(); ++i) threads.push_back(std::max(1, atoi(threadItems[i].c_str())));
+    if (threads.empty()) {
+        threads.push_back(1);
+        if (WorkerPool::DefaultThreadCount() > 1) threads.push_back((int)WorkerPool::DefaultThreadCount());
+    }
+
+    std::map<std::string, double> baseline;
+    if (!comparePath.empty()) {
+        std::string error;
+        if (!LoadBaseline(comparePath, &baseline, &error)) {
+            fprintf(stderr, "%s: %s\n", comparePath.c_str(), error.c_str());
+            return 2;
+        }
+    }
+    if (!CreateDirectoryUtf8(workdir)) {
+        fprintf(stderr, "无法创建工作目录: %s\n", workdir.c_str());
+        return 2;
+    }
+
+    std::vector<StageResult> stages;
+    std::vector<EndToEndResult> e2e;
+    fprintf(stderr, "单阶段（颜色转换内核 %s）:\n", ColorKernelName());
+    for (size_t i = 0; i < resolutions.size(); ++i) RunStages(resolutions[i], workdir, minSeconds, &stages);
+    fprintf(stderr, "端到端（每种设置两个 %d 帧的视频）:\n", frames);
+    for (size_t i = 0; i < resolutions.size(); ++i) RunEndToEnd(resolutions[i], frames, intervals, threads, workdir, &e2e);
+
+    if (outPath.empty()) {
+        WriteResults(stdout, stages, e2e, frames, minSeconds);
+    } else {
+        FILE* fp = OpenFileUtf8(outPath, "wb");
+        if (!fp) {
+            fprintf(stderr, "无法写入: %s\n", outPath.c_str());
+            return 1;
+        }
+        WriteResults(fp, stages, e2e, frames, minSeconds);
+        fclose(fp);
+    }
+
+    if (comparePath.empty()) return 0;
+    std::vector<std::pair<std::string, double>> current;
+    for (size_t i = 0; i < stages.size(); ++i) {
+        current.push_back(std::make_pair(StageKey(stages[i].resolution, stages[i].stage), stages[i].iterations / stages[i].seconds));
+    }
+    for (size_t i = 0; i < e2e.size(); ++i) {
+        current.push_back(std::make_pair(EndToEndKey(e2e[i].resolution, e2e[i].interval, e2e[i].roi, e2e[i].gray, e2e[i].threads),
+            e2e[i].frames / e2e[i].seconds));
+    }
+    int regressions = Compare(baseline, current, threshold);
+    if (regressions > 0) fprintf(stderr, "%d 项速度下降超过 %g%%\n", regressions, threshold);
+    return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,189 @@
+/*
+    命令行前端：按 JSON 任务文件批量提取，不需要图形界面
+    Windows 上使用 Media Foundation 后端，其他平台使用可移植的 Y4M 后端（ffmpeg -i in.mp4 -pix_fmt yuv420p out.y4m）。
+    Linux 上编译：
+        g++ -std=c++14 -O2 drag2frames_cli.cpp -o drag2frames_cli -pthread
+    用法：
+        drag2frames_cli [--backend mf|y4m] [--decoders N] [--encoders N] [--writers N] [--quiet] <任务文件>...
+    任务文件的格式见 job_file.h。jpg-gdiplus 输出在命令行中使用内置 JPEG 编码器。
+    全部成功返回 0，有文件无法打开或写出、任务失败返回 1，参数错误返回 2。
+*/
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "extract_engine.h"
+#include "job_file.h"
+#include "video_decoder.h"
+#include "y4m_decoder.h"
+#ifdef _WIN32
+#include "mf_decoder.h"
+#endif
+
+// 进度写到 stderr 的同一行，文件级的消息另起一行
+class ConsoleObserver : public IExtractionObserver {
+public:
+    ConsoleObserver(const ExtractionJob& job, bool quiet) : m_job(job), m_quiet(quiet), m_progress(0) {}
+
+    void OnProgress(int percent) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_progress = percent;
+        if (!m_quiet) fprintf(stderr, "\r进度 %3d%%", percent);
+    }
+
+    void OnFileError(size_t index, const std::string& message) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_errors[index] = message;
+    }
+
+    void OnFileFinished(size_t index, bool ok, int kept, int dropped) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!ok) {
+            std::map<size_t, std::string>::const_iterator it = m_errors.find(index);
+            if (it != m_errors.end()) fprintf(stderr, "\r无法打开: %s: %s\n", m_job.files[index].c_str(), it->second.c_str());
+            else fprintf(stderr, "\r无法打开: %s\n", m_job.files[index].c_str());
+        } else if (!m_quiet && m_job.dedupThreshold > 0.0) {
+            fprintf(stderr, "\r%s: 保留 %d 帧, 丢弃重复帧 %d 帧\n", m_job.files[index].c_str(), kept, dropped);
+        } else {
+            return;
+        }
+        if (!m_quiet) fprintf(stderr, "进度 %3d%%", m_progress);
+    }
+
+private:
+    ConsoleObserver(const ConsoleObserver&) = delete;
+    ConsoleObserver& operator=(const ConsoleObserver&) = delete;
+
+    const ExtractionJob& m_job;
+    bool m_quiet;
+    int m_progress;
+    std::map<size_t, std::string> m_errors;     // OnFileError 给出的原因，按文件下标
+    std::mutex m_mutex;
+};
+
+static int Usage() {
+    fprintf(stderr,
+        "用法:\n"
+        "  drag2frames_cli [--backend mf|y4m] [--decoders N] [--encoders N] [--writers N] [--quiet] <任务文件>...\n"
+        "选项:\n"
+        "  --backend   解码后端，Windows 默认 mf，其他平台只有 y4m\n"
+        "  --decoders  并行解码的文件数上限（默认 4）\n"
+        "  --encoders  编码线程数（默认 CPU 核心数）\n"
+        "  --writers   写出图像文件的线程数（默认 1，网络共享等高延迟存储可以加大）\n"
+        "  --quiet     只输出错误\n");
+    return 2;
+}
+
+int main(int argc, char** argv) {
+#ifdef _WIN32
+    std::string backendName = "mf";
+#else
+    std::string backendName = "y4m";
+#endif
+    size_t maxDecoders = 4, encoderThreads = 0, writerThreads = 1;
+    bool quiet = false;
+    std::vector<std::string> jobFiles;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--backend" && i + 1 < argc) backendName = argv[++i];
+        else if (arg == "--decoders" && i + 1 < argc) maxDecoders = (size_t)std::max(1, atoi(argv[++i]));
+        else if (arg == "--encoders" && i + 1 < argc) encoderThreads = (size_t)std::max(0, atoi(argv[++i]));
+        else if (arg == "--writers" && i + 1 < argc) writerThreads = (size_t)std::max(1, atoi(argv[++i]));
+        else if (arg == "--quiet") quiet = true;
+        else if (arg.compare(0, 2, "--") == 0) return Usage();
+        else jobFiles.push_back(arg);
+    }
+    if (jobFiles.empty()) return Usage();
+
+    std::unique_ptr<IDecoderBackend> backend;
+    if (backendName == "y4m") backend.reset(new Y4mDecoderBackend());
+#ifdef _WIN32
+    else if (backendName == "mf") backend.reset(new MfDecoderBackend());
+#endif
+    if (!backend) {
+        fprintf(stderr, "不支持的解码后端: %s\n", backendName.c_str());
+        return 2;
+    }
+
+    // 先读取全部任务文件，有错误时一个任务也不执行
+    std::vector<ExtractionJob> jobs;
+    for (size_t i = 0; i < jobFiles.size(); ++i) {
+        std::string error;
+        if (!LoadJobFile(jobFiles[i], *backend, &jobs, &error)) {
+            fprintf(stderr, "%s: %s\n", jobFiles[i].c_str(), error.c_str());
+            return 2;
+        }
+    }
+
+#ifdef _WIN32
+    backend->ThreadInit();
+    MFStartup(MF_VERSION);
+#endif
+    std::atomic<bool> stop(false);
+    int exitCode = 0;
+    for (size_t j = 0; j < jobs.size(); ++j) {
+        const ExtractionJob& job = jobs[j];
+        if (!quiet) fprintf(stderr, "任务 %zu/%zu: %zu 个文件 -> %s\n", j + 1, jobs.size(), job.files.size(), job.outputDir.c_str());
+
+        ConsoleObserver observer(job, quiet);
+        ExtractionEngine engine(*backend);
+        engine.SetObserver(&observer);
+        engine.SetThreadCounts(maxDecoders, encoderThreads, writerThreads);
+
+        ExtractionStats stats;
+        std::string error;
+        if (!engine.Run(job, stop, &stats, &error)) {
+            fprintf(stderr, "任务 %zu: %s\n", j + 1, error.c_str());
+            exitCode = 1;
+            continue;
+        }
+        if (stats.filesFailed > 0 || stats.writeFailures > 0) exitCode = 1;
+        if (stats.writeFailures > 0) fprintf(stderr, "\r%llu 个图像文件无法写出\n", (unsigned long long)stats.writeFailures);
+        if (!quiet) {
+            fprintf(stderr, "\r完成: %zu 个文件, %zu 个无法打开", stats.filesDone, stats.filesFailed);
+            if (stats.filesSkipped > 0 || stats.filesResumed > 0) {
+                fprintf(stderr, ", %zu 个已完成跳过, %zu 个续传", stats.filesSkipped, stats.filesResumed);
+            }
+            if (stats.filesSegmented > 0) fprintf(stderr, ", %zu 个分段并行解码", stats.filesSegmented);
+            if (stats.indexesLoaded > 0 || stats.indexesBuilt > 0) {
+                fprintf(stderr, ", 帧索引 %zu 个已有 / %zu 个新建", stats.indexesLoaded, stats.indexesBuilt);
+            }
+            if (job.dedupThreshold > 0.0) {
+                fprintf(stderr, ", 保留 %llu 帧, 丢弃重复帧 %llu 帧",
+                    (unsigned long long)stats.dedupKept, (unsigned long long)stats.dedupDropped);
+            }
+            fprintf(stderr, "\n");
+            if (job.sampling.mode == SAMPLE_LIST) {
+                fprintf(stderr, "帧列表: %llu 项, 输出 %llu 帧, 解码 %llu 帧", (unsigned long long)stats.framesRequested,
+                    (unsigned long long)stats.framesSaved, (unsigned long long)stats.framesDecoded);
+                if (stats.framesSaved > 0) fprintf(stderr, "（每输出一帧解码 %.1f 帧）", (double)stats.framesDecoded / stats.framesSaved);
+                fprintf(stderr, ", 各视频的明细见 %s\n", JoinPath(job.outputDir, "frame_list_summary.csv").c_str());
+            }
+            if (stats.filesWritten > 0) {
+                fprintf(stderr, "写出: %llu 个文件, %.1f MB, %.1f MB/s, 队列最大深度 %zu\n", (unsigned long long)stats.filesWritten,
+                    stats.bytesWritten / 1e6, stats.writeBytesPerSecond / 1e6, stats.writeQueuePeak);
+            }
+            fprintf(stderr, "内存: 在途数据最多 %.1f MB", stats.memoryPeakBytes / 1e6);
+            if (job.memoryBudgetBytes > 0) {
+                fprintf(stderr, "（预算 %.1f MB，等待 %llu 次共 %.2f 秒）", job.memoryBudgetBytes / 1e6,
+                    (unsigned long long)stats.memoryWaits, stats.memoryWaitSeconds);
+            }
+            fprintf(stderr, "\n");
+        }
+        if (job.trace) {
+            fprintf(stderr, "阶段耗时（跟踪文件 %s）:\n%s", JoinPath(job.outputDir, "pipeline_trace.json").c_str(),
+                stats.traceSummary.c_str());
+        }
+    }
+#ifdef _WIN32
+    MFShutdown();
+    backend->ThreadExit();
+#endif
+    return exitCode;
+}
@@ -0,0 +1,21 @@
+/*
+    按输出格式创建图像编码器
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <memory>
+
+#include "image_encoder.h"
+#include "jpeg_encoder.h"
+#include "png_encoder.h"
+
+inline std::unique_ptr<IImageEncoder> CreateImageEncoder(const EncoderOptions& options) {
+    switch (options.format) {
+    case IMAGE_JPEG: return std::unique_ptr<IImageEncoder>(new JpegEncoder(options.quality));
+    case IMAGE_PNG: return std::unique_ptr<IImageEncoder>(new PngEncoder(options.level));
+    case IMAGE_BMP: return std::unique_ptr<IImageEncoder>(new BmpEncoder());
+    case IMAGE_PPM: return std::unique_ptr<IImageEncoder>(new PpmEncoder());
+    default: return std::unique_ptr<IImageEncoder>();
+    }
+}
@@ -0,0 +1,1080 @@
+/*
+    提取引擎：与界面无关的 探测 -> 解码 -> 裁剪/缩放 -> 编码 -> 写出 流水线
+    图形界面与命令行都只是它的前端：任务由 ExtractionJob 描述，进度与状态通过 IExtractionObserver 回调，
+    解码由 IDecoderBackend 提供，图像编码器可由前端替换（例如 Windows 上的 GDI+ JPEG）。
+    回调在工作线程上调用，前端负责把它们转交到自己的线程。
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "batch_scheduler.h"
+#include "color_convert.h"
+#include "encoder_factory.h"
+#include "extract_manifest.h"
+#include "file_util.h"
+#include "frame_archive.h"
+#include "frame_dedup.h"
+#include "frame_list.h"
+#include "frame_pool.h"
+#include "image_resize.h"
+#include "memory_budget.h"
+#include "output_spec.h"
+#include "pipeline_trace.h"
+#include "probe_cache.h"
+#include "seek_sampling.h"
+#include "tensor_writer.h"
+#include "video_decoder.h"
+#include "work_queue.h"
+#include "write_behind.h"
+
+// 何时使用帧索引（frame_index.h）
+enum FrameIndexMode {
+    FRAME_INDEX_OFF = 0,        // 不读也不建立
+    FRAME_INDEX_AUTO,           // 有就用；采样稀疏或需要续传时才建立
+    FRAME_INDEX_ALWAYS          // 没有就建立
+};
+
+// 默认的最短分段时长：只有至少两段这么长的视频才分段
+static const double kDefaultSegmentSeconds = 300.0;
+
+// 一次批量提取的描述
+struct ExtractionJob {
+    std::vector<std::string> files;         // 视频文件（UTF-8）
+    std::vector<VideoProbeInfo> infos;      // 与 files 一一对应；为空时由引擎探测
+    std::string outputDir;                  // 输出根目录
+    SamplingOptions sampling;
+    std::vector<FrameList> frameLists;      // SAMPLE_LIST 时与 files 一一对应，已经 Normalize()
+    std::vector<OutputSpec> outputs;        // 至少一个；第 0 个的 ROI 用于去重判断
+    double dedupThreshold;                  // 每像素平均亮度差，0 表示不去重
+    bool trace;                             // 记录各阶段耗时，结束后在输出根目录写出 pipeline_trace.json 与统计表
+    bool resume;                            // 按输出目录中的清单跳过已完成的视频，未完成的从检查点继续（清单总是写出）
+    int durability;                         // WriteDurability，图像文件写出时是否 fsync
+    size_t writeBufferBytes;                // 写出队列中待写数据的上限，超过时编码线程等待
+    size_t memoryBudgetBytes;               // 在途帧与待写数据的字节上限，超过时解码线程等待；0 表示不限
+    double segmentSeconds;                  // 长视频按关键帧切成不短于这么多秒的段，由多个解码线程并行解码；0 表示不分段
+    int frameIndex;                         // FrameIndexMode
+    std::string indexDir;                   // 帧索引的缓存目录，为空时放在视频旁边
+
+    ExtractionJob() : dedupThreshold(0.0), trace(false), resume(true), durability(DURABILITY_NONE),
+                      writeBufferBytes(kDefaultWriteBufferBytes), memoryBudgetBytes(0), segmentSeconds(kDefaultSegmentSeconds),
+                      frameIndex(FRAME_INDEX_AUTO) {}
+};
+
+// 一次提取结束后的统计
+struct ExtractionStats {
+    uint64_t poolHits;
+    uint64_t poolMisses;
+    uint64_t dedupKept;
+    uint64_t dedupDropped;
+    uint64_t framesDecoded;     // 解码的帧数（跳转模式下少于视频总帧数）
+    uint64_t framesSaved;       // 去重之后送去输出的帧数（每帧计一次，与输出个数无关）
+    uint64_t framesRequested;   // 按帧列表采样时列表中的项数（超出视频长度或落在同一帧的项不会输出）
+    size_t filesDone;
+    size_t filesFailed;     // 无法打开或读取不到画面尺寸的文件
+    size_t filesSkipped;    // 清单表明已经完成、直接跳过的文件
+    size_t filesResumed;    // 从上次的检查点继续的文件
+    size_t filesSegmented;  // 切成几段并行解码的文件
+    size_t indexesLoaded;   // 读取已有帧索引的文件
+    size_t indexesBuilt;    // 本次建立帧索引的文件
+    uint64_t filesWritten;      // 写出线程写出的图像文件数与字节数
+    uint64_t bytesWritten;
+    uint64_t writeFailures;     // 无法写出的图像文件
+    size_t writeQueuePeak;      // 写出队列的最大深度（文件数）
+    double writeBytesPerSecond; // 写文件的速度：字节数 / 写出线程的平均忙碌时间
+    size_t memoryPeakBytes;     // 在途帧与待写数据占用的最大值（未设预算时同样统计）
+    uint64_t memoryWaits;       // 解码线程因预算用尽而等待的次数与总时间
+    double memoryWaitSeconds;
+    std::string traceSummary;   // 启用跟踪时为各阶段的耗时统计表
+
+    ExtractionStats() : poolHits(0), poolMisses(0), dedupKept(0), dedupDropped(0), framesDecoded(0), framesSaved(0), framesRequested(0),
+                        filesDone(0), filesFailed(0), filesSkipped(0), filesResumed(0), filesSegmented(0), indexesLoaded(0), indexesBuilt(0),
+                        filesWritten(0), bytesWritten(0), writeFailures(0), writeQueuePeak(0), writeBytesPerSecond(0.0),
+                        memoryPeakBytes(0), memoryWaits(0), memoryWaitSeconds(0.0) {}
+};
+
+// 进度与状态回调，全部在工作线程上调用，可能并发
+class IExtractionObserver {
+public:
+    virtual ~IExtractionObserver() {}
+
+    // 汇总进度（0-100）变化时调用
+    virtual void OnProgress(int percent) { (void)percent; }
+
+    // 开始处理第 index 个文件；active 为正在处理的文件数，done 为已完成的文件数
+    virtual void OnFileStarted(size_t index, size_t active, size_t done) { (void)index; (void)active; (void)done; }
+
+    // 第 index 个文件处理完毕；ok 为 false 表示无法打开，kept / dropped 为去重结果（未启用去重时 dropped 为 0）
+    virtual void OnFileFinished(size_t index, bool ok, int kept, int dropped) { (void)index; (void)ok; (void)kept; (void)dropped; }
+
+    // 第 index 个文件无法打开，message 为解码器给出的原因；随后仍会以 ok 为 false 调用 OnFileFinished
+    virtual void OnFileError(size_t index, const std::string& message) { (void)index; (void)message; }
+};
+
+// 为一个编码线程的一个图像输出创建编码器
+typedef std::function<std::unique_ptr<IImageEncoder>(const OutputSpec&)> EncoderFactory;
+
+// 解码阶段交给编码线程的一帧：像素位于帧缓冲池中，编码完成后归还
+// output 为输出下标，编码线程按它选择编码器；
+// 打包输出时 archive 非空，编码结果追加到归档而不是写入 filePath；
+// 张量输出时 tensor 非空，像素按通道顺序写入映射文件的第 slot 帧，不做编码。
+// 归档与张量文件由解码线程与所有未完成的任务共同持有，最后一个引用释放时写入索引；
+// manifest 为这个输出的续传检查点，写出后调用 Done()
+struct EncodeJob {
+    FrameBuffer* buffer;
+    FramePool* pool;
+    size_t charge;          // 计入内存预算的字节数，归还缓冲时一并归还
+    FrameView view;
+    size_t output;
+    std::string filePath;
+    std::shared_ptr<ManifestTracker> manifest;
+    std::shared_ptr<FrameArchiveWriter> archive;
+    std::shared_ptr<TensorWriter> tensor;
+    size_t slot;
+    int frameIndex;
+    int64_t timestamp;
+};
+
+// 一个输出在当前文件上的状态，由处理该文件的解码线程独占；分段解码时每段一份，输出文件与清单各段共用
+struct FileOutput {
+    RoiRect roi;            // 调整到画面范围内的 ROI
+    int width;              // 输出尺寸
+    int height;
+    int format;             // 缓冲的像素格式：FRAME_BGRX32，灰度输出为 FRAME_GRAY8
+    int stride;
+    bool resize;
+    ImageResizer resizer;
+    size_t source;          // ROI 与像素格式都相同的输出共用的转换结果下标
+    bool fused;             // 缩放输出独占它的源：直接从解码帧一遍完成裁剪、转换与缩放，不生成转换结果
+    FramePool* pool;
+    std::string dir;        // 图像输出的子目录；张量与归档输出的文件名（不含扩展名）
+    std::shared_ptr<ManifestTracker> manifest;     // 声明在写入器之前：析构时最后释放
+    std::shared_ptr<TensorWriter> tensor;
+    std::shared_ptr<FrameArchiveWriter> archive;
+    bool failed;            // 输出文件无法创建，跳过这个输出
+
+    FileOutput() : width(0), height(0), format(FRAME_BGRX32), stride(0), resize(false), source(0), fused(false), pool(nullptr), failed(false) {}
+};
+
+class ExtractionEngine {
+public:
+    explicit ExtractionEngine(IDecoderBackend& backend)
+        : m_backend(backend), m_probeCache(nullptr), m_observer(nullptr), m_sink(&m_diskSink), m_maxDecoders(4),
+          m_encoderThreads(0), m_writerThreads(1) {}
+
+    // 默认使用内置编码器（CreateImageEncoder）
+    void SetEncoderFactory(EncoderFactory factory) { m_encoderFactory = factory; }
+
+    // 探测 job.infos 为空的任务时使用的磁盘缓存，可以为空
+    void SetProbeCache(ProbeCache* cache) { m_probeCache = cache; }
+
+    void SetObserver(IExtractionObserver* observer) { m_observer = observer; }
+
+    // 图像文件的写出目标，默认直接写磁盘；为空时恢复默认
+    void SetFileSink(IFileSink* sink) { m_sink = sink ? sink : &m_diskSink; }
+
+    // 解码线程数上限、编码线程数（0 表示 CPU 核心数）与写出线程数
+    void SetThreadCounts(size_t maxDecoders, size_t encoderThreads, size_t writerThreads = 1) {
+        m_maxDecoders = std::max<size_t>(1, maxDecoders);
+        m_encoderThreads = encoderThreads;
+        m_writerThreads = std::max<size_t>(1, writerThreads);
+    }
+
+    // 执行一次批量提取，stop 置位后尽快结束（已入队的帧仍会写完）。
+    // 任务本身无效（没有输出、无法创建输出目录）时返回 false 并给出说明。
+    bool Run(const ExtractionJob& job, const std::atomic<bool>& stop, ExtractionStats* stats, std::string* error) {
+        *stats = ExtractionStats();
+        if (job.outputs.empty()) return Fail(error, "没有输出");
+        if (job.sampling.mode == SAMPLE_LIST && job.frameLists.size() != job.files.size()) return Fail(error, "帧列表与视频文件数不一致");
+        if (job.outputDir.empty() || !CreateDirectoryUtf8(job.outputDir)) return Fail(error, "无法创建输出目录: " + job.outputDir);
+
+        Context ctx(job);
+        std::unique_ptr<PipelineTracer> tracer;
+        if (job.trace) {
+            tracer.reset(new PipelineTracer());
+            ctx.tracer = tracer.get();
+        }
+        for (size_t o = 0; o < job.outputs.size(); ++o) {
+            std::string dir = job.outputDir;
+            if (!job.outputs[o].dir.empty()) {
+                dir = JoinPath(dir, job.outputs[o].dir);
+                if (!CreateDirectoryUtf8(dir)) return Fail(error, "无法创建输出目录: " + dir);
+            }
+            ctx.outputDirs.push_back(dir);
+            ctx.extensions.push_back(ImageFormatExtension(job.outputs[o].encoder.format, job.outputs[o].channels == CHANNELS_GRAY));
+        }
+
+        // 没有元数据时先并行探测（分组与进度都需要分辨率和时长）
+        if (job.infos.size() == job.files.size()) {
+            ctx.infos = job.infos;
+        }
+        else {
+            ProbeFilesParallel(job.files, m_probeCache, WorkerPool::DefaultThreadCount(), ctx.infos, stop,
+                [&](size_t i, VideoProbeInfo& info) { ProbeVideo(m_backend, job.files[i], &info); },
+                [&] { m_backend.ThreadInit(); },
+                [&] { m_backend.ThreadExit(); });
+        }
+
+        // 按分辨率分组：同组文件的输出尺寸相同，共用只设置一次尺寸的缓冲池
+        ctx.groupOf.assign(job.files.size(), 0);
+        std::vector<std::pair<uint32_t, uint32_t>> groupSizes;
+        for (size_t i = 0; i < job.files.size(); ++i) {
+            std::pair<uint32_t, uint32_t> size(ctx.infos[i].width, ctx.infos[i].height);
+            ctx.totalHns += ctx.infos[i].durationHns;
+            size_t g = std::find(groupSizes.begin(), groupSizes.end(), size) - groupSizes.begin();
+            if (g == groupSizes.size()) groupSizes.push_back(size);
+            ctx.groupOf[i] = g;
+        }
+        std::vector<size_t> order(job.files.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return ctx.groupOf[a] < ctx.groupOf[b]; });
+
+        // 流水线：K 个解码线程并行处理不同文件（空闲时窃取其他线程的待处理文件），
+        // N 个编码线程从共享的有界队列中取帧并编码（每个编码线程持有自己的编码器），
+        // 图像文件编码到内存后交给写出线程，编码线程不等待文件的创建与写入。
+        // 解码线程数有上限，队列、缓冲池与待写数据也有上限，内存占用因此有界；
+        // 设置了内存预算时，在途帧与待写数据的总字节数另受预算限制。
+        // 文件名由帧序号决定，与编码完成的先后无关。
+        size_t encoderCount = m_encoderThreads > 0 ? m_encoderThreads : WorkerPool::DefaultThreadCount();
+        // 长视频可能拆成几段，解码线程数不受文件数限制
+        size_t decoderCount = std::min(m_maxDecoders, encoderCount);
+        if (job.segmentSeconds <= 0.0 || job.dedupThreshold > 0.0) decoderCount = std::min(decoderCount, job.files.size());
+        decoderCount = std::max<size_t>(1, decoderCount);
+        ctx.decoderCount = decoderCount;
+        BoundedQueue<EncodeJob> encodeQueue(encoderCount * 2);
+        ctx.encodeQueue = &encodeQueue;
+        for (size_t i = 0; i < groupSizes.size() * job.outputs.size(); ++i) {
+            ctx.pools.push_back(std::unique_ptr<FramePool>(new FramePool(encodeQueue.Capacity() + encoderCount + decoderCount)));
+        }
+
+        MemoryBudget budget(job.memoryBudgetBytes);
+        ctx.budget = &budget;
+        WriteBehindQueue writer(*m_sink, job.durability, job.writeBufferBytes, &budget);
+        writer.Start(m_writerThreads, tracer.get());
+
+        WorkerPool encoders;
+        encoders.Start(encoderCount, [&](size_t worker) {
+            m_backend.ThreadInit();
+            TraceBuffer* trace = tracer ? tracer->RegisterThread("encoder", worker) : nullptr;
+            {
+                // 每个图像输出一个编码器，张量输出不需要编码器
+                std::vector<std::unique_ptr<IImageEncoder>> imageEncoders(job.outputs.size());
+                for (size_t o = 0; o < job.outputs.size(); ++o) {
+                    if (job.outputs[o].tensor == TENSOR_NONE) imageEncoders[o] = CreateEncoder(job.outputs[o]);
+                }
+                std::vector<uint8_t> bytes;
+                EncodeJob item;
+                while (encodeQueue.Pop(item)) {
+                    IImageEncoder* encoder = imageEncoders[item.output].get();
+                    bool ok = false;
+                    bool submitted = false;     // 交给写出线程后由它通知检查点
+                    if (item.tensor) {
+                        TraceScope scope(trace, TRACE_WRITE);
+                        ok = item.tensor->Write(item.slot, item.view);
+                    }
+                    else if (encoder && item.archive) {
+                        {
+                            TraceScope scope(trace, TRACE_ENCODE);
+                            ok = encoder->Encode(item.view, bytes);
+                        }
+                        TraceScope scope(trace, TRACE_WRITE);
+                        ok = ok && item.archive->Append(item.frameIndex, item.timestamp, bytes.data(), bytes.size());
+                    }
+                    else if (encoder) {
+                        WriteRequest* request = writer.Acquire();
+                        {
+                            TraceScope scope(trace, TRACE_ENCODE);
+                            ok = encoder->Encode(item.view, request->bytes);
+                        }
+                        if (ok) {
+                            request->path = item.filePath;
+                            request->manifest = item.manifest;
+                            request->frameIndex = item.frameIndex;
+                            writer.Submit(request);
+                            submitted = true;
+                        }
+                        else {
+                            writer.Recycle(request);
+                        }
+                    }
+                    item.pool->Release(item.buffer);
+                    budget.Release(item.charge);
+                    // 先释放写入器再释放检查点：最后一个检查点引用写清单时文件已经完整
+                    item.archive.reset();
+                    item.tensor.reset();
+                    if (item.manifest && !submitted) item.manifest->Done(item.frameIndex, ok);
+                    item.manifest.reset();
+                }
+            }
+            m_backend.ThreadExit();
+        });
+
+        WorkStealingScheduler scheduler(order, decoderCount);
+        WorkerPool decoders;
+        decoders.Start(decoderCount, [&](size_t worker) {
+            m_backend.ThreadInit();
+            TraceBuffer* trace = tracer ? tracer->RegisterThread("decoder", worker) : nullptr;
+            // 优先解码其他线程拆出的分段；调度器中没有文件后，等到不会再有新的分段才退出
+            size_t fileIndex;
+            SegmentTask segment;
+            for (;;) {
+                if (ctx.segments.TryPop(segment)) {
+                    RunSegment(ctx, segment.file, segment.segment, nullptr, stop, trace);
+                    segment.file.reset();
+                    continue;
+                }
+                ctx.segments.BeginProducing();
+                bool next = !stop && scheduler.Next(worker, fileIndex);
+                if (next) {
+                    size_t active = ++ctx.filesActive;
+                    if (m_observer) m_observer->OnFileStarted(fileIndex, active, ctx.filesDone.load());
+                    ExtractOneFile(ctx, fileIndex, stop, trace);
+                }
+                ctx.segments.EndProducing();
+                if (next) continue;
+                if (!ctx.segments.WaitPop(segment, stop)) break;
+                RunSegment(ctx, segment.file, segment.segment, nullptr, stop, trace);
+                segment.file.reset();
+            }
+            m_backend.ThreadExit();
+        });
+        decoders.Join();
+
+        // 等待编码线程处理完队列中剩余的帧，再等写出线程写完
+        encodeQueue.Close();
+        encoders.Join();
+        writer.Close();
+
+        for (size_t g = 0; g < ctx.pools.size(); ++g) {
+            stats->poolHits += ctx.pools[g]->Hits();
+            stats->poolMisses += ctx.pools[g]->Misses();
+        }
+        for (size_t i = 0; i < ctx.dedupCounts.size(); ++i) {
+            stats->dedupKept += ctx.dedupCounts[i].first;
+            stats->dedupDropped += ctx.dedupCounts[i].second;
+        }
+        stats->framesDecoded = ctx.framesDecoded;
+        stats->framesSaved = ctx.framesSaved;
+        for (size_t i = 0; i < job.frameLists.size(); ++i) stats->framesRequested += job.frameLists[i].Count();
+        stats->filesDone = ctx.filesDone;
+        stats->filesFailed = ctx.filesFailed;
+        stats->filesSkipped = ctx.filesSkipped;
+        stats->filesResumed = ctx.filesResumed;
+        stats->filesSegmented = ctx.filesSegmented;
+        stats->indexesLoaded = ctx.indexesLoaded;
+        stats->indexesBuilt = ctx.indexesBuilt;
+        stats->filesWritten = writer.FilesWritten();
+        stats->bytesWritten = writer.BytesWritten();
+        stats->writeFailures = writer.Failures();
+        stats->writeQueuePeak = writer.PeakDepth();
+        stats->memoryPeakBytes = budget.Peak();
+        stats->memoryWaits = budget.Waits();
+        stats->memoryWaitSeconds = budget.WaitSeconds();
+        if (writer.BusySeconds() > 0.0) stats->writeBytesPerSecond = stats->bytesWritten / writer.BusySeconds() * m_writerThreads;
+        if (job.dedupThreshold > 0.0) WriteDedupSummary(ctx);
+        if (job.sampling.mode == SAMPLE_LIST) WriteFrameListSummary(ctx);
+        if (tracer) {
+            // 所有记录线程都已结束，可以导出
+            stats->traceSummary = tracer->FormatSummary();
+            tracer->WriteChromeTrace(JoinPath(job.outputDir, "pipeline_trace.json"));
+            FILE* fp = OpenFileUtf8(JoinPath(job.outputDir, "pipeline_trace_summary.txt"), "wb");
+            if (fp) {
+                fputs(stats->traceSummary.c_str(), fp);
+                fclose(fp);
+            }
+        }
+        return true;
+    }
+
+private:
+    ExtractionEngine(const ExtractionEngine&) = delete;
+    ExtractionEngine& operator=(const ExtractionEngine&) = delete;
+
+    // 一个视频在一个解码线程上的输出状态：各输出的 ROI、尺寸、缓冲池与输出文件，
+    // ROI 与像素格式相同的输出共用一次颜色转换的结果（sources），需要缩放的输出从它缩放
+    struct FrameEmitter {
+        size_t fileIndex;
+        std::string videoBaseName;
+        bool timeNames;             // 文件名附加毫秒时间戳
+        std::vector<FileOutput> outputs;
+        std::vector<RoiRect> sourceRois;
+        std::vector<int> sourceFormats;
+        std::vector<std::vector<uint8_t>> sourceBuffers;
+        std::vector<FrameView> sources;
+        std::vector<EncodeJob> jobs;
+
+        FrameEmitter() : fileIndex(0), timeNames(false) {}
+    };
+
+    // 一个视频本次采样的统计：选中的帧数（含去重丢弃的帧）、解码的帧数与跳转次数
+    struct SamplingCounts {
+        int selected;
+        int decoded;
+        int seeks;
+
+        SamplingCounts() : selected(0), decoded(0), seeks(0) {}
+    };
+
+    // 切成几段并行解码的视频：各段从 emitter 复制自己的输出状态，最后结束的一段收尾
+    struct SegmentedFile {
+        FrameEmitter emitter;
+        uint64_t expectedHns;
+        int64_t firstTimestamp;
+        double frameDuration;
+        std::vector<int64_t> bounds;        // 每段起点的时间戳，第 0 段从第一帧开始
+        std::atomic<size_t> remaining;      // 尚未结束的段数
+        std::atomic<bool> failed;           // 有一段无法打开，清单不标记完成
+        std::atomic<int> selected;          // 各段的 SamplingCounts 之和
+        std::atomic<int> decoded;
+        std::atomic<int> seeks;
+
+        SegmentedFile() : expectedHns(0), firstTimestamp(0), frameDuration(0.0), remaining(0), failed(false),
+                          selected(0), decoded(0), seeks(0) {}
+    };
+
+    struct SegmentTask {
+        std::shared_ptr<SegmentedFile> file;
+        size_t segment;
+
+        SegmentTask() : segment(0) {}
+    };
+
+    // 一次批量提取中各解码线程共享的状态
+    struct Context {
+        const ExtractionJob& job;
+        std::vector<VideoProbeInfo> infos;
+        std::vector<std::string> outputDirs;    // 每个输出的根目录
+        std::vector<std::string> extensions;    // 每个输出的文件扩展名，由编码器决定
+        std::vector<std::pair<int, int>> dedupCounts;  // 文件下标 -> (保存, 丢弃)，每个文件只由一个线程写入
+        std::vector<SamplingCounts> samplingCounts;    // 文件下标 -> 本次采样的统计，写入方式同上
+
+        BoundedQueue<EncodeJob>* encodeQueue;
+        std::vector<std::unique_ptr<FramePool>> pools;  // 每个分辨率组的每个输出一个缓冲池：下标为 组 * 输出数 + 输出
+        std::vector<size_t> groupOf;                    // 文件下标 -> 分辨率组
+        PipelineTracer* tracer;                         // 未启用跟踪时为空
+        MemoryBudget* budget;
+        size_t decoderCount;
+        AppendedTaskQueue<SegmentTask> segments;        // 等待解码的分段
+
+        // 汇总进度：所有文件已处理的时长之和 / 总时长
+        uint64_t totalHns;
+        std::atomic<uint64_t> processedHns;
+        std::atomic<int> lastProgress;
+        std::atomic<size_t> filesDone;
+        std::atomic<size_t> filesActive;
+        std::atomic<size_t> filesFailed;
+        std::atomic<size_t> filesSkipped;
+        std::atomic<size_t> filesResumed;
+        std::atomic<size_t> filesSegmented;
+        std::atomic<size_t> indexesLoaded;
+        std::atomic<size_t> indexesBuilt;
+        std::atomic<uint64_t> framesDecoded;
+        std::atomic<uint64_t> framesSaved;
+
+        explicit Context(const ExtractionJob& j)
+            : job(j), dedupCounts(j.files.size(), std::make_pair(0, 0)), samplingCounts(j.files.size()), encodeQueue(nullptr), tracer(nullptr), budget(nullptr), decoderCount(1),
+              totalHns(0), processedHns(0), lastProgress(-1), filesDone(0), filesActive(0), filesFailed(0),
+              filesSkipped(0), filesResumed(0), filesSegmented(0), indexesLoaded(0), indexesBuilt(0), framesDecoded(0), framesSaved(0) {}
+    };
+
+    static bool Fail(std::string* error, const std::string& message) {
+        if (error) *error = message;
+        return false;
+    }
+
+    std::unique_ptr<IImageEncoder> CreateEncoder(const OutputSpec& spec) {
+        if (m_encoderFactory) return m_encoderFactory(spec);
+        return CreateImageEncoder(spec.encoder);
+    }
+
+    // 累加已处理时长，汇总百分比变化时通知前端
+    void AddProgress(Context& ctx, uint64_t deltaHns) {
+        uint64_t done = ctx.processedHns += deltaHns;
+        if (ctx.totalHns == 0) return;
+        int progress = (int)std::min<uint64_t>(100, done * 100 / ctx.totalHns);
+        int last = ctx.lastProgress.load();
+        if (progress != last && ctx.lastProgress.compare_exchange_strong(last, progress) && m_observer) {
+            m_observer->OnProgress(progress);
+        }
+    }
+
+    // 一个文件处理完毕（包括跳过、无法打开与分段解码的最后一段）
+    void FileFinished(Context& ctx, size_t fileIndex, bool ok, int kept, int dropped) {
+        if (m_observer) m_observer->OnFileFinished(fileIndex, ok, kept, dropped);
+        ctx.filesActive--;
+        ctx.filesDone++;
+    }
+
+    // 这个视频相邻两次保存之间的平均帧数；帧率未知时按时间采样为 0
+    static double SpacingFrames(const Context& ctx, size_t fileIndex, double fps) {
+        const SamplingOptions& sampling = ctx.job.sampling;
+        if (sampling.mode == SAMPLE_FRAMES) return sampling.interval + 1.0;
+        if (sampling.mode == SAMPLE_LIST) return FrameListSelector(ctx.job.frameLists[fileIndex]).Spacing(fps > 0.0 ? 1e7 / fps : 0.0);
+        return sampling.PeriodHns() * fps / 1e7;
+    }
+
+    // 这个视频分几段并行解码，1 表示不分段。
+    // 去重要依次比较相邻的保存帧、续传要从检查点顺序继续，都不分段；
+    // 采样稀疏时跳转模式只解码目标附近的帧，也不分段
+    static int SegmentCount(const Context& ctx, size_t fileIndex, uint64_t durationHns, double fps, const SamplingResume& resume) {
+        const ExtractionJob& job = ctx.job;
+        if (job.segmentSeconds <= 0.0 || ctx.decoderCount < 2 || job.dedupThreshold > 0.0 || resume.frame > 0 || fps <= 0.0) return 1;
+        if (SpacingFrames(ctx, fileIndex, fps) / fps > kSegmentMaxSpacingSeconds) return 1;
+        uint64_t count = durationHns / (uint64_t)(job.segmentSeconds * 10000000.0);
+        return (int)std::min<uint64_t>(count, ctx.decoderCount);
+    }
+
+    // 解码一个文件，把需要保存的帧送入编码队列；trace 为本线程的跟踪缓冲，未启用跟踪时为空
+    void ExtractOneFile(Context& ctx, size_t fileIndex, const std::atomic<bool>& stop, TraceBuffer* trace) {
+        TraceScope fileScope(trace, TRACE_FILE);
+        const ExtractionJob& job = ctx.job;
+        const std::string& currentFile = job.files[fileIndex];
+        uint64_t expectedHns = ctx.infos[fileIndex].durationHns;
+        std::string videoBaseName = FileStem(currentFile);  // 视频文件名（不含扩展名）
+        const FrameList* frameList = job.sampling.mode == SAMPLE_LIST ? &job.frameLists[fileIndex] : nullptr;
+
+        // 续传：每个输出的清单都与本次的来源和设置一致且已完成时跳过这个视频；
+        // 否则从所有输出都已写出的检查点继续。张量与归档输出的清单只在完成时记录检查点，
+        // 它们未完成时检查点为 0，整个视频从头开始
+        ExtractManifest identity;
+        identity.source = currentFile;
+        GetFileStamp(currentFile, &identity.size, &identity.mtime);
+        std::vector<ExtractManifest> manifests(job.outputs.size(), identity);
+        SamplingResume resume;
+        bool complete = job.resume;
+        for (size_t o = 0; o < manifests.size(); ++o) {
+            manifests[o].settings = ExtractionSettingsHash(job.sampling, job.dedupThreshold, job.outputs[o], frameList ? frameList->Hash() : 0);
+            ExtractManifest previous;
+            bool valid = job.resume && ReadManifest(ManifestPath(ctx, o, videoBaseName), &previous) && previous.Matches(manifests[o]);
+            if (!valid || !previous.complete) complete = false;
+            if (!valid) previous.lastFrame = 0;
+            if (o == 0 || previous.lastFrame < resume.frame) {
+                resume.frame = previous.lastFrame;
+                resume.timestamp = previous.lastTimestamp;
+            }
+        }
+        if (complete) {
+            ctx.filesSkipped++;
+            AddProgress(ctx, expectedHns);
+            FileFinished(ctx, fileIndex, true, 0, 0);
+            return;
+        }
+        for (size_t o = 0; o < manifests.size(); ++o) {
+            manifests[o].lastFrame = resume.frame;
+            manifests[o].lastTimestamp = resume.timestamp;
+        }
+
+        std::unique_ptr<IVideoDecoder> reader = m_backend.CreateDecoder();
+        VideoProbeInfo info;
+        if (!reader || !reader->Open(currentFile) || !reader->GetInfo(&info) || info.width == 0 || info.height == 0) {
+            ctx.filesFailed++;
+            std::string reason = reader ? reader->OpenError() : std::string();
+            if (m_observer && !reason.empty()) m_observer->OnFileError(fileIndex, reason);
+            AddProgress(ctx, expectedHns);
+            FileFinished(ctx, fileIndex, false, 0, 0);
+            return;
+        }
+        int vW = (int)info.width, vH = (int)info.height;
+        double vFps = info.fps;
+        double frameDuration = vFps > 0.0 ? 10000000.0 / vFps : 0.0;
+
+        // 长视频按关键帧切成几段，其他段交给空闲的解码线程，本线程解码第 0 段
+        std::shared_ptr<SegmentedFile> segmented;
+        int segmentCount = SegmentCount(ctx, fileIndex, expectedHns, vFps, resume);
+        if (segmentCount > 1) {
+            segmented = std::make_shared<SegmentedFile>();
+            if (!PlanSegments(*reader, frameDuration, expectedHns, segmentCount, &segmented->firstTimestamp, &segmented->bounds)) {
+                segmented.reset();
+            }
+        }
+
+        // 每个输出在本文件上的 ROI、输出尺寸、缓冲池与输出文件；
+        // ROI 与像素格式相同的输出共用一次颜色转换的结果（sources），需要缩放的输出从它缩放
+        FrameEmitter emitter;
+        emitter.fileIndex = fileIndex;
+        emitter.videoBaseName = videoBaseName;
+        emitter.timeNames = frameList ? !frameList->times.empty() : job.sampling.mode != SAMPLE_FRAMES;
+        emitter.outputs.resize(job.outputs.size());
+        std::vector<FileOutput>& outputs = emitter.outputs;
+        std::vector<RoiRect>& sourceRois = emitter.sourceRois;
+        std::vector<int>& sourceFormats = emitter.sourceFormats;
+        for (size_t o = 0; o < outputs.size(); ++o) {
+            const OutputSpec& spec = job.outputs[o];
+            FileOutput& out = outputs[o];
+            out.roi = spec.FrameRoi(vW, vH);
+            spec.OutputSize(out.roi, &out.width, &out.height);
+            // 灰度输出直接取 Y 平面，缓冲每像素 1 字节
+            out.format = spec.PixelFormat();
+            out.stride = out.width * FramePixelBytes(out.format);
+            int roiWidth = out.roi.right - out.roi.left, roiHeight = out.roi.bottom - out.roi.top;
+            out.resize = out.width != roiWidth || out.height != roiHeight;
+            if (out.resize) out.resizer.Configure(roiWidth, roiHeight, out.width, out.height, spec.filter, out.format);
+            out.source = 0;
+            while (out.source < sourceRois.size() &&
+                   (memcmp(&sourceRois[out.source], &out.roi, sizeof(RoiRect)) != 0 || sourceFormats[out.source] != out.format)) {
+                out.source++;
+            }
+            if (out.source == sourceRois.size()) {
+                sourceRois.push_back(out.roi);
+                sourceFormats.push_back(out.format);
+            }
+
+            // 缓冲区只需容纳输出尺寸；同一分辨率组共用一个缓冲池
+            out.pool = ctx.pools[ctx.groupOf[fileIndex] * outputs.size() + o].get();
+            out.pool->Configure((size_t)out.stride * out.height);
+
+            // 张量输出或打包输出：输出目录下每个视频一个文件，不创建子目录
+            out.dir = JoinPath(ctx.outputDirs[o], videoBaseName);
+            if (spec.tensor != TENSOR_NONE) {
+                // 按时长与帧率预分配，结束时截断到实际保存的帧数
+                out.tensor = std::make_shared<TensorWriter>();
+                size_t capacity = frameList ? std::max<size_t>(1, frameList->Count()) : job.sampling.EstimateCount(expectedHns, vFps, 256);
+                if (!out.tensor->Open(out.dir + "." + TensorExtension(spec.tensor), spec.tensor, out.width, out.height,
+                                      spec.channels, capacity)) {
+                    out.tensor.reset();
+                    out.failed = true;
+                }
+            }
+            else if (spec.pack) {
+                out.archive = std::make_shared<FrameArchiveWriter>();
+                uint32_t flags = (spec.channels == CHANNELS_GRAY ? ARCHIVE_GRAY : 0) | (emitter.timeNames ? ARCHIVE_TIME_NAMES : 0);
+                if (!out.archive->Open(out.dir + "." + kArchiveExtension, spec.encoder.format, flags)) {
+                    out.archive.reset();
+                    out.failed = true;
+                }
+            }
+            else {
+                CreateDirectoryUtf8(out.dir);
+            }
+            if (!out.failed) {
+                // 分段时各段乱序写出，检查点没有意义，清单只记录是否完成
+                bool resumable = spec.tensor == TENSOR_NONE && !spec.pack && !segmented;
+                out.manifest = std::make_shared<ManifestTracker>(ManifestPath(ctx, o, videoBaseName), manifests[o], resumable);
+                if (out.tensor) out.manifest->SetPayload(out.tensor);
+                if (out.archive) out.manifest->SetPayload(out.archive);
+            }
+        }
+        std::vector<int> sourceUsers(sourceRois.size(), 0);
+        for (size_t o = 0; o < outputs.size(); ++o) sourceUsers[outputs[o].source]++;
+        for (size_t o = 0; o < outputs.size(); ++o) outputs[o].fused = outputs[o].resize && sourceUsers[outputs[o].source] == 1;
+        emitter.sourceBuffers.resize(sourceRois.size());
+        emitter.sources.resize(sourceRois.size());
+
+        // 分段解码的视频从头到尾都要解码，不需要帧索引
+        FrameIndex frameIndex;
+        bool indexed = !segmented && LoadFrameIndex(ctx, fileIndex, identity, *reader, resume, vFps, stop, &frameIndex);
+
+        // 从视频开头开始顺序读取
+        reader->Rewind();
+
+        if (segmented) {
+            segmented->emitter = emitter;
+            segmented->expectedHns = expectedHns;
+            segmented->frameDuration = frameDuration;
+            segmented->remaining = segmented->bounds.size();
+            ctx.filesSegmented++;
+            for (size_t k = 1; k < segmented->bounds.size(); ++k) {
+                SegmentTask task;
+                task.file = segmented;
+                task.segment = k;
+                ctx.segments.Push(task);
+            }
+            emitter.outputs.clear();
+            RunSegment(ctx, segmented, 0, reader.get(), stop, trace);
+            return;
+        }
+
+        // 按帧数：interval=0 表示保存每一帧，interval=1 表示每隔1帧保存（即保存第1、3、5...帧）
+        // 按秒/按帧率：按时间戳选帧，可变帧率视频也能得到均匀的间隔
+        // 跳过的帧只推进流与帧计数，不做缓冲区转换；
+        // 采样间隔远大于 GOP 长度时改为跳转到目标帧之前的关键帧再解码，帧序号与顺序读取相同；
+        // 有帧索引时直接按索引跳转；按帧列表时只向前解码到列表中的最后一帧
+        int candidateCount = 0;     // 采样选中的帧数（含去重丢弃的帧）
+        uint64_t reportedHns = 0;   // 本文件已计入汇总进度的时长
+        DuplicateFilter dedup(job.dedupThreshold);
+        // 去重只与上一个保存的帧比较：续传时先把检查点那一帧（上次保存的最后一帧）设为基准，
+        // 之后每一帧比较的对象与完整执行相同
+        if (dedup.Enabled() && resume.frame > 0) PrimeDuplicateFilter(*reader, resume, outputs[0].roi, stop, &dedup);
+        auto onKeep = [&](int frameIndex, int64_t timestamp, const FrameView& view) {
+            // 更新汇总进度
+            candidateCount++;
+            if (candidateCount % 5 == 0 && timestamp > 0) {
+                uint64_t pos = std::min<uint64_t>((uint64_t)timestamp, expectedHns);
+                if (pos > reportedHns) {
+                    AddProgress(ctx, pos - reportedHns);
+                    reportedHns = pos;
+                }
+            }
+
+            // 与上一个保存的帧几乎相同的帧直接丢弃，不做颜色转换也不编码
+            {
+                TraceScope scope(dedup.Enabled() ? trace : nullptr, TRACE_DEDUP);
+                if (!dedup.Accept(view, outputs[0].roi)) return;
+            }
+            EmitFrame(ctx, emitter, frameIndex, timestamp, view, trace);
+        };
+        // 跟踪时为解码、跳转与锁定计时
+        TracedFrameSource traced(*reader, trace);
+        IFrameSource& source = trace ? static_cast<IFrameSource&>(traced) : *reader;
+        SamplingStats samplingStats;
+        const SamplingResume* resumeFrom = resume.frame > 0 ? &resume : nullptr;
+        const FrameIndex* index = indexed ? &frameIndex : nullptr;
+        if (job.sampling.mode == SAMPLE_FRAMES) {
+            SampleVideo(*reader, source, index, FrameIntervalSelector(job.sampling.interval), frameDuration, stop, onKeep,
+                        &samplingStats, resumeFrom);
+        }
+        else if (frameList) {
+            SampleVideo(*reader, source, index, FrameListSelector(*frameList), frameDuration, stop, onKeep,
+                        &samplingStats, resumeFrom);
+        }
+        else {
+            SampleVideo(*reader, source, index, TimeIntervalSelector(job.sampling.PeriodHns()), frameDuration, stop, onKeep,
+                        &samplingStats, resumeFrom);
+        }
+        ctx.framesDecoded += samplingStats.decodedFrames;
+        ctx.samplingCounts[fileIndex].selected = candidateCount;
+        ctx.samplingCounts[fileIndex].decoded = samplingStats.decodedFrames;
+        ctx.samplingCounts[fileIndex].seeks = samplingStats.seeks;
+        if (resumeFrom) ctx.filesResumed++;
+        if (!stop) {
+            for (size_t o = 0; o < outputs.size(); ++o) {
+                if (outputs[o].manifest) outputs[o].manifest->Finish();
+            }
+        }
+        reader->Close();
+        // 释放解码线程持有的引用，队列中的帧编码完成后归档与张量文件自动写入索引
+        outputs.clear();
+
+        if (dedup.Enabled()) ctx.dedupCounts[fileIndex] = std::make_pair(dedup.Kept(), dedup.Dropped());
+        FileFinished(ctx, fileIndex, true, dedup.Kept(), dedup.Dropped());
+
+        // 文件处理完毕：把剩余时长计入汇总进度
+        if (expectedHns > reportedHns) AddProgress(ctx, expectedHns - reportedHns);
+    }
+
+    // 解码时间戳为 resume.timestamp 的帧设为去重的基准：先跳转到它之前的关键帧，找不到时从头顺序解码。
+    // 结束后回到视频开头；仍找不到时（视频与清单不符）不设基准
+    static void PrimeDuplicateFilter(IVideoDecoder& reader, const SamplingResume& resume, const RoiRect& roi,
+                                     const std::atomic<bool>& stop, DuplicateFilter* dedup) {
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            bool positioned = attempt == 0 ? reader.CanSeek() && reader.SeekTo(resume.timestamp) : reader.Rewind();
+            if (!positioned) continue;
+            int64_t timestamp = 0;
+            bool decoded = false;
+            while (!stop && (decoded = reader.Advance(&timestamp)) && timestamp < resume.timestamp) {}
+            FrameView view;
+            if (decoded && timestamp == resume.timestamp && reader.LockFrame(&view)) {
+                dedup->SetReference(view, roi);
+                reader.UnlockFrame();
+                break;
+            }
+        }
+        reader.Rewind();
+    }
+
+    // 取得视频的帧索引：有效的边车文件直接读取；没有时按 job.frameIndex 决定是否建立并保存，
+    // 优先只读取数据包，后端不支持时顺序解码一遍。保存失败（例如视频所在的目录只读）不影响本次使用
+    bool LoadFrameIndex(Context& ctx, size_t fileIndex, const ExtractManifest& identity, IVideoDecoder& reader,
+                        const SamplingResume& resume, double fps, const std::atomic<bool>& stop, FrameIndex* index) {
+        const ExtractionJob& job = ctx.job;
+        if (job.frameIndex == FRAME_INDEX_OFF) return false;
+        std::string indexPath = FrameIndexPath(job.files[fileIndex], job.indexDir);
+        if (ReadFrameIndex(indexPath, identity.size, identity.mtime, index)) {
+            ctx.indexesLoaded++;
+            return true;
+        }
+        if (job.frameIndex == FRAME_INDEX_AUTO && resume.frame == 0 && SpacingFrames(ctx, fileIndex, fps) <= kIndexMinSpacingFrames) {
+            return false;
+        }
+        std::vector<FrameIndexEntry> entries;
+        if (reader.ScanFrames(&entries)) {
+            index->Assign(entries);
+        }
+        else if (!BuildFrameIndexByDecoding(reader, stop, index)) {
+            return false;
+        }
+        if (!job.indexDir.empty()) CreateDirectoryUtf8(job.indexDir);
+        WriteFrameIndex(indexPath, identity.size, identity.mtime, *index);
+        ctx.indexesBuilt++;
+        return true;
+    }
+
+    // 有帧索引时按索引采样；索引与视频对不上时回到开头，从已经输出的最后一帧续传，改为 RunAdaptiveSampling
+    template <class Selector, class KeepFn>
+    static void SampleVideo(IVideoDecoder& reader, IFrameSource& source, const FrameIndex* index, Selector selector,
+                            double frameDuration, const std::atomic<bool>& stop, KeepFn onKeep, SamplingStats* stats,
+                            const SamplingResume* resume) {
+        SamplingResume reached = resume ? *resume : SamplingResume();
+        if (index) {
+            Selector indexed = selector;
+            if (RunIndexedSampling(source, *index, indexed, stop, onKeep, stats, resume, &reached) || stop) return;
+            reader.Rewind();
+        }
+        RunAdaptiveSampling(source, selector, frameDuration, stop, onKeep, stats, reached.frame > 0 ? &reached : nullptr);
+    }
+
+    // 解码分段视频的第 segment 段：reader 为空时（其他线程拆出的段）自己打开一个。
+    // 每段输出时间戳在 [bounds[segment], bounds[segment + 1]) 内的帧，帧序号与文件名与顺序解码相同；
+    // 最后结束的一段写清单的完成标记并通知前端
+    void RunSegment(Context& ctx, const std::shared_ptr<SegmentedFile>& file, size_t segment, IVideoDecoder* reader,
+                    const std::atomic<bool>& stop, TraceBuffer* trace) {
+        TraceScope fileScope(reader ? nullptr : trace, TRACE_FILE);
+        const ExtractionJob& job = ctx.job;
+        size_t fileIndex = file->emitter.fileIndex;
+        int64_t begin = file->bounds[segment];
+        int64_t end = segment + 1 < file->bounds.size() ? file->bounds[segment + 1] : INT64_MAX;
+        int64_t last = segment + 1 < file->bounds.size() ? end : file->firstTimestamp + (int64_t)file->expectedHns;
+        uint64_t spanHns = last > begin ? (uint64_t)(last - begin) : 0;     // 本段计入汇总进度的时长
+        uint64_t reportedHns = 0;
+
+        std::unique_ptr<IVideoDecoder> owned;
+        if (!reader && !stop) {
+            owned = m_backend.CreateDecoder();
+            if (owned && owned->Open(job.files[fileIndex])) reader = owned.get();
+            else file->failed = true;
+        }
+        if (reader && !stop) {
+            FrameEmitter emitter = file->emitter;
+            int candidateCount = 0;
+            auto onKeep = [&](int frameIndex, int64_t timestamp, const FrameView& view) {
+                candidateCount++;
+                if (candidateCount % 5 == 0) {
+                    uint64_t pos = std::min<uint64_t>((uint64_t)(timestamp - begin), spanHns);
+                    if (pos > reportedHns) {
+                        AddProgress(ctx, pos - reportedHns);
+                        reportedHns = pos;
+                    }
+                }
+                EmitFrame(ctx, emitter, frameIndex, timestamp, view, trace);
+            };
+            TracedFrameSource traced(*reader, trace);
+            IFrameSource& source = trace ? static_cast<IFrameSource&>(traced) : *reader;
+            SamplingStats samplingStats;
+            if (job.sampling.mode == SAMPLE_FRAMES) {
+                FrameIntervalSelector selector(job.sampling.interval);
+                RunSegmentSampling(source, selector, file->firstTimestamp, file->frameDuration, begin, end, stop, onKeep, &samplingStats);
+            }
+            else if (job.sampling.mode == SAMPLE_LIST) {
+                FrameListSelector selector(job.frameLists[fileIndex]);
+                RunSegmentSampling(source, selector, file->firstTimestamp, file->frameDuration, begin, end, stop, onKeep, &samplingStats);
+            }
+            else {
+                TimeIntervalSelector selector(job.sampling.PeriodHns());
+                RunSegmentSampling(source, selector, file->firstTimestamp, file->frameDuration, begin, end, stop, onKeep, &samplingStats);
+            }
+            ctx.framesDecoded += samplingStats.decodedFrames;
+            file->selected += candidateCount;
+            file->decoded += samplingStats.decodedFrames;
+            file->seeks += samplingStats.seeks;
+            reader->Close();
+        }
+        if (spanHns > reportedHns) AddProgress(ctx, spanHns - reportedHns);
+
+        if (--file->remaining == 0) {
+            if (!stop && !file->failed) {
+                for (size_t o = 0; o < file->emitter.outputs.size(); ++o) {
+                    if (file->emitter.outputs[o].manifest) file->emitter.outputs[o].manifest->Finish();
+                }
+            }
+            file->emitter.outputs.clear();
+            ctx.samplingCounts[fileIndex].selected = file->selected;
+            ctx.samplingCounts[fileIndex].decoded = file->decoded;
+            ctx.samplingCounts[fileIndex].seeks = file->seeks;
+            FileFinished(ctx, fileIndex, !file->failed, 0, 0);
+        }
+    }
+
+    // 把一帧送去所有输出：转换、缩放后放入编码队列
+    void EmitFrame(Context& ctx, FrameEmitter& emitter, int frameIndex, int64_t timestamp, const FrameView& view, TraceBuffer* trace) {
+        std::vector<FileOutput>& outputs = emitter.outputs;
+        std::vector<FrameView>& sources = emitter.sources;
+        std::vector<EncodeJob>& jobs = emitter.jobs;
+        ctx.framesSaved++;
+
+        // 直接从已锁定的解码缓冲读取 ROI：YUV 帧只转换 ROI 内的像素，RGB32 帧只复制 ROI 内的行与列，灰度输出只读 Y 平面。
+        // 先处理不缩放的输出，转换结果直接作为同一 ROI 缩放输出的源；独占源的缩放输出一遍完成，不经过转换结果。
+        // 所有输出处理完才入队，
+        // 入队之后缓冲区可能随时被编码线程归还
+        // 先按这一帧所有输出的缓冲大小申请内存预算，额度随缓冲一起归还；
+        // 缩放前的转换结果（sourceBuffers）也一并申请，它只在这一帧内使用，额度在本函数结束时归还
+        size_t frameBytes = 0;
+        for (size_t o = 0; o < outputs.size(); ++o) {
+            if (!outputs[o].failed) frameBytes += (size_t)outputs[o].stride * outputs[o].height;
+        }
+        size_t sourceBytes = SourceBufferBytes(emitter);
+        {
+            TraceScope scope(trace, TRACE_BUDGET_WAIT);
+            ctx.budget->Acquire(frameBytes + sourceBytes);
+        }
+
+        jobs.clear();
+        for (size_t s = 0; s < sources.size(); ++s) sources[s] = FrameView();
+        for (int pass = 0; pass < 2; ++pass) {
+            for (size_t o = 0; o < outputs.size(); ++o) {
+                FileOutput& out = outputs[o];
+                if (out.failed || out.resize != (pass == 1)) continue;
+                FrameView& source = sources[out.source];
+                EncodeJob item;
+                item.pool = out.pool;
+                item.charge = (size_t)out.stride * out.height;
+                {
+                    TraceScope scope(trace, TRACE_POOL_WAIT);
+                    item.buffer = out.pool->Acquire();
+                }
+                item.view = FrameView();
+                item.view.data = item.buffer->data;
+                item.view.width = out.width;
+                item.view.height = out.height;
+                item.view.stride = out.stride;
+                item.view.format = out.format;
+                bool ok;
+                if (!out.resize) {
+                    TraceScope scope(trace, TRACE_CONVERT);
+                    ok = ConvertRoi(view, out.roi, out.format, item.buffer->data, out.stride);
+                    if (ok && !source.data) source = item.view;
+                }
+                else if (out.fused) {
+                    TraceScope scope(trace, TRACE_RESIZE);
+                    ok = out.resizer.ResizeRoi(view, out.roi, item.buffer->data, out.stride);
+                }
+                else {
+                    if (!source.data) {
+                        const RoiRect& r = emitter.sourceRois[out.source];
+                        FrameView converted = FrameView();
+                        converted.width = r.right - r.left;
+                        converted.height = r.bottom - r.top;
+                        converted.format = out.format;
+                        converted.stride = converted.width * FramePixelBytes(out.format);
+                        emitter.sourceBuffers[out.source].resize((size_t)converted.stride * converted.height);
+                        uint8_t* pixels = emitter.sourceBuffers[out.source].data();
+                        converted.data = pixels;
+                        TraceScope scope(trace, TRACE_CONVERT);
+                        if (ConvertRoi(view, r, out.format, pixels, converted.stride)) source = converted;
+                    }
+                    TraceScope scope(trace, TRACE_RESIZE);
+                    ok = source.data && out.resizer.Resize(source, item.buffer->data, out.stride);
+                }
+                if (!ok) {
+                    out.pool->Release(item.buffer);
+                    ctx.budget->Release(item.charge);
+                    continue;
+                }
+                item.output = o;
+                item.frameIndex = frameIndex;
+                item.timestamp = timestamp;
+                item.manifest = out.manifest;
+                out.manifest->Submit(frameIndex, timestamp);
+                if (out.tensor) {
+                    item.tensor = out.tensor;
+                    item.slot = out.tensor->Reserve(frameIndex, timestamp);
+                }
+                else if (out.archive) {
+                    item.archive = out.archive;
+                }
+                else {
+                    // 按帧数采样使用"视频文件名_帧序号"格式作为文件名，按时间采样（或帧列表中有时间）再附加毫秒时间戳
+                    char name[512];
+                    if (!emitter.timeNames) {
+                        snprintf(name, sizeof(name), "%s_%05d.%s", emitter.videoBaseName.c_str(), frameIndex, ctx.extensions[o].c_str());
+                    }
+                    else {
+                        snprintf(name, sizeof(name), "%s_%05d_%08lldms.%s", emitter.videoBaseName.c_str(), frameIndex,
+                            (long long)((timestamp + 5000) / 10000), ctx.extensions[o].c_str());
+                    }
+                    item.filePath = JoinPath(out.dir, name);
+                }
+                jobs.push_back(item);
+            }
+        }
+        for (size_t j = 0; j < jobs.size(); ++j) {
+            TraceScope scope(trace, TRACE_QUEUE_WAIT);
+            if (!ctx.encodeQueue->Push(jobs[j])) {
+                jobs[j].pool->Release(jobs[j].buffer);
+                ctx.budget->Release(jobs[j].charge);
+                jobs[j].manifest->Done(jobs[j].frameIndex, false);
+            }
+        }
+        ctx.budget->Release(sourceBytes);
+        if (trace && !jobs.empty()) {
+            // 入队之后采样队列深度与所有缓冲池中使用中的缓冲数
+            size_t inUse = 0;
+            for (size_t g = 0; g < ctx.pools.size(); ++g) inUse += ctx.pools[g]->InUse();
+            trace->Counter(TRACE_COUNTER_QUEUE, (int64_t)ctx.encodeQueue->Size());
+            trace->Counter(TRACE_COUNTER_BUFFERS, (int64_t)inUse);
+            trace->Counter(TRACE_COUNTER_MEMORY, (int64_t)ctx.budget->Used());
+        }
+        jobs.clear();
+    }
+
+    // 这一帧需要的转换结果缓冲大小：源只被一遍完成的缩放输出或不缩放的输出使用时不需要转换结果
+    static size_t SourceBufferBytes(const FrameEmitter& emitter) {
+        const std::vector<FileOutput>& outputs = emitter.outputs;
+        size_t bytes = 0;
+        for (size_t s = 0; s < emitter.sourceRois.size(); ++s) {
+            bool converted = false, resized = false;
+            int format = 0;
+            for (size_t o = 0; o < outputs.size(); ++o) {
+                if (outputs[o].failed || outputs[o].source != s) continue;
+                if (!outputs[o].resize) converted = true;
+                else if (!outputs[o].fused) {
+                    resized = true;
+                    format = outputs[o].format;
+                }
+            }
+            if (resized && !converted) {
+                const RoiRect& r = emitter.sourceRois[s];
+                bytes += (size_t)(r.right - r.left) * FramePixelBytes(format) * (r.bottom - r.top);
+            }
+        }
+        return bytes;
+    }
+
+    // 第 o 个输出中这个视频的清单：与图像子目录（或张量、归档文件）同名，扩展名为 .manifest
+    static std::string ManifestPath(const Context& ctx, size_t o, const std::string& videoBaseName) {
+        return JoinPath(ctx.outputDirs[o], videoBaseName) + "." + kManifestExtension;
+    }
+
+    // 去重统计写入输出根目录下的 dedup_summary.csv（UTF-8）：文件, 保存帧数, 丢弃帧数
+    static void WriteDedupSummary(const Context& ctx) {
+        FILE* fp = OpenFileUtf8(JoinPath(ctx.job.outputDir, "dedup_summary.csv"), "wb");
+        if (!fp) return;
+        fputs("file,kept,dropped\n", fp);
+        for (size_t i = 0; i < ctx.job.files.size() && i < ctx.dedupCounts.size(); ++i) {
+            fprintf(fp, "\"%s\",%d,%d\n", ctx.job.files[i].c_str(), ctx.dedupCounts[i].first, ctx.dedupCounts[i].second);
+        }
+        fclose(fp);
+    }
+
+    // 帧列表采样的统计写入输出根目录下的 frame_list_summary.csv（UTF-8）：
+    // 文件, 列表项数, 选中帧数（去重之前）, 解码帧数, 跳转次数；本次跳过的已完成视频各项为 0
+    static void WriteFrameListSummary(const Context& ctx) {
+        FILE* fp = OpenFileUtf8(JoinPath(ctx.job.outputDir, "frame_list_summary.csv"), "wb");
+        if (!fp) return;
+        fputs("file,requested,selected,decoded,seeks\n", fp);
+        for (size_t i = 0; i < ctx.job.files.size() && i < ctx.samplingCounts.size(); ++i) {
+            const SamplingCounts& c = ctx.samplingCounts[i];
+            fprintf(fp, "\"%s\",%zu,%d,%d,%d\n", ctx.job.files[i].c_str(), ctx.job.frameLists[i].Count(), c.selected, c.decoded, c.seeks);
+        }
+        fclose(fp);
+    }
+
+    IDecoderBackend& m_backend;
+    EncoderFactory m_encoderFactory;
+    ProbeCache* m_probeCache;
+    IExtractionObserver* m_observer;
+    DiskFileSink m_diskSink;
+    IFileSink* m_sink;
+    size_t m_maxDecoders;
+    size_t m_encoderThreads;
+    size_t m_writerThreads;
+};
@@ -0,0 +1,196 @@
+/*
+    续传清单：每个输出为每个视频记录来源标识（路径、大小、修改时间、提取设置的哈希）
+    与最后一个已完整写出的帧，文件为输出目录下的 "视频文件名.manifest"。
+    再次执行同一任务时，清单全部标记完成的视频直接跳过，未完成的从检查点之前的关键帧继续。
+    编码线程乱序完成，检查点取"它及之前送出的帧都已写出"的最大帧序号；写入先写临时文件再替换，
+    中途崩溃时清单仍是上一次的完整内容。
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "file_util.h"
+#include "output_spec.h"
+#include "seek_sampling.h"
+
+static const char* const kManifestExtension = "manifest";
+
+// 检查点每前进这么多帧写一次清单
+static const int kManifestFlushFrames = 32;
+
+struct ExtractManifest {
+    std::string source;         // 视频路径（UTF-8）
+    uint64_t size;
+    int64_t mtime;
+    uint64_t settings;          // ExtractionSettingsHash()
+    int lastFrame;              // 最后一个已写出的帧序号，它之前采样到的帧也都已写出；0 表示没有
+    int64_t lastTimestamp;      // lastFrame 的时间戳
+    bool complete;              // 整个视频处理完毕
+
+    ExtractManifest() : size(0), mtime(0), settings(0), lastFrame(0), lastTimestamp(0), complete(false) {}
+
+    // 清单是否描述同一个视频与同一组设置
+    bool Matches(const ExtractManifest& other) const {
+        return source == other.source && size == other.size && mtime == other.mtime && settings == other.settings;
+    }
+};
+
+// 影响一个输出内容的设置（采样、去重、ROI、尺寸、格式……）的 FNV-1a 哈希；
+// selection 为按帧列表采样时这个视频的列表哈希（FrameList::Hash()），其他采样方式为 0
+inline uint64_t ExtractionSettingsHash(const SamplingOptions& sampling, double dedupThreshold, const OutputSpec& spec,
+                                       uint64_t selection = 0) {
+    char text[512];
+    int n = snprintf(text, sizeof(text), "v1|%d|%d|%.6f|%.6f|%s|%d|%d,%d,%d,%d|%dx%d|%d|%d,%d,%d|%d|%d|%d|%d",
+        sampling.mode, sampling.interval, sampling.value, dedupThreshold, spec.dir.c_str(),
+        spec.useRoi ? 1 : 0, spec.roi.left, spec.roi.top, spec.roi.right, spec.roi.bottom, spec.width, spec.height,
+        spec.filter, spec.encoder.format, spec.encoder.quality, spec.encoder.level, spec.gdiplus ? 1 : 0,
+        spec.tensor, spec.channels, spec.pack ? 1 : 0);
+    if (selection != 0 && n > 0 && (size_t)n < sizeof(text)) {
+        snprintf(text + n, sizeof(text) - n, "|%016llx", (unsigned long long)selection);
+    }
+    uint64_t hash = 14695981039346656037ull;
+    for (const char* p = text; *p; ++p) {
+        hash ^= (uint8_t)*p;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// 格式：第一行为版本，之后每行 键<TAB>值，source 放在最后（路径可能含任意字符）
+inline bool ReadManifest(const std::string& path, ExtractManifest* manifest) {
+    FILE* fp = OpenFileUtf8(path, "rb");
+    if (!fp) return false;
+    *manifest = ExtractManifest();
+    char line[4096];
+    bool ok = fgets(line, sizeof(line), fp) && strncmp(line, "# drag2frames manifest v1", 25) == 0;
+    bool hasSource = false;
+    while (ok && fgets(line, sizeof(line), fp)) {
+        std::string text(line);
+        while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) text.pop_back();
+        size_t tab = text.find('\t');
+        if (tab == std::string::npos) continue;
+        std::string key = text.substr(0, tab), value = text.substr(tab + 1);
+        if (key == "size") manifest->size = strtoull(value.c_str(), NULL, 10);
+        else if (key == "mtime") manifest->mtime = strtoll(value.c_str(), NULL, 10);
+        else if (key == "settings") manifest->settings = strtoull(value.c_str(), NULL, 16);
+        else if (key == "last_frame") manifest->lastFrame = atoi(value.c_str());
+        else if (key == "last_timestamp") manifest->lastTimestamp = strtoll(value.c_str(), NULL, 10);
+        else if (key == "complete") manifest->complete = value == "1";
+        else if (key == "source") {
+            manifest->source = value;
+            hasSource = true;
+        }
+    }
+    fclose(fp);
+    return ok && hasSource;
+}
+
+inline bool WriteManifest(const std::string& path, const ExtractManifest& manifest) {
+    std::string tmp = path + ".tmp";
+    FILE* fp = OpenFileUtf8(tmp, "wb");
+    if (!fp) return false;
+    fprintf(fp, "# drag2frames manifest v1\n");
+    fprintf(fp, "size\t%llu\nmtime\t%lld\nsettings\t%016llx\n", (unsigned long long)manifest.size,
+        (long long)manifest.mtime, (unsigned long long)manifest.settings);
+    fprintf(fp, "last_frame\t%d\nlast_timestamp\t%lld\ncomplete\t%d\n", manifest.lastFrame,
+        (long long)manifest.lastTimestamp, manifest.complete ? 1 : 0);
+    fprintf(fp, "source\t%s\n", manifest.source.c_str());
+    return (fclose(fp) == 0) && ReplaceFileUtf8(tmp, path);
+}
+
+// ==========================================
+// 一个输出在一个视频上的检查点：解码线程按顺序 Submit()，编码线程写出后 Done()。
+// 由解码线程与所有未完成的任务共同持有，最后一个引用释放时写入最终清单。
+// 张量与归档输出中途的内容无法续写，只在整个视频完成时写清单；
+// 它们的写入器交给 SetPayload() 持有，先于清单释放，清单标记完成时文件已经写完索引。
+// ==========================================
+class ManifestTracker {
+public:
+    // base 为本次的来源标识与设置，lastFrame 为续传起点（之前的帧已在上次写出）
+    ManifestTracker(const std::string& path, const ExtractManifest& base, bool resumable)
+        : m_path(path), m_manifest(base), m_resumable(resumable), m_finished(false), m_failed(false), m_sinceFlush(0) {
+        m_manifest.complete = false;
+        if (!m_resumable) {
+            m_manifest.lastFrame = 0;
+            m_manifest.lastTimestamp = 0;
+        }
+        WriteManifest(m_path, m_manifest);
+    }
+
+    ~ManifestTracker() {
+        m_payload.reset();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_manifest.complete = m_finished && !m_failed && m_pending.empty();
+        WriteManifest(m_path, m_manifest);
+    }
+
+    void SetPayload(const std::shared_ptr<void>& payload) { m_payload = payload; }
+
+    // 解码线程：这一帧已送去输出（帧序号递增）
+    void Submit(int frameIndex, int64_t timestamp) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Pending p;
+        p.frame = frameIndex;
+        p.timestamp = timestamp;
+        p.done = false;
+        m_pending.push_back(p);
+    }
+
+    // 编码线程：这一帧写出完毕；ok 为 false 时检查点不再前进，清单不会标记完成
+    void Done(int frameIndex, bool ok) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!ok) m_failed = true;
+        for (size_t i = 0; i < m_pending.size(); ++i) {
+            if (m_pending[i].frame == frameIndex) {
+                m_pending[i].done = ok;
+                break;
+            }
+        }
+        while (!m_failed && !m_pending.empty() && m_pending.front().done) {
+            if (m_resumable) {
+                m_manifest.lastFrame = m_pending.front().frame;
+                m_manifest.lastTimestamp = m_pending.front().timestamp;
+            }
+            m_pending.pop_front();
+            m_sinceFlush++;
+        }
+        if (m_resumable && m_sinceFlush >= kManifestFlushFrames) {
+            m_sinceFlush = 0;
+            WriteManifest(m_path, m_manifest);
+        }
+    }
+
+    // 解码线程：整个视频已读完（没有被停止）
+    void Finish() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_finished = true;
+    }
+
+private:
+    ManifestTracker(const ManifestTracker&) = delete;
+    ManifestTracker& operator=(const ManifestTracker&) = delete;
+
+    struct Pending {
+        int frame;
+        int64_t timestamp;
+        bool done;
+    };
+
+    std::string m_path;
+    ExtractManifest m_manifest;
+    bool m_resumable;
+    bool m_finished;
+    bool m_failed;
+    int m_sinceFlush;
+    std::deque<Pending> m_pending;
+    std::shared_ptr<void> m_payload;
+    std::mutex m_mutex;
+};
@@ -0,0 +1,386 @@
+/*
+    文件工具：UTF-8 路径的打开、重命名、目录、文件标识（大小 + 修改时间）与内存映射
+    Windows 下转换为宽字符 API，其他平台直接使用 POSIX 接口。
+*/
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+inline std::wstring Utf8ToWide(const std::string& s) {
+    if (s.empty()) return std::wstring();
+    int n = MultiByteToWideChar(CP_UTF8, 0, s.c_str(), (int)s.size(), NULL, 0);
+    std::wstring w(n, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, s.c_str(), (int)s.size(), &w[0], n);
+    return w;
+}
+
+inline std::string WideToUtf8(const std::wstring& w) {
+    if (w.empty()) return std::string();
+    int n = WideCharToMultiByte(CP_UTF8, 0, w.c_str(), (int)w.size(), NULL, 0, NULL, NULL);
+    std::string s(n, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, w.c_str(), (int)w.size(), &s[0], n, NULL, NULL);
+    return s;
+}
+#endif
+
+inline FILE* OpenFileUtf8(const std::string& path, const char* mode) {
+#ifdef _WIN32
+    std::wstring wmode(mode, mode + strlen(mode));
+    return _wfopen(Utf8ToWide(path).c_str(), wmode.c_str());
+#else
+    return fopen(path.c_str(), mode);
+#endif
+}
+
+// 把整块数据写入文件（覆盖已有文件）
+inline bool WriteFileUtf8(const std::string& path, const void* data, size_t size) {
+    FILE* fp = OpenFileUtf8(path, "wb");
+    if (!fp) return false;
+    bool ok = fwrite(data, 1, size, fp) == size;
+    return (fclose(fp) == 0) && ok;
+}
+
+// 把已写入 fp 的数据刷到磁盘（fflush + fsync），用于需要断电不丢的输出
+inline bool SyncFile(FILE* fp) {
+    if (fflush(fp) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(fp)) == 0;
+#else
+    return fsync(fileno(fp)) == 0;
+#endif
+}
+
+// 替换式重命名：目标已存在时覆盖
+inline bool ReplaceFileUtf8(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+    return MoveFileExW(Utf8ToWide(from).c_str(), Utf8ToWide(to).c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+#ifdef _WIN32
+static const char kPathSeparator = '\\';
+#else
+static const char kPathSeparator = '/';
+#endif
+
+inline bool IsPathSeparator(char c) {
+    return c == '/' || c == '\\';
+}
+
+// 拼接目录与文件名，目录为空时返回文件名
+inline std::string JoinPath(const std::string& dir, const std::string& name) {
+    if (dir.empty()) return name;
+    if (IsPathSeparator(dir[dir.size() - 1])) return dir + name;
+    return dir + kPathSeparator + name;
+}
+
+// 不含目录与扩展名的文件名，例如 "C:\\v\\a.mp4" -> "a"
+inline std::string FileStem(const std::string& path) {
+    size_t begin = path.size();
+    while (begin > 0 && !IsPathSeparator(path[begin - 1])) begin--;
+    size_t dot = path.rfind('.');
+    if (dot == std::string::npos || dot < begin) dot = path.size();
+    return path.substr(begin, dot - begin);
+}
+
+// 小写的扩展名（含点），没有扩展名时返回空串
+inline std::string FileExtension(const std::string& path) {
+    size_t dot = path.rfind('.');
+    if (dot == std::string::npos) return std::string();
+    for (size_t i = dot + 1; i < path.size(); ++i) {
+        if (IsPathSeparator(path[i])) return std::string();
+    }
+    std::string ext = path.substr(dot);
+    for (size_t i = 0; i < ext.size(); ++i) {
+        if (ext[i] >= 'A' && ext[i] <= 'Z') ext[i] = (char)(ext[i] - 'A' + 'a');
+    }
+    return ext;
+}
+
+// 以分隔符开头或带盘符（"C:"）的路径
+inline bool IsAbsolutePath(const std::string& path) {
+    return (!path.empty() && IsPathSeparator(path[0])) || (path.size() >= 2 && path[1] == ':');
+}
+
+// 所在目录，例如 "C:\\v\\a.mp4" -> "C:\\v"；不含目录时返回空串
+inline std::string ParentDirectory(const std::string& path) {
+    size_t end = path.size();
+    while (end > 0 && !IsPathSeparator(path[end - 1])) end--;
+    while (end > 1 && IsPathSeparator(path[end - 1])) end--;
+    return path.substr(0, end);
+}
+
+inline bool IsDirectoryUtf8(const std::string& path) {
+#ifdef _WIN32
+    DWORD attrs = GetFileAttributesW(Utf8ToWide(path).c_str());
+    return attrs != INVALID_FILE_ATTRIBUTES && (attrs & FILE_ATTRIBUTE_DIRECTORY) != 0;
+#else
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+#endif
+}
+
+// 创建一级目录；目录已存在时同样返回 true
+inline bool CreateDirectoryUtf8(const std::string& path) {
+#ifdef _WIN32
+    if (CreateDirectoryW(Utf8ToWide(path).c_str(), NULL)) return true;
+#else
+    if (mkdir(path.c_str(), 0755) == 0) return true;
+#endif
+    return IsDirectoryUtf8(path);
+}
+
+// 创建目录及缺少的各级上级目录；目录已存在时同样返回 true
+inline bool CreateDirectoriesUtf8(const std::string& path) {
+    if (path.empty() || IsDirectoryUtf8(path)) return true;
+    std::string parent = ParentDirectory(path);
+    if (!parent.empty() && parent.size() < path.size() && !CreateDirectoriesUtf8(parent)) return false;
+    return CreateDirectoryUtf8(path);
+}
+
+// 列出目录下的文件（不含子目录），按名称排序，返回完整路径
+inline bool ListFilesUtf8(const std::string& dir, std::vector<std::string>* files) {
+    std::vector<std::string> names;
+#ifdef _WIN32
+    WIN32_FIND_DATAW fd;
+    HANDLE hFind = FindFirstFileW(Utf8ToWide(JoinPath(dir, "*")).c_str(), &fd);
+    if (hFind == INVALID_HANDLE_VALUE) return false;
+    do {
+        if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) names.push_back(WideToUtf8(fd.cFileName));
+    } while (FindNextFileW(hFind, &fd));
+    FindClose(hFind);
+#else
+    DIR* d = opendir(dir.c_str());
+    if (!d) return false;
+    while (struct dirent* e = readdir(d)) {
+        std::string name = e->d_name;
+        if (name != "." && name != ".." && !IsDirectoryUtf8(JoinPath(dir, name))) names.push_back(name);
+    }
+    closedir(d);
+#endif
+    std::sort(names.begin(), names.end());
+    for (size_t i = 0; i < names.size(); ++i) files->push_back(JoinPath(dir, names[i]));
+    return true;
+}
+
+// 文件标识：大小与修改时间（不透明的 64 位值，只用于比较是否变化）
+inline bool GetFileStamp(const std::string& path, uint64_t* size, int64_t* mtime) {
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    if (!GetFileAttributesExW(Utf8ToWide(path).c_str(), GetFileExInfoStandard, &fad)) return false;
+    *size = ((uint64_t)fad.nFileSizeHigh << 32) | fad.nFileSizeLow;
+    *mtime = (int64_t)(((uint64_t)fad.ftLastWriteTime.dwHighDateTime << 32) | fad.ftLastWriteTime.dwLowDateTime);
+    return true;
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return false;
+    *size = (uint64_t)st.st_size;
+    *mtime = (int64_t)st.st_mtim.tv_sec * 10000000 + st.st_mtim.tv_nsec / 100;
+    return true;
+#endif
+}
+
+// ==========================================
+// 只读内存映射：整个文件映射到地址空间，按需由系统分页读入
+// ==========================================
+class MappedFile {
+public:
+    MappedFile() : m_data(NULL), m_size(0)
+#ifdef _WIN32
+        , m_file(INVALID_HANDLE_VALUE), m_mapping(NULL)
+#endif
+    {}
+    ~MappedFile() { Close(); }
+
+    bool Open(const std::string& path) {
+        Close();
+#ifdef _WIN32
+        m_file = CreateFileW(Utf8ToWide(path).c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL, NULL);
+        if (m_file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) {
+            Close();
+            return false;
+        }
+        m_mapping = CreateFileMappingW(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!m_mapping) {
+            Close();
+            return false;
+        }
+        m_data = (const uint8_t*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!m_data) {
+            Close();
+            return false;
+        }
+        m_size = (size_t)size.QuadPart;
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            return false;
+        }
+        void* p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) return false;
+        m_data = (const uint8_t*)p;
+        m_size = (size_t)st.st_size;
+#endif
+        return true;
+    }
+
+    void Close() {
+#ifdef _WIN32
+        if (m_data) UnmapViewOfFile(m_data);
+        if (m_mapping) CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+        m_mapping = NULL;
+        m_file = INVALID_HANDLE_VALUE;
+#else
+        if (m_data) munmap((void*)m_data, m_size);
+#endif
+        m_data = NULL;
+        m_size = 0;
+    }
+
+    const uint8_t* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+private:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* m_data;
+    size_t m_size;
+#ifdef _WIN32
+    HANDLE m_file;
+    HANDLE m_mapping;
+#endif
+};
+
+// ==========================================
+// 可写内存映射：创建（或截断）文件并映射为指定大小，可以扩大，关闭时截断到最终大小。
+// Resize() 会重新映射，之前取得的指针全部失效，调用者负责与写入方同步。
+// ==========================================
+class WritableMappedFile {
+public:
+    WritableMappedFile() : m_data(NULL), m_size(0)
+#ifdef _WIN32
+        , m_file(INVALID_HANDLE_VALUE), m_mapping(NULL)
+#else
+        , m_fd(-1)
+#endif
+    {}
+    ~WritableMappedFile() { Close(m_size); }
+
+    bool Create(const std::string& path, size_t size) {
+        Close(0);
+#ifdef _WIN32
+        m_file = CreateFileW(Utf8ToWide(path).c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS,
+                             FILE_ATTRIBUTE_NORMAL, NULL);
+        if (m_file == INVALID_HANDLE_VALUE) return false;
+#else
+        m_fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (m_fd < 0) return false;
+#endif
+        return Resize(size);
+    }
+
+    // 改变映射大小（文件随之扩大或截断），原有内容保留
+    bool Resize(size_t size) {
+        Unmap();
+        if (size == 0) return false;
+#ifdef _WIN32
+        // 映射大小超过文件大小时，CreateFileMapping 会把文件扩大到映射大小
+        m_mapping = CreateFileMappingW(m_file, NULL, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, NULL);
+        if (!m_mapping) return false;
+        m_data = (uint8_t*)MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, size);
+        if (!m_data) {
+            CloseHandle(m_mapping);
+            m_mapping = NULL;
+            return false;
+        }
+#else
+        if (ftruncate(m_fd, (off_t)size) != 0) return false;
+        void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+        if (p == MAP_FAILED) return false;
+        m_data = (uint8_t*)p;
+#endif
+        m_size = size;
+        return true;
+    }
+
+    // 解除映射并把文件截断为 finalSize 字节
+    bool Close(size_t finalSize) {
+        Unmap();
+        bool ok = true;
+#ifdef _WIN32
+        if (m_file != INVALID_HANDLE_VALUE) {
+            LARGE_INTEGER pos;
+            pos.QuadPart = (LONGLONG)finalSize;
+            ok = SetFilePointerEx(m_file, pos, NULL, FILE_BEGIN) && SetEndOfFile(m_file);
+            CloseHandle(m_file);
+            m_file = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (m_fd >= 0) {
+            ok = ftruncate(m_fd, (off_t)finalSize) == 0;
+            ok = (close(m_fd) == 0) && ok;
+            m_fd = -1;
+        }
+#endif
+        m_size = 0;
+        return ok;
+    }
+
+    uint8_t* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+private:
+    WritableMappedFile(const WritableMappedFile&) = delete;
+    WritableMappedFile& operator=(const WritableMappedFile&) = delete;
+
+    void Unmap() {
+#ifdef _WIN32
+        if (m_data) UnmapViewOfFile(m_data);
+        if (m_mapping) CloseHandle(m_mapping);
+        m_mapping = NULL;
+#else
+        if (m_data) munmap(m_data, m_size);
+#endif
+        m_data = NULL;
+    }
+
+    uint8_t* m_data;
+    size_t m_size;
+#ifdef _WIN32
+    HANDLE m_file;
+    HANDLE m_mapping;
+#else
+    int m_fd;
+#endif
+};
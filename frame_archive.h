@@ -0,0 +1,300 @@
+/*
+    帧归档：把一个视频的所有输出帧追加写入一个文件，代替成千上万个小文件。
+    文件结构（小端）：
+        文件头   32 字节：魔数 "D2FPACK\0"、版本、图像格式（ImageFormat）、标志（ArchiveFlag）、保留
+        帧数据   各帧编码后的图像文件字节依次排列
+        索引     每帧 32 字节：偏移(u64)、长度(u32)、CRC32(u32)、时间戳(i64, 100ns)、帧序号(i32)、保留(u32)
+        文件尾   32 字节：魔数 "D2FINDEX"、索引偏移(u64)、帧数(u64)、索引的 CRC32(u32)、保留
+    索引按帧序号排序，读取端映射文件后由文件尾定位索引，第 N 帧的位置为 O(1)。
+    文件尾在所有帧写完后才写入，中断的归档没有文件尾，读取端会拒绝打开。
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "file_util.h"
+#include "image_encoder.h"
+#include "deflate.h"
+
+static const char kArchiveMagic[8] = { 'D', '2', 'F', 'P', 'A', 'C', 'K', 0 };
+static const char kArchiveIndexMagic[8] = { 'D', '2', 'F', 'I', 'N', 'D', 'E', 'X' };
+static const uint32_t kArchiveVersion = 1;
+static const size_t kArchiveHeaderSize = 32;
+static const size_t kArchiveEntrySize = 32;
+static const size_t kArchiveFooterSize = 32;
+
+// 文件头中的标志位；旧归档这 4 字节为 0，与不设任何标志相同
+enum ArchiveFlag {
+    ARCHIVE_GRAY = 1,       // 单通道图像（PPM 格式时各帧为 PGM，P5）
+    ARCHIVE_TIME_NAMES = 2, // 直接输出时文件名附加毫秒时间戳（按时间采样）
+};
+
+// 归档文件的扩展名（不含点）
+static const char* const kArchiveExtension = "d2fpack";
+
+struct ArchiveEntry {
+    uint64_t offset;
+    uint32_t length;
+    uint32_t crc;
+    int64_t timestamp;
+    int32_t frameIndex;
+};
+
+inline uint32_t GetU32LE(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+inline uint64_t GetU64LE(const uint8_t* p) {
+    return (uint64_t)GetU32LE(p) | ((uint64_t)GetU32LE(p + 4) << 32);
+}
+
+// ==========================================
+// 写入端：多个编码线程可以并发 Append，帧数据按到达顺序写入，索引在 Finish() 时按帧序号排序
+// ==========================================
+class FrameArchiveWriter {
+public:
+    FrameArchiveWriter() : m_fp(NULL), m_offset(0), m_failed(false) {}
+    ~FrameArchiveWriter() { Finish(); }
+
+    // flags 为 ArchiveFlag 的组合
+    bool Open(const std::string& path, int imageFormat, uint32_t flags = 0) {
+        m_fp = OpenFileUtf8(path, "wb");
+        if (!m_fp) return false;
+        std::vector<uint8_t> header(kArchiveMagic, kArchiveMagic + 8);
+        PutU32LE(header, kArchiveVersion);
+        PutU32LE(header, (uint32_t)imageFormat);
+        PutU32LE(header, flags);
+        header.resize(kArchiveHeaderSize, 0);
+        m_offset = header.size();
+        m_failed = fwrite(header.data(), 1, header.size(), m_fp) != header.size();
+        return !m_failed;
+    }
+
+    // 追加一帧编码后的图像；CRC 在调用线程上计算，锁内只有一次写入
+    bool Append(int frameIndex, int64_t timestamp, const uint8_t* data, size_t size) {
+        ArchiveEntry entry;
+        entry.length = (uint32_t)size;
+        entry.crc = Crc32Update(0, data, size);
+        entry.timestamp = timestamp;
+        entry.frameIndex = frameIndex;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_fp || m_failed) return false;
+        entry.offset = m_offset;
+        if (fwrite(data, 1, size, m_fp) != size) {
+            m_failed = true;
+            return false;
+        }
+        m_offset += size;
+        m_entries.push_back(entry);
+        return true;
+    }
+
+    // 写入索引与文件尾并关闭；写入出错时不写文件尾，归档保持不可读
+    bool Finish() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_fp) return !m_failed;
+        if (!m_failed) {
+            std::stable_sort(m_entries.begin(), m_entries.end(), [](const ArchiveEntry& a, const ArchiveEntry& b) {
+                return a.frameIndex < b.frameIndex;
+            });
+            std::vector<uint8_t> index;
+            index.reserve(m_entries.size() * kArchiveEntrySize + kArchiveFooterSize);
+            for (size_t i = 0; i < m_entries.size(); ++i) {
+                const ArchiveEntry& e = m_entries[i];
+                PutU64LE(index, e.offset);
+                PutU32LE(index, e.length);
+                PutU32LE(index, e.crc);
+                PutU64LE(index, (uint64_t)e.timestamp);
+                PutU32LE(index, (uint32_t)e.frameIndex);
+                PutU32LE(index, 0);
+            }
+            uint32_t indexCrc = Crc32Update(0, index.data(), index.size());
+            index.insert(index.end(), kArchiveIndexMagic, kArchiveIndexMagic + 8);
+            PutU64LE(index, m_offset);
+            PutU64LE(index, m_entries.size());
+            PutU32LE(index, indexCrc);
+            PutU32LE(index, 0);
+            m_failed = fwrite(index.data(), 1, index.size(), m_fp) != index.size();
+        }
+        m_failed = (fclose(m_fp) != 0) || m_failed;
+        m_fp = NULL;
+        return !m_failed;
+    }
+
+    size_t Count() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_entries.size();
+    }
+
+private:
+    FrameArchiveWriter(const FrameArchiveWriter&) = delete;
+    FrameArchiveWriter& operator=(const FrameArchiveWriter&) = delete;
+
+    mutable std::mutex m_mutex;
+    FILE* m_fp;
+    uint64_t m_offset;
+    bool m_failed;
+    std::vector<ArchiveEntry> m_entries;
+};
+
+// ==========================================
+// 读取端：内存映射整个归档，Open() 只校验文件头、文件尾与索引范围，
+// Frame(n) 直接返回映射内的指针，不拷贝
+// ==========================================
+class FrameArchiveReader {
+public:
+    FrameArchiveReader() : m_imageFormat(-1), m_flags(0), m_index(NULL), m_count(0), m_indexCrc(0) {}
+
+    bool Open(const std::string& path, std::string* error = NULL) {
+        m_index = NULL;
+        m_count = 0;
+        m_path = path;
+        if (!m_file.Open(path)) return Fail(error, "无法打开或映射文件");
+        const uint8_t* base = m_file.Data();
+        size_t size = m_file.Size();
+        if (size < kArchiveHeaderSize + kArchiveFooterSize || memcmp(base, kArchiveMagic, 8) != 0) {
+            return Fail(error, "不是帧归档文件");
+        }
+        if (GetU32LE(base + 8) != kArchiveVersion) return Fail(error, "不支持的归档版本");
+        m_imageFormat = (int)GetU32LE(base + 12);
+        m_flags = GetU32LE(base + 16);
+
+        const uint8_t* footer = base + size - kArchiveFooterSize;
+        if (memcmp(footer, kArchiveIndexMagic, 8) != 0) return Fail(error, "缺少文件尾（写入未完成）");
+        uint64_t indexOffset = GetU64LE(footer + 8);
+        uint64_t count = GetU64LE(footer + 16);
+        uint64_t indexEnd = size - kArchiveFooterSize;
+        if (indexOffset < kArchiveHeaderSize || indexOffset > indexEnd ||
+            count != (indexEnd - indexOffset) / kArchiveEntrySize || (indexEnd - indexOffset) % kArchiveEntrySize != 0) {
+            return Fail(error, "索引位置或帧数无效");
+        }
+        m_index = base + indexOffset;
+        m_count = (size_t)count;
+        m_indexCrc = GetU32LE(footer + 24);
+        return true;
+    }
+
+    int ImageFormat() const { return m_imageFormat; }
+    bool Gray() const { return (m_flags & ARCHIVE_GRAY) != 0; }
+    bool TimeNames() const { return (m_flags & ARCHIVE_TIME_NAMES) != 0; }
+    const std::string& Path() const { return m_path; }
+    // 各帧图像文件的扩展名（灰度 PPM 为 pgm）
+    const char* Extension() const { return ImageFormatExtension(m_imageFormat, Gray()); }
+    size_t Count() const { return m_count; }
+
+    ArchiveEntry Entry(size_t n) const {
+        const uint8_t* p = m_index + n * kArchiveEntrySize;
+        ArchiveEntry e;
+        e.offset = GetU64LE(p);
+        e.length = GetU32LE(p + 8);
+        e.crc = GetU32LE(p + 12);
+        e.timestamp = (int64_t)GetU64LE(p + 16);
+        e.frameIndex = (int32_t)GetU32LE(p + 24);
+        return e;
+    }
+
+    // 第 n 帧的图像字节；越界时返回 NULL
+    const uint8_t* Frame(size_t n, size_t* length) const {
+        if (n >= m_count) return NULL;
+        ArchiveEntry e = Entry(n);
+        if (e.offset + e.length > (uint64_t)(m_index - m_file.Data())) return NULL;
+        if (length) *length = e.length;
+        return m_file.Data() + e.offset;
+    }
+
+    // 完整校验：索引 CRC、每帧的范围、CRC、图像文件签名与帧序号递增。
+    // 返回第一个错误的描述，全部通过时返回空串。
+    std::string Verify() const {
+        char buf[128];
+        if (!m_index) return "归档未打开";
+        if (Crc32Update(0, m_index, m_count * kArchiveEntrySize) != m_indexCrc) return "索引 CRC 不匹配";
+        uint64_t dataEnd = (uint64_t)(m_index - m_file.Data());
+        for (size_t n = 0; n < m_count; ++n) {
+            ArchiveEntry e = Entry(n);
+            if (e.offset < kArchiveHeaderSize || e.offset + e.length > dataEnd) {
+                snprintf(buf, sizeof(buf), "第 %zu 帧超出数据区", n);
+                return buf;
+            }
+            const uint8_t* data = m_file.Data() + e.offset;
+            if (Crc32Update(0, data, e.length) != e.crc) {
+                snprintf(buf, sizeof(buf), "第 %zu 帧（帧序号 %d）CRC 不匹配", n, e.frameIndex);
+                return buf;
+            }
+            if (!HasImageSignature(data, e.length)) {
+                snprintf(buf, sizeof(buf), "第 %zu 帧（帧序号 %d）不是 %s 图像", n, e.frameIndex, Extension());
+                return buf;
+            }
+            if (n > 0 && Entry(n - 1).frameIndex >= e.frameIndex) {
+                snprintf(buf, sizeof(buf), "第 %zu 帧的帧序号 %d 没有递增", n, e.frameIndex);
+                return buf;
+            }
+        }
+        return std::string();
+    }
+
+private:
+    static bool Fail(std::string* error, const char* message) {
+        if (error) *error = message;
+        return false;
+    }
+
+    bool HasImageSignature(const uint8_t* data, size_t length) const {
+        switch (m_imageFormat) {
+        case IMAGE_JPEG: return length >= 2 && data[0] == 0xFF && data[1] == 0xD8;
+        case IMAGE_PNG: return length >= 8 && memcmp(data, "\x89PNG\r\n\x1A\n", 8) == 0;
+        case IMAGE_BMP: return length >= 2 && data[0] == 'B' && data[1] == 'M';
+        case IMAGE_PPM: return length >= 2 && data[0] == 'P' && data[1] == (Gray() ? '5' : '6');
+        default: return false;
+        }
+    }
+
+    MappedFile m_file;
+    std::string m_path;
+    int m_imageFormat;
+    uint32_t m_flags;
+    const uint8_t* m_index;
+    size_t m_count;
+    uint32_t m_indexCrc;
+};
+
+// 把归档中的每一帧写成单独的文件，命名与直接输出单个文件时一致："视频文件名_帧序号.jpg"，
+// 视频文件名取自归档文件名（不含扩展名），按时间采样的归档再附加毫秒时间戳。
+// dir 及缺少的上级目录会先创建。失败时 error 为原因，已写出的文件保留。
+inline bool UnpackFrameArchive(const FrameArchiveReader& reader, const std::string& dir, std::string* error) {
+    char buf[512];
+    std::string stem = FileStem(reader.Path());
+    if (!CreateDirectoriesUtf8(dir)) {
+        if (error) *error = "无法创建目录 " + dir;
+        return false;
+    }
+    for (size_t n = 0; n < reader.Count(); ++n) {
+        size_t length = 0;
+        const uint8_t* data = reader.Frame(n, &length);
+        if (!data) {
+            snprintf(buf, sizeof(buf), "第 %zu 帧超出数据区", n);
+            if (error) *error = buf;
+            return false;
+        }
+        ArchiveEntry e = reader.Entry(n);
+        if (!reader.TimeNames()) {
+            snprintf(buf, sizeof(buf), "%s_%05d.%s", stem.c_str(), e.frameIndex, reader.Extension());
+        }
+        else {
+            snprintf(buf, sizeof(buf), "%s_%05d_%08lldms.%s", stem.c_str(), e.frameIndex,
+                (long long)((e.timestamp + 5000) / 10000), reader.Extension());
+        }
+        std::string path = JoinPath(dir, buf);
+        if (!WriteFileUtf8(path, data, length)) {
+            if (error) *error = "无法写入 " + path;
+            return false;
+        }
+    }
+    return true;
+}
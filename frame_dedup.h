@@ -0,0 +1,135 @@
+/*
+    近重复帧过滤
+    把候选帧的 ROI 缩小为 32x32 的亮度缩略图，与上一个保存的帧比较平均绝对差（SAD / 像素数）。
+    低于阈值的帧视为重复，直接丢弃，不做颜色转换也不编码。
+    与上一个“保存的”帧比较，缓慢的渐变累积到阈值后仍会被保存。
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "frame_source.h"
+#include "simd_config.h"
+
+static const int kThumbSize = 32;
+static const int kThumbPixels = kThumbSize * kThumbSize;
+
+// 每个格子在每个方向上最多取样的像素数，格子内均匀取样后求平均
+static const int kThumbSamples = 4;
+
+// 把 ROI 内的亮度按块平均缩小为 kThumbSize x kThumbSize。
+// BGRX 帧按 BT.601 系数计算亮度，NV12 / I420 帧直接读取 Y 平面。
+// 每个格子只取 kThumbSamples x kThumbSamples 个像素，1080p 帧只读约一万六千个像素。
+// ROI 小于缩略图时相邻的格子取同一个像素。
+inline bool MakeLumaThumbnail(const FrameView& src, const RoiRect& roi, uint8_t* thumb) {
+    int w = roi.right - roi.left;
+    int h = roi.bottom - roi.top;
+    if (!src.data || w <= 0 || h <= 0) return false;
+
+    int xs[kThumbSize + 1], ys[kThumbSize + 1];
+    for (int i = 0; i <= kThumbSize; i++) {
+        xs[i] = roi.left + (int)((int64_t)i * w / kThumbSize);
+        ys[i] = roi.top + (int)((int64_t)i * h / kThumbSize);
+    }
+    int stepX = w / (kThumbSize * kThumbSamples);
+    int stepY = h / (kThumbSize * kThumbSamples);
+    if (stepX < 1) stepX = 1;
+    if (stepY < 1) stepY = 1;
+
+    uint32_t sums[kThumbSize];
+    uint32_t counts[kThumbSize];
+    for (int cy = 0; cy < kThumbSize; cy++) {
+        int y0 = ys[cy];
+        int y1 = ys[cy + 1] > y0 ? ys[cy + 1] : y0 + 1;
+        memset(sums, 0, sizeof(sums));
+        memset(counts, 0, sizeof(counts));
+        for (int y = y0; y < y1; y += stepY) {
+            const uint8_t* row = src.data + (ptrdiff_t)y * src.stride;
+            for (int cx = 0; cx < kThumbSize; cx++) {
+                int x0 = xs[cx];
+                int x1 = xs[cx + 1] > x0 ? xs[cx + 1] : x0 + 1;
+                uint32_t sum = 0, count = 0;
+                if (src.format == FRAME_BGRX32) {
+                    for (int x = x0; x < x1; x += stepX, count++) {
+                        const uint8_t* p = row + x * 4;
+                        sum += (29 * p[0] + 150 * p[1] + 77 * p[2] + 128) >> 8;
+                    }
+                } else {
+                    for (int x = x0; x < x1; x += stepX, count++) sum += row[x];
+                }
+                sums[cx] += sum;
+                counts[cx] += count;
+            }
+        }
+        for (int cx = 0; cx < kThumbSize; cx++) {
+            thumb[cy * kThumbSize + cx] = (uint8_t)((sums[cx] + counts[cx] / 2) / counts[cx]);
+        }
+    }
+    return true;
+}
+
+// 两张缩略图的绝对差之和
+inline uint32_t ThumbnailSad(const uint8_t* a, const uint8_t* b) {
+#ifdef D2F_X86
+    __m128i acc = _mm_setzero_si128();
+    for (int i = 0; i < kThumbPixels; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+    }
+    return (uint32_t)(_mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+#else
+    uint32_t sad = 0;
+    for (int i = 0; i < kThumbPixels; i++) sad += a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+    return sad;
+#endif
+}
+
+// ==========================================
+// 每个视频文件一个过滤器实例（不是线程安全的）
+// threshold 为每像素平均亮度差（0-255），0 表示不过滤
+// ==========================================
+class DuplicateFilter {
+public:
+    explicit DuplicateFilter(double threshold)
+        : m_threshold(threshold), m_hasReference(false), m_kept(0), m_dropped(0) {}
+
+    bool Enabled() const { return m_threshold > 0.0; }
+
+    // 返回 true 表示这一帧需要保存，保存的帧成为之后比较的基准
+    bool Accept(const FrameView& view, const RoiRect& roi) {
+        if (Enabled() && MakeLumaThumbnail(view, roi, m_current)) {
+            if (m_hasReference && Distance(m_current, m_reference) < m_threshold) {
+                m_dropped++;
+                return false;
+            }
+            memcpy(m_reference, m_current, kThumbPixels);
+            m_hasReference = true;
+        }
+        m_kept++;
+        return true;
+    }
+
+    // 把这一帧设为比较的基准，不计入保存与丢弃的帧数（续传时用上次保存的最后一帧）
+    void SetReference(const FrameView& view, const RoiRect& roi) {
+        if (Enabled() && MakeLumaThumbnail(view, roi, m_reference)) m_hasReference = true;
+    }
+
+    int Kept() const { return m_kept; }
+    int Dropped() const { return m_dropped; }
+
+    // 每像素平均亮度差
+    static double Distance(const uint8_t* a, const uint8_t* b) {
+        return (double)ThumbnailSad(a, b) / kThumbPixels;
+    }
+
+private:
+    double m_threshold;
+    bool m_hasReference;
+    int m_kept;
+    int m_dropped;
+    uint8_t m_reference[kThumbPixels];
+    uint8_t m_current[kThumbPixels];
+};
@@ -0,0 +1,214 @@
+/*
+    帧索引：一个视频每一帧的时间戳、是否关键帧与在文件中的字节偏移，按显示顺序排列，第 N 帧即第 N 项。
+    建立一次之后保存为边车文件，之后的稀疏采样与续传直接由帧序号找到之前最近的关键帧跳转，
+    不再顺序解码来测量 GOP，也不要求恒定帧率。
+    跳转总是 IFrameSource::SeekTo(关键帧的时间戳)，由解码后端定位；字节偏移只作记录，采样不使用。
+    Media Foundation 不提供样本的偏移，其索引中偏移全为 0，跳转是按时间戳的跳转，容器内的定位仍由 Media Foundation 完成。
+    后端能只读取压缩数据包时（IVideoDecoder::ScanFrames）不解码，否则顺序解码一遍建立。
+    文件为视频旁的 "视频文件名.扩展名.d2findex"，或缓存目录下附加路径哈希的同名文件；
+    记录视频的大小与修改时间，视频变化后索引作废。
+    每帧的时间戳与偏移按与上一帧的差值 zigzag 变长编码，关键帧标记放在时间戳差值的最低位，恒定帧率时每帧 4 到 6 字节
+    （偏移全为 0 时偏移差值每帧 1 字节）。
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "deflate.h"
+#include "file_util.h"
+#include "frame_source.h"
+
+static const char kFrameIndexMagic[8] = { 'D', '2', 'F', 'F', 'I', 'D', 'X', 0 };
+static const uint32_t kFrameIndexVersion = 1;
+static const size_t kFrameIndexHeaderSize = 40;
+
+// 边车文件的扩展名（不含点）
+static const char* const kFrameIndexExtension = "d2findex";
+
+// 解码得到的时间戳与索引相差不超过这么多（100 纳秒单位）时视为同一帧
+static const int64_t kFrameIndexTolerance = 5000;
+
+struct FrameIndexEntry {
+    int64_t timestamp;      // 显示时间戳（100 纳秒）
+    uint64_t offset;        // 数据包在文件中的字节偏移，后端不知道时为 0（Media Foundation）；只作记录，跳转按时间戳
+    bool key;
+
+    FrameIndexEntry() : timestamp(0), offset(0), key(false) {}
+};
+
+class FrameIndex {
+public:
+    FrameIndex() {}
+
+    // 按时间戳排序（数据包按解码顺序到达）；第一帧总是作为关键帧
+    void Assign(const std::vector<FrameIndexEntry>& entries) {
+        m_entries = entries;
+        std::stable_sort(m_entries.begin(), m_entries.end(),
+            [](const FrameIndexEntry& a, const FrameIndexEntry& b) { return a.timestamp < b.timestamp; });
+        if (!m_entries.empty()) m_entries[0].key = true;
+        m_keys.clear();
+        for (size_t i = 0; i < m_entries.size(); ++i) {
+            if (m_entries[i].key) m_keys.push_back((int)i + 1);
+        }
+    }
+
+    bool Empty() const { return m_entries.empty(); }
+    int Count() const { return (int)m_entries.size(); }
+    int KeyFrameCount() const { return (int)m_keys.size(); }
+    const std::vector<FrameIndexEntry>& Entries() const { return m_entries; }
+
+    // 第 frame 帧（从 1 开始）
+    const FrameIndexEntry& Frame(int frame) const { return m_entries[(size_t)frame - 1]; }
+
+    // 时间戳为 timestamp 的帧的序号，没有这一帧时返回 0
+    int FrameAt(int64_t timestamp) const {
+        std::vector<FrameIndexEntry>::const_iterator it = std::lower_bound(m_entries.begin(), m_entries.end(),
+            timestamp - kFrameIndexTolerance, [](const FrameIndexEntry& e, int64_t t) { return e.timestamp < t; });
+        if (it == m_entries.end() || it->timestamp > timestamp + kFrameIndexTolerance) return 0;
+        return (int)(it - m_entries.begin()) + 1;
+    }
+
+    // frame 及之前最近的关键帧
+    int KeyFrameAtOrBefore(int frame) const {
+        std::vector<int>::const_iterator it = std::upper_bound(m_keys.begin(), m_keys.end(), frame);
+        return it == m_keys.begin() ? 1 : *(it - 1);
+    }
+
+    // 序列化为边车文件的内容；size 与 mtime 为视频文件的大小与修改时间
+    std::vector<uint8_t> Serialize(uint64_t size, int64_t mtime) const {
+        std::vector<uint8_t> bytes(kFrameIndexHeaderSize, 0);
+        int64_t previousTimestamp = 0;
+        uint64_t previousOffset = 0;
+        for (size_t i = 0; i < m_entries.size(); ++i) {
+            const FrameIndexEntry& e = m_entries[i];
+            PutVarint(bytes, (ZigZag(e.timestamp - previousTimestamp) << 1) | (e.key ? 1 : 0));
+            PutVarint(bytes, ZigZag((int64_t)(e.offset - previousOffset)));
+            previousTimestamp = e.timestamp;
+            previousOffset = e.offset;
+        }
+        uint8_t* header = bytes.data();
+        memcpy(header, kFrameIndexMagic, 8);
+        PutLE(header + 8, kFrameIndexVersion, 4);
+        PutLE(header + 12, (uint64_t)m_entries.size(), 4);
+        PutLE(header + 16, size, 8);
+        PutLE(header + 24, (uint64_t)mtime, 8);
+        PutLE(header + 32, (uint64_t)(bytes.size() - kFrameIndexHeaderSize), 4);
+        PutLE(header + 36, Crc32Update(0, bytes.data() + kFrameIndexHeaderSize, bytes.size() - kFrameIndexHeaderSize), 4);
+        return bytes;
+    }
+
+    // 解析边车文件的内容；格式不对、校验失败或视频的大小与修改时间不符时返回 false
+    bool Parse(const uint8_t* data, size_t length, uint64_t size, int64_t mtime) {
+        m_entries.clear();
+        m_keys.clear();
+        if (length < kFrameIndexHeaderSize || memcmp(data, kFrameIndexMagic, 8) != 0) return false;
+        if (GetLE(data + 8, 4) != kFrameIndexVersion || GetLE(data + 16, 8) != size || (int64_t)GetLE(data + 24, 8) != mtime) return false;
+        uint64_t count = GetLE(data + 12, 4);
+        uint64_t payload = GetLE(data + 32, 4);
+        if (payload != length - kFrameIndexHeaderSize || count > payload) return false;
+        const uint8_t* p = data + kFrameIndexHeaderSize;
+        const uint8_t* end = data + length;
+        if (Crc32Update(0, p, (size_t)payload) != (uint32_t)GetLE(data + 36, 4)) return false;
+
+        std::vector<FrameIndexEntry> entries((size_t)count);
+        int64_t timestamp = 0;
+        uint64_t offset = 0;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            uint64_t first = 0, second = 0;
+            if (!GetVarint(p, end, &first) || !GetVarint(p, end, &second)) return false;
+            timestamp += UnZigZag(first >> 1);
+            offset += (uint64_t)UnZigZag(second);
+            entries[i].timestamp = timestamp;
+            entries[i].offset = offset;
+            entries[i].key = (first & 1) != 0;
+        }
+        if (p != end) return false;
+        Assign(entries);
+        return true;
+    }
+
+private:
+    static uint64_t ZigZag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+    static int64_t UnZigZag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+    static void PutVarint(std::vector<uint8_t>& out, uint64_t v) {
+        while (v >= 0x80) {
+            out.push_back((uint8_t)(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back((uint8_t)v);
+    }
+
+    static bool GetVarint(const uint8_t*& p, const uint8_t* end, uint64_t* v) {
+        *v = 0;
+        for (int shift = 0; shift < 64 && p < end; shift += 7) {
+            uint8_t b = *p++;
+            *v |= (uint64_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+
+    static void PutLE(uint8_t* p, uint64_t v, int bytes) {
+        for (int i = 0; i < bytes; i++) p[i] = (uint8_t)(v >> (i * 8));
+    }
+
+    static uint64_t GetLE(const uint8_t* p, int bytes) {
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; i++) v |= (uint64_t)p[i] << (i * 8);
+        return v;
+    }
+
+    std::vector<FrameIndexEntry> m_entries;
+    std::vector<int> m_keys;            // 关键帧的帧序号，递增
+};
+
+// 视频的索引文件：cacheDir 为空时放在视频旁边，否则放在 cacheDir 下，文件名附加完整路径的哈希以免同名视频冲突
+inline std::string FrameIndexPath(const std::string& videoPath, const std::string& cacheDir) {
+    size_t nameBegin = videoPath.size();
+    while (nameBegin > 0 && !IsPathSeparator(videoPath[nameBegin - 1])) nameBegin--;
+    if (cacheDir.empty()) return videoPath + "." + kFrameIndexExtension;
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < videoPath.size(); ++i) {
+        hash ^= (uint8_t)videoPath[i];
+        hash *= 1099511628211ull;
+    }
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%016llx.", (unsigned long long)hash);
+    return JoinPath(cacheDir, videoPath.substr(nameBegin) + suffix + kFrameIndexExtension);
+}
+
+inline bool ReadFrameIndex(const std::string& path, uint64_t size, int64_t mtime, FrameIndex* index) {
+    MappedFile file;
+    return file.Open(path) && index->Parse(file.Data(), file.Size(), size, mtime);
+}
+
+// 先写临时文件再替换，写到一半中断时不会留下损坏的索引
+inline bool WriteFrameIndex(const std::string& path, uint64_t size, int64_t mtime, const FrameIndex& index) {
+    std::vector<uint8_t> bytes = index.Serialize(size, mtime);
+    std::string tmp = path + ".tmp";
+    return WriteFileUtf8(tmp, bytes.data(), bytes.size()) && ReplaceFileUtf8(tmp, path);
+}
+
+// 后端不能只读取数据包时的回退：顺序推进整个视频记录时间戳与关键帧标记（偏移未知，记为 0）。
+// 被停止时返回 false，调用方之后需要 Rewind()
+inline bool BuildFrameIndexByDecoding(IFrameSource& source, const std::atomic<bool>& stop, FrameIndex* index) {
+    std::vector<FrameIndexEntry> entries;
+    int64_t timestamp = 0;
+    while (!stop && source.Advance(&timestamp)) {
+        FrameIndexEntry e;
+        e.timestamp = timestamp;
+        e.key = source.IsKeyFrame();
+        entries.push_back(e);
+    }
+    if (stop || entries.empty()) return false;
+    index->Assign(entries);
+    return true;
+}
@@ -0,0 +1,191 @@
+/*
+    帧列表：每个视频只保存列表中给出的帧，按帧序号（从 1 开始）或相对第一帧的时间指定。
+    列表排序去重后交给 FrameListSelector，采样引擎据此跳转：按目标帧的先后只向前解码，
+    同一个 GOP 内的多个目标一次解码完，每个关键帧区间最多解码一次；有帧索引时直接查索引。
+    列表来自任务文件或 CSV 文件，每行 "视频,帧序号" 或 "视频,秒数s"，例如：
+        video,frame
+        a.mp4,1200
+        a.mp4,1201
+        b.mp4,12.5s
+    视频列可以写完整路径（相对于 CSV 文件所在的目录）、带扩展名的文件名或不含扩展名的文件名。
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "file_util.h"
+
+// 按时间指定的帧：时间戳与列表相差不超过这么多（100 纳秒单位）时视为已经达到，抵消时间戳取整的误差
+static const int64_t kFrameListTolerance = 5000;
+
+// 一个视频要保存的帧
+struct FrameList {
+    std::vector<int> frames;        // 帧序号，从 1 开始
+    std::vector<int64_t> times;     // 相对第一帧的时间（100 纳秒），保存时间戳首次达到它的帧
+
+    // 排序并去掉重复项，交给 FrameListSelector 之前调用
+    void Normalize() {
+        std::sort(frames.begin(), frames.end());
+        frames.erase(std::unique(frames.begin(), frames.end()), frames.end());
+        std::sort(times.begin(), times.end());
+        times.erase(std::unique(times.begin(), times.end()), times.end());
+    }
+
+    bool Empty() const { return frames.empty() && times.empty(); }
+    size_t Count() const { return frames.size() + times.size(); }
+
+    // 列表内容的 FNV-1a 哈希，计入续传清单的设置
+    uint64_t Hash() const {
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](uint64_t v) {
+            for (int i = 0; i < 8; ++i) {
+                hash ^= (uint8_t)(v >> (i * 8));
+                hash *= 1099511628211ull;
+            }
+        };
+        mix(frames.size());
+        for (size_t i = 0; i < frames.size(); ++i) mix((uint64_t)frames[i]);
+        mix(times.size());
+        for (size_t i = 0; i < times.size(); ++i) mix((uint64_t)times[i]);
+        return hash;
+    }
+};
+
+// ==========================================
+// 按列表选帧，接口与 seek_sampling.h 中的选帧器相同。
+// 每一帧都消耗列表中不晚于它的项，从任意一帧开始都会收敛到与顺序解码相同的状态（续传与分段解码依赖这一点）；
+// 列表用完后 Finished() 为 true，采样循环不再解码后面的帧。列表须已经 Normalize()，并且在选帧器之后销毁
+// ==========================================
+class FrameListSelector {
+public:
+    explicit FrameListSelector(const FrameList& list) : m_list(&list), m_frame(0), m_time(0) {}
+
+    bool Keep(int frameIndex, int64_t elapsed) {
+        bool keep = false;
+        const std::vector<int>& frames = m_list->frames;
+        const std::vector<int64_t>& times = m_list->times;
+        while (m_frame < frames.size() && frames[m_frame] <= frameIndex) {
+            if (frames[m_frame] == frameIndex) keep = true;
+            m_frame++;
+        }
+        while (m_time < times.size() && times[m_time] <= elapsed + kFrameListTolerance) {
+            keep = true;
+            m_time++;
+        }
+        return keep;
+    }
+
+    int NextTarget(int frameIndex, double frameDuration) const {
+        int target = frameIndex + 1;
+        if (m_frame < m_list->frames.size()) target = m_list->frames[m_frame];
+        if (m_time < m_list->times.size()) {
+            // 提前半帧，与 TimeIntervalSelector 相同
+            int t = frameDuration > 0 ? (int)((m_list->times[m_time] - frameDuration / 2) / frameDuration) + 1 : frameIndex + 1;
+            if (m_frame >= m_list->frames.size() || t < target) target = t;
+        }
+        return target > frameIndex ? target : frameIndex + 1;
+    }
+
+    // 从开头到最后一个目标的平均间隔
+    double Spacing(double frameDuration) const {
+        if (m_list->Empty()) return 1.0;
+        double last = m_list->frames.empty() ? 1.0 : (double)m_list->frames.back();
+        if (!m_list->times.empty() && frameDuration > 0) last = std::max(last, m_list->times.back() / frameDuration + 1.0);
+        return last / m_list->Count();
+    }
+
+    bool Finished() const { return m_frame >= m_list->frames.size() && m_time >= m_list->times.size(); }
+
+private:
+    const FrameList* m_list;
+    size_t m_frame;     // 下一个未处理的帧序号
+    size_t m_time;      // 下一个未处理的时间
+};
+
+// 解析一项：整数为帧序号，以 s 结尾的数为秒数
+inline bool ParseFrameListItem(const std::string& text, FrameList* list) {
+    if (text.empty()) return false;
+    const char* begin = text.c_str();
+    char* end = NULL;
+    if (text[text.size() - 1] == 's') {
+        double seconds = strtod(begin, &end);
+        if (end != begin + text.size() - 1 || !(seconds >= 0.0 && seconds < 1e9)) return false;
+        list->times.push_back((int64_t)std::llround(seconds * 10000000.0));
+        return true;
+    }
+    long frame = strtol(begin, &end, 10);
+    if (end != begin + text.size() || frame < 1 || frame > 0x7FFFFFFF) return false;
+    list->frames.push_back((int)frame);
+    return true;
+}
+
+// 读取 CSV 帧列表（UTF-8），按视频列分组，顺序与首次出现的顺序相同。
+// 第一行第二列不是帧序号或时间时视为表头；空行与 # 开头的行忽略；视频列可以用双引号括起。
+inline bool LoadFrameListCsv(const std::string& path, std::vector<std::pair<std::string, FrameList>>* lists, std::string* error) {
+    FILE* fp = OpenFileUtf8(path, "rb");
+    if (!fp) {
+        *error = "无法打开帧列表: " + path;
+        return false;
+    }
+    lists->clear();
+    char buffer[4096];
+    int lineNumber = 0;
+    bool ok = true;
+    while (ok && fgets(buffer, sizeof(buffer), fp)) {
+        std::string line(buffer);
+        lineNumber++;
+        if (lineNumber == 1 && line.compare(0, 3, "\xEF\xBB\xBF") == 0) line.erase(0, 3);
+        while (!line.empty() && (line.back() == '\n' || line.back() == '\r' || line.back() == ' ' || line.back() == '\t')) line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        std::string video, item;
+        size_t comma;
+        if (line[0] == '"') {
+            size_t quote = line.find('"', 1);
+            comma = quote == std::string::npos ? quote : line.find(',', quote);
+            if (comma != std::string::npos) video = line.substr(1, quote - 1);
+        } else {
+            comma = line.find(',');
+            if (comma != std::string::npos) video = line.substr(0, comma);
+        }
+        if (comma != std::string::npos) {
+            size_t begin = line.find_first_not_of(" \t", comma + 1);
+            if (begin != std::string::npos) item = line.substr(begin);
+        }
+
+        FrameList parsed;
+        if (video.empty() || !ParseFrameListItem(item, &parsed)) {
+            if (lineNumber == 1) continue;
+            char message[64];
+            snprintf(message, sizeof(message), "帧列表第 %d 行无效: ", lineNumber);
+            *error = message + line;
+            ok = false;
+            break;
+        }
+        // 同一个视频的行通常连在一起，先看最后一组
+        size_t k = lists->empty() || lists->back().first != video ? 0 : lists->size() - 1;
+        while (k < lists->size() && (*lists)[k].first != video) k++;
+        if (k == lists->size()) lists->push_back(std::make_pair(video, FrameList()));
+        FrameList& list = (*lists)[k].second;
+        list.frames.insert(list.frames.end(), parsed.frames.begin(), parsed.frames.end());
+        list.times.insert(list.times.end(), parsed.times.begin(), parsed.times.end());
+    }
+    fclose(fp);
+    return ok;
+}
+
+// 帧列表中的视频名是否指这个文件：相对 baseDir 的路径、带扩展名的文件名或不含扩展名的文件名
+inline bool FrameListNamesFile(const std::string& name, const std::string& baseDir, const std::string& path) {
+    if (name == path || (!IsAbsolutePath(name) && JoinPath(baseDir, name) == path)) return true;
+    size_t nameBegin = path.size();
+    while (nameBegin > 0 && !IsPathSeparator(path[nameBegin - 1])) nameBegin--;
+    return name == path.substr(nameBegin) || name == FileStem(path);
+}
@@ -0,0 +1,108 @@
+/*
+    帧缓冲池
+    固定尺寸、可复用的像素缓冲区，避免每帧分配/释放整帧内存。
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+// 池中的一块缓冲区，data 按 64 字节对齐
+struct FrameBuffer {
+    uint8_t* data;
+    size_t size;
+    std::vector<uint8_t> storage;
+};
+
+class FramePool {
+public:
+    // capacity：同时存在的缓冲区上限，达到上限后 Acquire() 阻塞等待归还
+    explicit FramePool(size_t capacity = 4)
+        : m_capacity(capacity < 1 ? 1 : capacity), m_bufferBytes(0), m_allocated(0), m_hits(0), m_misses(0) {}
+
+    ~FramePool() {
+        for (FrameBuffer* buf : m_free) delete buf;
+    }
+
+    // 按分辨率组设置缓冲区尺寸；尺寸不变时不做任何事，
+    // 尺寸变化时释放空闲缓冲，仍在使用中的旧缓冲在归还时释放
+    void Configure(size_t bufferBytes) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (bufferBytes == m_bufferBytes) return;
+        for (FrameBuffer* buf : m_free) {
+            delete buf;
+            m_allocated--;
+        }
+        m_free.clear();
+        m_bufferBytes = bufferBytes;
+    }
+
+    size_t BufferBytes() const { return m_bufferBytes; }
+
+    // 取出一块缓冲：空闲链表非空则命中，否则在容量内新分配（未命中）
+    FrameBuffer* Acquire() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cond.wait(lock, [this] { return !m_free.empty() || m_allocated < m_capacity; });
+        if (!m_free.empty()) {
+            FrameBuffer* buf = m_free.back();
+            m_free.pop_back();
+            m_hits++;
+            return buf;
+        }
+        m_allocated++;
+        m_misses++;
+        size_t bytes = m_bufferBytes;
+        lock.unlock();
+
+        FrameBuffer* buf = new FrameBuffer;
+        buf->storage.resize(bytes + 63);
+        uintptr_t p = (uintptr_t)buf->storage.data();
+        buf->data = (uint8_t*)((p + 63) & ~(uintptr_t)63);
+        buf->size = bytes;
+        return buf;
+    }
+
+    void Release(FrameBuffer* buf) {
+        if (!buf) return;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (buf->size == m_bufferBytes) {
+                m_free.push_back(buf);
+            }
+            else {
+                delete buf;
+                m_allocated--;
+            }
+        }
+        m_cond.notify_one();
+    }
+
+    uint64_t Hits() const { std::lock_guard<std::mutex> lock(m_mutex); return m_hits; }
+    uint64_t Misses() const { std::lock_guard<std::mutex> lock(m_mutex); return m_misses; }
+
+    // 已分配但尚未归还的缓冲数
+    size_t InUse() const { std::lock_guard<std::mutex> lock(m_mutex); return m_allocated - m_free.size(); }
+
+    void ResetCounters() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_hits = 0;
+        m_misses = 0;
+    }
+
+private:
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::vector<FrameBuffer*> m_free;
+    size_t m_capacity;
+    size_t m_bufferBytes;
+    size_t m_allocated;
+    uint64_t m_hits;
+    uint64_t m_misses;
+};
@@ -0,0 +1,107 @@
+/*
+    帧源接口、帧视图与 ROI
+    与平台无关：不依赖 Windows / Media Foundation，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+// 帧像素格式
+enum FramePixelFormat {
+    FRAME_BGRX32 = 0,   // 32 位 BGRX，每像素 4 字节
+    FRAME_NV12,         // Y 平面 + 交错的 UV 平面（2x2 下采样）
+    FRAME_I420,         // Y、U、V 三个平面（2x2 下采样）
+    FRAME_GRAY8         // 8 位灰度（亮度），每像素 1 字节；只用于转换后的输出缓冲
+};
+
+// BGRX32 / GRAY8 视图每像素的字节数
+inline int FramePixelBytes(int format) {
+    return format == FRAME_GRAY8 ? 1 : 4;
+}
+
+// 帧视图：指向一块不拥有所有权的像素内存。
+// BGRX32 与 GRAY8 只使用 data/stride；NV12 的 plane1 为 UV 平面；I420 的 plane1/plane2 为 U/V 平面。
+struct FrameView {
+    const uint8_t* data;
+    int width;
+    int height;
+    int stride;   // 相邻两行起始地址之差（字节），自下而上的缓冲为负
+    int format;   // FramePixelFormat
+    const uint8_t* plane1;
+    int stride1;
+    const uint8_t* plane2;
+    int stride2;
+};
+
+// ROI 矩形（像素坐标，right/bottom 不包含）
+struct RoiRect {
+    int left;
+    int top;
+    int right;
+    int bottom;
+};
+
+// 将 ROI 调整到 width x height 画面范围内；调整后为空时返回 false
+inline bool ClampRoi(RoiRect& roi, int width, int height) {
+    if (roi.left < 0) roi.left = 0;
+    if (roi.top < 0) roi.top = 0;
+    if (roi.right > width) roi.right = width;
+    if (roi.bottom > height) roi.bottom = height;
+    return roi.right > roi.left && roi.bottom > roi.top;
+}
+
+// 在 BGRX32（或 GRAY8）源帧上构造 ROI 的跨步视图：不拷贝像素，只偏移起始指针并沿用源 stride。
+// stride 为负（自下而上的缓冲）时同样适用。ROI 会先被调整到画面范围内。
+// YUV 格式的 ROI 由 ConvertRoiToBgrx() 在转换时直接处理。
+inline bool MakeRoiView(const FrameView& src, RoiRect roi, FrameView* out) {
+    if ((src.format != FRAME_BGRX32 && src.format != FRAME_GRAY8) || !ClampRoi(roi, src.width, src.height)) return false;
+    *out = FrameView();
+    out->data = src.data + (ptrdiff_t)roi.top * src.stride + (ptrdiff_t)roi.left * FramePixelBytes(src.format);
+    out->width = roi.right - roi.left;
+    out->height = roi.bottom - roi.top;
+    out->stride = src.stride;
+    out->format = src.format;
+    return true;
+}
+
+// 将 BGRX32（或 GRAY8）视图中的像素逐行复制到 dst（行跨度 dstStride），返回目标视图
+inline FrameView CopyFrameView(const FrameView& src, uint8_t* dst, int dstStride) {
+    size_t rowBytes = (size_t)src.width * FramePixelBytes(src.format);
+    for (int y = 0; y < src.height; y++) {
+        memcpy(dst + (size_t)y * dstStride, src.data + (ptrdiff_t)y * src.stride, rowBytes);
+    }
+    FrameView out = FrameView();
+    out.data = dst;
+    out.width = src.width;
+    out.height = src.height;
+    out.stride = dstStride;
+    out.format = src.format;
+    return out;
+}
+
+// ==========================================
+// 帧源接口
+// Advance() 只推进流与帧计数，不触碰像素；
+// 只有真正需要保存的帧才调用 LockFrame() 物化像素。
+// ==========================================
+class IFrameSource {
+public:
+    virtual ~IFrameSource() {}
+
+    // 推进到下一帧，返回 false 表示读取完毕或出错；timestamp 单位为 100 纳秒
+    virtual bool Advance(int64_t* timestamp) = 0;
+
+    // 锁定当前帧像素，必须与 UnlockFrame() 成对调用
+    virtual bool LockFrame(FrameView* view) = 0;
+    virtual void UnlockFrame() = 0;
+
+    // 当前帧是否为关键帧；不提供关键帧信息的帧源始终返回 false
+    virtual bool IsKeyFrame() const { return false; }
+
+    // 跳转到 timestamp 之前最近的关键帧，之后的 Advance() 从该关键帧开始输出。
+    // 不支持跳转的帧源返回 false。
+    virtual bool CanSeek() const { return false; }
+    virtual bool SeekTo(int64_t timestamp) { (void)timestamp; return false; }
+};
@@ -0,0 +1,183 @@
+/*
+    图像编码器接口
+    编码器输入为 BGRX32 或 8 位灰度（GRAY8）帧视图，输出为完整的图像文件字节流；
+    灰度输入编码为单通道图像（JPEG 单分量、PNG 灰度、8 位调色板 BMP、PGM）。
+    每个编码线程持有自己的编码器实例（编码器内部有可复用的缓冲，不是线程安全的）。
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "frame_source.h"
+#include "file_util.h"
+
+// 输出图像格式
+enum ImageFormat {
+    IMAGE_JPEG = 0,     // 内置基线 JPEG（可设质量）
+    IMAGE_PNG,          // 内置 PNG（可设压缩级别）
+    IMAGE_BMP,          // 不压缩的 32 位 BMP（灰度为 8 位）
+    IMAGE_PPM,          // 不压缩的二进制 PPM（P6；灰度为 PGM，P5）
+    IMAGE_FORMAT_COUNT
+};
+
+// 编码参数：quality 用于 JPEG（1-100），level 用于 PNG（0-9，0 为不压缩）
+struct EncoderOptions {
+    int format;
+    int quality;
+    int level;
+
+    EncoderOptions() : format(IMAGE_JPEG), quality(90), level(6) {}
+};
+
+class IImageEncoder {
+public:
+    virtual ~IImageEncoder() {}
+
+    // 输出文件扩展名（不含点），例如 "jpg"
+    virtual const char* Extension() const = 0;
+
+    // 把 BGRX32 或 GRAY8 视图编码为图像文件字节流，out 原有内容会被覆盖
+    virtual bool Encode(const FrameView& view, std::vector<uint8_t>& out) = 0;
+
+    // 编码并写入文件；默认先编码到内存再一次写出，直接写文件的后端可以覆盖
+    virtual bool EncodeToFile(const FrameView& view, const std::string& path) {
+        if (!Encode(view, m_fileBytes)) return false;
+        FILE* fp = OpenFileUtf8(path, "wb");
+        if (!fp) return false;
+        bool ok = fwrite(m_fileBytes.data(), 1, m_fileBytes.size(), fp) == m_fileBytes.size();
+        return (fclose(fp) == 0) && ok;
+    }
+
+protected:
+    std::vector<uint8_t> m_fileBytes;
+};
+
+// gray 为 true 时是灰度输出的扩展名（只有 PPM 不同：灰度写为 PGM）
+inline const char* ImageFormatExtension(int format, bool gray = false) {
+    switch (format) {
+    case IMAGE_JPEG: return "jpg";
+    case IMAGE_PNG: return "png";
+    case IMAGE_BMP: return "bmp";
+    case IMAGE_PPM: return gray ? "pgm" : "ppm";
+    default: return "";
+    }
+}
+
+inline void PutU16LE(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back((uint8_t)v);
+    out.push_back((uint8_t)(v >> 8));
+}
+
+inline void PutU32LE(std::vector<uint8_t>& out, uint32_t v) {
+    PutU16LE(out, v & 0xFFFF);
+    PutU16LE(out, v >> 16);
+}
+
+inline void PutU64LE(std::vector<uint8_t>& out, uint64_t v) {
+    PutU32LE(out, (uint32_t)v);
+    PutU32LE(out, (uint32_t)(v >> 32));
+}
+
+inline void PutU16BE(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back((uint8_t)(v >> 8));
+    out.push_back((uint8_t)v);
+}
+
+inline void PutU32BE(std::vector<uint8_t>& out, uint32_t v) {
+    PutU16BE(out, v >> 16);
+    PutU16BE(out, v & 0xFFFF);
+}
+
+// ==========================================
+// BMP：32 位自上而下，像素行原样复制，是最快的输出方式。
+// 灰度为 8 位自上而下，附 256 级灰阶调色板，每行补齐到 4 字节
+// ==========================================
+class BmpEncoder : public IImageEncoder {
+public:
+    const char* Extension() const override { return "bmp"; }
+
+    bool Encode(const FrameView& view, std::vector<uint8_t>& out) override {
+        bool gray = view.format == FRAME_GRAY8;
+        if ((view.format != FRAME_BGRX32 && !gray) || view.width <= 0 || view.height <= 0) return false;
+        size_t copyBytes = (size_t)view.width * FramePixelBytes(view.format);
+        size_t rowBytes = (copyBytes + 3) & ~(size_t)3;
+        size_t pixelBytes = rowBytes * view.height;
+        uint32_t headerBytes = gray ? 54 + 256 * 4 : 54;
+        out.clear();
+        out.reserve(headerBytes + pixelBytes);
+        // BITMAPFILEHEADER
+        out.push_back('B');
+        out.push_back('M');
+        PutU32LE(out, (uint32_t)(headerBytes + pixelBytes));
+        PutU32LE(out, 0);
+        PutU32LE(out, headerBytes);
+        // BITMAPINFOHEADER，高度为负表示自上而下
+        PutU32LE(out, 40);
+        PutU32LE(out, (uint32_t)view.width);
+        PutU32LE(out, (uint32_t)(-view.height));
+        PutU16LE(out, 1);
+        PutU16LE(out, gray ? 8 : 32);
+        PutU32LE(out, 0);   // BI_RGB
+        PutU32LE(out, (uint32_t)pixelBytes);
+        PutU32LE(out, 2835);
+        PutU32LE(out, 2835);
+        PutU32LE(out, gray ? 256 : 0);
+        PutU32LE(out, 0);
+        if (gray) {
+            for (uint32_t i = 0; i < 256; i++) PutU32LE(out, i * 0x010101u);
+        }
+        size_t offset = out.size();
+        out.resize(offset + pixelBytes, 0);
+        for (int y = 0; y < view.height; y++) {
+            memcpy(&out[offset + (size_t)y * rowBytes], view.data + (ptrdiff_t)y * view.stride, copyBytes);
+        }
+        return true;
+    }
+};
+
+// ==========================================
+// PPM（P6）：24 位 RGB，便于在 Linux 工具链中直接读取；灰度写为 PGM（P5），像素行原样复制
+// ==========================================
+class PpmEncoder : public IImageEncoder {
+public:
+    const char* Extension() const override { return "ppm"; }
+
+    bool Encode(const FrameView& view, std::vector<uint8_t>& out) override {
+        if (view.format == FRAME_GRAY8) return EncodeGray(view, out);
+        if (view.format != FRAME_BGRX32 || view.width <= 0 || view.height <= 0) return false;
+        char header[64];
+        int headerLen = snprintf(header, sizeof(header), "P6\n%d %d\n255\n", view.width, view.height);
+        out.assign(header, header + headerLen);
+        out.resize(headerLen + (size_t)view.width * 3 * view.height);
+        uint8_t* dst = &out[headerLen];
+        for (int y = 0; y < view.height; y++) {
+            const uint8_t* src = view.data + (ptrdiff_t)y * view.stride;
+            for (int x = 0; x < view.width; x++) {
+                dst[0] = src[2];
+                dst[1] = src[1];
+                dst[2] = src[0];
+                dst += 3;
+                src += 4;
+            }
+        }
+        return true;
+    }
+
+private:
+    static bool EncodeGray(const FrameView& view, std::vector<uint8_t>& out) {
+        if (view.width <= 0 || view.height <= 0) return false;
+        char header[64];
+        int headerLen = snprintf(header, sizeof(header), "P5\n%d %d\n255\n", view.width, view.height);
+        out.assign(header, header + headerLen);
+        out.resize(headerLen + (size_t)view.width * view.height);
+        for (int y = 0; y < view.height; y++) {
+            memcpy(&out[headerLen + (size_t)y * view.width], view.data + (ptrdiff_t)y * view.stride, (size_t)view.width);
+        }
+        return true;
+    }
+};
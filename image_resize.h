@@ -0,0 +1,362 @@
+/*
+    BGRX / 灰度图像缩放：可分离的两遍定点滤波
+    - 面积平均（RESIZE_AREA）：缩小时每个输出像素取覆盖的源像素按面积加权平均，放大时退化为双线性
+    - 双线性（RESIZE_BILINEAR）：像素中心对齐，边缘像素复制
+    权重为 14 位定点，每个输出像素的权重之和恰好为 1 << 14。
+    水平一遍的结果保留 7 位小数（int16），竖直一遍再合并并舍入到 8 位。
+    标量与 SSE2 版本使用完全相同的整数运算，输出逐位一致。
+    ResizeRoi() 把裁剪、颜色转换与缩放合成一遍：按源格式、输出格式与水平抽头数特化的内核逐行转换 ROI 源行后
+    立即水平滤波，不生成整个 ROI 的中间图像，结果与先 ConvertRoi() 再 Resize() 逐位一致。
+    与平台无关，非 x86 平台只使用标量版本。
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+#include "color_convert.h"
+#include "frame_source.h"
+#include "simd_config.h"
+
+enum ResizeFilter {
+    RESIZE_AREA = 0,
+    RESIZE_BILINEAR
+};
+
+static const int kResizeWeightBits = 14;
+static const int kResizeInterBits = 7;      // 水平结果保留的小数位数
+
+// ==========================================
+// 一个实例对应一组固定的源/目标尺寸，权重表在 Configure() 时生成。
+// 水平结果按源行缓存在环形缓冲中，每个源行只做一次水平滤波。
+// 不是线程安全的，每个解码线程持有自己的实例。
+// ==========================================
+class ImageResizer {
+public:
+    ImageResizer() : m_srcWidth(0), m_srcHeight(0), m_dstWidth(0), m_dstHeight(0), m_format(FRAME_BGRX32), m_channels(4), m_grayTaps(0) {}
+
+    // format 为 FRAME_BGRX32 或 FRAME_GRAY8，源与目标的像素格式相同
+    bool Configure(int srcWidth, int srcHeight, int dstWidth, int dstHeight, int filter, int format = FRAME_BGRX32) {
+        if (srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 || dstHeight <= 0) return false;
+        if (format != FRAME_BGRX32 && format != FRAME_GRAY8) return false;
+        m_srcWidth = srcWidth;
+        m_srcHeight = srcHeight;
+        m_dstWidth = dstWidth;
+        m_dstHeight = dstHeight;
+        m_format = format;
+        m_channels = FramePixelBytes(format);
+        BuildAxis(srcWidth, dstWidth, filter, m_horz);
+        BuildAxis(srcHeight, dstHeight, filter, m_vert);
+        // 灰度的 SSE2 水平滤波每次读 8 个相邻源像素：权重按 8 个一组补 0
+        m_grayTaps = (m_horz.taps + 7) & ~7;
+        m_grayWeights.assign(format == FRAME_GRAY8 ? (size_t)dstWidth * m_grayTaps : 0, 0);
+        for (int x = 0; x < dstWidth && format == FRAME_GRAY8; x++) {
+            memcpy(&m_grayWeights[(size_t)x * m_grayTaps], &m_horz.weights[(size_t)x * m_horz.taps], m_horz.taps * sizeof(int16_t));
+        }
+        m_ring.assign((size_t)m_vert.taps * dstWidth * m_channels, 0);
+        m_ringRows.assign(m_vert.taps, -1);
+        m_rowPointers.assign(m_vert.taps, nullptr);
+        m_rowBuffer.assign((size_t)srcWidth * m_channels, 0);
+        return true;
+    }
+
+    int DstWidth() const { return m_dstWidth; }
+    int DstHeight() const { return m_dstHeight; }
+
+    // src 的像素格式与尺寸必须与 Configure() 一致
+    bool Resize(const FrameView& src, uint8_t* dst, int dstStride, ColorKernelLevel level = COLOR_KERNEL_AUTO) {
+        if (src.format != m_format || src.width != m_srcWidth || src.height != m_srcHeight) return false;
+        RoiRect full = { 0, 0, src.width, src.height };
+        return ResizeRoi(src, full, dst, dstStride, level);
+    }
+
+    // 裁剪、颜色转换与缩放一遍完成：frame 为解码器的帧（NV12 / I420 / BGRX32，或与输出格式相同的 GRAY8），
+    // roi 调整到画面范围后的尺寸必须与 Configure() 的源尺寸一致，输出为 Configure() 的像素格式。
+    // 只转换竖直滤波用到的源行，每行转换到行缓冲后立即做水平滤波，不生成整个 ROI 的中间图像。
+    // 没有特化的格式组合退回先转换整个 ROI 再缩放
+    bool ResizeRoi(const FrameView& frame, RoiRect roi, uint8_t* dst, int dstStride, ColorKernelLevel level = COLOR_KERNEL_AUTO) {
+        if (!frame.data || !ClampRoi(roi, frame.width, frame.height)) return false;
+        if (roi.right - roi.left != m_srcWidth || roi.bottom - roi.top != m_srcHeight) return false;
+        FusedKernel kernel = SelectKernel(frame.format);
+        if (kernel) {
+            (this->*kernel)(frame, roi, dst, dstStride, level);
+            return true;
+        }
+        FrameView converted = FrameView();
+        converted.width = m_srcWidth;
+        converted.height = m_srcHeight;
+        converted.stride = m_srcWidth * m_channels;
+        converted.format = m_format;
+        m_converted.resize((size_t)converted.stride * converted.height);
+        converted.data = m_converted.data();
+        if (!ConvertRoi(frame, roi, m_format, m_converted.data(), converted.stride, level)) return false;
+        RoiRect full = { 0, 0, m_srcWidth, m_srcHeight };
+        (this->*SelectKernel(m_format))(converted, full, dst, dstStride, level);
+        return true;
+    }
+
+private:
+    typedef void (ImageResizer::*FusedKernel)(const FrameView&, const RoiRect&, uint8_t*, int, ColorKernelLevel);
+
+    // 源格式 Src、输出格式 Dst 与水平抽头数 Taps 在编译期确定的一遍缩放。
+    // Taps 为 2 时是双线性（以及面积平均放大），为 0 时使用运行时的面积平均抽头数。
+    // 源行按竖直滤波的需要转换到行缓冲（几 KB，留在 L1），水平结果放在 taps 行的环形缓冲，每个输出行只写一次
+    template <int Src, int Dst, int Taps>
+    void ResizeRoiKernel(const FrameView& frame, const RoiRect& roi, uint8_t* dst, int dstStride, ColorKernelLevel level) {
+        bool simd = false;
+#ifdef D2F_X86
+        simd = level != COLOR_KERNEL_SCALAR;
+#endif
+        YuvRowKernel yuvKernel = GetYuvRowKernel(level);
+        GrayRowKernel grayKernel = GetGrayRowKernel(level);
+        const int taps = m_vert.taps;
+        const int rowValues = m_dstWidth * m_channels;
+        for (int r = 0; r < taps; r++) m_ringRows[r] = -1;
+        for (int y = 0; y < m_dstHeight; y++) {
+            const int* index = &m_vert.index[(size_t)y * taps];
+            for (int k = 0; k < taps; k++) {
+                int sy = index[k];
+                int slot = sy % taps;
+                int16_t* row = &m_ring[(size_t)slot * rowValues];
+                if (m_ringRows[slot] != sy) {
+                    const uint8_t* srcRow = LoadRow<Src, Dst>(frame, roi, sy, yuvKernel, grayKernel);
+                    HorizontalRow<Dst, Taps>(srcRow, row, simd);
+                    m_ringRows[slot] = sy;
+                }
+                m_rowPointers[k] = row;
+            }
+            const int16_t* weights = &m_vert.weights[(size_t)y * taps];
+            uint8_t* out = dst + (ptrdiff_t)y * dstStride;
+#ifdef D2F_X86
+            if (simd) VerticalRow_SSE2(m_rowPointers.data(), weights, out);
+            else
+#endif
+            VerticalRow_Scalar(m_rowPointers.data(), weights, 0, out);
+        }
+    }
+
+    // ROI 内第 sy 行的 Dst 格式像素：格式相同时直接指向源帧，否则转换到行缓冲
+    template <int Src, int Dst>
+    const uint8_t* LoadRow(const FrameView& frame, const RoiRect& roi, int sy, YuvRowKernel yuvKernel, GrayRowKernel grayKernel) {
+        const int y = roi.top + sy;
+        const uint8_t* row = frame.data + (ptrdiff_t)y * frame.stride;
+        if (Src == Dst) return row + (ptrdiff_t)roi.left * FramePixelBytes(Dst);
+        uint8_t* out = m_rowBuffer.data();
+        if (Src == FRAME_BGRX32) BgrxRowToGray(row + (ptrdiff_t)roi.left * 4, m_srcWidth, out);
+        else if (Dst == FRAME_GRAY8) grayKernel(row + roi.left, m_srcWidth, out);
+        else YuvRoiRowToBgrx(frame, y, roi.left, m_srcWidth, out, yuvKernel);
+        return out;
+    }
+
+    template <int Dst, int Taps>
+    void HorizontalRow(const uint8_t* src, int16_t* out, bool simd) const {
+#ifdef D2F_X86
+        if (simd) {
+            if (Dst == FRAME_GRAY8) HorizontalGrayRow_SSE2(src, out);
+            else HorizontalRow_SSE2<Taps>(src, out);
+            return;
+        }
+#else
+        (void)simd;
+#endif
+        HorizontalRow_Scalar<Dst == FRAME_GRAY8 ? 1 : 4, Taps>(src, out);
+    }
+
+    template <int Src, int Dst>
+    FusedKernel PickKernel() const {
+        return m_horz.taps == 2 ? &ImageResizer::ResizeRoiKernel<Src, Dst, 2> : &ImageResizer::ResizeRoiKernel<Src, Dst, 0>;
+    }
+
+    // 特化的组合：YUV（NV12 与 I420 只在行转换内部不同，共用一个实例）与 BGRX32 到两种输出格式，
+    // 以及 GRAY8 到 GRAY8；其他组合返回空，由调用方走通用路径
+    FusedKernel SelectKernel(int srcFormat) const {
+        bool gray = m_format == FRAME_GRAY8;
+        switch (srcFormat) {
+        case FRAME_NV12:
+        case FRAME_I420: return gray ? PickKernel<FRAME_I420, FRAME_GRAY8>() : PickKernel<FRAME_I420, FRAME_BGRX32>();
+        case FRAME_BGRX32: return gray ? PickKernel<FRAME_BGRX32, FRAME_GRAY8>() : PickKernel<FRAME_BGRX32, FRAME_BGRX32>();
+        case FRAME_GRAY8: return gray ? PickKernel<FRAME_GRAY8, FRAME_GRAY8>() : nullptr;
+        default: return nullptr;
+        }
+    }
+
+    // 每个输出位置 taps 个（偶数个，便于成对相乘）源下标与权重，不足的位置权重为 0
+    struct Axis {
+        int taps;
+        std::vector<int> index;
+        std::vector<int16_t> weights;
+    };
+
+    static void BuildAxis(int src, int dst, int filter, Axis& axis) {
+        double scale = (double)src / dst;
+        bool area = filter == RESIZE_AREA && dst < src;
+        int taps = area ? (int)std::ceil(scale) + 1 : 2;
+        taps = (taps + 1) & ~1;
+        axis.taps = taps;
+        axis.index.assign((size_t)dst * taps, 0);
+        axis.weights.assign((size_t)dst * taps, 0);
+
+        std::vector<double> w(taps);
+        for (int i = 0; i < dst; i++) {
+            int start;
+            for (int k = 0; k < taps; k++) w[k] = 0.0;
+            if (area) {
+                double x0 = i * scale, x1 = (i + 1) * scale;
+                start = (int)std::floor(x0);
+                for (int k = 0; k < taps && start + k < x1; k++) {
+                    double lo = std::max(x0, (double)(start + k));
+                    double hi = std::min(x1, (double)(start + k + 1));
+                    if (hi > lo) w[k] = (hi - lo) / scale;
+                }
+            }
+            else {
+                double center = (i + 0.5) * scale - 0.5;
+                start = (int)std::floor(center);
+                double frac = center - start;
+                if (start < 0) { start = 0; frac = 0.0; }
+                if (start >= src - 1) { start = src - 1; frac = 0.0; }
+                w[0] = 1.0 - frac;
+                w[1] = frac;
+            }
+
+            // 量化后把误差补到最大的权重上，权重和恰好为 1 << kResizeWeightBits
+            int16_t* qw = &axis.weights[(size_t)i * taps];
+            int* qi = &axis.index[(size_t)i * taps];
+            int sum = 0, largest = 0;
+            for (int k = 0; k < taps; k++) {
+                qw[k] = (int16_t)std::lround(w[k] * (1 << kResizeWeightBits));
+                qi[k] = std::min(start + k, src - 1);
+                sum += qw[k];
+                if (qw[k] > qw[largest]) largest = k;
+            }
+            qw[largest] = (int16_t)(qw[largest] + (1 << kResizeWeightBits) - sum);
+        }
+    }
+
+    // 通道数 C 为 4（BGRX）或 1（灰度）；Taps 为 0 时使用运行时的抽头数
+    template <int C, int Taps>
+    void HorizontalRow_Scalar(const uint8_t* src, int16_t* out) const {
+        const int taps = Taps ? Taps : m_horz.taps;
+        const int stride = m_horz.taps;
+        for (int x = 0; x < m_dstWidth; x++) {
+            const int* index = &m_horz.index[(size_t)x * stride];
+            const int16_t* weights = &m_horz.weights[(size_t)x * stride];
+            int acc[C] = {};
+            for (int k = 0; k < taps; k++) {
+                const uint8_t* p = src + index[k] * C;
+                for (int c = 0; c < C; c++) acc[c] += weights[k] * p[c];
+            }
+            for (int c = 0; c < C; c++) {
+                out[x * C + c] = (int16_t)((acc[c] + (1 << (kResizeWeightBits - kResizeInterBits - 1))) >> (kResizeWeightBits - kResizeInterBits));
+            }
+        }
+    }
+
+    // 从第 i0 个通道值开始的标量竖直滤波（SSE2 版本用它处理行尾）
+    void VerticalRow_Scalar(const int16_t* const* rows, const int16_t* weights, int i0, uint8_t* out) const {
+        const int taps = m_vert.taps;
+        const int shift = kResizeWeightBits + kResizeInterBits;
+        for (int i = i0; i < m_dstWidth * m_channels; i++) {
+            int acc = 0;
+            for (int k = 0; k < taps; k++) acc += weights[k] * rows[k][i];
+            out[i] = ClampToByte((acc + (1 << (shift - 1))) >> shift);
+        }
+    }
+
+#ifdef D2F_X86
+    // 每次处理一个输出像素（4 个通道），源像素两两交错后用 madd 同时乘两个权重
+    template <int Taps>
+    void HorizontalRow_SSE2(const uint8_t* src, int16_t* out) const {
+        const int taps = Taps ? Taps : m_horz.taps;
+        const int stride = m_horz.taps;
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i round = _mm_set1_epi32(1 << (kResizeWeightBits - kResizeInterBits - 1));
+        for (int x = 0; x < m_dstWidth; x++) {
+            const int* index = &m_horz.index[(size_t)x * stride];
+            const int16_t* weights = &m_horz.weights[(size_t)x * stride];
+            __m128i acc = round;
+            for (int k = 0; k < taps; k += 2) {
+                int pa, pb;
+                memcpy(&pa, src + index[k] * 4, 4);
+                memcpy(&pb, src + index[k + 1] * 4, 4);
+                __m128i a = _mm_cvtsi32_si128(pa);
+                __m128i b = _mm_cvtsi32_si128(pb);
+                __m128i ab = _mm_unpacklo_epi8(_mm_unpacklo_epi8(a, b), zero);
+                __m128i w = _mm_set1_epi32((int)(((uint32_t)(uint16_t)weights[k + 1] << 16) | (uint16_t)weights[k]));
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(ab, w));
+            }
+            acc = _mm_srai_epi32(acc, kResizeWeightBits - kResizeInterBits);
+            _mm_storel_epi64((__m128i*)(out + x * 4), _mm_packs_epi32(acc, acc));
+        }
+    }
+
+    // 灰度：一个输出像素的源下标是连续的（只有右边缘被截断），8 个相邻源像素与补 0 的权重一次 madd，最后横向求和。
+    // 8 个一组会读到画面外的像素用标量处理
+    void HorizontalGrayRow_SSE2(const uint8_t* src, int16_t* out) const {
+        const int taps = m_horz.taps, padded = m_grayTaps;
+        const int shift = kResizeWeightBits - kResizeInterBits;
+        const __m128i zero = _mm_setzero_si128();
+        for (int x = 0; x < m_dstWidth; x++) {
+            const int* index = &m_horz.index[(size_t)x * taps];
+            if (index[0] + padded > m_srcWidth) {
+                int acc = 0;
+                for (int k = 0; k < taps; k++) acc += m_horz.weights[(size_t)x * taps + k] * src[index[k]];
+                out[x] = (int16_t)((acc + (1 << (shift - 1))) >> shift);
+                continue;
+            }
+            const uint8_t* p = src + index[0];
+            const int16_t* weights = &m_grayWeights[(size_t)x * padded];
+            __m128i acc = zero;
+            for (int k = 0; k < padded; k += 8) {
+                __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(p + k)), zero);
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(v, _mm_loadu_si128((const __m128i*)(weights + k))));
+            }
+            acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+            acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+            out[x] = (int16_t)((_mm_cvtsi128_si32(acc) + (1 << (shift - 1))) >> shift);
+        }
+    }
+
+    // 每次处理 8 个通道值（2 个 BGRX 像素或 8 个灰度像素），两个源行交错后用 madd 同时乘两个权重
+    void VerticalRow_SSE2(const int16_t* const* rows, const int16_t* weights, uint8_t* out) const {
+        const int taps = m_vert.taps;
+        const int shift = kResizeWeightBits + kResizeInterBits;
+        const __m128i round = _mm_set1_epi32(1 << (shift - 1));
+        const int count = m_dstWidth * m_channels;
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m128i lo = round, hi = round;
+            for (int k = 0; k < taps; k += 2) {
+                __m128i a = _mm_loadu_si128((const __m128i*)(rows[k] + i));
+                __m128i b = _mm_loadu_si128((const __m128i*)(rows[k + 1] + i));
+                __m128i w = _mm_set1_epi32((int)(((uint32_t)(uint16_t)weights[k + 1] << 16) | (uint16_t)weights[k]));
+                lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), w));
+                hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), w));
+            }
+            __m128i v = _mm_packs_epi32(_mm_srai_epi32(lo, shift), _mm_srai_epi32(hi, shift));
+            _mm_storel_epi64((__m128i*)(out + i), _mm_packus_epi16(v, v));
+        }
+        VerticalRow_Scalar(rows, weights, i, out);
+    }
+#endif
+
+    int m_srcWidth;
+    int m_srcHeight;
+    int m_dstWidth;
+    int m_dstHeight;
+    int m_format;
+    int m_channels;                     // 每像素的字节数：BGRX 为 4，灰度为 1
+    Axis m_horz;
+    Axis m_vert;
+    int m_grayTaps;                         // 灰度水平权重补齐到 8 的倍数后的个数
+    std::vector<int16_t> m_grayWeights;
+    std::vector<int16_t> m_ring;        // taps 行水平结果，源行 sy 存在第 sy % taps 行
+    std::vector<int> m_ringRows;        // 环形缓冲每一行当前对应的源行，-1 表示空
+    std::vector<const int16_t*> m_rowPointers;  // 当前输出行用到的 taps 个环形缓冲行
+    std::vector<uint8_t> m_rowBuffer;   // 一个转换后的 ROI 源行
+    std::vector<uint8_t> m_converted;   // 通用路径：整个 ROI 的转换结果，用到时才分配
+};
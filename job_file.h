@@ -0,0 +1,556 @@
+/*
+    JSON 任务文件：命令行前端用它描述一次或多次批量提取
+    文件内容为一个任务对象，或 {"jobs": [任务, ...]}。任务对象：
+        {
+            "inputs":   ["a.mp4", "videos/"],              视频文件或目录（目录只扫描一级，按后端支持的扩展名筛选）
+            "output":   "frames",                         输出根目录
+            "sampling": {"mode": "frames", "interval": 0}, 或 {"mode": "seconds", "value": 0.5}、{"mode": "fps", "value": 2}、
+                        {"mode": "list", "file": "picks.csv"}     只保存帧列表中的帧（见 frame_list.h），列表中没有的视频不处理；
+                        {"mode": "list", "frames": [1, 300], "seconds": [12.5]}  也可以直接给出，对每个视频都适用
+            "dedup":    0,                                去重阈值，0 表示关闭
+            "trace":    false,                            记录各阶段耗时，输出根目录下写出 pipeline_trace.json（见 pipeline_trace.h）
+            "resume":   true,                             按清单跳过已完成的视频、续传未完成的视频（见 extract_manifest.h）
+            "fsync":    false,                            每个图像文件写出后 fsync（见 write_behind.h）
+            "write_buffer_mb": 64,                        写出队列中待写数据的上限
+            "memory_budget_mb": 0,                        在途帧与待写数据的内存上限，0 表示不限（见 memory_budget.h）
+            "segment_seconds": 300,                       长视频按关键帧切成不短于这么多秒的段并行解码，0 表示不分段
+            "frame_index": "auto",                        帧索引："auto"、"always" 或 "off"（见 frame_index.h）
+            "index_dir": "cache",                         帧索引的缓存目录，省略时放在视频旁边
+            "outputs":  [                                 省略时为一个整帧 JPEG 输出
+                {"format": "jpg", "quality": 90},
+                {"dir": "thumbs", "size": [224, 224], "filter": "area", "format": "png", "level": 6},
+                {"dir": "face", "roi": [600, 200, 1000, 600], "format": "npy", "channels": "gray"},
+                "dir=small size=320x0 format=bmp"          也可以直接写附加输出的文本格式
+            ]
+        }
+    相对路径相对于任务文件所在的目录。输出对象的键与附加输出的 键=值 相同，dir 省略时直接输出到根目录。
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "extract_engine.h"
+#include "file_util.h"
+#include "frame_list.h"
+#include "output_spec.h"
+#include "video_decoder.h"
+
+// ==========================================
+// 最小的 JSON 值与解析器：只支持任务文件需要的部分（\u 转义不合并代理对）
+// ==========================================
+struct JsonValue {
+    enum Type { JSON_NULL = 0, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT };
+
+    Type type;
+    bool boolean;
+    double number;
+    std::string text;
+    std::vector<JsonValue> items;                               // 数组元素
+    std::vector<std::pair<std::string, JsonValue>> members;     // 对象成员，保持原顺序
+
+    JsonValue() : type(JSON_NULL), boolean(false), number(0.0) {}
+
+    // 对象成员，不存在时返回 NULL
+    const JsonValue* Find(const std::string& key) const {
+        for (size_t i = 0; i < members.size(); ++i) {
+            if (members[i].first == key) return &members[i].second;
+        }
+        return NULL;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : m_text(text), m_pos(0) {}
+
+    // 解析整个文本；失败时 error 为带位置的说明
+    bool Parse(JsonValue* value, std::string* error) {
+        if (!ParseValue(value, 0) || (SkipSpace(), m_pos != m_text.size())) {
+            if (m_error.empty()) m_error = "多余的内容";
+            char where[64];
+            snprintf(where, sizeof(where), "第 %zu 行: ", Line());
+            *error = where + m_error;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    JsonParser(const JsonParser&) = delete;
+    JsonParser& operator=(const JsonParser&) = delete;
+
+    static const int kMaxDepth = 64;
+
+    size_t Line() const {
+        size_t line = 1;
+        for (size_t i = 0; i < m_pos && i < m_text.size(); ++i) {
+            if (m_text[i] == '\n') line++;
+        }
+        return line;
+    }
+
+    bool Fail(const char* message) {
+        if (m_error.empty()) m_error = message;
+        return false;
+    }
+
+    void SkipSpace() {
+        while (m_pos < m_text.size() && (m_text[m_pos] == ' ' || m_text[m_pos] == '\t' || m_text[m_pos] == '\r' || m_text[m_pos] == '\n')) m_pos++;
+    }
+
+    bool Match(const char* literal) {
+        size_t n = strlen(literal);
+        if (m_text.compare(m_pos, n, literal) != 0) return false;
+        m_pos += n;
+        return true;
+    }
+
+    bool ParseValue(JsonValue* value, int depth) {
+        if (depth > kMaxDepth) return Fail("嵌套层数过多");
+        SkipSpace();
+        if (m_pos >= m_text.size()) return Fail("意外的结尾");
+        *value = JsonValue();
+        char c = m_text[m_pos];
+        if (c == '{') return ParseObject(value, depth);
+        if (c == '[') return ParseArray(value, depth);
+        if (c == '"') {
+            value->type = JsonValue::JSON_STRING;
+            return ParseString(&value->text);
+        }
+        if (Match("true")) { value->type = JsonValue::JSON_BOOL; value->boolean = true; return true; }
+        if (Match("false")) { value->type = JsonValue::JSON_BOOL; return true; }
+        if (Match("null")) return true;
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            const char* begin = m_text.c_str() + m_pos;
+            char* end = NULL;
+            value->type = JsonValue::JSON_NUMBER;
+            value->number = strtod(begin, &end);
+            if (end == begin) return Fail("无效的数字");
+            m_pos += end - begin;
+            return true;
+        }
+        return Fail("无法识别的值");
+    }
+
+    bool ParseObject(JsonValue* value, int depth) {
+        value->type = JsonValue::JSON_OBJECT;
+        m_pos++;
+        SkipSpace();
+        if (m_pos < m_text.size() && m_text[m_pos] == '}') { m_pos++; return true; }
+        for (;;) {
+            SkipSpace();
+            std::pair<std::string, JsonValue> member;
+            if (m_pos >= m_text.size() || m_text[m_pos] != '"') return Fail("缺少键名");
+            if (!ParseString(&member.first)) return false;
+            SkipSpace();
+            if (m_pos >= m_text.size() || m_text[m_pos] != ':') return Fail("缺少 ':'");
+            m_pos++;
+            if (!ParseValue(&member.second, depth + 1)) return false;
+            value->members.push_back(member);
+            SkipSpace();
+            if (m_pos < m_text.size() && m_text[m_pos] == ',') { m_pos++; continue; }
+            if (m_pos < m_text.size() && m_text[m_pos] == '}') { m_pos++; return true; }
+            return Fail("缺少 ',' 或 '}'");
+        }
+    }
+
+    bool ParseArray(JsonValue* value, int depth) {
+        value->type = JsonValue::JSON_ARRAY;
+        m_pos++;
+        SkipSpace();
+        if (m_pos < m_text.size() && m_text[m_pos] == ']') { m_pos++; return true; }
+        for (;;) {
+            JsonValue item;
+            if (!ParseValue(&item, depth + 1)) return false;
+            value->items.push_back(item);
+            SkipSpace();
+            if (m_pos < m_text.size() && m_text[m_pos] == ',') { m_pos++; continue; }
+            if (m_pos < m_text.size() && m_text[m_pos] == ']') { m_pos++; return true; }
+            return Fail("缺少 ',' 或 ']'");
+        }
+    }
+
+    // 字符串按 UTF-8 原样保留，\uXXXX 转为 UTF-8
+    bool ParseString(std::string* out) {
+        m_pos++;
+        while (m_pos < m_text.size()) {
+            char c = m_text[m_pos++];
+            if (c == '"') return true;
+            if (c != '\\') { *out += c; continue; }
+            if (m_pos >= m_text.size()) break;
+            char e = m_text[m_pos++];
+            switch (e) {
+            case '"': case '\\': case '/': *out += e; break;
+            case 'b': *out += '\b'; break;
+            case 'f': *out += '\f'; break;
+            case 'n': *out += '\n'; break;
+            case 'r': *out += '\r'; break;
+            case 't': *out += '\t'; break;
+            case 'u': {
+                if (m_pos + 4 > m_text.size()) return Fail("无效的 \\u 转义");
+                unsigned code = (unsigned)strtoul(m_text.substr(m_pos, 4).c_str(), NULL, 16);
+                m_pos += 4;
+                if (code < 0x80) {
+                    *out += (char)code;
+                } else if (code < 0x800) {
+                    *out += (char)(0xC0 | (code >> 6));
+                    *out += (char)(0x80 | (code & 0x3F));
+                } else {
+                    *out += (char)(0xE0 | (code >> 12));
+                    *out += (char)(0x80 | ((code >> 6) & 0x3F));
+                    *out += (char)(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default: return Fail("无效的转义");
+            }
+        }
+        return Fail("字符串没有结束");
+    }
+
+    const std::string& m_text;
+    size_t m_pos;
+    std::string m_error;
+};
+
+// 把 JSON 标量写成附加输出文本格式中的值：数组用 sep 连接，布尔写成 1/0
+inline std::string JsonSpecValue(const JsonValue& v, const char* sep) {
+    char num[32];
+    switch (v.type) {
+    case JsonValue::JSON_STRING: return v.text;
+    case JsonValue::JSON_BOOL: return v.boolean ? "1" : "0";
+    case JsonValue::JSON_NUMBER:
+        snprintf(num, sizeof(num), "%g", v.number);
+        return num;
+    case JsonValue::JSON_ARRAY: {
+        std::string s;
+        for (size_t i = 0; i < v.items.size(); ++i) {
+            if (i > 0) s += sep;
+            s += JsonSpecValue(v.items[i], sep);
+        }
+        return s;
+    }
+    default: return std::string();
+    }
+}
+
+// 解析一个输出：对象按键转换为 键=值 文本后与附加输出共用同一个解析函数
+inline bool ParseJobOutput(const JsonValue& v, OutputSpec* spec, std::string* error) {
+    if (v.type == JsonValue::JSON_STRING) return ParseOutputSpec(v.text, spec, error);
+    if (v.type != JsonValue::JSON_OBJECT) {
+        *error = "输出应为对象或字符串";
+        return false;
+    }
+    std::string line;
+    for (size_t i = 0; i < v.members.size(); ++i) {
+        const std::string& key = v.members[i].first;
+        std::string value = JsonSpecValue(v.members[i].second, key == "size" ? "x" : ",");
+        if (value.find_first_of(" \t") != std::string::npos) {
+            *error = key + " 不能包含空格";
+            return false;
+        }
+        line += key + "=" + value + " ";
+    }
+    return ParseOutputSpec(line, spec, error);
+}
+
+// 按帧列表采样：sampling 中的 frames / seconds 适用于每个视频，file 指定的 CSV 按视频列分配；
+// 列表为空的视频从任务中去掉，CSV 中的视频不在 inputs 中时视为错误（多半是写错了文件名）
+inline bool ParseJobFrameLists(const JsonValue& sampling, const std::string& baseDir, ExtractionJob* job, std::string* error) {
+    FrameList common;
+    const JsonValue* frames = sampling.Find("frames");
+    const JsonValue* seconds = sampling.Find("seconds");
+    const JsonValue* file = sampling.Find("file");
+    for (int pass = 0; pass < 2; ++pass) {
+        const JsonValue* items = pass == 0 ? frames : seconds;
+        if (!items) continue;
+        if (items->type != JsonValue::JSON_ARRAY) {
+            *error = pass == 0 ? "sampling.frames 应为数组" : "sampling.seconds 应为数组";
+            return false;
+        }
+        for (size_t i = 0; i < items->items.size(); ++i) {
+            const JsonValue& item = items->items[i];
+            bool ok = item.type == JsonValue::JSON_NUMBER;
+            if (ok && pass == 0) ok = item.number >= 1.0 && item.number <= 0x7FFFFFFF && item.number == (double)(int)item.number;
+            if (ok && pass == 1) ok = item.number >= 0.0 && item.number < 1e9;
+            if (!ok) {
+                *error = pass == 0 ? "sampling.frames 的元素应为正整数" : "sampling.seconds 的元素应为非负数";
+                return false;
+            }
+            if (pass == 0) common.frames.push_back((int)item.number);
+            else common.times.push_back((int64_t)std::llround(item.number * 10000000.0));
+        }
+    }
+
+    std::vector<std::pair<std::string, FrameList>> lists;
+    std::string listDir;
+    if (file) {
+        if (file->type != JsonValue::JSON_STRING || file->text.empty()) {
+            *error = "sampling.file 应为 CSV 文件";
+            return false;
+        }
+        std::string path = IsAbsolutePath(file->text) ? file->text : JoinPath(baseDir, file->text);
+        if (!LoadFrameListCsv(path, &lists, error)) return false;
+        listDir = ParentDirectory(path);
+    }
+    else if (common.Empty()) {
+        *error = "sampling.mode 为 list 时需要 file、frames 或 seconds";
+        return false;
+    }
+
+    std::vector<bool> used(lists.size(), false);
+    std::vector<std::string> files;
+    for (size_t f = 0; f < job->files.size(); ++f) {
+        FrameList list = common;
+        for (size_t k = 0; k < lists.size(); ++k) {
+            if (!FrameListNamesFile(lists[k].first, listDir, job->files[f])) continue;
+            list.frames.insert(list.frames.end(), lists[k].second.frames.begin(), lists[k].second.frames.end());
+            list.times.insert(list.times.end(), lists[k].second.times.begin(), lists[k].second.times.end());
+            used[k] = true;
+        }
+        if (list.Empty()) continue;
+        list.Normalize();
+        files.push_back(job->files[f]);
+        job->frameLists.push_back(list);
+    }
+    for (size_t k = 0; k < lists.size(); ++k) {
+        if (!used[k]) {
+            *error = "帧列表中的视频不在 inputs 中: " + lists[k].first;
+            return false;
+        }
+    }
+    if (files.empty()) {
+        *error = "帧列表为空";
+        return false;
+    }
+    job->files.swap(files);
+    return true;
+}
+
+// 解析一个任务对象；baseDir 用于解析相对路径，backend 决定目录扫描时收录哪些文件
+inline bool ParseJob(const JsonValue& v, const std::string& baseDir, const IDecoderBackend& backend,
+                     ExtractionJob* job, std::string* error) {
+    *job = ExtractionJob();
+    if (v.type != JsonValue::JSON_OBJECT) {
+        *error = "任务应为对象";
+        return false;
+    }
+    for (size_t i = 0; i < v.members.size(); ++i) {
+        const std::string& key = v.members[i].first;
+        if (key != "inputs" && key != "output" && key != "sampling" && key != "dedup" && key != "trace" &&
+            key != "resume" && key != "fsync" && key != "write_buffer_mb" &&
+            key != "memory_budget_mb" && key != "segment_seconds" &&
+            key != "frame_index" && key != "index_dir" && key != "outputs") {
+            *error = "未知的键: " + key;
+            return false;
+        }
+    }
+    auto resolve = [&](const std::string& path) { return IsAbsolutePath(path) ? path : JoinPath(baseDir, path); };
+
+    // 输入：文件直接加入，目录按扩展名筛选
+    const JsonValue* inputs = v.Find("inputs");
+    if (!inputs || inputs->type != JsonValue::JSON_ARRAY || inputs->items.empty()) {
+        *error = "inputs 应为非空数组";
+        return false;
+    }
+    for (size_t i = 0; i < inputs->items.size(); ++i) {
+        if (inputs->items[i].type != JsonValue::JSON_STRING) {
+            *error = "inputs 的元素应为字符串";
+            return false;
+        }
+        std::string path = resolve(inputs->items[i].text);
+        if (IsDirectoryUtf8(path)) {
+            std::vector<std::string> files;
+            ListFilesUtf8(path, &files);
+            for (size_t f = 0; f < files.size(); ++f) {
+                if (backend.IsVideoFile(files[f])) job->files.push_back(files[f]);
+            }
+        } else {
+            job->files.push_back(path);
+        }
+    }
+
+    const JsonValue* output = v.Find("output");
+    if (!output || output->type != JsonValue::JSON_STRING || output->text.empty()) {
+        *error = "缺少 output";
+        return false;
+    }
+    job->outputDir = resolve(output->text);
+
+    if (const JsonValue* sampling = v.Find("sampling")) {
+        const JsonValue* mode = sampling->Find("mode");
+        const JsonValue* interval = sampling->Find("interval");
+        const JsonValue* value = sampling->Find("value");
+        std::string m = mode && mode->type == JsonValue::JSON_STRING ? mode->text : "frames";
+        if (m == "frames") job->sampling.mode = SAMPLE_FRAMES;
+        else if (m == "seconds") job->sampling.mode = SAMPLE_SECONDS;
+        else if (m == "fps") job->sampling.mode = SAMPLE_FPS;
+        else if (m == "list") job->sampling.mode = SAMPLE_LIST;
+        else {
+            *error = "sampling.mode 应为 frames、seconds、fps 或 list: " + m;
+            return false;
+        }
+        if (interval && interval->type == JsonValue::JSON_NUMBER) job->sampling.interval = (int)interval->number;
+        if (value && value->type == JsonValue::JSON_NUMBER) job->sampling.value = value->number;
+        if (job->sampling.interval < 0 || (job->sampling.mode != SAMPLE_FRAMES && job->sampling.value <= 0.0)) {
+            *error = "sampling 的间隔无效";
+            return false;
+        }
+        if (job->sampling.mode == SAMPLE_LIST && !ParseJobFrameLists(*sampling, baseDir, job, error)) return false;
+    }
+
+    if (const JsonValue* dedup = v.Find("dedup")) {
+        if (dedup->type != JsonValue::JSON_NUMBER || dedup->number < 0.0) {
+            *error = "dedup 应为非负数";
+            return false;
+        }
+        job->dedupThreshold = dedup->number;
+    }
+
+    if (const JsonValue* trace = v.Find("trace")) {
+        if (trace->type != JsonValue::JSON_BOOL) {
+            *error = "trace 应为 true 或 false";
+            return false;
+        }
+        job->trace = trace->boolean;
+    }
+
+    if (const JsonValue* resume = v.Find("resume")) {
+        if (resume->type != JsonValue::JSON_BOOL) {
+            *error = "resume 应为 true 或 false";
+            return false;
+        }
+        job->resume = resume->boolean;
+    }
+
+    if (const JsonValue* fsync = v.Find("fsync")) {
+        if (fsync->type != JsonValue::JSON_BOOL) {
+            *error = "fsync 应为 true 或 false";
+            return false;
+        }
+        job->durability = fsync->boolean ? DURABILITY_FSYNC : DURABILITY_NONE;
+    }
+
+    if (const JsonValue* buffer = v.Find("write_buffer_mb")) {
+        if (buffer->type != JsonValue::JSON_NUMBER || buffer->number <= 0.0) {
+            *error = "write_buffer_mb 应为正数";
+            return false;
+        }
+        job->writeBufferBytes = (size_t)(buffer->number * 1024 * 1024);
+    }
+
+    if (const JsonValue* budget = v.Find("memory_budget_mb")) {
+        if (budget->type != JsonValue::JSON_NUMBER || budget->number < 0.0) {
+            *error = "memory_budget_mb 应为非负数";
+            return false;
+        }
+        job->memoryBudgetBytes = (size_t)(budget->number * 1024 * 1024);
+    }
+
+    if (const JsonValue* segment = v.Find("segment_seconds")) {
+        if (segment->type != JsonValue::JSON_NUMBER || segment->number < 0.0) {
+            *error = "segment_seconds 应为非负数";
+            return false;
+        }
+        job->segmentSeconds = segment->number;
+    }
+
+    if (const JsonValue* index = v.Find("frame_index")) {
+        if (index->type == JsonValue::JSON_STRING && index->text == "auto") job->frameIndex = FRAME_INDEX_AUTO;
+        else if (index->type == JsonValue::JSON_STRING && index->text == "always") job->frameIndex = FRAME_INDEX_ALWAYS;
+        else if (index->type == JsonValue::JSON_STRING && index->text == "off") job->frameIndex = FRAME_INDEX_OFF;
+        else {
+            *error = "frame_index 应为 \"auto\"、\"always\" 或 \"off\"";
+            return false;
+        }
+    }
+
+    if (const JsonValue* dir = v.Find("index_dir")) {
+        if (dir->type != JsonValue::JSON_STRING || dir->text.empty()) {
+            *error = "index_dir 应为目录";
+            return false;
+        }
+        job->indexDir = resolve(dir->text);
+    }
+
+    const JsonValue* outputs = v.Find("outputs");
+    if (!outputs) {
+        job->outputs.push_back(OutputSpec());
+        return true;
+    }
+    if (outputs->type != JsonValue::JSON_ARRAY || outputs->items.empty()) {
+        *error = "outputs 应为非空数组";
+        return false;
+    }
+    for (size_t i = 0; i < outputs->items.size(); ++i) {
+        OutputSpec spec;
+        std::string specError;
+        if (!ParseJobOutput(outputs->items[i], &spec, &specError)) {
+            char prefix[32];
+            snprintf(prefix, sizeof(prefix), "输出 %zu: ", i + 1);
+            *error = prefix + specError;
+            return false;
+        }
+        for (size_t k = 0; k < job->outputs.size(); ++k) {
+            if (job->outputs[k].dir == spec.dir) {
+                *error = "输出目录重复: " + (spec.dir.empty() ? std::string("(根目录)") : spec.dir);
+                return false;
+            }
+        }
+        job->outputs.push_back(spec);
+    }
+    return true;
+}
+
+// 读取任务文件（UTF-8），结果追加到 jobs；失败时 error 为说明，jobs 不变
+inline bool LoadJobFile(const std::string& path, const IDecoderBackend& backend,
+                        std::vector<ExtractionJob>* jobs, std::string* error) {
+    FILE* fp = OpenFileUtf8(path, "rb");
+    if (!fp) {
+        *error = "无法打开任务文件: " + path;
+        return false;
+    }
+    std::string text;
+    char chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0) text.append(chunk, n);
+    fclose(fp);
+    if (text.compare(0, 3, "\xEF\xBB\xBF") == 0) text.erase(0, 3);     // 去掉 UTF-8 BOM
+
+    JsonValue root;
+    JsonParser parser(text);
+    if (!parser.Parse(&root, error)) return false;
+
+    std::vector<const JsonValue*> items;
+    const JsonValue* list = root.Find("jobs");
+    if (list) {
+        if (list->type != JsonValue::JSON_ARRAY || list->items.empty()) {
+            *error = "jobs 应为非空数组";
+            return false;
+        }
+        for (size_t i = 0; i < list->items.size(); ++i) items.push_back(&list->items[i]);
+    } else {
+        items.push_back(&root);
+    }
+
+    std::string baseDir = ParentDirectory(path);
+    std::vector<ExtractionJob> parsed(items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        std::string jobError;
+        if (!ParseJob(*items[i], baseDir, backend, &parsed[i], &jobError)) {
+            char prefix[32];
+            snprintf(prefix, sizeof(prefix), "任务 %zu: ", i + 1);
+            *error = prefix + jobError;
+            return false;
+        }
+    }
+    jobs->insert(jobs->end(), parsed.begin(), parsed.end());
+    return true;
+}
@@ -0,0 +1,538 @@
+/*
+    基线 JPEG 编码器
+    YCbCr 4:2:0，标准量化表按质量缩放，标准 Huffman 表；灰度输入编码为单分量（只有亮度）的 JPEG，MCU 为 8x8。
+    DCT 采用 AAN 浮点算法并把量化因子合并进缩放表：两遍都按列处理 8 个相邻系数，
+    x86 上每一遍用 SSE 一次处理 4 列，其他平台使用同样结构的标量代码。
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <vector>
+
+#include "image_encoder.h"
+#include "simd_config.h"
+
+// Z 字形顺序 -> 自然顺序
+static const uint8_t kJpegZigzag[64] = {
+    0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+};
+
+// Z 字形顺序 -> 转置后的位置（DCT 输出为转置顺序，见 JpegEncoder::EncodeBlock）
+static const uint8_t kJpegZigzagTransposed[64] = {
+    0, 8, 1, 2, 9, 16, 24, 17, 10, 3, 4, 11, 18, 25, 32, 40,
+    33, 26, 19, 12, 5, 6, 13, 20, 27, 34, 41, 48, 56, 49, 42, 35,
+    28, 21, 14, 7, 15, 22, 29, 36, 43, 50, 57, 58, 51, 44, 37, 30,
+    23, 31, 38, 45, 52, 59, 60, 53, 46, 39, 47, 54, 61, 62, 55, 63
+};
+
+// JPEG 标准附录 K 的量化表（自然顺序）与 Huffman 表
+static const uint8_t kJpegLumQuant[64] = {
+    16, 11, 10, 16, 24, 40, 51, 61,
+    12, 12, 14, 19, 26, 58, 60, 55,
+    14, 13, 16, 24, 40, 57, 69, 56,
+    14, 17, 22, 29, 51, 87, 80, 62,
+    18, 22, 37, 56, 68, 109, 103, 77,
+    24, 35, 55, 64, 81, 104, 113, 92,
+    49, 64, 78, 87, 103, 121, 120, 101,
+    72, 92, 95, 98, 112, 100, 103, 99
+};
+
+static const uint8_t kJpegChromQuant[64] = {
+    17, 18, 24, 47, 99, 99, 99, 99,
+    18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,
+    47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99
+};
+
+static const uint8_t kJpegDcLumBits[16] = { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+static const uint8_t kJpegDcLumVals[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+static const uint8_t kJpegDcChromBits[16] = { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 };
+static const uint8_t kJpegDcChromVals[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+
+static const uint8_t kJpegAcLumBits[16] = { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d };
+static const uint8_t kJpegAcLumVals[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+
+static const uint8_t kJpegAcChromBits[16] = { 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 };
+static const uint8_t kJpegAcChromVals[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+    0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+    0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+
+class JpegEncoder : public IImageEncoder {
+public:
+    explicit JpegEncoder(int quality = 90) : m_quality(0), m_out(NULL), m_used(0), m_bitBuf(0), m_bitCount(0) {
+        BuildHuffmanTable(kJpegDcLumBits, kJpegDcLumVals, m_dcLum);
+        BuildHuffmanTable(kJpegDcChromBits, kJpegDcChromVals, m_dcChrom);
+        BuildHuffmanTable(kJpegAcLumBits, kJpegAcLumVals, m_acLum);
+        BuildHuffmanTable(kJpegAcChromBits, kJpegAcChromVals, m_acChrom);
+        SetQuality(quality);
+    }
+
+    // 质量 1-100，按 IJG 的方式缩放标准量化表
+    void SetQuality(int quality) {
+        if (quality < 1) quality = 1;
+        if (quality > 100) quality = 100;
+        if (quality == m_quality) return;
+        m_quality = quality;
+        int scale = quality < 50 ? 5000 / quality : 200 - quality * 2;
+        static const float kAanScale[8] = {
+            1.0f, 1.387039845f, 1.306562965f, 1.175875602f, 1.0f, 0.785694958f, 0.541196100f, 0.275899379f
+        };
+        for (int i = 0; i < 64; i++) {
+            int qy = (kJpegLumQuant[i] * scale + 50) / 100;
+            int qc = (kJpegChromQuant[i] * scale + 50) / 100;
+            m_qtLum[i] = (uint8_t)(qy < 1 ? 1 : (qy > 255 ? 255 : qy));
+            m_qtChrom[i] = (uint8_t)(qc < 1 ? 1 : (qc > 255 ? 255 : qc));
+        }
+        // DCT 的输出是转置的：缩放表按转置后的位置存放
+        for (int v = 0; v < 8; v++) {
+            for (int u = 0; u < 8; u++) {
+                float aan = kAanScale[u] * kAanScale[v] * 8.0f;
+                m_scaleLum[v * 8 + u] = 1.0f / (m_qtLum[u * 8 + v] * aan);
+                m_scaleChrom[v * 8 + u] = 1.0f / (m_qtChrom[u * 8 + v] * aan);
+            }
+        }
+    }
+
+    int Quality() const { return m_quality; }
+
+    const char* Extension() const override { return "jpg"; }
+
+    bool Encode(const FrameView& view, std::vector<uint8_t>& out) override {
+        bool gray = view.format == FRAME_GRAY8;
+        if ((view.format != FRAME_BGRX32 && !gray) || view.width <= 0 || view.height <= 0 ||
+            view.width > 65535 || view.height > 65535) return false;
+        out.clear();
+        m_out = &out;
+        WriteHeaders(view.width, view.height, gray);
+
+        // 熵编码直接写入预留的空间，每个 MCU 之前检查余量
+        m_used = out.size();
+        out.resize(m_used + (size_t)view.width * view.height / 4 + kMaxMcuBytes);
+        m_bitBuf = 0;
+        m_bitCount = 0;
+        if (gray) {
+            int dc = 0;
+            float block[64];
+            for (int my = 0; my < view.height; my += 8) {
+                for (int mx = 0; mx < view.width; mx += 8) {
+                    if (out.size() - m_used < kMaxMcuBytes) out.resize(out.size() * 2);
+                    LoadGrayBlock(view, mx, my, block);
+                    dc = EncodeBlock(block, m_scaleLum, dc, m_dcLum, m_acLum);
+                }
+            }
+        }
+        else {
+            int dcY = 0, dcCb = 0, dcCr = 0;
+            float y[4][64], cb[64], cr[64];
+            for (int my = 0; my < view.height; my += 16) {
+                for (int mx = 0; mx < view.width; mx += 16) {
+                    if (out.size() - m_used < kMaxMcuBytes) out.resize(out.size() * 2);
+                    LoadMcu(view, mx, my, y, cb, cr);
+                    for (int b = 0; b < 4; b++) dcY = EncodeBlock(y[b], m_scaleLum, dcY, m_dcLum, m_acLum);
+                    dcCb = EncodeBlock(cb, m_scaleChrom, dcCb, m_dcChrom, m_acChrom);
+                    dcCr = EncodeBlock(cr, m_scaleChrom, dcCr, m_dcChrom, m_acChrom);
+                }
+            }
+        }
+        // 用 1 填充最后不足一个字节的位
+        PutBits(0x7F, 7);
+        while (m_bitCount >= 8) {
+            m_bitCount -= 8;
+            PutByte((uint8_t)(m_bitBuf >> m_bitCount));
+        }
+        out.resize(m_used);
+        out.push_back(0xFF);
+        out.push_back(0xD9);
+        m_out = NULL;
+        return true;
+    }
+
+private:
+    struct HuffmanTable {
+        uint16_t code[256];
+        uint8_t size[256];
+    };
+
+    // 一个 MCU（6 个块）熵编码后的上限：每块 64 个系数 x（16 位码 + 11 位附加位），0xFF 填充最多翻倍
+    enum { kMaxMcuBytes = 6 * 64 * 27 / 8 * 2 + 16 };
+
+    // 读取一个 16x16 的 MCU：超出画面的像素复制边缘，Cb/Cr 取 2x2 平均。
+    // 每行先取出 16 个像素的 R/G/B，再对整行做同样的运算，便于编译器向量化。
+    static void LoadMcu(const FrameView& view, int mx, int my, float y[4][64], float* cb, float* cr) {
+        float cbFull[256], crFull[256];
+        int xs[16];
+        for (int c = 0; c < 16; c++) xs[c] = (mx + c < view.width ? mx + c : view.width - 1) * 4;
+        for (int r = 0; r < 16; r++) {
+            int sy = my + r < view.height ? my + r : view.height - 1;
+            const uint8_t* row = view.data + (ptrdiff_t)sy * view.stride;
+            float rr[16], g[16], b[16], yy[16];
+            for (int c = 0; c < 16; c++) {
+                b[c] = row[xs[c]];
+                g[c] = row[xs[c] + 1];
+                rr[c] = row[xs[c] + 2];
+            }
+            for (int c = 0; c < 16; c++) {
+                yy[c] = 0.299f * rr[c] + 0.587f * g[c] + 0.114f * b[c] - 128.0f;
+                cbFull[r * 16 + c] = -0.168736f * rr[c] - 0.331264f * g[c] + 0.5f * b[c];
+                crFull[r * 16 + c] = 0.5f * rr[c] - 0.418688f * g[c] - 0.081312f * b[c];
+            }
+            float* yRow = y[(r >> 3) * 2] + (r & 7) * 8;
+            memcpy(yRow, yy, 8 * sizeof(float));
+            memcpy(yRow + 64, yy + 8, 8 * sizeof(float));
+        }
+        for (int r = 0; r < 8; r++) {
+            for (int c = 0; c < 8; c++) {
+                int i = r * 32 + c * 2;
+                cb[r * 8 + c] = (cbFull[i] + cbFull[i + 1] + cbFull[i + 16] + cbFull[i + 17]) * 0.25f;
+                cr[r * 8 + c] = (crFull[i] + crFull[i + 1] + crFull[i + 16] + crFull[i + 17]) * 0.25f;
+            }
+        }
+    }
+
+    // 读取一个 8x8 的灰度块，超出画面的像素复制边缘
+    static void LoadGrayBlock(const FrameView& view, int mx, int my, float* block) {
+        int xs[8];
+        for (int c = 0; c < 8; c++) xs[c] = mx + c < view.width ? mx + c : view.width - 1;
+        for (int r = 0; r < 8; r++) {
+            int sy = my + r < view.height ? my + r : view.height - 1;
+            const uint8_t* row = view.data + (ptrdiff_t)sy * view.stride;
+            for (int c = 0; c < 8; c++) block[r * 8 + c] = row[xs[c]] - 128.0f;
+        }
+    }
+
+#ifdef D2F_X86
+    // 对 8 列同时做一维 AAN DCT：d[k * 8 + lane]，每行 8 个元素用两个 SSE 寄存器
+    static void ForwardDctColumns(float* d) {
+        const __m128 k0707 = _mm_set1_ps(0.707106781f);
+        const __m128 k0382 = _mm_set1_ps(0.382683433f);
+        const __m128 k0541 = _mm_set1_ps(0.541196100f);
+        const __m128 k1306 = _mm_set1_ps(1.306562965f);
+        for (int h = 0; h < 8; h += 4) {
+            __m128 d0 = _mm_loadu_ps(d + 0 * 8 + h), d7 = _mm_loadu_ps(d + 7 * 8 + h);
+            __m128 d1 = _mm_loadu_ps(d + 1 * 8 + h), d6 = _mm_loadu_ps(d + 6 * 8 + h);
+            __m128 d2 = _mm_loadu_ps(d + 2 * 8 + h), d5 = _mm_loadu_ps(d + 5 * 8 + h);
+            __m128 d3 = _mm_loadu_ps(d + 3 * 8 + h), d4 = _mm_loadu_ps(d + 4 * 8 + h);
+            __m128 tmp0 = _mm_add_ps(d0, d7), tmp7 = _mm_sub_ps(d0, d7);
+            __m128 tmp1 = _mm_add_ps(d1, d6), tmp6 = _mm_sub_ps(d1, d6);
+            __m128 tmp2 = _mm_add_ps(d2, d5), tmp5 = _mm_sub_ps(d2, d5);
+            __m128 tmp3 = _mm_add_ps(d3, d4), tmp4 = _mm_sub_ps(d3, d4);
+
+            // 偶数部分
+            __m128 tmp10 = _mm_add_ps(tmp0, tmp3), tmp13 = _mm_sub_ps(tmp0, tmp3);
+            __m128 tmp11 = _mm_add_ps(tmp1, tmp2), tmp12 = _mm_sub_ps(tmp1, tmp2);
+            _mm_storeu_ps(d + 0 * 8 + h, _mm_add_ps(tmp10, tmp11));
+            _mm_storeu_ps(d + 4 * 8 + h, _mm_sub_ps(tmp10, tmp11));
+            __m128 z1 = _mm_mul_ps(_mm_add_ps(tmp12, tmp13), k0707);
+            _mm_storeu_ps(d + 2 * 8 + h, _mm_add_ps(tmp13, z1));
+            _mm_storeu_ps(d + 6 * 8 + h, _mm_sub_ps(tmp13, z1));
+
+            // 奇数部分
+            tmp10 = _mm_add_ps(tmp4, tmp5);
+            tmp11 = _mm_add_ps(tmp5, tmp6);
+            tmp12 = _mm_add_ps(tmp6, tmp7);
+            __m128 z5 = _mm_mul_ps(_mm_sub_ps(tmp10, tmp12), k0382);
+            __m128 z2 = _mm_add_ps(_mm_mul_ps(tmp10, k0541), z5);
+            __m128 z4 = _mm_add_ps(_mm_mul_ps(tmp12, k1306), z5);
+            __m128 z3 = _mm_mul_ps(tmp11, k0707);
+            __m128 z11 = _mm_add_ps(tmp7, z3), z13 = _mm_sub_ps(tmp7, z3);
+            _mm_storeu_ps(d + 5 * 8 + h, _mm_add_ps(z13, z2));
+            _mm_storeu_ps(d + 3 * 8 + h, _mm_sub_ps(z13, z2));
+            _mm_storeu_ps(d + 1 * 8 + h, _mm_add_ps(z11, z4));
+            _mm_storeu_ps(d + 7 * 8 + h, _mm_sub_ps(z11, z4));
+        }
+    }
+
+    // 按 4x4 子块转置：对角子块原地转置，非对角子块转置后互换
+    static void Transpose8x8(float* d) {
+        __m128 a[8], b[8];
+        for (int r = 0; r < 8; r++) {
+            a[r] = _mm_loadu_ps(d + r * 8);
+            b[r] = _mm_loadu_ps(d + r * 8 + 4);
+        }
+        _MM_TRANSPOSE4_PS(a[0], a[1], a[2], a[3]);
+        _MM_TRANSPOSE4_PS(b[0], b[1], b[2], b[3]);
+        _MM_TRANSPOSE4_PS(a[4], a[5], a[6], a[7]);
+        _MM_TRANSPOSE4_PS(b[4], b[5], b[6], b[7]);
+        for (int r = 0; r < 4; r++) {
+            _mm_storeu_ps(d + r * 8, a[r]);
+            _mm_storeu_ps(d + r * 8 + 4, a[r + 4]);
+            _mm_storeu_ps(d + (r + 4) * 8, b[r]);
+            _mm_storeu_ps(d + (r + 4) * 8 + 4, b[r + 4]);
+        }
+    }
+#else
+    // 对 8 列同时做一维 AAN DCT：d[k * 8 + lane]
+    static void ForwardDctColumns(float* d) {
+        for (int i = 0; i < 8; i++) {
+            float tmp0 = d[0 * 8 + i] + d[7 * 8 + i];
+            float tmp7 = d[0 * 8 + i] - d[7 * 8 + i];
+            float tmp1 = d[1 * 8 + i] + d[6 * 8 + i];
+            float tmp6 = d[1 * 8 + i] - d[6 * 8 + i];
+            float tmp2 = d[2 * 8 + i] + d[5 * 8 + i];
+            float tmp5 = d[2 * 8 + i] - d[5 * 8 + i];
+            float tmp3 = d[3 * 8 + i] + d[4 * 8 + i];
+            float tmp4 = d[3 * 8 + i] - d[4 * 8 + i];
+
+            // 偶数部分
+            float tmp10 = tmp0 + tmp3;
+            float tmp13 = tmp0 - tmp3;
+            float tmp11 = tmp1 + tmp2;
+            float tmp12 = tmp1 - tmp2;
+            d[0 * 8 + i] = tmp10 + tmp11;
+            d[4 * 8 + i] = tmp10 - tmp11;
+            float z1 = (tmp12 + tmp13) * 0.707106781f;
+            d[2 * 8 + i] = tmp13 + z1;
+            d[6 * 8 + i] = tmp13 - z1;
+
+            // 奇数部分
+            tmp10 = tmp4 + tmp5;
+            tmp11 = tmp5 + tmp6;
+            tmp12 = tmp6 + tmp7;
+            float z5 = (tmp10 - tmp12) * 0.382683433f;
+            float z2 = tmp10 * 0.541196100f + z5;
+            float z4 = tmp12 * 1.306562965f + z5;
+            float z3 = tmp11 * 0.707106781f;
+            float z11 = tmp7 + z3;
+            float z13 = tmp7 - z3;
+            d[5 * 8 + i] = z13 + z2;
+            d[3 * 8 + i] = z13 - z2;
+            d[1 * 8 + i] = z11 + z4;
+            d[7 * 8 + i] = z11 - z4;
+        }
+    }
+
+    static void Transpose8x8(float* d) {
+        for (int r = 0; r < 8; r++) {
+            for (int c = r + 1; c < 8; c++) {
+                float t = d[r * 8 + c];
+                d[r * 8 + c] = d[c * 8 + r];
+                d[c * 8 + r] = t;
+            }
+        }
+    }
+#endif
+
+    // 变换、量化并熵编码一个 8x8 块，返回本块的 DC 值
+    int EncodeBlock(float* block, const float* scale, int prevDc, const HuffmanTable& dc, const HuffmanTable& ac) {
+        ForwardDctColumns(block);
+        Transpose8x8(block);
+        ForwardDctColumns(block);
+
+        // 量化（就近舍入），block 与缩放表都是转置顺序
+        int q[64];
+#ifdef D2F_X86
+        for (int i = 0; i < 64; i += 4) {
+            __m128 v = _mm_mul_ps(_mm_loadu_ps(block + i), _mm_loadu_ps(scale + i));
+            _mm_storeu_si128((__m128i*)(q + i), _mm_cvtps_epi32(v));
+        }
+#else
+        for (int i = 0; i < 64; i++) q[i] = (int)lrintf(block[i] * scale[i]);
+#endif
+
+        // Z 字形重排，同时记录非零系数的位置
+        int zz[64];
+        uint64_t nonzero = 0;
+        for (int k = 0; k < 64; k++) {
+            zz[k] = q[kJpegZigzagTransposed[k]];
+            nonzero |= (uint64_t)(zz[k] != 0) << k;
+        }
+
+        PutCoefficient(zz[0] - prevDc, dc, 0);
+
+        // 只遍历非零的 AC 系数
+        int last = 0;
+        nonzero &= ~(uint64_t)1;
+        while (nonzero) {
+            int k = CountTrailingZeros64(nonzero);
+            nonzero &= nonzero - 1;
+            int run = k - last - 1;
+            while (run >= 16) {
+                PutBits(ac.code[0xF0], ac.size[0xF0]);
+                run -= 16;
+            }
+            PutCoefficient(zz[k], ac, run << 4);
+            last = k;
+        }
+        if (last != 63) PutBits(ac.code[0x00], ac.size[0x00]);
+        return zz[0];
+    }
+
+    // 写出符号 (run << 4 | 位数) 及其附加位
+    void PutCoefficient(int value, const HuffmanTable& table, int runShifted) {
+        int magnitude = value < 0 ? -value : value;
+        int bits = BitLength((uint32_t)magnitude);
+        int symbol = runShifted | bits;
+        PutBits(table.code[symbol], table.size[symbol]);
+        if (bits) {
+            int extra = value < 0 ? value + (1 << bits) - 1 : value;
+            PutBits((uint32_t)extra & ((1u << bits) - 1), bits);
+        }
+    }
+
+    static int BitLength(uint32_t v) {
+        if (!v) return 0;
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse(&index, v);
+        return (int)index + 1;
+#else
+        return 32 - __builtin_clz(v);
+#endif
+    }
+
+    static int CountTrailingZeros64(uint64_t v) {
+#ifdef _MSC_VER
+        unsigned long index;
+        if (_BitScanForward(&index, (unsigned long)v)) return (int)index;
+        _BitScanForward(&index, (unsigned long)(v >> 32));
+        return (int)index + 32;
+#else
+        return __builtin_ctzll(v);
+#endif
+    }
+
+    void PutByte(uint8_t byte) {
+        uint8_t* dst = m_out->data() + m_used;
+        dst[0] = byte;
+        m_used++;
+        if (byte == 0xFF) dst[1] = 0x00, m_used++;
+    }
+
+    // 位缓冲攒满 32 位再写出；不含 0xFF 字节时整字写出，否则逐字节写出并填充 0x00
+    void PutBits(uint32_t bits, int count) {
+        m_bitBuf = (m_bitBuf << count) | bits;
+        m_bitCount += count;
+        if (m_bitCount < 32) return;
+        m_bitCount -= 32;
+        uint32_t word = (uint32_t)(m_bitBuf >> m_bitCount);
+        uint32_t inv = ~word;
+        if (((inv - 0x01010101u) & ~inv & 0x80808080u) == 0) {
+            uint8_t* dst = m_out->data() + m_used;
+            dst[0] = (uint8_t)(word >> 24);
+            dst[1] = (uint8_t)(word >> 16);
+            dst[2] = (uint8_t)(word >> 8);
+            dst[3] = (uint8_t)word;
+            m_used += 4;
+        }
+        else {
+            for (int s = 24; s >= 0; s -= 8) PutByte((uint8_t)(word >> s));
+        }
+    }
+
+    static void BuildHuffmanTable(const uint8_t* bits, const uint8_t* vals, HuffmanTable& table) {
+        memset(&table, 0, sizeof(table));
+        int code = 0, k = 0;
+        for (int len = 1; len <= 16; len++) {
+            for (int i = 0; i < bits[len - 1]; i++) {
+                table.code[vals[k]] = (uint16_t)code;
+                table.size[vals[k]] = (uint8_t)len;
+                code++;
+                k++;
+            }
+            code <<= 1;
+        }
+    }
+
+    void PutMarker(uint8_t marker, uint32_t length) {
+        m_out->push_back(0xFF);
+        m_out->push_back(marker);
+        PutU16BE(*m_out, length);
+    }
+
+    void PutHuffmanSegment(uint8_t tableClassId, const uint8_t* bits, const uint8_t* vals) {
+        int count = 0;
+        for (int i = 0; i < 16; i++) count += bits[i];
+        m_out->push_back(tableClassId);
+        m_out->insert(m_out->end(), bits, bits + 16);
+        m_out->insert(m_out->end(), vals, vals + count);
+    }
+
+    // 灰度时只写亮度的量化表与 Huffman 表，帧与扫描只有一个分量
+    void WriteHeaders(int width, int height, bool gray) {
+        std::vector<uint8_t>& out = *m_out;
+        out.push_back(0xFF);
+        out.push_back(0xD8);
+
+        static const uint8_t kJfif[] = { 'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0 };
+        PutMarker(0xE0, 2 + sizeof(kJfif));
+        out.insert(out.end(), kJfif, kJfif + sizeof(kJfif));
+
+        int tables = gray ? 1 : 2;
+        PutMarker(0xDB, 2 + 65 * tables);
+        out.push_back(0x00);
+        for (int k = 0; k < 64; k++) out.push_back(m_qtLum[kJpegZigzag[k]]);
+        if (!gray) {
+            out.push_back(0x01);
+            for (int k = 0; k < 64; k++) out.push_back(m_qtChrom[kJpegZigzag[k]]);
+        }
+
+        static const uint8_t kComponents[] = { 1, 0x22, 0, 2, 0x11, 1, 3, 0x11, 1 };
+        static const uint8_t kGrayComponent[] = { 1, 0x11, 0 };
+        PutMarker(0xC0, gray ? 8 + 3 : 8 + 3 * 3);
+        out.push_back(8);
+        PutU16BE(out, (uint32_t)height);
+        PutU16BE(out, (uint32_t)width);
+        out.push_back(gray ? 1 : 3);
+        if (gray) out.insert(out.end(), kGrayComponent, kGrayComponent + sizeof(kGrayComponent));
+        else out.insert(out.end(), kComponents, kComponents + sizeof(kComponents));
+
+        PutMarker(0xC4, 2 + ((17 + 12) + (17 + 162)) * tables);
+        PutHuffmanSegment(0x00, kJpegDcLumBits, kJpegDcLumVals);
+        PutHuffmanSegment(0x10, kJpegAcLumBits, kJpegAcLumVals);
+        if (!gray) {
+            PutHuffmanSegment(0x01, kJpegDcChromBits, kJpegDcChromVals);
+            PutHuffmanSegment(0x11, kJpegAcChromBits, kJpegAcChromVals);
+        }
+
+        static const uint8_t kScan[] = { 1, 0x00, 2, 0x11, 3, 0x11, 0, 63, 0 };
+        static const uint8_t kGrayScan[] = { 1, 0x00, 0, 63, 0 };
+        PutMarker(0xDA, gray ? 6 + 2 : 6 + 2 * 3);
+        out.push_back(gray ? 1 : 3);
+        if (gray) out.insert(out.end(), kGrayScan, kGrayScan + sizeof(kGrayScan));
+        else out.insert(out.end(), kScan, kScan + sizeof(kScan));
+    }
+
+    int m_quality;
+    uint8_t m_qtLum[64];        // 自然顺序
+    uint8_t m_qtChrom[64];
+    float m_scaleLum[64];       // 1 / (量化值 * AAN 缩放)，转置顺序
+    float m_scaleChrom[64];
+    HuffmanTable m_dcLum, m_acLum, m_dcChrom, m_acChrom;
+
+    std::vector<uint8_t>* m_out;
+    size_t m_used;              // m_out 中已写入的字节数
+    uint64_t m_bitBuf;
+    int m_bitCount;
+};
@@ -17,38 +17,40 @@
 #include <shlwapi.h>
 #include <shlobj.h>
 #include <gdiplus.h>
-#include <mfapi.h>
-#include <mfidl.h>
-#include <mfreadwrite.h>
-#include <propvarutil.h>
 #include <string>
 #include <vector>
 #include <atomic>
 #include <thread>
+#include <memory>
+#include <mutex>
 #include <cmath>
 #include <algorithm> // 用于 std::min, std::max
 #include <cstdint>   // 用于 int8_t 等类型
 #include <cstdio>    // 用于 swprintf
 
+#include "frame_source.h"
+#include "work_queue.h"
+#include "file_util.h"
+#include "probe_cache.h"
+#include "color_convert.h"
+#include "image_encoder.h"
+#include "encoder_factory.h"
+#include "seek_sampling.h"
+#include "tensor_writer.h"
+#include "output_spec.h"
+#include "video_decoder.h"
+#include "mf_decoder.h"
+#include "extract_engine.h"
+
 // 链接库
 #pragma comment(lib, "gdiplus.lib")
 #pragma comment(lib, "shlwapi.lib")
 #pragma comment(lib, "comctl32.lib")
 #pragma comment(lib, "shell32.lib")
-#pragma comment(lib, "mf.lib")
-#pragma comment(lib, "mfplat.lib")
-#pragma comment(lib, "mfreadwrite.lib")
-#pragma comment(lib, "mfuuid.lib")
-#pragma comment(lib, "propsys.lib")
 
 using namespace Gdiplus;
 using namespace std;
 
-// 安全释放宏
-template <class T> void SafeRelease(T** ppT) {
-    if (*ppT) { (*ppT)->Release(); *ppT = NULL; }
-}
-
 // 控件ID
 #define IDC_EDT_PATH    1001
 #define IDC_EDT_OUT     1002
@@ -65,6 +67,14 @@ template <class T> void SafeRelease(T** ppT) {
 #define IDC_LBL_INFO    1013
 #define IDC_LBL_BATCH   1014
 #define IDC_LBL_ROI     1015
+#define IDC_CMB_FORMAT  1016
+#define IDC_EDT_QUALITY 1017
+#define IDC_LBL_QUALITY 1018
+#define IDC_LBL_INT     1019
+#define IDC_CMB_SAMPLING 1020
+#define IDC_EDT_DEDUP   1021
+#define IDC_CHK_PACK    1022
+#define IDC_EDT_OUTPUTS 1023
 
 // 全局状态
 HINSTANCE hInst;
@@ -73,6 +83,7 @@ ULONG_PTR gdiplusToken;
 
 // 批量处理相关变量
 vector<wstring> g_batchFiles;
+vector<VideoProbeInfo> g_batchInfos;   // 与 g_batchFiles 一一对应，探测失败时宽高为 0
 bool g_isConsistent = true;
 UINT32 g_batchWidth = 0;
 UINT32 g_batchHeight = 0;
@@ -85,6 +96,21 @@ Bitmap* g_pPreviewBitmap = nullptr;
 bool g_isExtracting = false;
 std::atomic<bool> g_stopRequested(false);
 
+// 解码后端：探测、预览与提取都通过它打开视频
+MfDecoderBackend g_decoderBackend;
+
+// 元数据探测：后台线程池 + 磁盘缓存；每次拖入递增代号，过期的探测结果被丢弃
+ProbeCache g_probeCache;
+std::once_flag g_probeCacheLoaded;
+std::atomic<unsigned> g_probeGeneration(0);
+
+// 帧缓冲池统计（提取结束时显示）
+std::atomic<uint64_t> g_poolHits(0);
+std::atomic<uint64_t> g_poolMisses(0);
+// 去重统计：上次提取中保存与丢弃的帧数（未启用去重时均为 0）
+std::atomic<uint64_t> g_dedupKept(0);
+std::atomic<uint64_t> g_dedupDropped(0);
+
 // ==========================================
 // 前置声明
 // ==========================================
@@ -92,197 +118,155 @@ LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
 LRESULT CALLBACK PreviewProc(HWND, UINT, WPARAM, LPARAM, UINT_PTR, DWORD_PTR);
 void ProcessDrop(const wstring& path);
 void ProcessMultipleFiles(const vector<wstring>& files);
+void BeginProbe();
 void StartExtractionThread();
 int GetEncoderClsid(const WCHAR* format, CLSID* pClsid);
 bool BrowseFolder(HWND hWnd, wstring& outPath);
 void SetIntToEdit(int id, int val);
 int GetIntFromEdit(int id);
+double GetDoubleFromEdit(int id);
 void UpdateROISizeLabel();
+void OnOutputFormatChanged();
+void OnSamplingModeChanged();
 bool IsVideoFile(const wstring& path);
 // ==========================================
 
-// ==========================================
-// Media Foundation 视频读取器
-// ==========================================
-class VideoReaderMF {
-public:
-    IMFSourceReader* m_pReader;
+// 将帧视图转换为独立的 Bitmap（YUV 帧在此转换为 BGRX），调用者负责 delete
+Bitmap* CreateBitmapFromView(const FrameView& view, UINT32 width, UINT32 height) {
+    Bitmap* safeBmp = new Bitmap(width, height, PixelFormat32bppRGB);
+    if (safeBmp->GetLastStatus() != Ok) { delete safeBmp; return nullptr; }
 
-    VideoReaderMF() : m_pReader(NULL) {}
-    ~VideoReaderMF() { Close(); }
+    BitmapData bmpData;
+    Rect rect(0, 0, width, height);
+    if (safeBmp->LockBits(&rect, ImageLockModeWrite, PixelFormat32bppRGB, &bmpData) != Ok) {
+        delete safeBmp;
+        return nullptr;
+    }
+    RoiRect full = { 0, 0, std::min((int)width, view.width), std::min((int)height, view.height) };
+    ConvertRoiToBgrx(view, full, (uint8_t*)bmpData.Scan0, bmpData.Stride);
+    safeBmp->UnlockBits(&bmpData);
+    return safeBmp;
+}
 
-    void Close() { SafeRelease(&m_pReader); }
+// 解码下一帧并转换为 Bitmap（预览用），调用者负责 delete
+Bitmap* ReadFrameBitmap(IVideoDecoder& decoder, UINT32 width, UINT32 height) {
+    if (!decoder.Advance(NULL)) return nullptr;
+    FrameView view;
+    if (!decoder.LockFrame(&view)) return nullptr;
+    Bitmap* safeBmp = CreateBitmapFromView(view, width, height);
+    decoder.UnlockFrame();
+    return safeBmp;
+}
 
-    HRESULT Open(const wstring& filepath) {
-        Close();
-        IMFAttributes* pAttributes = NULL;
-        HRESULT hr = MFCreateAttributes(&pAttributes, 1);
-        if (SUCCEEDED(hr)) {
-            hr = pAttributes->SetUINT32(MF_SOURCE_READER_ENABLE_VIDEO_PROCESSING, TRUE);
-        }
-        hr = MFCreateSourceReaderFromURL(filepath.c_str(), pAttributes, &m_pReader);
-        SafeRelease(&pAttributes);
-        if (FAILED(hr)) return hr;
-
-        hr = m_pReader->SetStreamSelection(MF_SOURCE_READER_ALL_STREAMS, FALSE);
-        hr = m_pReader->SetStreamSelection(MF_SOURCE_READER_FIRST_VIDEO_STREAM, TRUE);
-        if (FAILED(hr)) return hr;
-
-        IMFMediaType* pType = NULL;
-        hr = MFCreateMediaType(&pType);
-        if (SUCCEEDED(hr)) {
-            pType->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video);
-            pType->SetGUID(MF_MT_SUBTYPE, MFVideoFormat_RGB32);
-            hr = m_pReader->SetCurrentMediaType(MF_SOURCE_READER_FIRST_VIDEO_STREAM, NULL, pType);
-            SafeRelease(&pType);
-        }
-        return hr;
+// ==========================================
+// GDI+ JPEG 编码器：系统自带的编码器，作为内置编码器之外的备选
+// ==========================================
+class GdiplusJpegEncoder : public IImageEncoder {
+public:
+    explicit GdiplusJpegEncoder(int quality) : m_quality((ULONG)std::max(1, std::min(100, quality))) {
+        m_hasClsid = GetEncoderClsid(L"image/jpeg", &m_clsid) >= 0;
     }
 
-    HRESULT GetVideoInfo(UINT32& w, UINT32& h, UINT64& duration, double& fps) {
-        if (!m_pReader) return E_FAIL;
-        
-        // 初始化输出参数
-        w = 0;
-        h = 0;
-        duration = 0;
-        fps = 0.0;
-        
-        IMFMediaType* pType = NULL;
-        HRESULT hr = m_pReader->GetCurrentMediaType(MF_SOURCE_READER_FIRST_VIDEO_STREAM, &pType);
-        if (FAILED(hr)) return hr;
-        MFGetAttributeSize(pType, MF_MT_FRAME_SIZE, &w, &h);
-        UINT32 num = 0, den = 1;
-        if (SUCCEEDED(MFGetAttributeRatio(pType, MF_MT_FRAME_RATE, &num, &den)) && den != 0) {
-            fps = (double)num / (double)den;
-        }
-        SafeRelease(&pType);
-        PROPVARIANT var;
-        PropVariantInit(&var);
-        if (SUCCEEDED(m_pReader->GetPresentationAttribute(MF_SOURCE_READER_MEDIASOURCE, MF_PD_DURATION, &var))) {
-            if (var.vt == VT_UI8) duration = var.uhVal.QuadPart;
-            PropVariantClear(&var);
-        }
-        return S_OK;
-    }
-
-    HRESULT Seek(double seconds) {
-        if (!m_pReader) return E_FAIL;
-        PROPVARIANT var;
-        PropVariantInit(&var);
-        var.vt = VT_I8;
-        var.hVal.QuadPart = (LONGLONG)(seconds * 10000000.0);
-        HRESULT hr = m_pReader->SetCurrentPosition(GUID_NULL, var);
-        PropVariantClear(&var);
-        // 注意：不要调用 Flush()，这会导致解码状态异常
-        return hr;
-    }
-
-    Bitmap* ReadFrame(UINT32 width, UINT32 height) {
-        if (!m_pReader) return nullptr;
-        IMFSample* pSample = NULL;
-        DWORD flags = 0;
-        HRESULT hr = m_pReader->ReadSample(MF_SOURCE_READER_FIRST_VIDEO_STREAM, 0, NULL, &flags, NULL, &pSample);
-        if (FAILED(hr) || pSample == NULL) return nullptr;
-
-        Bitmap* safeBmp = nullptr;
-        IMFMediaBuffer* pBuffer = NULL;
-        if (SUCCEEDED(pSample->ConvertToContiguousBuffer(&pBuffer))) {
-            BYTE* pSrcData = NULL;
-            DWORD srcLen = 0;
-            if (SUCCEEDED(pBuffer->Lock(&pSrcData, NULL, &srcLen))) {
-                safeBmp = new Bitmap(width, height, PixelFormat32bppRGB);
-                if (safeBmp->GetLastStatus() == Ok) {
-                    BitmapData bmpData;
-                    Rect rect(0, 0, width, height);
-                    if (safeBmp->LockBits(&rect, ImageLockModeWrite, PixelFormat32bppRGB, &bmpData) == Ok) {
-                        BYTE* pDstRow = (BYTE*)bmpData.Scan0;
-                        BYTE* pSrcRow = pSrcData;
-                        int bytesPerRow = width * 4;
-                        for (UINT32 y = 0; y < height; y++) {
-                            if ((pSrcRow - pSrcData) + bytesPerRow > (int)srcLen) break;
-                            memcpy(pDstRow, pSrcRow, bytesPerRow);
-                            pDstRow += bmpData.Stride;
-                            pSrcRow += bytesPerRow;
-                        }
-                        safeBmp->UnlockBits(&bmpData);
-                    }
-                    else { delete safeBmp; safeBmp = nullptr; }
+    const char* Extension() const override { return "jpg"; }
+
+    bool Encode(const FrameView& view, vector<uint8_t>& out) override {
+        IStream* pStream = NULL;
+        if (!m_hasClsid || FAILED(CreateStreamOnHGlobal(NULL, TRUE, &pStream))) return false;
+        bool ok = false;
+        Bitmap bmp(view.width, view.height, view.stride, PixelFormat32bppRGB, const_cast<BYTE*>(view.data));
+        EncoderParameters params;
+        FillParameters(params);
+        if (bmp.Save(pStream, &m_clsid, &params) == Ok) {
+            // 保存后流的当前位置即数据长度
+            LARGE_INTEGER zero = {};
+            ULARGE_INTEGER size = {};
+            HGLOBAL hMem = NULL;
+            if (SUCCEEDED(pStream->Seek(zero, STREAM_SEEK_CUR, &size)) && SUCCEEDED(GetHGlobalFromStream(pStream, &hMem))) {
+                const BYTE* p = (const BYTE*)GlobalLock(hMem);
+                if (p) {
+                    out.assign(p, p + (size_t)size.QuadPart);
+                    GlobalUnlock(hMem);
+                    ok = true;
                 }
-                else { delete safeBmp; safeBmp = nullptr; }
-                pBuffer->Unlock();
             }
-            SafeRelease(&pBuffer);
         }
-        SafeRelease(&pSample);
-        return safeBmp;
+        pStream->Release();
+        return ok;
     }
 
-    // 顺序读取下一帧，返回帧的时间戳（单位：100纳秒）
-    Bitmap* ReadNextFrame(UINT32 width, UINT32 height, LONGLONG* outTimestamp) {
-        if (!m_pReader) return nullptr;
-        
-        IMFSample* pSample = NULL;
-        DWORD flags = 0;
-        LONGLONG timestamp = 0;
-        
-        HRESULT hr = m_pReader->ReadSample(
-            MF_SOURCE_READER_FIRST_VIDEO_STREAM, 
-            0, 
-            NULL, 
-            &flags, 
-            &timestamp, 
-            &pSample
-        );
-        
-        if (FAILED(hr) || pSample == NULL || (flags & MF_SOURCE_READERF_ENDOFSTREAM)) {
-            if (pSample) SafeRelease(&pSample);
-            return nullptr;
-        }
-        
-        if (outTimestamp) *outTimestamp = timestamp;
-        
-        Bitmap* safeBmp = nullptr;
-        IMFMediaBuffer* pBuffer = NULL;
-        if (SUCCEEDED(pSample->ConvertToContiguousBuffer(&pBuffer))) {
-            BYTE* pSrcData = NULL;
-            DWORD srcLen = 0;
-            if (SUCCEEDED(pBuffer->Lock(&pSrcData, NULL, &srcLen))) {
-                safeBmp = new Bitmap(width, height, PixelFormat32bppRGB);
-                if (safeBmp->GetLastStatus() == Ok) {
-                    BitmapData bmpData;
-                    Rect rect(0, 0, width, height);
-                    if (safeBmp->LockBits(&rect, ImageLockModeWrite, PixelFormat32bppRGB, &bmpData) == Ok) {
-                        BYTE* pDstRow = (BYTE*)bmpData.Scan0;
-                        BYTE* pSrcRow = pSrcData;
-                        int bytesPerRow = width * 4;
-                        for (UINT32 y = 0; y < height; y++) {
-                            if ((pSrcRow - pSrcData) + bytesPerRow > (int)srcLen) break;
-                            memcpy(pDstRow, pSrcRow, bytesPerRow);
-                            pDstRow += bmpData.Stride;
-                            pSrcRow += bytesPerRow;
-                        }
-                        safeBmp->UnlockBits(&bmpData);
-                    }
-                    else { delete safeBmp; safeBmp = nullptr; }
-                }
-                else { delete safeBmp; safeBmp = nullptr; }
-                pBuffer->Unlock();
-            }
-            SafeRelease(&pBuffer);
-        }
-        SafeRelease(&pSample);
-        return safeBmp;
+    // GDI+ 可以直接写文件，省去一次内存拷贝
+    bool EncodeToFile(const FrameView& view, const string& path) override {
+        if (!m_hasClsid) return false;
+        Bitmap bmp(view.width, view.height, view.stride, PixelFormat32bppRGB, const_cast<BYTE*>(view.data));
+        EncoderParameters params;
+        FillParameters(params);
+        return bmp.Save(Utf8ToWide(path).c_str(), &m_clsid, &params) == Ok;
     }
+
+private:
+    void FillParameters(EncoderParameters& params) {
+        params.Count = 1;
+        params.Parameter[0].Guid = EncoderQuality;
+        params.Parameter[0].Type = EncoderParameterValueTypeLong;
+        params.Parameter[0].NumberOfValues = 1;
+        params.Parameter[0].Value = &m_quality;
+    }
+
+    CLSID m_clsid;
+    bool m_hasClsid;
+    ULONG m_quality;
+};
+
+// 输出格式下拉框的选项
+struct OutputFormatItem {
+    const WCHAR* name;
+    int format;         // ImageFormat，张量输出时为 IMAGE_FORMAT_COUNT
+    bool gdiplus;       // 使用 GDI+ 编码（仅 JPEG）
+    int tensor;         // TensorFormat，TENSOR_NONE 表示编码为图像
+    int channels;       // 张量的 ChannelOrder；图像为 CHANNELS_GRAY 时输出灰度图像
+};
+
+const OutputFormatItem g_outputFormats[] = {
+    { L"JPEG (快速)", IMAGE_JPEG, false, TENSOR_NONE, CHANNELS_RGB },
+    { L"JPEG (GDI+)", IMAGE_JPEG, true, TENSOR_NONE, CHANNELS_RGB },
+    { L"PNG", IMAGE_PNG, false, TENSOR_NONE, CHANNELS_RGB },
+    { L"BMP", IMAGE_BMP, false, TENSOR_NONE, CHANNELS_RGB },
+    { L"PPM", IMAGE_PPM, false, TENSOR_NONE, CHANNELS_RGB },
+    { L"JPEG (灰度)", IMAGE_JPEG, false, TENSOR_NONE, CHANNELS_GRAY },
+    { L"PNG (灰度)", IMAGE_PNG, false, TENSOR_NONE, CHANNELS_GRAY },
+    { L"NPY 张量 (RGB)", IMAGE_FORMAT_COUNT, false, TENSOR_NPY, CHANNELS_RGB },
+    { L"NPY 张量 (BGR)", IMAGE_FORMAT_COUNT, false, TENSOR_NPY, CHANNELS_BGR },
+    { L"NPY 张量 (灰度)", IMAGE_FORMAT_COUNT, false, TENSOR_NPY, CHANNELS_GRAY },
+    { L"RAW 张量 (RGB)", IMAGE_FORMAT_COUNT, false, TENSOR_RAW, CHANNELS_RGB },
+    { L"RAW 张量 (BGR)", IMAGE_FORMAT_COUNT, false, TENSOR_RAW, CHANNELS_BGR },
+    { L"RAW 张量 (灰度)", IMAGE_FORMAT_COUNT, false, TENSOR_RAW, CHANNELS_GRAY },
+};
+
+// 采样方式下拉框，顺序与 SamplingMode 一致；label 为数值框前的提示
+struct SamplingModeItem {
+    const WCHAR* name;
+    const WCHAR* label;
+};
+
+const SamplingModeItem g_samplingModes[] = {
+    { L"按帧数", L"跳帧数:" },
+    { L"按秒", L"间隔(秒):" },
+    { L"按帧率", L"帧率:" },
 };
 
+// 为一个编码线程创建编码器
+unique_ptr<IImageEncoder> CreateOutputEncoder(const EncoderOptions& options, bool gdiplus) {
+    if (gdiplus && options.format == IMAGE_JPEG) {
+        return unique_ptr<IImageEncoder>(new GdiplusJpegEncoder(options.quality));
+    }
+    return CreateImageEncoder(options);
+}
+
 // ==========================================
 // 辅助功能：目录扫描等
 // ==========================================
 bool IsVideoFile(const wstring& path) {
-    wstring ext = PathFindExtensionW(path.c_str());
-    transform(ext.begin(), ext.end(), ext.begin(), ::towlower);
-    return (ext == L".mp4" || ext == L".avi" || ext == L".mov" || ext == L".mkv" || ext == L".wmv" || ext == L".flv" || ext == L".mpg");
+    return g_decoderBackend.IsVideoFile(WideToUtf8(path));
 }
 
 bool BrowseFolder(HWND hWnd, wstring& outPath) {
@@ -300,88 +284,119 @@ bool BrowseFolder(HWND hWnd, wstring& outPath) {
     return false;
 }
 
-void ProcessDrop(const wstring& path) {
-    g_batchFiles.clear();
+// 后台探测的结果，通过 WM_USER + 4 的 LPARAM 交给界面线程，由界面线程 delete
+struct ProbeResult {
+    unsigned generation;
+    vector<VideoProbeInfo> infos;
+    size_t cacheHits;
+    Bitmap* preview;
+};
 
-    if (PathIsDirectoryW(path.c_str())) {
-        wstring searchPath = path + L"\\*.*";
-        WIN32_FIND_DATAW fd;
-        HANDLE hFind = FindFirstFileW(searchPath.c_str(), &fd);
-        if (hFind != INVALID_HANDLE_VALUE) {
-            do {
-                if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
-                    wstring fileName = fd.cFileName;
-                    if (IsVideoFile(fileName)) {
-                        g_batchFiles.push_back(path + L"\\" + fileName);
-                    }
-                }
-            } while (FindNextFileW(hFind, &fd));
-            FindClose(hFind);
-        }
-    }
-    else {
-        if (IsVideoFile(path)) g_batchFiles.push_back(path);
-    }
+// 探测缓存文件：%LOCALAPPDATA%\drag2frames\probe_cache.tsv
+string GetProbeCachePath() {
+    WCHAR appData[MAX_PATH];
+    if (FAILED(SHGetFolderPathW(NULL, CSIDL_LOCAL_APPDATA, NULL, 0, appData))) return string();
+    wstring dir = wstring(appData) + L"\\drag2frames";
+    CreateDirectoryW(dir.c_str(), NULL);
+    return WideToUtf8(dir + L"\\probe_cache.tsv");
+}
 
-    if (g_batchFiles.empty()) {
-        MessageBoxW(hMainWnd, L"未找到有效的视频文件！", L"提示", MB_ICONWARNING);
-        return;
-    }
+// 探测线程：在线程池上并行读取每个文件的视频信息（优先使用磁盘缓存），再解码第一个文件的首帧作为预览
+void ProbeWorker(vector<wstring> files, unsigned generation) {
+    CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
 
-    g_isConsistent = true;
-    g_batchWidth = 0;
-    g_batchHeight = 0;
+    string cachePath = GetProbeCachePath();
+    call_once(g_probeCacheLoaded, [&] { if (!cachePath.empty()) g_probeCache.Load(cachePath); });
 
-    HCURSOR hOldCursor = SetCursor(LoadCursor(NULL, IDC_WAIT));
+    vector<string> paths(files.size());
+    for (size_t i = 0; i < files.size(); ++i) paths[i] = WideToUtf8(files[i]);
 
-    VideoReaderMF tempReader;
-    for (size_t i = 0; i < g_batchFiles.size(); ++i) {
-        if (FAILED(tempReader.Open(g_batchFiles[i]))) continue;
+    ProbeResult* result = new ProbeResult;
+    result->generation = generation;
+    result->preview = nullptr;
 
-        UINT32 w, h;
-        UINT64 d;
-        double f;
-        if (SUCCEEDED(tempReader.GetVideoInfo(w, h, d, f))) {
-            if (i == 0) {
-                g_batchWidth = w;
-                g_batchHeight = h;
-            }
-            else {
-                if (w != g_batchWidth || h != g_batchHeight) {
-                    g_isConsistent = false;
-                }
+    // 新的拖入会使本次探测作废，剩余文件不再探测
+    std::atomic<bool> cancel(false);
+    result->cacheHits = ProbeFilesParallel(paths, &g_probeCache, WorkerPool::DefaultThreadCount(), result->infos, cancel,
+        [&](size_t i, VideoProbeInfo& info) {
+            if (g_probeGeneration != generation) {
+                cancel = true;
+                return;
             }
+            ProbeVideo(g_decoderBackend, paths[i], &info);
+        },
+        [] { g_decoderBackend.ThreadInit(); },
+        [] { g_decoderBackend.ThreadExit(); });
+
+    if (!cachePath.empty() && g_probeCache.Dirty()) g_probeCache.Save(cachePath);
+
+    // 预览无法缓存，只解码第一个文件的首帧
+    if (g_probeGeneration == generation && !result->infos.empty() && result->infos[0].ok) {
+        unique_ptr<IVideoDecoder> reader = g_decoderBackend.CreateDecoder();
+        if (reader->Open(paths[0])) {
+            result->preview = ReadFrameBitmap(*reader, result->infos[0].width, result->infos[0].height);
         }
-        tempReader.Close();
     }
-    SetCursor(hOldCursor);
 
-    SetDlgItemTextW(hMainWnd, IDC_EDT_PATH, path.c_str());
+    CoUninitialize();
+    if (!PostMessage(hMainWnd, WM_USER + 4, 0, (LPARAM)result)) {
+        delete result->preview;
+        delete result;
+    }
+}
 
-    if (PathIsDirectoryW(path.c_str())) {
-        SetDlgItemTextW(hMainWnd, IDC_EDT_OUT, (path + L"_frames").c_str());
+// 在后台开始探测 g_batchFiles，探测期间界面保持可响应
+void BeginProbe() {
+    unsigned generation = ++g_probeGeneration;
+    EnableWindow(GetDlgItem(hMainWnd, IDC_BTN_START), FALSE);
+
+    WCHAR info[256];
+    swprintf(info, 256, L"正在探测 %zu 个视频文件...", g_batchFiles.size());
+    SetDlgItemTextW(hMainWnd, IDC_LBL_BATCH, info);
+
+    thread t(ProbeWorker, g_batchFiles, generation);
+    t.detach();
+}
+
+// 界面线程：应用探测结果，检查分辨率一致性，更新预览、ROI 与批量信息
+void OnProbeFinished(ProbeResult* result) {
+    if (result->generation != g_probeGeneration) {
+        // 已被新的拖入取代
+        delete result->preview;
+        delete result;
+        return;
     }
-    else {
-        WCHAR drive[MAX_PATH], dir[MAX_PATH], name[MAX_PATH], ext[MAX_PATH];
-        _wsplitpath_s(path.c_str(), drive, MAX_PATH, dir, MAX_PATH, name, MAX_PATH, ext, MAX_PATH);
-        wstring defaultOut = wstring(drive) + wstring(dir) + wstring(name);
-        SetDlgItemTextW(hMainWnd, IDC_EDT_OUT, defaultOut.c_str());
+
+    g_batchInfos = result->infos;
+    g_isConsistent = true;
+    g_batchWidth = 0;
+    g_batchHeight = 0;
+    bool first = true;
+    for (size_t i = 0; i < g_batchInfos.size(); ++i) {
+        if (!g_batchInfos[i].ok) continue;
+        if (first) {
+            g_batchWidth = g_batchInfos[i].width;
+            g_batchHeight = g_batchInfos[i].height;
+            first = false;
+        }
+        else if (g_batchInfos[i].width != g_batchWidth || g_batchInfos[i].height != g_batchHeight) {
+            g_isConsistent = false;
+        }
     }
 
-    VideoReaderMF reader;
-    if (SUCCEEDED(reader.Open(g_batchFiles[0]))) {
-        // 初始化全局变量
-        g_durationHns = 0;
-        g_fps = 0.0;
-        g_durationSec = 0.0;
-        
-        reader.GetVideoInfo(g_batchWidth, g_batchHeight, g_durationHns, g_fps);
+    // 预览与元数据取第一个文件
+    g_durationHns = 0;
+    g_fps = 0.0;
+    g_durationSec = 0.0;
+    if (!g_batchInfos.empty() && g_batchInfos[0].ok) {
+        g_batchWidth = g_batchInfos[0].width;
+        g_batchHeight = g_batchInfos[0].height;
+        g_durationHns = g_batchInfos[0].durationHns;
+        g_fps = g_batchInfos[0].fps;
         g_durationSec = (double)g_durationHns / 10000000.0;
-
-        reader.Seek(0);
-        if (g_pPreviewBitmap) delete g_pPreviewBitmap;
-        g_pPreviewBitmap = reader.ReadFrame(g_batchWidth, g_batchHeight);
     }
+    if (g_pPreviewBitmap) delete g_pPreviewBitmap;
+    g_pPreviewBitmap = result->preview;
 
     BOOL bEnableROI = g_isConsistent;
     EnableWindow(GetDlgItem(hMainWnd, IDC_EDT_X1), bEnableROI);
@@ -400,64 +415,79 @@ void ProcessDrop(const wstring& path) {
     WCHAR info[256];
     if (g_batchFiles.size() > 1) {
         if (g_isConsistent) {
-            swprintf(info, 256, L"批量模式: %zu 个文件 | 分辨率一致 (%dx%d) | 可裁剪", g_batchFiles.size(), g_batchWidth, g_batchHeight);
-            SetDlgItemTextW(hMainWnd, IDC_LBL_BATCH, info);
+            swprintf(info, 256, L"批量模式: %zu 个文件 | 分辨率一致 (%dx%d) | 可裁剪 | 缓存命中 %zu", g_batchFiles.size(), g_batchWidth, g_batchHeight, result->cacheHits);
         }
         else {
-            swprintf(info, 256, L"批量模式: %zu 个文件 | 分辨率不一致 | 裁剪已禁用", g_batchFiles.size());
-            SetDlgItemTextW(hMainWnd, IDC_LBL_BATCH, info);
+            swprintf(info, 256, L"批量模式: %zu 个文件 | 分辨率不一致 | 裁剪已禁用 | 缓存命中 %zu", g_batchFiles.size(), result->cacheHits);
         }
     }
     else {
         swprintf(info, 256, L"单文件模式 | %dx%d, %.2f秒, %.2f FPS", g_batchWidth, g_batchHeight, g_durationSec, g_fps);
-        SetDlgItemTextW(hMainWnd, IDC_LBL_BATCH, info);
     }
+    SetDlgItemTextW(hMainWnd, IDC_LBL_BATCH, info);
 
     SetWindowSubclass(GetDlgItem(hMainWnd, IDC_PREVIEW), PreviewProc, 0, 0);
     InvalidateRect(GetDlgItem(hMainWnd, IDC_PREVIEW), NULL, FALSE);
 
+    EnableWindow(GetDlgItem(hMainWnd, IDC_BTN_START), TRUE);
+    delete result;
+
     if (SendMessage(GetDlgItem(hMainWnd, IDC_CHK_AUTO), BM_GETCHECK, 0, 0) == BST_CHECKED) {
         StartExtractionThread();
     }
 }
 
-// 处理多个拖入的视频文件
-void ProcessMultipleFiles(const vector<wstring>& files) {
-    g_batchFiles = files;
+void ProcessDrop(const wstring& path) {
+    g_batchFiles.clear();
+
+    if (PathIsDirectoryW(path.c_str())) {
+        wstring searchPath = path + L"\\*.*";
+        WIN32_FIND_DATAW fd;
+        HANDLE hFind = FindFirstFileW(searchPath.c_str(), &fd);
+        if (hFind != INVALID_HANDLE_VALUE) {
+            do {
+                if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+                    wstring fileName = fd.cFileName;
+                    if (IsVideoFile(fileName)) {
+                        g_batchFiles.push_back(path + L"\\" + fileName);
+                    }
+                }
+            } while (FindNextFileW(hFind, &fd));
+            FindClose(hFind);
+        }
+    }
+    else {
+        if (IsVideoFile(path)) g_batchFiles.push_back(path);
+    }
 
     if (g_batchFiles.empty()) {
         MessageBoxW(hMainWnd, L"未找到有效的视频文件！", L"提示", MB_ICONWARNING);
         return;
     }
 
-    g_isConsistent = true;
-    g_batchWidth = 0;
-    g_batchHeight = 0;
+    SetDlgItemTextW(hMainWnd, IDC_EDT_PATH, path.c_str());
+
+    if (PathIsDirectoryW(path.c_str())) {
+        SetDlgItemTextW(hMainWnd, IDC_EDT_OUT, (path + L"_frames").c_str());
+    }
+    else {
+        WCHAR drive[MAX_PATH], dir[MAX_PATH], name[MAX_PATH], ext[MAX_PATH];
+        _wsplitpath_s(path.c_str(), drive, MAX_PATH, dir, MAX_PATH, name, MAX_PATH, ext, MAX_PATH);
+        wstring defaultOut = wstring(drive) + wstring(dir) + wstring(name);
+        SetDlgItemTextW(hMainWnd, IDC_EDT_OUT, defaultOut.c_str());
+    }
 
-    HCURSOR hOldCursor = SetCursor(LoadCursor(NULL, IDC_WAIT));
+    BeginProbe();
+}
 
-    // 检查所有文件的分辨率是否一致
-    VideoReaderMF tempReader;
-    for (size_t i = 0; i < g_batchFiles.size(); ++i) {
-        if (FAILED(tempReader.Open(g_batchFiles[i]))) continue;
+// 处理多个拖入的视频文件
+void ProcessMultipleFiles(const vector<wstring>& files) {
+    g_batchFiles = files;
 
-        UINT32 w, h;
-        UINT64 d;
-        double f;
-        if (SUCCEEDED(tempReader.GetVideoInfo(w, h, d, f))) {
-            if (i == 0) {
-                g_batchWidth = w;
-                g_batchHeight = h;
-            }
-            else {
-                if (w != g_batchWidth || h != g_batchHeight) {
-                    g_isConsistent = false;
-                }
-            }
-        }
-        tempReader.Close();
+    if (g_batchFiles.empty()) {
+        MessageBoxW(hMainWnd, L"未找到有效的视频文件！", L"提示", MB_ICONWARNING);
+        return;
     }
-    SetCursor(hOldCursor);
 
     // 获取第一个文件的目录作为输出目录的基础
     wstring firstFile = g_batchFiles[0];
@@ -478,51 +508,7 @@ void ProcessMultipleFiles(const vector<wstring>& files) {
     // 设置输出目录
     SetDlgItemTextW(hMainWnd, IDC_EDT_OUT, (baseDir + L"_frames").c_str());
 
-    // 读取第一个视频的信息用于预览
-    VideoReaderMF reader;
-    if (SUCCEEDED(reader.Open(g_batchFiles[0]))) {
-        g_durationHns = 0;
-        g_fps = 0.0;
-        g_durationSec = 0.0;
-        
-        reader.GetVideoInfo(g_batchWidth, g_batchHeight, g_durationHns, g_fps);
-        g_durationSec = (double)g_durationHns / 10000000.0;
-
-        reader.Seek(0);
-        if (g_pPreviewBitmap) delete g_pPreviewBitmap;
-        g_pPreviewBitmap = reader.ReadFrame(g_batchWidth, g_batchHeight);
-    }
-
-    // 设置ROI控件状态
-    BOOL bEnableROI = g_isConsistent;
-    EnableWindow(GetDlgItem(hMainWnd, IDC_EDT_X1), bEnableROI);
-    EnableWindow(GetDlgItem(hMainWnd, IDC_EDT_Y1), bEnableROI);
-    EnableWindow(GetDlgItem(hMainWnd, IDC_EDT_X2), bEnableROI);
-    EnableWindow(GetDlgItem(hMainWnd, IDC_EDT_Y2), bEnableROI);
-
-    SetIntToEdit(IDC_EDT_X1, 0);
-    SetIntToEdit(IDC_EDT_Y1, 0);
-    SetIntToEdit(IDC_EDT_X2, g_batchWidth);
-    SetIntToEdit(IDC_EDT_Y2, g_batchHeight);
-
-    UpdateROISizeLabel();
-
-    // 显示批量模式信息
-    WCHAR info[256];
-    if (g_isConsistent) {
-        swprintf(info, 256, L"批量模式: %zu 个文件 | 分辨率一致 (%dx%d) | 可裁剪", g_batchFiles.size(), g_batchWidth, g_batchHeight);
-    }
-    else {
-        swprintf(info, 256, L"批量模式: %zu 个文件 | 分辨率不一致 | 裁剪已禁用", g_batchFiles.size());
-    }
-    SetDlgItemTextW(hMainWnd, IDC_LBL_BATCH, info);
-
-    SetWindowSubclass(GetDlgItem(hMainWnd, IDC_PREVIEW), PreviewProc, 0, 0);
-    InvalidateRect(GetDlgItem(hMainWnd, IDC_PREVIEW), NULL, FALSE);
-
-    if (SendMessage(GetDlgItem(hMainWnd, IDC_CHK_AUTO), BM_GETCHECK, 0, 0) == BST_CHECKED) {
-        StartExtractionThread();
-    }
+    BeginProbe();
 }
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
@@ -551,7 +537,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 
     hMainWnd = CreateWindowW(L"VideoExtractorBatch", L"drag2frames",
         WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_MINIMIZEBOX,
-        CW_USEDEFAULT, 0, 800, 680, NULL, NULL, hInstance, NULL);
+        CW_USEDEFAULT, 0, 800, 740, NULL, NULL, hInstance, NULL);
 
     if (!hMainWnd) return FALSE;
 
@@ -579,6 +565,12 @@ int GetIntFromEdit(int id) {
     return _wtoi(buf);
 }
 
+double GetDoubleFromEdit(int id) {
+    WCHAR buf[32];
+    GetDlgItemTextW(hMainWnd, id, buf, 32);
+    return _wtof(buf);
+}
+
 void SetIntToEdit(int id, int val) {
     WCHAR buf[32];
     wsprintfW(buf, L"%d", val);
@@ -604,97 +596,108 @@ void UpdateROISizeLabel() {
     SetDlgItemTextW(hMainWnd, IDC_LBL_ROI, buf);
 }
 
-void ExtractionWorker(wstring rootOutDir, int interval, RECT roi) {
-    CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
-    CLSID jpgClsid;
-    GetEncoderClsid(L"image/jpeg", &jpgClsid);
-
-    PostMessage(hMainWnd, WM_USER + 1, 0, 0);
-    WCHAR statusBuf[512];
+// 切换输出格式：质量框在 JPEG 下为质量，在 PNG 下为压缩级别，其他格式不可用
+void OnOutputFormatChanged() {
+    int index = (int)SendMessage(GetDlgItem(hMainWnd, IDC_CMB_FORMAT), CB_GETCURSEL, 0, 0);
+    if (index < 0 || index >= (int)(sizeof(g_outputFormats) / sizeof(g_outputFormats[0]))) return;
+    int format = g_outputFormats[index].format;
+    HWND hQuality = GetDlgItem(hMainWnd, IDC_EDT_QUALITY);
+    if (format == IMAGE_JPEG) {
+        SetDlgItemTextW(hMainWnd, IDC_LBL_QUALITY, L"质量:");
+        int q = GetIntFromEdit(IDC_EDT_QUALITY);
+        if (q < 1 || q > 100) SetIntToEdit(IDC_EDT_QUALITY, 90);
+        EnableWindow(hQuality, TRUE);
+    }
+    else if (format == IMAGE_PNG) {
+        SetDlgItemTextW(hMainWnd, IDC_LBL_QUALITY, L"级别:");
+        int level = GetIntFromEdit(IDC_EDT_QUALITY);
+        if (level > 9) SetIntToEdit(IDC_EDT_QUALITY, 6);
+        EnableWindow(hQuality, TRUE);
+    }
+    else {
+        EnableWindow(hQuality, FALSE);
+    }
+    // 张量输出本身就是每个视频一个文件，不需要打包
+    EnableWindow(GetDlgItem(hMainWnd, IDC_CHK_PACK), g_outputFormats[index].tensor == TENSOR_NONE);
+}
 
-    for (size_t i = 0; i < g_batchFiles.size(); ++i) {
-        if (g_stopRequested) break;
+// 切换采样方式：数值框在按帧数时为跳帧数（整数），按秒时为间隔秒数，按帧率时为每秒帧数
+void OnSamplingModeChanged() {
+    int mode = (int)SendMessage(GetDlgItem(hMainWnd, IDC_CMB_SAMPLING), CB_GETCURSEL, 0, 0);
+    if (mode < 0 || mode >= (int)(sizeof(g_samplingModes) / sizeof(g_samplingModes[0]))) return;
+    SetDlgItemTextW(hMainWnd, IDC_LBL_INT, g_samplingModes[mode].label);
+    if (mode == SAMPLE_FRAMES) {
+        int interval = GetIntFromEdit(IDC_EDT_INT);
+        SetIntToEdit(IDC_EDT_INT, interval < 0 ? 0 : interval);
+    }
+    else if (GetDoubleFromEdit(IDC_EDT_INT) <= 0.0) {
+        SetIntToEdit(IDC_EDT_INT, 1);
+    }
+}
 
-        wstring currentFile = g_batchFiles[i];
-        swprintf(statusBuf, 512, L"正在处理文件 (%zu/%zu): %s", i + 1, g_batchFiles.size(), PathFindFileNameW(currentFile.c_str()));
-        SetDlgItemTextW(hMainWnd, IDC_LBL_INFO, statusBuf);
+// 工作线程的状态文字：通过 WM_USER + 5 的 LPARAM 交给界面线程，由界面线程显示后 delete。
+// 工作线程不直接调用 SetDlgItemTextW：它向界面线程同步发送消息，多个工作线程会阻塞在界面线程上，窗口关闭后还会访问已销毁的控件
+void PostStatusText(const wstring& text) {
+    wstring* copy = new wstring(text);
+    if (!PostMessage(hMainWnd, WM_USER + 5, 0, (LPARAM)copy)) delete copy;
+}
 
-        WCHAR fName[MAX_PATH], fExt[MAX_PATH];
-        _wsplitpath_s(currentFile.c_str(), NULL, 0, NULL, 0, fName, MAX_PATH, fExt, MAX_PATH);
-        wstring videoBaseName = fName;  // 保存视频文件名（不含扩展名）
-        wstring subOutDir = rootOutDir + L"\\" + fName;
+// 把引擎的进度与状态转交给界面：进度通过 WM_USER + 2，状态通过 WM_USER + 5；
+// 各回调在多个工作线程上并发调用，只使用局部缓冲
+class GuiExtractionObserver : public IExtractionObserver {
+public:
+    explicit GuiExtractionObserver(bool dedup) : m_dedup(dedup) {}
 
-        CreateDirectoryW(subOutDir.c_str(), NULL);
+    void OnProgress(int percent) override {
+        PostMessage(hMainWnd, WM_USER + 2, percent, 0);
+    }
 
-        VideoReaderMF reader;
-        if (FAILED(reader.Open(currentFile))) continue;
+    void OnFileStarted(size_t index, size_t active, size_t done) override {
+        WCHAR statusBuf[512];
+        swprintf(statusBuf, 512, L"正在处理 %zu 个文件 (已完成 %zu/%zu): %s", active, done, g_batchFiles.size(),
+            PathFindFileNameW(g_batchFiles[index].c_str()));
+        PostStatusText(statusBuf);
+    }
 
-        UINT32 vW = 0, vH = 0;
-        UINT64 vDurHns = 0;
-        double vFps = 0.0;
-        reader.GetVideoInfo(vW, vH, vDurHns, vFps);
-        double vDurSec = (double)vDurHns / 10000000.0;
+    void OnFileFinished(size_t index, bool ok, int kept, int dropped) override {
+        if (!ok || !m_dedup) return;
+        WCHAR statusBuf[512];
+        swprintf(statusBuf, 512, L"%s: 保留 %d 帧, 丢弃重复帧 %d 帧", PathFindFileNameW(g_batchFiles[index].c_str()), kept, dropped);
+        PostStatusText(statusBuf);
+    }
 
-        int roiW = roi.right - roi.left;
-        int roiH = roi.bottom - roi.top;
-        if (!g_isConsistent || roiW <= 0 || roiH <= 0) {
-            roi.left = 0; roi.top = 0;
-            roiW = vW; roiH = vH;
-        }
+private:
+    bool m_dedup;   // 启用去重时每个文件完成后显示保存与丢弃的帧数
+};
 
-        // 使用顺序读取方式：读取所有帧，按间隔保存
-        // interval=0 表示保存每一帧，interval=1 表示每隔1帧保存（即保存第1、3、5...帧）
-        int frameIndex = 0;      // 当前读取的帧索引（从0开始）
-        int savedCount = 0;      // 已保存的帧数
-        int skipCount = interval; // 跳过计数器，初始设为interval以便立即保存第一帧
-        
-        LONGLONG timestamp = 0;
-        
-        // 从视频开头开始顺序读取
-        reader.Seek(0.0);
-        
-        while (!g_stopRequested) {
-            Bitmap* bmp = reader.ReadNextFrame(vW, vH, &timestamp);
-            if (!bmp) break; // 读取完毕或出错
-            
-            frameIndex++;
-            skipCount++;
-            
-            // 判断是否需要保存这一帧
-            if (skipCount > interval) {
-                skipCount = 0; // 重置跳过计数器
-                
-                Bitmap* pSaveBmp = bmp;
-                Bitmap* pCropped = nullptr;
-
-                if (g_isConsistent && (roiW < (int)vW || roiH < (int)vH)) {
-                    pCropped = bmp->Clone(roi.left, roi.top, roiW, roiH, PixelFormatDontCare);
-                    if (pCropped) pSaveBmp = pCropped;
-                }
+// outputs 至少有一个；每个保存的帧只解码一次，按各输出的 ROI、尺寸与格式分别输出
+void ExtractionWorker(wstring rootOutDir, SamplingOptions sampling, vector<OutputSpec> outputs, double dedupThreshold) {
+    PostMessage(hMainWnd, WM_USER + 1, 0, 0);
 
-                // 使用"视频文件名_帧序号"格式作为文件名
-                WCHAR filePath[MAX_PATH];
-                swprintf(filePath, MAX_PATH, L"%s\\%s_%05d.jpg", subOutDir.c_str(), videoBaseName.c_str(), frameIndex);
-                pSaveBmp->Save(filePath, &jpgClsid, NULL);
-
-                if (pCropped) delete pCropped;
-                savedCount++;
-                
-                // 更新进度条
-                if (savedCount % 5 == 0) {
-                    double currentTimeSec = (double)timestamp / 10000000.0;
-                    int progress = (int)((currentTimeSec / vDurSec) * 100);
-                    if (progress > 100) progress = 100;
-                    PostMessage(hMainWnd, WM_USER + 2, progress, 0);
-                }
-            }
-            
-            delete bmp;
-        }
-        reader.Close();
+    // 探测阶段已取得每个文件的元数据，引擎不再重复探测
+    ExtractionJob job;
+    job.outputDir = WideToUtf8(rootOutDir);
+    job.sampling = sampling;
+    job.outputs = outputs;
+    job.dedupThreshold = dedupThreshold;
+    for (size_t i = 0; i < g_batchFiles.size(); ++i) job.files.push_back(WideToUtf8(g_batchFiles[i]));
+    job.infos = g_batchInfos;
+
+    GuiExtractionObserver observer(dedupThreshold > 0.0);
+    ExtractionEngine engine(g_decoderBackend);
+    engine.SetEncoderFactory([](const OutputSpec& spec) { return CreateOutputEncoder(spec.encoder, spec.gdiplus); });
+    engine.SetObserver(&observer);
+
+    ExtractionStats stats;
+    string error;
+    if (!engine.Run(job, g_stopRequested, &stats, &error)) {
+        PostStatusText(Utf8ToWide(error));
     }
+    g_poolHits = stats.poolHits;
+    g_poolMisses = stats.poolMisses;
+    g_dedupKept = stats.dedupKept;
+    g_dedupDropped = stats.dedupDropped;
 
-    CoUninitialize();
     PostMessage(hMainWnd, WM_USER + 3, 0, 0);
 }
 
@@ -713,16 +716,54 @@ void StartExtractionThread() {
     }
     CreateDirectoryW(outDir.c_str(), NULL);
 
-    int interval = GetIntFromEdit(IDC_EDT_INT);
-    RECT roi;
-    roi.left = GetIntFromEdit(IDC_EDT_X1);
-    roi.top = GetIntFromEdit(IDC_EDT_Y1);
-    roi.right = GetIntFromEdit(IDC_EDT_X2);
-    roi.bottom = GetIntFromEdit(IDC_EDT_Y2);
+    SamplingOptions sampling;
+    sampling.mode = (int)SendMessage(GetDlgItem(hMainWnd, IDC_CMB_SAMPLING), CB_GETCURSEL, 0, 0);
+    if (sampling.mode == SAMPLE_FRAMES) {
+        sampling.interval = std::max(0, GetIntFromEdit(IDC_EDT_INT));
+    }
+    else {
+        sampling.value = GetDoubleFromEdit(IDC_EDT_INT);
+        if (sampling.PeriodHns() <= 0) {
+            MessageBoxW(hMainWnd, sampling.mode == SAMPLE_SECONDS ? L"间隔秒数必须大于 0！" : L"帧率必须大于 0！", L"错误", MB_ICONERROR);
+            return;
+        }
+    }
+    // 主输出：界面上的 ROI 与格式，直接输出到输出目录；分辨率不一致的批量模式下 ROI 不生效
+    OutputSpec primary;
+    primary.useRoi = g_isConsistent;
+    primary.roi.left = GetIntFromEdit(IDC_EDT_X1);
+    primary.roi.top = GetIntFromEdit(IDC_EDT_Y1);
+    primary.roi.right = GetIntFromEdit(IDC_EDT_X2);
+    primary.roi.bottom = GetIntFromEdit(IDC_EDT_Y2);
+
+    int formatIndex = (int)SendMessage(GetDlgItem(hMainWnd, IDC_CMB_FORMAT), CB_GETCURSEL, 0, 0);
+    if (formatIndex < 0 || formatIndex >= (int)(sizeof(g_outputFormats) / sizeof(g_outputFormats[0]))) formatIndex = 0;
+    const OutputFormatItem& format = g_outputFormats[formatIndex];
+    primary.encoder.format = format.format;
+    if (format.format == IMAGE_JPEG) primary.encoder.quality = GetIntFromEdit(IDC_EDT_QUALITY);
+    if (format.format == IMAGE_PNG) primary.encoder.level = GetIntFromEdit(IDC_EDT_QUALITY);
+    primary.gdiplus = format.gdiplus;
+    primary.tensor = format.tensor;
+    primary.channels = format.channels;
+    primary.pack = format.tensor == TENSOR_NONE && SendMessage(GetDlgItem(hMainWnd, IDC_CHK_PACK), BM_GETCHECK, 0, 0) == BST_CHECKED;
+
+    // 附加输出：与主输出共用一次解码，各自输出到输出目录下的子目录
+    vector<OutputSpec> outputs(1, primary);
+    HWND hOutputs = GetDlgItem(hMainWnd, IDC_EDT_OUTPUTS);
+    wstring outputsText(GetWindowTextLengthW(hOutputs) + 1, L'\0');
+    outputsText.resize(GetWindowTextW(hOutputs, &outputsText[0], (int)outputsText.size()));
+    string outputsError;
+    if (!ParseOutputList(WideToUtf8(outputsText), &outputs, &outputsError)) {
+        MessageBoxW(hMainWnd, (L"附加输出无效：" + Utf8ToWide(outputsError)).c_str(), L"错误", MB_ICONERROR);
+        return;
+    }
+
+    // 去重阈值：每像素平均亮度差（0-255），0 表示不去重
+    double dedupThreshold = std::max(0.0, GetDoubleFromEdit(IDC_EDT_DEDUP));
 
     g_stopRequested = false;
     g_isExtracting = true;
-    thread t(ExtractionWorker, outDir, interval, roi);
+    thread t(ExtractionWorker, outDir, sampling, outputs, dedupThreshold);
     t.detach();
 }
 
@@ -782,8 +823,9 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         CreateWindowW(L"BUTTON", L"...", WS_VISIBLE | WS_CHILD | WS_TABSTOP, 680, y - 2, 70, 24, hWnd, (HMENU)IDC_BTN_BROWSE, hInst, NULL);
 
         y += 30;
-        CreateWindowW(L"STATIC", L"跳帧数:", WS_VISIBLE | WS_CHILD, 10, y, 70, 20, hWnd, NULL, hInst, NULL);
-        CreateWindowW(L"EDIT", L"0", WS_VISIBLE | WS_CHILD | WS_BORDER | ES_NUMBER | WS_TABSTOP, 80, y, 50, 20, hWnd, (HMENU)IDC_EDT_INT, hInst, NULL);
+        CreateWindowW(L"STATIC", L"跳帧数:", WS_VISIBLE | WS_CHILD, 10, y, 70, 20, hWnd, (HMENU)IDC_LBL_INT, hInst, NULL);
+        // 按秒/按帧率时需要输入小数，因此不使用 ES_NUMBER
+        CreateWindowW(L"EDIT", L"0", WS_VISIBLE | WS_CHILD | WS_BORDER | ES_AUTOHSCROLL | WS_TABSTOP, 80, y, 50, 20, hWnd, (HMENU)IDC_EDT_INT, hInst, NULL);
 
         CreateWindowW(L"STATIC", L"ROI区域:", WS_VISIBLE | WS_CHILD, 150, y, 60, 20, hWnd, NULL, hInst, NULL);
         CreateWindowW(L"EDIT", L"0", WS_VISIBLE | WS_CHILD | WS_BORDER | ES_NUMBER | WS_TABSTOP, 210, y, 40, 20, hWnd, (HMENU)IDC_EDT_X1, hInst, NULL);
@@ -798,6 +840,37 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         CreateWindowW(L"BUTTON", L"自动开始", WS_VISIBLE | WS_CHILD | BS_AUTOCHECKBOX | WS_TABSTOP, 500, y, 80, 20, hWnd, (HMENU)IDC_CHK_AUTO, hInst, NULL);
         CreateWindowW(L"BUTTON", L"开始提取", WS_VISIBLE | WS_CHILD | WS_TABSTOP, 600, y - 2, 100, 25, hWnd, (HMENU)IDC_BTN_START, hInst, NULL);
 
+        // 输出格式与质量（JPEG 为质量 1-100，PNG 为压缩级别 0-9）
+        y += 30;
+        CreateWindowW(L"STATIC", L"输出格式:", WS_VISIBLE | WS_CHILD, 10, y, 70, 20, hWnd, NULL, hInst, NULL);
+        HWND hFormat = CreateWindowW(L"COMBOBOX", L"", WS_VISIBLE | WS_CHILD | CBS_DROPDOWNLIST | WS_VSCROLL | WS_TABSTOP, 80, y - 2, 120, 200, hWnd, (HMENU)IDC_CMB_FORMAT, hInst, NULL);
+        for (size_t i = 0; i < sizeof(g_outputFormats) / sizeof(g_outputFormats[0]); ++i) {
+            SendMessage(hFormat, CB_ADDSTRING, 0, (LPARAM)g_outputFormats[i].name);
+        }
+        SendMessage(hFormat, CB_SETCURSEL, 0, 0);
+        CreateWindowW(L"STATIC", L"质量:", WS_VISIBLE | WS_CHILD, 215, y, 40, 20, hWnd, (HMENU)IDC_LBL_QUALITY, hInst, NULL);
+        CreateWindowW(L"EDIT", L"90", WS_VISIBLE | WS_CHILD | WS_BORDER | ES_NUMBER | WS_TABSTOP, 255, y, 40, 20, hWnd, (HMENU)IDC_EDT_QUALITY, hInst, NULL);
+
+        // 采样方式：按帧数、按秒或按帧率，切换时改变跳帧数输入框的含义
+        CreateWindowW(L"STATIC", L"采样方式:", WS_VISIBLE | WS_CHILD, 320, y, 70, 20, hWnd, NULL, hInst, NULL);
+        HWND hSampling = CreateWindowW(L"COMBOBOX", L"", WS_VISIBLE | WS_CHILD | CBS_DROPDOWNLIST | WS_VSCROLL | WS_TABSTOP, 390, y - 2, 100, 200, hWnd, (HMENU)IDC_CMB_SAMPLING, hInst, NULL);
+        for (size_t i = 0; i < sizeof(g_samplingModes) / sizeof(g_samplingModes[0]); ++i) {
+            SendMessage(hSampling, CB_ADDSTRING, 0, (LPARAM)g_samplingModes[i].name);
+        }
+        SendMessage(hSampling, CB_SETCURSEL, SAMPLE_FRAMES, 0);
+
+        // 去重阈值：与上一个保存的帧平均亮度差低于该值的帧不保存，0 表示关闭
+        CreateWindowW(L"STATIC", L"去重阈值:", WS_VISIBLE | WS_CHILD, 510, y, 70, 20, hWnd, NULL, hInst, NULL);
+        CreateWindowW(L"EDIT", L"0", WS_VISIBLE | WS_CHILD | WS_BORDER | ES_AUTOHSCROLL | WS_TABSTOP, 580, y, 40, 20, hWnd, (HMENU)IDC_EDT_DEDUP, hInst, NULL);
+
+        // 打包输出：每个视频的所有帧写入一个归档文件，代替大量小文件
+        CreateWindowW(L"BUTTON", L"打包输出", WS_VISIBLE | WS_CHILD | BS_AUTOCHECKBOX | WS_TABSTOP, 640, y, 90, 20, hWnd, (HMENU)IDC_CHK_PACK, hInst, NULL);
+
+        // 附加输出：以 ';' 分隔的多个输出描述（子目录、ROI、缩放尺寸、格式），与主输出共用一次解码
+        y += 30;
+        CreateWindowW(L"STATIC", L"附加输出:", WS_VISIBLE | WS_CHILD, 10, y, 70, 20, hWnd, NULL, hInst, NULL);
+        CreateWindowW(L"EDIT", L"", WS_VISIBLE | WS_CHILD | WS_BORDER | ES_AUTOHSCROLL | WS_TABSTOP, 80, y, 670, 20, hWnd, (HMENU)IDC_EDT_OUTPUTS, hInst, NULL);
+
         y += 30;
         CreateWindowW(L"STATIC", L"等待拖入...", WS_VISIBLE | WS_CHILD, 10, y, 760, 20, hWnd, (HMENU)IDC_LBL_BATCH, hInst, NULL);
 
@@ -813,6 +886,12 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
     case WM_DROPFILES:
     {
         HDROP hDrop = (HDROP)wParam;
+        if (g_isExtracting) {
+            // 提取期间批量文件列表正被工作线程使用，不接受新的拖入
+            DragFinish(hDrop);
+            MessageBoxW(hMainWnd, L"正在提取中，请先停止当前任务。", L"提示", MB_ICONWARNING);
+            break;
+        }
         UINT fileCount = DragQueryFileW(hDrop, 0xFFFFFFFF, NULL, 0);
         
         if (fileCount == 1) {
@@ -866,6 +945,13 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             }
         }
 
+        if (id == IDC_CMB_FORMAT && code == CBN_SELCHANGE) {
+            OnOutputFormatChanged();
+        }
+        if (id == IDC_CMB_SAMPLING && code == CBN_SELCHANGE) {
+            OnSamplingModeChanged();
+        }
+
         if ((id == IDC_EDT_X1 || id == IDC_EDT_Y1 || id == IDC_EDT_X2 || id == IDC_EDT_Y2) && code == EN_CHANGE) {
             InvalidateRect(GetDlgItem(hWnd, IDC_PREVIEW), NULL, FALSE);
             UpdateWindow(GetDlgItem(hWnd, IDC_PREVIEW));
@@ -880,22 +966,58 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         EnableWindow(GetDlgItem(hWnd, IDC_EDT_PATH), FALSE);
         EnableWindow(GetDlgItem(hWnd, IDC_EDT_OUT), FALSE);
         EnableWindow(GetDlgItem(hWnd, IDC_BTN_BROWSE), FALSE);
+        EnableWindow(GetDlgItem(hWnd, IDC_CMB_FORMAT), FALSE);
+        EnableWindow(GetDlgItem(hWnd, IDC_EDT_QUALITY), FALSE);
+        EnableWindow(GetDlgItem(hWnd, IDC_CMB_SAMPLING), FALSE);
+        EnableWindow(GetDlgItem(hWnd, IDC_EDT_INT), FALSE);
+        EnableWindow(GetDlgItem(hWnd, IDC_EDT_DEDUP), FALSE);
+        EnableWindow(GetDlgItem(hWnd, IDC_CHK_PACK), FALSE);
+        EnableWindow(GetDlgItem(hWnd, IDC_EDT_OUTPUTS), FALSE);
         break;
 
     case WM_USER + 2: // Progress
         SendMessage(GetDlgItem(hWnd, IDC_PROGRESS), PBM_SETPOS, wParam, 0);
         break;
 
+    case WM_USER + 5: // Status text
+    {
+        wstring* text = (wstring*)lParam;
+        SetDlgItemTextW(hWnd, IDC_LBL_INFO, text->c_str());
+        delete text;
+    }
+    break;
+
+    case WM_USER + 4: // Probe finished
+        OnProbeFinished((ProbeResult*)lParam);
+        break;
+
     case WM_USER + 3: // Finish
+    {
         g_isExtracting = false;
         SetDlgItemTextW(hWnd, IDC_BTN_START, L"开始提取");
-        SetDlgItemTextW(hWnd, IDC_LBL_INFO, L"所有任务已完成！");
+        WCHAR doneBuf[256];
+        swprintf(doneBuf, 256, L"所有任务已完成！(帧缓冲池: 复用 %llu 次, 分配 %llu 次)",
+            (unsigned long long)g_poolHits.load(), (unsigned long long)g_poolMisses.load());
+        if (g_dedupKept + g_dedupDropped > 0) {
+            WCHAR dedupBuf[96];
+            swprintf(dedupBuf, 96, L" 去重: 保留 %llu 帧, 丢弃 %llu 帧",
+                (unsigned long long)g_dedupKept.load(), (unsigned long long)g_dedupDropped.load());
+            wcscat(doneBuf, dedupBuf);
+        }
+        SetDlgItemTextW(hWnd, IDC_LBL_INFO, doneBuf);
         EnableWindow(GetDlgItem(hWnd, IDC_EDT_PATH), TRUE);
         EnableWindow(GetDlgItem(hWnd, IDC_EDT_OUT), TRUE);
         EnableWindow(GetDlgItem(hWnd, IDC_BTN_BROWSE), TRUE);
+        EnableWindow(GetDlgItem(hWnd, IDC_CMB_FORMAT), TRUE);
+        EnableWindow(GetDlgItem(hWnd, IDC_CMB_SAMPLING), TRUE);
+        EnableWindow(GetDlgItem(hWnd, IDC_EDT_INT), TRUE);
+        EnableWindow(GetDlgItem(hWnd, IDC_EDT_DEDUP), TRUE);
+        EnableWindow(GetDlgItem(hWnd, IDC_EDT_OUTPUTS), TRUE);
+        OnOutputFormatChanged();
         SendMessage(GetDlgItem(hWnd, IDC_PROGRESS), PBM_SETPOS, 100, 0);
         MessageBoxW(hWnd, L"所有任务已完成。", L"提示", MB_OK);
-        break;
+    }
+    break;
 
     case WM_DESTROY:
         PostQuitMessage(0);
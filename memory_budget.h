@@ -0,0 +1,78 @@
+/*
+    内存预算：一次提取中流水线各阶段持有的帧数据共用一个字节上限。
+    解码线程在送出一帧之前按这一帧所有输出的缓冲大小（含缩放前的转换结果）申请额度，额度不足时等待编码线程归还；
+    编码后等待写出的数据也计入同一预算（不等待，由写出队列自己的上限反压），写出后归还。
+    预算为空（上限 0）时从不等待，只统计占用的最大值。
+    已经申请到额度的帧一定能走完流水线，预算用尽时总有额度在归还途中；
+    没有任何占用时放行一次超过上限的申请，单帧大于上限也不会卡住。
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+class MemoryBudget {
+public:
+    // limitBytes 为 0 表示不限
+    explicit MemoryBudget(size_t limitBytes = 0)
+        : m_limit(limitBytes), m_used(0), m_peak(0), m_waits(0), m_waitNs(0) {}
+
+    // 申请额度，超过上限时阻塞直到归还足够的额度
+    void Acquire(size_t bytes) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!Fits(bytes)) {
+            m_waits++;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            m_released.wait(lock, [this, bytes] { return Fits(bytes); });
+            m_waitNs += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        }
+        Add(bytes);
+    }
+
+    // 不等待地计入额度（下游阶段使用，避免与上游互相等待）
+    void Charge(size_t bytes) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Add(bytes);
+    }
+
+    void Release(size_t bytes) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_used -= bytes < m_used ? bytes : m_used;
+        }
+        m_released.notify_all();
+    }
+
+    size_t Limit() const { return m_limit; }
+    size_t Used() const { std::lock_guard<std::mutex> lock(m_mutex); return m_used; }
+    size_t Peak() const { std::lock_guard<std::mutex> lock(m_mutex); return m_peak; }
+
+    // Acquire() 等待的次数与总时间
+    uint64_t Waits() const { std::lock_guard<std::mutex> lock(m_mutex); return m_waits; }
+    double WaitSeconds() const { std::lock_guard<std::mutex> lock(m_mutex); return m_waitNs / 1e9; }
+
+private:
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    bool Fits(size_t bytes) const {
+        return m_limit == 0 || m_used == 0 || m_used + bytes <= m_limit;
+    }
+
+    void Add(size_t bytes) {
+        m_used += bytes;
+        if (m_used > m_peak) m_peak = m_used;
+    }
+
+    size_t m_limit;
+    size_t m_used;
+    size_t m_peak;
+    uint64_t m_waits;
+    uint64_t m_waitNs;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_released;
+};
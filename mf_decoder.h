@@ -0,0 +1,391 @@
+/*
+    Media Foundation 解码后端（仅 Windows）
+    IMFSourceReader 优先输出 NV12 / I420，不支持时回退到 RGB32；锁定帧时优先使用 IMF2DBuffer，避免整帧拷贝。
+    调用 MFStartup() 之后才能使用；每个使用解码器的线程需要初始化 COM（由后端的 ThreadInit / ThreadExit 完成）。
+*/
+#pragma once
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <mfapi.h>
+#include <mfidl.h>
+#include <mfreadwrite.h>
+#include <propvarutil.h>
+#include <shlwapi.h>
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "file_util.h"
+#include "video_decoder.h"
+
+#pragma comment(lib, "mf.lib")
+#pragma comment(lib, "mfplat.lib")
+#pragma comment(lib, "mfreadwrite.lib")
+#pragma comment(lib, "mfuuid.lib")
+#pragma comment(lib, "propsys.lib")
+
+// 安全释放 COM 接口
+template <class T> void SafeRelease(T** ppT) {
+    if (*ppT) { (*ppT)->Release(); *ppT = NULL; }
+}
+
+// ==========================================
+// Media Foundation 视频读取器
+// ==========================================
+class VideoReaderMF : public IVideoDecoder {
+public:
+    IMFSourceReader* m_pReader;
+
+    VideoReaderMF() : m_pReader(NULL), m_pCurSample(NULL), m_pLockedBuffer(NULL), m_pLocked2D(NULL),
+        m_width(0), m_height(0), m_codedHeight(0), m_defaultStride(0), m_format(FRAME_BGRX32) {}
+    ~VideoReaderMF() { Close(); }
+
+    void Close() override {
+        UnlockFrame();
+        SafeRelease(&m_pCurSample);
+        SafeRelease(&m_pReader);
+    }
+
+    // 优先让解码器直接输出 NV12 / I420：颜色转换推迟到保存阶段，且只转换 ROI 内的像素。
+    // 解码器不支持时回退到由 Media Foundation 视频处理器转换的 RGB32。
+    HRESULT Open(const std::wstring& filepath) {
+        Close();
+        m_path = filepath;
+        HRESULT hr = CreateReader(filepath, FALSE);
+        if (SUCCEEDED(hr)) {
+            hr = SetOutputSubtype(MFVideoFormat_NV12);
+            if (FAILED(hr)) hr = SetOutputSubtype(MFVideoFormat_IYUV);
+        }
+        if (FAILED(hr)) {
+            SafeRelease(&m_pReader);
+            hr = CreateReader(filepath, TRUE);
+            if (SUCCEEDED(hr)) hr = SetOutputSubtype(MFVideoFormat_RGB32);
+        }
+        if (FAILED(hr)) return hr;
+
+        IMFMediaType* pCurType = NULL;
+        hr = m_pReader->GetCurrentMediaType(MF_SOURCE_READER_FIRST_VIDEO_STREAM, &pCurType);
+        if (FAILED(hr)) return hr;
+        GUID subtype = GUID_NULL;
+        pCurType->GetGUID(MF_MT_SUBTYPE, &subtype);
+        m_format = (subtype == MFVideoFormat_NV12) ? FRAME_NV12 : (subtype == MFVideoFormat_IYUV ? FRAME_I420 : FRAME_BGRX32);
+
+        // 编码尺寸可能按宏块对齐（例如 1080 -> 1088）：画面大小取显示区域，色度平面偏移按编码高度计算
+        UINT32 codedWidth = 0;
+        MFGetAttributeSize(pCurType, MF_MT_FRAME_SIZE, &codedWidth, &m_codedHeight);
+        GetVisibleSize(pCurType, m_width, m_height);
+        m_defaultStride = (INT32)codedWidth * (m_format == FRAME_BGRX32 ? 4 : 1);
+        UINT32 stride = 0;
+        if (SUCCEEDED(pCurType->GetUINT32(MF_MT_DEFAULT_STRIDE, &stride)) && stride != 0) {
+            m_defaultStride = (INT32)stride;
+        }
+        SafeRelease(&pCurType);
+        return hr;
+    }
+
+    HRESULT GetVideoInfo(UINT32& w, UINT32& h, UINT64& duration, double& fps) {
+        if (!m_pReader) return E_FAIL;
+        
+        // 初始化输出参数
+        w = 0;
+        h = 0;
+        duration = 0;
+        fps = 0.0;
+        
+        IMFMediaType* pType = NULL;
+        HRESULT hr = m_pReader->GetCurrentMediaType(MF_SOURCE_READER_FIRST_VIDEO_STREAM, &pType);
+        if (FAILED(hr)) return hr;
+        GetVisibleSize(pType, w, h);
+        UINT32 num = 0, den = 1;
+        if (SUCCEEDED(MFGetAttributeRatio(pType, MF_MT_FRAME_RATE, &num, &den)) && den != 0) {
+            fps = (double)num / (double)den;
+        }
+        SafeRelease(&pType);
+        PROPVARIANT var;
+        PropVariantInit(&var);
+        if (SUCCEEDED(m_pReader->GetPresentationAttribute(MF_SOURCE_READER_MEDIASOURCE, MF_PD_DURATION, &var))) {
+            if (var.vt == VT_UI8) duration = var.uhVal.QuadPart;
+            PropVariantClear(&var);
+        }
+        return S_OK;
+    }
+
+    bool Open(const std::string& path) override {
+        return SUCCEEDED(Open(Utf8ToWide(path)));
+    }
+
+    bool GetInfo(VideoProbeInfo* info) override {
+        *info = VideoProbeInfo();
+        UINT32 w = 0, h = 0;
+        UINT64 duration = 0;
+        double fps = 0.0;
+        if (FAILED(GetVideoInfo(w, h, duration, fps))) return false;
+        info->width = w;
+        info->height = h;
+        info->durationHns = duration;
+        info->fps = fps;
+        info->ok = w > 0 && h > 0;
+        return info->ok;
+    }
+
+    bool Rewind() override {
+        return SUCCEEDED(Seek(0.0));
+    }
+
+    HRESULT Seek(double seconds) {
+        return SeekHns((LONGLONG)(seconds * 10000000.0));
+    }
+
+    // 媒体源是否支持跳转（部分流式容器不支持）
+    bool CanSeek() const override {
+        if (!m_pReader) return false;
+        PROPVARIANT var;
+        PropVariantInit(&var);
+        ULONG characteristics = 0;
+        if (SUCCEEDED(m_pReader->GetPresentationAttribute(MF_SOURCE_READER_MEDIASOURCE,
+                MF_SOURCE_READER_MEDIASOURCE_CHARACTERISTICS, &var))) {
+            if (var.vt == VT_UI4) characteristics = var.ulVal;
+            PropVariantClear(&var);
+        }
+        return (characteristics & MFMEDIASOURCE_CAN_SEEK) != 0;
+    }
+
+    // SetCurrentPosition 落在目标之前最近的关键帧上，之后 ReadSample 从该关键帧开始输出
+    bool SeekTo(int64_t timestamp) override {
+        return SUCCEEDED(SeekHns(timestamp));
+    }
+
+    // 另开一个不解码的读取器：不设置输出类型时 ReadSample 按本地格式返回压缩样本，
+    // 样本按解码顺序到达，时间戳为显示时间戳，CleanPoint 为关键帧标记。
+    // Media Foundation 不提供样本在文件中的偏移，记为 0：按索引跳转时仍是 SeekTo(关键帧时间戳)，
+    // 索引省下的是测量 GOP 的顺序解码与对恒定帧率的要求，容器内的定位与不用索引时相同
+    bool ScanFrames(std::vector<FrameIndexEntry>* entries) override {
+        entries->clear();
+        if (m_path.empty()) return false;
+        IMFSourceReader* pScan = NULL;
+        HRESULT hr = MFCreateSourceReaderFromURL(m_path.c_str(), NULL, &pScan);
+        if (FAILED(hr)) return false;
+        pScan->SetStreamSelection(MF_SOURCE_READER_ALL_STREAMS, FALSE);
+        hr = pScan->SetStreamSelection(MF_SOURCE_READER_FIRST_VIDEO_STREAM, TRUE);
+        while (SUCCEEDED(hr)) {
+            DWORD flags = 0;
+            LONGLONG ts = 0;
+            IMFSample* pSample = NULL;
+            hr = pScan->ReadSample(MF_SOURCE_READER_FIRST_VIDEO_STREAM, 0, NULL, &flags, &ts, &pSample);
+            if (SUCCEEDED(hr) && pSample) {
+                FrameIndexEntry e;
+                e.timestamp = ts;
+                UINT32 cleanPoint = 0;
+                e.key = SUCCEEDED(pSample->GetUINT32(MFSampleExtension_CleanPoint, &cleanPoint)) && cleanPoint;
+                entries->push_back(e);
+            }
+            SafeRelease(&pSample);
+            if (flags & MF_SOURCE_READERF_ENDOFSTREAM) break;
+        }
+        SafeRelease(&pScan);
+        return SUCCEEDED(hr) && !entries->empty();
+    }
+
+    // 解码器把压缩样本的 CleanPoint 标记传递到输出样本上
+    bool IsKeyFrame() const override {
+        UINT32 cleanPoint = 0;
+        return m_pCurSample && SUCCEEDED(m_pCurSample->GetUINT32(MFSampleExtension_CleanPoint, &cleanPoint)) && cleanPoint;
+    }
+
+    // 顺序推进到下一帧，只持有样本，不做缓冲区转换与像素拷贝
+    bool Advance(int64_t* timestamp) override {
+        if (!m_pReader) return false;
+        UnlockFrame();
+        SafeRelease(&m_pCurSample);
+
+        DWORD flags = 0;
+        LONGLONG ts = 0;
+        HRESULT hr = m_pReader->ReadSample(
+            MF_SOURCE_READER_FIRST_VIDEO_STREAM, 
+            0, 
+            NULL, 
+            &flags, 
+            &ts, 
+            &m_pCurSample
+        );
+        
+        if (FAILED(hr) || m_pCurSample == NULL || (flags & MF_SOURCE_READERF_ENDOFSTREAM)) {
+            SafeRelease(&m_pCurSample);
+            return false;
+        }
+        
+        if (timestamp) *timestamp = ts;
+        return true;
+    }
+
+    // 锁定当前帧的像素（NV12 / I420 / RGB32，取决于 Open() 协商到的输出格式）
+    // 优先通过 IMF2DBuffer 直接锁定解码输出，避免 ConvertToContiguousBuffer 的整帧拷贝
+    bool LockFrame(FrameView* view) override {
+        if (!m_pCurSample || m_width == 0 || m_height == 0) return false;
+        UnlockFrame();
+
+        DWORD bufferCount = 0;
+        m_pCurSample->GetBufferCount(&bufferCount);
+        if (bufferCount == 1) {
+            IMFMediaBuffer* pBuffer = NULL;
+            if (SUCCEEDED(m_pCurSample->GetBufferByIndex(0, &pBuffer))) {
+                if (SUCCEEDED(pBuffer->QueryInterface(IID_PPV_ARGS(&m_pLocked2D)))) {
+                    BYTE* pScan0 = NULL;
+                    LONG pitch = 0;
+                    if (SUCCEEDED(m_pLocked2D->Lock2D(&pScan0, &pitch))) {
+                        SafeRelease(&pBuffer);
+                        FillFrameView(view, pScan0, (int)pitch, (int)m_height);
+                        return true;
+                    }
+                    SafeRelease(&m_pLocked2D);
+                }
+                SafeRelease(&pBuffer);
+            }
+        }
+
+        // 回退：多缓冲样本或不支持 2D 锁定时转换为连续缓冲
+        if (FAILED(m_pCurSample->ConvertToContiguousBuffer(&m_pLockedBuffer))) return false;
+        BYTE* pSrcData = NULL;
+        DWORD srcLen = 0;
+        if (FAILED(m_pLockedBuffer->Lock(&pSrcData, NULL, &srcLen))) {
+            SafeRelease(&m_pLockedBuffer);
+            return false;
+        }
+
+        int bytesPerRow = std::abs(m_defaultStride);
+        if (m_format != FRAME_BGRX32) {
+            // YUV 平面按编码高度连续排列，缓冲不完整时放弃这一帧
+            size_t lumaBytes = (size_t)bytesPerRow * m_codedHeight;
+            if (srcLen < lumaBytes + lumaBytes / 2) {
+                UnlockFrame();
+                return false;
+            }
+            FillFrameView(view, pSrcData, bytesPerRow, (int)m_height);
+            return true;
+        }
+        int rows = std::min((int)m_height, (int)(srcLen / bytesPerRow));
+        // 自下而上的缓冲：第一行位于缓冲区末尾
+        FillFrameView(view, (m_defaultStride < 0) ? pSrcData + (size_t)(rows - 1) * bytesPerRow : pSrcData, m_defaultStride, rows);
+        return true;
+    }
+
+    void UnlockFrame() override {
+        if (m_pLocked2D) {
+            m_pLocked2D->Unlock2D();
+            SafeRelease(&m_pLocked2D);
+        }
+        if (m_pLockedBuffer) {
+            m_pLockedBuffer->Unlock();
+            SafeRelease(&m_pLockedBuffer);
+        }
+    }
+
+private:
+    HRESULT SeekHns(LONGLONG position) {
+        if (!m_pReader) return E_FAIL;
+        UnlockFrame();
+        SafeRelease(&m_pCurSample);
+        PROPVARIANT var;
+        PropVariantInit(&var);
+        var.vt = VT_I8;
+        var.hVal.QuadPart = position;
+        HRESULT hr = m_pReader->SetCurrentPosition(GUID_NULL, var);
+        PropVariantClear(&var);
+        // 注意：不要调用 Flush()，这会导致解码状态异常
+        return hr;
+    }
+
+    HRESULT CreateReader(const std::wstring& filepath, BOOL videoProcessing) {
+        IMFAttributes* pAttributes = NULL;
+        HRESULT hr = MFCreateAttributes(&pAttributes, 1);
+        if (SUCCEEDED(hr)) {
+            hr = pAttributes->SetUINT32(MF_SOURCE_READER_ENABLE_VIDEO_PROCESSING, videoProcessing);
+        }
+        hr = MFCreateSourceReaderFromURL(filepath.c_str(), pAttributes, &m_pReader);
+        SafeRelease(&pAttributes);
+        if (FAILED(hr)) return hr;
+
+        hr = m_pReader->SetStreamSelection(MF_SOURCE_READER_ALL_STREAMS, FALSE);
+        hr = m_pReader->SetStreamSelection(MF_SOURCE_READER_FIRST_VIDEO_STREAM, TRUE);
+        return hr;
+    }
+
+    HRESULT SetOutputSubtype(const GUID& subtype) {
+        IMFMediaType* pType = NULL;
+        HRESULT hr = MFCreateMediaType(&pType);
+        if (SUCCEEDED(hr)) {
+            pType->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video);
+            pType->SetGUID(MF_MT_SUBTYPE, subtype);
+            hr = m_pReader->SetCurrentMediaType(MF_SOURCE_READER_FIRST_VIDEO_STREAM, NULL, pType);
+            SafeRelease(&pType);
+        }
+        return hr;
+    }
+
+    // 可见画面大小：有显示区域时取显示区域，否则取帧尺寸
+    static void GetVisibleSize(IMFMediaType* pType, UINT32& w, UINT32& h) {
+        MFGetAttributeSize(pType, MF_MT_FRAME_SIZE, &w, &h);
+        MFVideoArea area;
+        if (SUCCEEDED(pType->GetBlob(MF_MT_MINIMUM_DISPLAY_APERTURE, (UINT8*)&area, sizeof(area), NULL)) &&
+            area.Area.cx > 0 && area.Area.cy > 0 && (UINT32)area.Area.cx <= w && (UINT32)area.Area.cy <= h) {
+            w = (UINT32)area.Area.cx;
+            h = (UINT32)area.Area.cy;
+        }
+    }
+
+    // 按输出格式填写平面指针：色度平面紧跟在编码高度的亮度平面之后
+    void FillFrameView(FrameView* view, const BYTE* base, int pitch, int rows) {
+        *view = FrameView();
+        view->data = base;
+        view->width = (int)m_width;
+        view->height = rows;
+        view->stride = pitch;
+        view->format = m_format;
+        if (m_format == FRAME_NV12) {
+            view->plane1 = base + (size_t)pitch * m_codedHeight;
+            view->stride1 = pitch;
+        }
+        else if (m_format == FRAME_I420) {
+            view->plane1 = base + (size_t)pitch * m_codedHeight;
+            view->stride1 = pitch / 2;
+            view->plane2 = view->plane1 + (size_t)view->stride1 * ((m_codedHeight + 1) / 2);
+            view->stride2 = pitch / 2;
+        }
+    }
+
+    std::wstring m_path;            // 建立帧索引时另开读取器
+    IMFSample* m_pCurSample;        // 当前帧样本（尚未物化）
+    IMFMediaBuffer* m_pLockedBuffer;
+    IMF2DBuffer* m_pLocked2D;
+    UINT32 m_width;                 // 可见画面大小
+    UINT32 m_height;
+    UINT32 m_codedHeight;           // 解码缓冲的编码高度（用于定位色度平面）
+    INT32 m_defaultStride;          // 连续缓冲的行跨度，自下而上时为负
+    int m_format;                   // FramePixelFormat
+};
+
+class MfDecoderBackend : public IDecoderBackend {
+public:
+    const char* Name() const override { return "mf"; }
+
+    bool IsVideoFile(const std::string& path) const override {
+        static const char* const kExtensions[] = { ".mp4", ".avi", ".mov", ".mkv", ".wmv", ".flv", ".mpg" };
+        std::string ext = FileExtension(path);
+        for (size_t i = 0; i < sizeof(kExtensions) / sizeof(kExtensions[0]); ++i) {
+            if (ext == kExtensions[i]) return true;
+        }
+        return false;
+    }
+
+    std::unique_ptr<IVideoDecoder> CreateDecoder() override {
+        return std::unique_ptr<IVideoDecoder>(new VideoReaderMF());
+    }
+
+    void ThreadInit() override { CoInitializeEx(NULL, COINIT_APARTMENTTHREADED); }
+    void ThreadExit() override { CoUninitialize(); }
+};
@@ -0,0 +1,218 @@
+/*
+    多路输出描述：一次解码，每个保存的帧按各自的 ROI、缩放尺寸、格式与目录分别输出
+    文本格式：每个输出一行（或以 ';' 分隔），由空格分隔的 键=值 组成，'#' 之后为注释：
+        dir=thumbs size=224x224 filter=area format=jpg quality=85
+        dir=face roi=600,200,1000,600 format=png level=3
+        dir=train size=320x0 format=npy channels=gray
+        dir=luma size=640x0 format=jpg channels=gray
+    键：
+        dir       输出根目录下的一级子目录（列表中必填，各输出不能相同；省略时直接输出到根目录）
+        roi       x1,y1,x2,y2，超出画面的部分自动调整；省略时为整帧
+        size      WxH，其中一项为 0 时按 ROI 宽高比计算；省略时不缩放
+        filter    area（默认，缩小时按面积平均）或 bilinear
+        format    jpg、jpg-gdiplus、png、bmp、ppm、npy、raw
+        quality   JPEG 质量 1-100        level  PNG 压缩级别 0-9
+        channels  张量的通道顺序 rgb、bgr、gray；图像输出为 gray 时直接取 Y 平面输出单通道图像
+        pack      1 表示图像帧写入帧归档
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "frame_source.h"
+#include "image_encoder.h"
+#include "image_resize.h"
+#include "tensor_writer.h"
+
+struct OutputSpec {
+    std::string dir;            // 输出根目录下的子目录，空串表示直接输出到根目录
+    bool useRoi;                // false 表示整帧
+    RoiRect roi;
+    int width;                  // 缩放目标尺寸，均为 0 表示不缩放
+    int height;
+    int filter;                 // ResizeFilter
+    EncoderOptions encoder;     // 图像输出的格式与质量
+    bool gdiplus;               // 使用 GDI+ 编码（仅 JPEG，仅 Windows）
+    int tensor;                 // TensorFormat，非 TENSOR_NONE 时输出张量而不是图像
+    int channels;               // 张量的 ChannelOrder；CHANNELS_GRAY 时图像输出也为灰度
+    bool pack;                  // 图像帧写入帧归档
+
+    OutputSpec() : useRoi(false), width(0), height(0), filter(RESIZE_AREA), gdiplus(false),
+                   tensor(TENSOR_NONE), channels(CHANNELS_RGB), pack(false) {
+        roi.left = roi.top = roi.right = roi.bottom = 0;
+    }
+
+    // 按视频尺寸求实际的 ROI：调整到画面范围内，未启用或调整后为空时使用整帧
+    RoiRect FrameRoi(int frameWidth, int frameHeight) const {
+        RoiRect r = roi;
+        if (!useRoi || !ClampRoi(r, frameWidth, frameHeight)) {
+            r.left = 0;
+            r.top = 0;
+            r.right = frameWidth;
+            r.bottom = frameHeight;
+        }
+        return r;
+    }
+
+    // 转换、缩放与编码使用的像素格式：灰度输出（图像或张量）为 FRAME_GRAY8，每像素 1 字节
+    int PixelFormat() const { return channels == CHANNELS_GRAY ? FRAME_GRAY8 : FRAME_BGRX32; }
+
+    // 按 ROI 尺寸求输出尺寸：不缩放时与 ROI 相同，一项为 0 时保持宽高比
+    void OutputSize(const RoiRect& r, int* outWidth, int* outHeight) const {
+        int w = r.right - r.left, h = r.bottom - r.top;
+        *outWidth = w;
+        *outHeight = h;
+        if (width <= 0 && height <= 0) return;
+        *outWidth = width > 0 ? width : (int)(((int64_t)height * w + h / 2) / h);
+        *outHeight = height > 0 ? height : (int)(((int64_t)width * h + w / 2) / w);
+        if (*outWidth < 1) *outWidth = 1;
+        if (*outHeight < 1) *outHeight = 1;
+    }
+};
+
+// 解析一个输出的描述；失败时 error 为说明
+inline bool ParseOutputSpec(const std::string& line, OutputSpec* spec, std::string* error) {
+    *spec = OutputSpec();
+    size_t pos = 0;
+    while (pos < line.size()) {
+        while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) pos++;
+        if (pos >= line.size()) break;
+        size_t end = pos;
+        while (end < line.size() && line[end] != ' ' && line[end] != '\t') end++;
+        std::string token = line.substr(pos, end - pos);
+        pos = end;
+
+        size_t eq = token.find('=');
+        if (eq == std::string::npos || eq == 0) {
+            *error = "无法识别的项: " + token;
+            return false;
+        }
+        std::string key = token.substr(0, eq);
+        std::string value = token.substr(eq + 1);
+        const char* v = value.c_str();
+        if (key == "dir") {
+            if (value.empty() || value == "." || value.find("..") != std::string::npos || value.find_first_of("/\\:") != std::string::npos) {
+                *error = "dir 无效: " + value;
+                return false;
+            }
+            spec->dir = value;
+        }
+        else if (key == "roi") {
+            RoiRect& r = spec->roi;
+            if (sscanf(v, "%d,%d,%d,%d", &r.left, &r.top, &r.right, &r.bottom) != 4 || r.right <= r.left || r.bottom <= r.top) {
+                *error = "roi 应为 x1,y1,x2,y2: " + value;
+                return false;
+            }
+            spec->useRoi = true;
+        }
+        else if (key == "size") {
+            if (sscanf(v, "%dx%d", &spec->width, &spec->height) != 2 || spec->width < 0 || spec->height < 0 ||
+                (spec->width == 0 && spec->height == 0)) {
+                *error = "size 应为 WxH: " + value;
+                return false;
+            }
+        }
+        else if (key == "filter") {
+            if (value == "area") spec->filter = RESIZE_AREA;
+            else if (value == "bilinear") spec->filter = RESIZE_BILINEAR;
+            else {
+                *error = "filter 应为 area 或 bilinear: " + value;
+                return false;
+            }
+        }
+        else if (key == "format") {
+            spec->tensor = TENSOR_NONE;
+            spec->gdiplus = false;
+            if (value == "jpg" || value == "jpeg") spec->encoder.format = IMAGE_JPEG;
+            else if (value == "jpg-gdiplus") { spec->encoder.format = IMAGE_JPEG; spec->gdiplus = true; }
+            else if (value == "png") spec->encoder.format = IMAGE_PNG;
+            else if (value == "bmp") spec->encoder.format = IMAGE_BMP;
+            else if (value == "ppm") spec->encoder.format = IMAGE_PPM;
+            else if (value == "npy") { spec->encoder.format = IMAGE_FORMAT_COUNT; spec->tensor = TENSOR_NPY; }
+            else if (value == "raw") { spec->encoder.format = IMAGE_FORMAT_COUNT; spec->tensor = TENSOR_RAW; }
+            else {
+                *error = "不支持的 format: " + value;
+                return false;
+            }
+        }
+        else if (key == "quality") {
+            spec->encoder.quality = atoi(v);
+            if (spec->encoder.quality < 1 || spec->encoder.quality > 100) {
+                *error = "quality 应为 1-100: " + value;
+                return false;
+            }
+        }
+        else if (key == "level") {
+            spec->encoder.level = atoi(v);
+            if (spec->encoder.level < 0 || spec->encoder.level > 9) {
+                *error = "level 应为 0-9: " + value;
+                return false;
+            }
+        }
+        else if (key == "channels") {
+            if (value == "rgb") spec->channels = CHANNELS_RGB;
+            else if (value == "bgr") spec->channels = CHANNELS_BGR;
+            else if (value == "gray") spec->channels = CHANNELS_GRAY;
+            else {
+                *error = "channels 应为 rgb、bgr 或 gray: " + value;
+                return false;
+            }
+        }
+        else if (key == "pack") {
+            spec->pack = value == "1" || value == "true";
+        }
+        else {
+            *error = "未知的键: " + key;
+            return false;
+        }
+    }
+    if (spec->tensor != TENSOR_NONE) spec->pack = false;
+    // GDI+ 不能编码单通道 JPEG，灰度输出使用内置编码器
+    if (spec->channels == CHANNELS_GRAY) spec->gdiplus = false;
+    return true;
+}
+
+// 解析多个附加输出的描述（按行或 ';' 分隔，空行与注释忽略），追加到 outputs。
+// 附加输出必须指定 dir，不能占用主输出所在的根目录。失败时 error 为带序号的说明，outputs 不变。
+inline bool ParseOutputList(const std::string& text, std::vector<OutputSpec>* outputs, std::string* error) {
+    std::vector<OutputSpec> parsed;
+    size_t pos = 0;
+    while (pos <= text.size()) {
+        size_t end = text.find_first_of(";\r\n", pos);
+        if (end == std::string::npos) end = text.size();
+        std::string line = text.substr(pos, end - pos);
+        pos = end + 1;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.resize(hash);
+        if (line.find_first_not_of(" \t") == std::string::npos) continue;
+
+        OutputSpec spec;
+        std::string lineError;
+        bool ok = ParseOutputSpec(line, &spec, &lineError);
+        if (ok && spec.dir.empty()) {
+            lineError = "缺少 dir";
+            ok = false;
+        }
+        if (!ok) {
+            char prefix[32];
+            snprintf(prefix, sizeof(prefix), "输出 %zu: ", parsed.size() + 1);
+            *error = prefix + lineError;
+            return false;
+        }
+        for (size_t i = 0; i < outputs->size() + parsed.size(); ++i) {
+            const OutputSpec& other = i < outputs->size() ? (*outputs)[i] : parsed[i - outputs->size()];
+            if (other.dir == spec.dir) {
+                *error = "输出目录重复: " + spec.dir;
+                return false;
+            }
+        }
+        parsed.push_back(spec);
+    }
+    outputs->insert(outputs->end(), parsed.begin(), parsed.end());
+    return true;
+}
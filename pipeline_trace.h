@@ -0,0 +1,320 @@
+/*
+    流水线跟踪：记录解码、转换、缩放、编码、写入等阶段的耗时以及队列深度、缓冲占用，
+    结束后写出 Chrome / Perfetto 可以打开的跟踪文件（chrome://tracing 或 ui.perfetto.dev），并按阶段统计 p50 / p99。
+    每个工作线程注册一个自己的环形缓冲，记录时只有单个写者，不加锁；缓冲满时覆盖最旧的事件并计数。
+    未启用时各处只持有空指针，TraceScope 不读时钟，开销只有一次指针判断。
+    导出必须在所有记录线程结束之后进行。
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "file_util.h"
+#include "frame_source.h"
+
+// 记录耗时的阶段
+enum TraceStage {
+    TRACE_FILE = 0,     // 处理一个文件的全过程
+    TRACE_DECODE,       // 解码一帧（Advance）
+    TRACE_SEEK,         // 跳转到关键帧
+    TRACE_LOCK,         // 锁定解码缓冲
+    TRACE_DEDUP,        // 去重判断
+    TRACE_CONVERT,      // ROI 裁剪 + 颜色转换
+    TRACE_RESIZE,       // 缩放
+    TRACE_BUDGET_WAIT,  // 等待内存预算
+    TRACE_POOL_WAIT,    // 等待帧缓冲池
+    TRACE_QUEUE_WAIT,   // 等待编码队列有空位
+    TRACE_ENCODE,       // 图像编码
+    TRACE_WRITE,        // 写文件（写出线程）/ 追加归档 / 写张量
+    TRACE_STAGE_COUNT
+};
+
+// 采样的计数器
+enum TraceCounter {
+    TRACE_COUNTER_QUEUE = 0,    // 编码队列深度
+    TRACE_COUNTER_BUFFERS,      // 使用中的帧缓冲数
+    TRACE_COUNTER_WRITE_QUEUE,  // 写出队列中等待的文件数
+    TRACE_COUNTER_MEMORY,       // 内存预算的占用（字节）
+    TRACE_COUNTER_COUNT
+};
+
+static const char* const kTraceStageNames[TRACE_STAGE_COUNT] = {
+    "file", "decode", "seek", "lock", "dedup", "convert", "resize", "budget_wait", "pool_wait", "queue_wait", "encode", "write"
+};
+
+static const char* const kTraceCounterNames[TRACE_COUNTER_COUNT] = { "encode_queue", "frame_buffers", "write_queue", "memory_used" };
+
+static const size_t kTraceDefaultEvents = 1 << 16;     // 每个线程的环形缓冲容量（事件数）
+
+inline uint64_t TraceNow() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 一个事件：阶段耗时（start + duration）或计数器采样（start + value），时间为纳秒
+struct TraceEvent {
+    uint64_t start;
+    uint64_t duration;
+    int64_t value;
+    uint16_t id;        // TraceStage 或 TraceCounter
+    uint16_t counter;   // 1 表示计数器采样
+};
+
+// ==========================================
+// 一个线程的环形缓冲：只由注册它的线程写入
+// ==========================================
+class TraceBuffer {
+public:
+    TraceBuffer(const std::string& name, int tid, size_t capacity) : m_name(name), m_tid(tid), m_written(0) {
+        size_t n = 1;
+        while (n < capacity) n <<= 1;
+        m_events.resize(n);
+    }
+
+    void Span(int stage, uint64_t start, uint64_t end) {
+        TraceEvent e;
+        e.start = start;
+        e.duration = end - start;
+        e.value = 0;
+        e.id = (uint16_t)stage;
+        e.counter = 0;
+        Record(e);
+    }
+
+    void Counter(int counter, int64_t value) {
+        TraceEvent e;
+        e.start = TraceNow();
+        e.duration = 0;
+        e.value = value;
+        e.id = (uint16_t)counter;
+        e.counter = 1;
+        Record(e);
+    }
+
+    const std::string& Name() const { return m_name; }
+    int Tid() const { return m_tid; }
+
+    // 缓冲中保留的事件（按记录顺序）与被覆盖的事件数
+    void Snapshot(std::vector<TraceEvent>* events, uint64_t* dropped) const {
+        uint64_t written = m_written.load(std::memory_order_acquire);
+        uint64_t kept = std::min<uint64_t>(written, m_events.size());
+        *dropped = written - kept;
+        events->clear();
+        for (uint64_t i = written - kept; i < written; ++i) events->push_back(m_events[i & (m_events.size() - 1)]);
+    }
+
+private:
+    TraceBuffer(const TraceBuffer&) = delete;
+    TraceBuffer& operator=(const TraceBuffer&) = delete;
+
+    void Record(const TraceEvent& e) {
+        uint64_t n = m_written.load(std::memory_order_relaxed);
+        m_events[n & (m_events.size() - 1)] = e;
+        m_written.store(n + 1, std::memory_order_release);
+    }
+
+    std::string m_name;
+    int m_tid;
+    std::vector<TraceEvent> m_events;
+    std::atomic<uint64_t> m_written;
+};
+
+// 作用域计时：buffer 为空时什么也不做
+class TraceScope {
+public:
+    TraceScope(TraceBuffer* buffer, int stage) : m_buffer(buffer), m_stage(stage), m_start(buffer ? TraceNow() : 0) {}
+    ~TraceScope() {
+        if (m_buffer) m_buffer->Span(m_stage, m_start, TraceNow());
+    }
+
+private:
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    TraceBuffer* m_buffer;
+    int m_stage;
+    uint64_t m_start;
+};
+
+// 一个阶段的统计（微秒）
+struct TraceStageSummary {
+    int stage;
+    uint64_t count;
+    double totalUs;
+    double p50Us;
+    double p99Us;
+    double maxUs;
+};
+
+// ==========================================
+// 一次提取的跟踪：线程注册时加锁，记录不加锁
+// ==========================================
+class PipelineTracer {
+public:
+    explicit PipelineTracer(size_t eventsPerThread = kTraceDefaultEvents) : m_capacity(eventsPerThread), m_origin(TraceNow()) {}
+
+    // 为当前线程注册一个缓冲，role 与 index 组成线程名（例如 "decoder 0"）
+    TraceBuffer* RegisterThread(const char* role, size_t index) {
+        char name[64];
+        snprintf(name, sizeof(name), "%s %zu", role, index);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_buffers.push_back(std::unique_ptr<TraceBuffer>(new TraceBuffer(name, (int)m_buffers.size() + 1, m_capacity)));
+        return m_buffers.back().get();
+    }
+
+    // 被覆盖的事件总数（缓冲容量不足时不为 0，统计只基于保留下来的事件）
+    uint64_t Dropped() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        uint64_t total = 0;
+        std::vector<TraceEvent> events;
+        for (size_t i = 0; i < m_buffers.size(); ++i) {
+            uint64_t dropped = 0;
+            m_buffers[i]->Snapshot(&events, &dropped);
+            total += dropped;
+        }
+        return total;
+    }
+
+    // Chrome 跟踪事件格式（JSON 对象格式），时间单位为微秒
+    bool WriteChromeTrace(const std::string& path) const {
+        FILE* fp = OpenFileUtf8(path, "wb");
+        if (!fp) return false;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        fputs("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n", fp);
+        fputs("{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, \"args\": {\"name\": \"drag2frames\"}}", fp);
+        std::vector<TraceEvent> events;
+        for (size_t b = 0; b < m_buffers.size(); ++b) {
+            const TraceBuffer& buffer = *m_buffers[b];
+            fprintf(fp, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+                buffer.Tid(), buffer.Name().c_str());
+            uint64_t dropped = 0;
+            buffer.Snapshot(&events, &dropped);
+            for (size_t i = 0; i < events.size(); ++i) {
+                const TraceEvent& e = events[i];
+                double ts = e.start >= m_origin ? (e.start - m_origin) / 1000.0 : 0.0;
+                if (e.counter) {
+                    fprintf(fp, ",\n{\"name\": \"%s\", \"ph\": \"C\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"args\": {\"value\": %lld}}",
+                        kTraceCounterNames[e.id], buffer.Tid(), ts, (long long)e.value);
+                } else {
+                    fprintf(fp, ",\n{\"name\": \"%s\", \"cat\": \"stage\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                        kTraceStageNames[e.id], buffer.Tid(), ts, e.duration / 1000.0);
+                }
+            }
+        }
+        fputs("\n]}\n", fp);
+        return fclose(fp) == 0;
+    }
+
+    // 按阶段汇总所有线程的耗时，没有事件的阶段不列出
+    std::vector<TraceStageSummary> Summarize() const {
+        std::vector<std::vector<uint64_t>> durations(TRACE_STAGE_COUNT);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::vector<TraceEvent> events;
+            for (size_t b = 0; b < m_buffers.size(); ++b) {
+                uint64_t dropped = 0;
+                m_buffers[b]->Snapshot(&events, &dropped);
+                for (size_t i = 0; i < events.size(); ++i) {
+                    if (!events[i].counter && events[i].id < TRACE_STAGE_COUNT) durations[events[i].id].push_back(events[i].duration);
+                }
+            }
+        }
+        std::vector<TraceStageSummary> result;
+        for (int s = 0; s < TRACE_STAGE_COUNT; s++) {
+            std::vector<uint64_t>& d = durations[s];
+            if (d.empty()) continue;
+            std::sort(d.begin(), d.end());
+            TraceStageSummary summary;
+            summary.stage = s;
+            summary.count = d.size();
+            summary.totalUs = 0.0;
+            for (size_t i = 0; i < d.size(); ++i) summary.totalUs += d[i] / 1000.0;
+            summary.p50Us = Percentile(d, 0.50) / 1000.0;
+            summary.p99Us = Percentile(d, 0.99) / 1000.0;
+            summary.maxUs = d.back() / 1000.0;
+            result.push_back(summary);
+        }
+        return result;
+    }
+
+    // 统计表：阶段、次数、总耗时、p50、p99、最大值
+    std::string FormatSummary() const {
+        std::vector<TraceStageSummary> rows = Summarize();
+        std::string text;
+        char line[160];
+        snprintf(line, sizeof(line), "%-12s %10s %12s %10s %10s %10s\n", "stage", "count", "total_ms", "p50_us", "p99_us", "max_us");
+        text += line;
+        for (size_t i = 0; i < rows.size(); ++i) {
+            const TraceStageSummary& r = rows[i];
+            snprintf(line, sizeof(line), "%-12s %10llu %12.1f %10.1f %10.1f %10.1f\n", kTraceStageNames[r.stage],
+                (unsigned long long)r.count, r.totalUs / 1000.0, r.p50Us, r.p99Us, r.maxUs);
+            text += line;
+        }
+        uint64_t dropped = Dropped();
+        if (dropped > 0) {
+            snprintf(line, sizeof(line), "(%llu events overwritten, ring buffer too small)\n", (unsigned long long)dropped);
+            text += line;
+        }
+        return text;
+    }
+
+private:
+    PipelineTracer(const PipelineTracer&) = delete;
+    PipelineTracer& operator=(const PipelineTracer&) = delete;
+
+    // 最近秩法：不小于 q 比例的最小样本
+    static uint64_t Percentile(const std::vector<uint64_t>& sorted, double q) {
+        size_t rank = (size_t)(q * sorted.size() + 0.999999);
+        if (rank < 1) rank = 1;
+        if (rank > sorted.size()) rank = sorted.size();
+        return sorted[rank - 1];
+    }
+
+    size_t m_capacity;
+    uint64_t m_origin;
+    mutable std::mutex m_mutex;
+    std::vector<std::unique_ptr<TraceBuffer>> m_buffers;
+};
+
+// ==========================================
+// 帧源包装：为解码、跳转与锁定计时，其余调用原样转发
+// ==========================================
+class TracedFrameSource : public IFrameSource {
+public:
+    TracedFrameSource(IFrameSource& source, TraceBuffer* buffer) : m_source(source), m_buffer(buffer) {}
+
+    bool Advance(int64_t* timestamp) override {
+        TraceScope scope(m_buffer, TRACE_DECODE);
+        return m_source.Advance(timestamp);
+    }
+
+    bool LockFrame(FrameView* view) override {
+        TraceScope scope(m_buffer, TRACE_LOCK);
+        return m_source.LockFrame(view);
+    }
+
+    void UnlockFrame() override { m_source.UnlockFrame(); }
+    bool IsKeyFrame() const override { return m_source.IsKeyFrame(); }
+    bool CanSeek() const override { return m_source.CanSeek(); }
+
+    bool SeekTo(int64_t timestamp) override {
+        TraceScope scope(m_buffer, TRACE_SEEK);
+        return m_source.SeekTo(timestamp);
+    }
+
+private:
+    TracedFrameSource(const TracedFrameSource&) = delete;
+    TracedFrameSource& operator=(const TracedFrameSource&) = delete;
+
+    IFrameSource& m_source;
+    TraceBuffer* m_buffer;
+};
@@ -0,0 +1,139 @@
+/*
+    PNG 编码器：24 位 RGB 或 8 位灰度，压缩级别 0-9
+    级别 0 不过滤、不压缩；1-3 使用 Sub 过滤；4 以上逐行在五种过滤器中选择绝对值和最小的一种。
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "image_encoder.h"
+#include "deflate.h"
+
+class PngEncoder : public IImageEncoder {
+public:
+    explicit PngEncoder(int level = 6) { SetLevel(level); }
+
+    void SetLevel(int level) { m_level = level < 0 ? 0 : (level > 9 ? 9 : level); }
+    int Level() const { return m_level; }
+
+    const char* Extension() const override { return "png"; }
+
+    bool Encode(const FrameView& view, std::vector<uint8_t>& out) override {
+        bool gray = view.format == FRAME_GRAY8;
+        if ((view.format != FRAME_BGRX32 && !gray) || view.width <= 0 || view.height <= 0) return false;
+        size_t rowBytes = (size_t)view.width * (gray ? 1 : 3);
+        m_filtered.resize((rowBytes + 1) * view.height);
+        // 第一行的“上一行”全为 0
+        m_rows[0].resize(rowBytes);
+        m_rows[1].assign(rowBytes, 0);
+        const uint8_t* prev = m_rows[1].data();
+        for (int y = 0; y < view.height; y++) {
+            const uint8_t* src = view.data + (ptrdiff_t)y * view.stride;
+            uint8_t* dst = &m_filtered[(rowBytes + 1) * y];
+            // 灰度行直接过滤，不复制
+            if (gray) {
+                FilterRow<1>(src, prev, rowBytes, dst);
+                prev = src;
+                continue;
+            }
+            uint8_t* cur = m_rows[y & 1].data();
+            for (int x = 0; x < view.width; x++) {
+                cur[x * 3 + 0] = src[x * 4 + 2];
+                cur[x * 3 + 1] = src[x * 4 + 1];
+                cur[x * 3 + 2] = src[x * 4 + 0];
+            }
+            FilterRow<3>(cur, prev, rowBytes, dst);
+            prev = cur;
+        }
+
+        out.clear();
+        static const uint8_t kSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        out.insert(out.end(), kSignature, kSignature + 8);
+
+        std::vector<uint8_t> ihdr;
+        PutU32BE(ihdr, (uint32_t)view.width);
+        PutU32BE(ihdr, (uint32_t)view.height);
+        ihdr.push_back(8);      // 位深
+        ihdr.push_back(gray ? 0 : 2);      // 灰度 / 真彩色
+        ihdr.push_back(0);
+        ihdr.push_back(0);
+        ihdr.push_back(0);
+        PutChunk(out, "IHDR", ihdr.data(), ihdr.size());
+
+        m_compressed.clear();
+        m_deflate.Compress(m_filtered.data(), m_filtered.size(), m_level, m_compressed);
+        PutChunk(out, "IDAT", m_compressed.data(), m_compressed.size());
+        PutChunk(out, "IEND", NULL, 0);
+        return true;
+    }
+
+private:
+    static int Paeth(int a, int b, int c) {
+        int p = a + b - c;
+        int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+        if (pa <= pb && pa <= pc) return a;
+        return pb <= pc ? b : c;
+    }
+
+    // 用过滤器 Type 过滤一行（每像素 Bpp 字节），dst[0] 为过滤器类型，返回有符号残差的绝对值和。
+    // 过滤器类型作为模板参数，内层循环中没有分支。
+    template <int Type, int Bpp>
+    static uint64_t ApplyFilter(const uint8_t* cur, const uint8_t* prev, size_t n, uint8_t* dst) {
+        dst[0] = (uint8_t)Type;
+        uint8_t* d = dst + 1;
+        uint64_t sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            int a = i >= Bpp ? cur[i - Bpp] : 0;
+            int b = prev[i];
+            int c = i >= Bpp ? prev[i - Bpp] : 0;
+            int pred = Type == 1 ? a : (Type == 2 ? b : (Type == 3 ? (a + b) >> 1 : (Type == 4 ? Paeth(a, b, c) : 0)));
+            uint8_t v = (uint8_t)(cur[i] - pred);
+            d[i] = v;
+            sum += v < 128 ? v : 256 - v;
+        }
+        return sum;
+    }
+
+    template <int Bpp>
+    void FilterRow(const uint8_t* cur, const uint8_t* prev, size_t n, uint8_t* dst) {
+        if (m_level == 0) {
+            dst[0] = 0;
+            memcpy(dst + 1, cur, n);
+            return;
+        }
+        if (m_level <= 3) {
+            ApplyFilter<1, Bpp>(cur, prev, n, dst);
+            return;
+        }
+        m_trial.resize(n + 1);
+        uint64_t best = ApplyFilter<0, Bpp>(cur, prev, n, dst);
+        uint64_t (*const filters[4])(const uint8_t*, const uint8_t*, size_t, uint8_t*) = {
+            ApplyFilter<1, Bpp>, ApplyFilter<2, Bpp>, ApplyFilter<3, Bpp>, ApplyFilter<4, Bpp>
+        };
+        for (int f = 0; f < 4; f++) {
+            uint64_t sum = filters[f](cur, prev, n, m_trial.data());
+            if (sum < best) {
+                best = sum;
+                memcpy(dst, m_trial.data(), n + 1);
+            }
+        }
+    }
+
+    static void PutChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t size) {
+        PutU32BE(out, (uint32_t)size);
+        size_t typeOffset = out.size();
+        out.insert(out.end(), type, type + 4);
+        if (size) out.insert(out.end(), data, data + size);
+        PutU32BE(out, Crc32Update(0, &out[typeOffset], size + 4));
+    }
+
+    int m_level;
+    DeflateEncoder m_deflate;
+    std::vector<uint8_t> m_rows[2];     // 当前行与上一行（RGB；灰度时直接使用源行，只用到全 0 的 m_rows[1]）
+    std::vector<uint8_t> m_filtered;
+    std::vector<uint8_t> m_trial;
+    std::vector<uint8_t> m_compressed;
+};
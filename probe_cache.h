@@ -0,0 +1,147 @@
+/*
+    视频元数据探测缓存
+    以（路径, 文件大小, 修改时间）为键，把分辨率、时长、帧率保存到磁盘，
+    重复拖入同一批文件时无需重新打开视频；只有变化过的文件才会重新探测。
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+
+#include "file_util.h"
+#include "video_decoder.h"
+#include "work_queue.h"
+
+class ProbeCache {
+public:
+    ProbeCache() : m_dirty(false) {}
+
+    // 从磁盘加载，文件不存在时视为空缓存
+    // 格式：每行 size<TAB>mtime<TAB>width<TAB>height<TAB>durationHns<TAB>fps<TAB>path
+    bool Load(const std::string& cacheFile) {
+        FILE* fp = OpenFileUtf8(cacheFile, "rb");
+        if (!fp) return false;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        char line[4096];
+        while (fgets(line, sizeof(line), fp)) {
+            if (line[0] == '#') continue;
+            Entry e;
+            unsigned long long size = 0, dur = 0;
+            long long mtime = 0;
+            unsigned w = 0, h = 0;
+            double fps = 0.0;
+            int consumed = 0;
+            if (sscanf(line, "%llu\t%lld\t%u\t%u\t%llu\t%lf\t%n", &size, &mtime, &w, &h, &dur, &fps, &consumed) < 6 || consumed == 0) continue;
+            std::string path(line + consumed);
+            while (!path.empty() && (path.back() == '\n' || path.back() == '\r')) path.pop_back();
+            if (path.empty()) continue;
+            e.size = size;
+            e.mtime = mtime;
+            e.info.width = w;
+            e.info.height = h;
+            e.info.durationHns = dur;
+            e.info.fps = fps;
+            e.info.ok = true;
+            m_entries[path] = e;
+        }
+        fclose(fp);
+        m_dirty = false;
+        return true;
+    }
+
+    // 先写临时文件再替换，避免写入中途崩溃留下损坏的缓存
+    bool Save(const std::string& cacheFile) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::string tmp = cacheFile + ".tmp";
+        FILE* fp = OpenFileUtf8(tmp, "wb");
+        if (!fp) return false;
+        fprintf(fp, "# drag2frames probe cache v1\n");
+        for (const auto& kv : m_entries) {
+            const Entry& e = kv.second;
+            fprintf(fp, "%llu\t%lld\t%u\t%u\t%llu\t%.6f\t%s\n", (unsigned long long)e.size, (long long)e.mtime,
+                e.info.width, e.info.height, (unsigned long long)e.info.durationHns, e.info.fps, kv.first.c_str());
+        }
+        bool ok = (fclose(fp) == 0) && ReplaceFileUtf8(tmp, cacheFile);
+        if (ok) m_dirty = false;
+        return ok;
+    }
+
+    // 命中条件：路径存在，且大小与修改时间都未变化
+    bool Lookup(const std::string& path, uint64_t size, int64_t mtime, VideoProbeInfo* info) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(path);
+        if (it == m_entries.end() || it->second.size != size || it->second.mtime != mtime) return false;
+        *info = it->second.info;
+        return true;
+    }
+
+    // 只缓存成功的探测结果，失败的文件下次仍会重试
+    void Store(const std::string& path, uint64_t size, int64_t mtime, const VideoProbeInfo& info) {
+        if (!info.ok) return;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Entry& e = m_entries[path];
+        e.size = size;
+        e.mtime = mtime;
+        e.info = info;
+        m_dirty = true;
+    }
+
+    bool Dirty() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_dirty;
+    }
+
+private:
+    struct Entry {
+        uint64_t size;
+        int64_t mtime;
+        VideoProbeInfo info;
+        Entry() : size(0), mtime(0) {}
+    };
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, Entry> m_entries;
+    bool m_dirty;
+};
+
+// 在线程池上并行探测一批文件，先查缓存，未命中或文件已变化时才调用 probeFn(index, info)。
+// threadInit / threadExit 在每个探测线程开始与结束时调用（例如 COM 初始化）。
+// 返回缓存命中的文件数。
+template <class ProbeFn, class ThreadInit, class ThreadExit>
+size_t ProbeFilesParallel(const std::vector<std::string>& paths, ProbeCache* cache, size_t threadCount,
+                          std::vector<VideoProbeInfo>& results, const std::atomic<bool>& cancel,
+                          ProbeFn probeFn, ThreadInit threadInit, ThreadExit threadExit) {
+    results.assign(paths.size(), VideoProbeInfo());
+    if (paths.empty()) return 0;
+    if (threadCount > paths.size()) threadCount = paths.size();
+
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> hits(0);
+    WorkerPool workers;
+    workers.Start(threadCount, [&](size_t) {
+        threadInit();
+        for (;;) {
+            size_t i = next++;
+            if (i >= paths.size() || cancel) break;
+            uint64_t size = 0;
+            int64_t mtime = 0;
+            bool stamped = GetFileStamp(paths[i], &size, &mtime);
+            if (stamped && cache && cache->Lookup(paths[i], size, mtime, &results[i])) {
+                hits++;
+                continue;
+            }
+            probeFn(i, results[i]);
+            if (stamped && cache) cache->Store(paths[i], size, mtime, results[i]);
+        }
+        threadExit();
+    });
+    workers.Join();
+    return hits;
+}
@@ -0,0 +1,436 @@
+/*
+    采样引擎：按帧数间隔、按秒或按目标帧率选帧。
+    采样间隔很大时，跳转到目标帧之前最近的关键帧再向前解码，而不是解码整个视频。
+    先按顺序解码一小段，测得 GOP 长度并确认时间戳是恒定帧率，再决定是否切换到跳转模式。
+    跳转模式用时间戳推算帧序号，保存的帧及其序号与顺序解码完全相同。
+    续传时先跳转到检查点之前的关键帧，数到检查点那一帧确定帧序号，之后的结果同样与顺序解码相同。
+    长视频可以按关键帧切成几段，由几个帧源各自跳转到段首并行解码，帧序号同样由时间戳推算。
+    有帧索引（frame_index.h）时不需要测量：要保存的帧与它们之前的关键帧都直接查索引，可变帧率的视频也能跳转。
+    选帧器不会再保存任何帧时（帧列表用完，见 frame_list.h）不再解码后面的帧。
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "frame_index.h"
+#include "frame_source.h"
+
+// 采样方式
+enum SamplingMode {
+    SAMPLE_FRAMES = 0,  // 每隔 interval 帧保存一帧
+    SAMPLE_SECONDS,     // 每 value 秒保存一帧
+    SAMPLE_FPS,         // 按 value 帧每秒重新采样
+    SAMPLE_LIST         // 只保存每个视频的帧列表中的帧（frame_list.h）
+};
+
+struct SamplingOptions {
+    int mode;
+    int interval;       // SAMPLE_FRAMES 的跳帧数
+    double value;       // SAMPLE_SECONDS 的秒数或 SAMPLE_FPS 的帧率
+
+    SamplingOptions() : mode(SAMPLE_FRAMES), interval(0), value(1.0) {}
+
+    // 按时间采样的周期（100 纳秒单位）
+    int64_t PeriodHns() const {
+        if (value <= 0.0) return 0;
+        return (int64_t)(mode == SAMPLE_FPS ? 10000000.0 / value : value * 10000000.0);
+    }
+
+    // 由时长与帧率估计会保存的帧数（略偏多），用于预分配输出；时长或帧率未知时返回 fallback
+    size_t EstimateCount(uint64_t durationHns, double fps, size_t fallback) const {
+        if (durationHns == 0 || fps <= 0.0) return fallback;
+        double frames = durationHns * fps / 10000000.0;
+        double count = frames / (interval + 1);
+        if (mode != SAMPLE_FRAMES && PeriodHns() > 0) count = std::min(frames, (double)durationHns / PeriodHns());
+        return (size_t)(count * 1.01) + 8;
+    }
+};
+
+// 跳转一次的固定开销（清空解码器、重新读取容器索引），折算为解码帧数
+static const int kSeekOverheadFrames = 4;
+
+// 跳转后落点晚于目标时，依次向前多退的 GOP 倍数，全部失败后从头开始
+static const int kSeekRetryCount = 3;
+
+// 分段前顺序解码的帧数，用来确认时间戳是恒定帧率
+static const int kSegmentProbeFrames = 3;
+
+// 采样间隔超过这么多秒时不分段：跳转模式只解码目标附近的帧，已经比分段顺序解码快
+static const double kSegmentMaxSpacingSeconds = 2.0;
+
+// 平均每隔这么多帧才保存一帧时，按帧索引跳转才可能省下解码
+static const double kIndexMinSpacingFrames = 2.0 * kSeekOverheadFrames;
+
+struct SamplingStats {
+    int decodedFrames;  // Advance() 次数
+    int seeks;          // SeekTo() 次数
+    int gopFrames;      // 测得的 GOP 长度，0 表示未知
+    bool sparse;        // 是否切换到了跳转模式
+
+    bool resumed;       // 是否从续传检查点开始（跳过了检查点之前的帧）
+    bool indexed;       // 是否按帧索引跳转
+
+    SamplingStats() : decodedFrames(0), seeks(0), gopFrames(0), sparse(false), resumed(false), indexed(false) {}
+};
+
+// 续传检查点：序号不大于 frame 的帧已经输出过，不再交给 onKeep；timestamp 为这一帧的时间戳
+struct SamplingResume {
+    int frame;
+    int64_t timestamp;
+
+    SamplingResume() : frame(0), timestamp(0) {}
+};
+
+// 由时间戳推算帧序号（从 1 开始），firstTimestamp 为第一帧的时间戳
+inline int FrameIndexFromTimestamp(int64_t timestamp, int64_t firstTimestamp, double frameDuration) {
+    return (int)std::floor((double)(timestamp - firstTimestamp) / frameDuration + 0.5) + 1;
+}
+
+// 第 1 帧保存，之后每隔 interval 帧保存一帧（第 1、interval+2、2*interval+3... 帧）
+inline bool IsSampledFrame(int frameIndex, int interval) {
+    return (frameIndex - 1) % (interval + 1) == 0;
+}
+
+// 大于 frameIndex 的下一个需要保存的帧
+inline int NextSampledFrame(int frameIndex, int interval) {
+    int step = interval + 1;
+    return ((frameIndex - 1) / step + 1) * step + 1;
+}
+
+// ==========================================
+// 选帧器：Keep() 按解码顺序对每一帧调用一次，决定是否保存；
+// NextTarget() 估计下一个可能保存的帧序号，只能偏早不能偏晚，跳转模式据此决定跳转位置；
+// Spacing() 为相邻两次保存之间的平均帧数，用于判断跳转是否划算；
+// Finished() 为 true 时之后的帧都不会保存，采样循环提前结束。
+// ==========================================
+
+// 按帧数间隔选帧
+class FrameIntervalSelector {
+public:
+    explicit FrameIntervalSelector(int interval) : m_interval(interval < 0 ? 0 : interval) {}
+
+    bool Keep(int frameIndex, int64_t elapsed) {
+        (void)elapsed;
+        return IsSampledFrame(frameIndex, m_interval);
+    }
+
+    int NextTarget(int frameIndex, double frameDuration) const {
+        (void)frameDuration;
+        return NextSampledFrame(frameIndex, m_interval);
+    }
+
+    double Spacing(double frameDuration) const {
+        (void)frameDuration;
+        return m_interval + 1.0;
+    }
+
+    bool Finished() const { return false; }
+
+private:
+    int m_interval;
+};
+
+// 按时间间隔选帧：保存时间戳首次达到 k * period 的帧（k = 0, 1, 2...），时间从第一帧起算。
+// 只看时间戳，可变帧率的视频也能得到均匀的间隔；源帧率低于目标帧率时一帧只保存一次。
+class TimeIntervalSelector {
+public:
+    explicit TimeIntervalSelector(int64_t period) : m_period(period < 1 ? 1 : period), m_next(0) {}
+
+    bool Keep(int frameIndex, int64_t elapsed) {
+        (void)frameIndex;
+        if (elapsed < m_next) return false;
+        m_next = (elapsed / m_period + 1) * m_period;
+        return true;
+    }
+
+    int NextTarget(int frameIndex, double frameDuration) const {
+        // 提前半帧，抵消时间戳取整的误差
+        int target = (int)((m_next - frameDuration / 2) / frameDuration) + 1;
+        return target > frameIndex ? target : frameIndex + 1;
+    }
+
+    double Spacing(double frameDuration) const { return m_period / frameDuration; }
+
+    bool Finished() const { return false; }
+
+private:
+    int64_t m_period;
+    int64_t m_next;     // 下一个采样时刻（相对第一帧）
+};
+
+// 距离超过一个 GOP 时，目标之前的关键帧一定在当前位置之后，跳转才不会走回头路
+inline bool ShouldSeek(int distance, int gopFrames) {
+    return distance > gopFrames + kSeekOverheadFrames;
+}
+
+// 采样循环：onKeep(frameIndex, timestamp, view) 在像素锁定期间调用，frameIndex 从 1 开始；
+// 不保存的帧只推进帧源，不锁定像素。
+// frameDuration 为一帧的时长（100 纳秒单位），未知时传 0，由前两帧的时间戳测量。
+// 帧源不支持跳转、时间戳不是恒定帧率或 GOP 太长时，全程按顺序解码，结果与逐帧调用 selector 相同。
+// resume 非空时不输出检查点及之前的帧；跳转找不到检查点那一帧时回到开头顺序解码。
+// 返回最后一帧的序号。
+template <class Selector, class KeepFn>
+int RunAdaptiveSampling(IFrameSource& source, Selector& selector, double frameDuration,
+                        const std::atomic<bool>& stop, KeepFn onKeep, SamplingStats* stats = NULL,
+                        const SamplingResume* resume = NULL) {
+    SamplingStats local;
+    SamplingStats& st = stats ? *stats : local;
+    int resumeFrame = resume ? resume->frame : 0;
+    bool resumeTried = resumeFrame <= 1 || !source.CanSeek();
+
+    int frameIndex = 0;
+    int64_t timestamp = 0;
+    int64_t firstTimestamp = 0;
+    bool keyFlags = false;      // 帧源是否标记关键帧（第一帧一定是关键帧）
+    int lastKey = 0;
+    double spacing = 0.0;
+    bool decided = !source.CanSeek();
+
+    // 第一阶段：顺序解码，同时测量 GOP
+    while (!stop) {
+        if (!source.Advance(&timestamp)) return frameIndex;
+        frameIndex++;
+        st.decodedFrames++;
+        if (frameIndex == 1) {
+            firstTimestamp = timestamp;
+            keyFlags = source.IsKeyFrame();
+            lastKey = 1;
+        }
+        if (frameIndex == 1 && !resumeTried) {
+            // 续传：跳转到检查点之前的关键帧，向前解码到检查点那一帧，由解码的帧数倒推落点的帧序号。
+            // 检查点之前的帧只交给 selector 更新状态：按时间选帧时，从任意一帧开始都会收敛到与顺序解码相同的状态
+            resumeTried = true;
+            selector.Keep(frameIndex, 0);
+            std::vector<int64_t> elapsed;
+            bool found = false;
+            bool landedKey = false;
+            if (source.SeekTo(resume->timestamp)) {
+                st.seeks++;
+                int64_t ts = 0;
+                while (!stop && source.Advance(&ts)) {
+                    st.decodedFrames++;
+                    if (elapsed.empty()) landedKey = source.IsKeyFrame();
+                    elapsed.push_back(ts - firstTimestamp);
+                    if (ts >= resume->timestamp) {
+                        found = ts == resume->timestamp;
+                        timestamp = ts;
+                        break;
+                    }
+                }
+            }
+            if (stop) return frameIndex;
+            if (found && (int)elapsed.size() <= resumeFrame) {
+                int landed = resumeFrame - (int)elapsed.size() + 1;
+                for (size_t i = 0; i < elapsed.size(); ++i) selector.Keep(landed + (int)i, elapsed[i]);
+                frameIndex = resumeFrame;
+                if (frameDuration <= 0) frameDuration = (double)(resume->timestamp - firstTimestamp) / (resumeFrame - 1);
+                if (keyFlags && landedKey) lastKey = landed;
+                st.resumed = true;
+                continue;
+            }
+            // 落点晚于检查点或时间戳对不上：回到开头，第一帧会再解码一次
+            if (!source.SeekTo(firstTimestamp)) return frameIndex;
+            st.seeks++;
+            frameIndex = 0;
+            continue;
+        }
+        if (frameIndex > 1 && !decided) {
+            if (frameIndex == 2 && frameDuration <= 0) frameDuration = (double)(timestamp - firstTimestamp);
+            if (frameDuration > 0) spacing = selector.Spacing(frameDuration);
+            if (frameDuration <= 0 || FrameIndexFromTimestamp(timestamp, firstTimestamp, frameDuration) != frameIndex) {
+                // 时间戳与帧计数对不上（可变帧率或丢帧），无法由时间戳推算帧序号
+                decided = true;
+            } else if (spacing <= kSeekOverheadFrames) {
+                decided = true;
+            } else if (keyFlags && source.IsKeyFrame()) {
+                st.gopFrames = frameIndex - lastKey;
+                lastKey = frameIndex;
+                decided = true;
+                st.sparse = spacing > st.gopFrames + kSeekOverheadFrames;
+            } else if (keyFlags && frameIndex - lastKey > 2 * spacing) {
+                // GOP 比两个采样间隔还长，跳转不划算
+                decided = true;
+            } else if (!keyFlags && frameIndex > spacing) {
+                // 没有关键帧信息：先试着跳转，由跳转落点估计 GOP
+                decided = true;
+                st.sparse = true;
+            }
+        }
+
+        if (selector.Keep(frameIndex, timestamp - firstTimestamp) && frameIndex > resumeFrame) {
+            FrameView view;
+            if (source.LockFrame(&view)) {
+                onKeep(frameIndex, timestamp, view);
+                source.UnlockFrame();
+            }
+        }
+        if (selector.Finished()) return frameIndex;
+        if (st.sparse) break;
+    }
+
+    // 第二阶段：按目标帧跳转，距离较近时继续顺序解码。
+    // 已处理过的帧不再交给 selector，跳转落点早于预期时也不会重复保存。
+    int target = selector.NextTarget(frameIndex, frameDuration);
+    while (!stop) {
+        if (ShouldSeek(target - frameIndex, st.gopFrames)) {
+            int64_t targetTime = firstTimestamp + (int64_t)((target - 1) * frameDuration - frameDuration / 2);
+            int backoff = 0;
+            for (;;) {
+                int64_t seekTime = backoff <= kSeekRetryCount
+                    ? targetTime - (int64_t)(backoff * (st.gopFrames + 1) * frameDuration) : firstTimestamp;
+                if (seekTime < firstTimestamp) seekTime = firstTimestamp;
+                if (!source.SeekTo(seekTime)) return frameIndex;
+                st.seeks++;
+                if (!source.Advance(&timestamp)) return frameIndex;
+                st.decodedFrames++;
+                frameIndex = FrameIndexFromTimestamp(timestamp, firstTimestamp, frameDuration);
+                if (frameIndex <= target || seekTime == firstTimestamp) break;
+                backoff++;
+            }
+            // 落点到目标的距离就是实际要多解码的帧数，用来修正 GOP 估计
+            if (target - frameIndex > st.gopFrames) st.gopFrames = target - frameIndex;
+        } else {
+            if (!source.Advance(&timestamp)) break;
+            st.decodedFrames++;
+            frameIndex = FrameIndexFromTimestamp(timestamp, firstTimestamp, frameDuration);
+        }
+
+        if (frameIndex < target) continue;
+        if (selector.Keep(frameIndex, timestamp - firstTimestamp) && frameIndex > resumeFrame) {
+            FrameView view;
+            if (source.LockFrame(&view)) {
+                onKeep(frameIndex, timestamp, view);
+                source.UnlockFrame();
+            }
+        }
+        if (selector.Finished()) break;
+        target = selector.NextTarget(frameIndex, frameDuration);
+    }
+    return frameIndex;
+}
+
+// 把视频切成 count 段，分界是跳转到各等分点时落到的关键帧；bounds 得到每段起点的时间戳，第 0 段从第一帧开始。
+// 先顺序解码开头几帧确认时间戳是恒定帧率，各段才能由时间戳推算帧序号；分界的时间戳也必须落在帧的格点上。
+// 关键帧稀疏时几个等分点会落到同一个关键帧，段数随之减少。
+// 帧源不支持跳转、帧率未知或不恒定、只剩一段时返回 false。返回后帧源的位置不确定。
+inline bool PlanSegments(IFrameSource& source, double frameDuration, uint64_t durationHns, int count,
+                         int64_t* firstTimestamp, std::vector<int64_t>* bounds) {
+    bounds->clear();
+    if (count < 2 || frameDuration <= 0 || durationHns == 0 || !source.CanSeek()) return false;
+    int64_t timestamp = 0;
+    for (int i = 0; i < kSegmentProbeFrames; ++i) {
+        if (!source.Advance(&timestamp)) return false;
+        if (i == 0) *firstTimestamp = timestamp;
+        else if (FrameIndexFromTimestamp(timestamp, *firstTimestamp, frameDuration) != i + 1) return false;
+    }
+    bounds->push_back(*firstTimestamp);
+    for (int k = 1; k < count; ++k) {
+        int64_t nominal = *firstTimestamp + (int64_t)(durationHns / count * k);
+        if (!source.SeekTo(nominal) || !source.Advance(&timestamp)) return false;
+        double position = (timestamp - *firstTimestamp) / frameDuration;
+        if (std::fabs(position - std::floor(position + 0.5)) > 0.25) return false;
+        if (timestamp > bounds->back()) bounds->push_back(timestamp);
+    }
+    return bounds->size() > 1;
+}
+
+// 解码一段：只输出时间戳在 [begin, end) 内的帧，帧序号由时间戳推算，与顺序解码的结果相同。
+// begin 为第一帧的时间戳时（第 0 段）从帧源当前位置读起，调用方负责回到开头；
+// 其他段跳转到 begin 之前的关键帧，begin 之前的帧只交给 selector 更新状态（与续传相同，会收敛到顺序解码的状态）。
+// 落点不早于 begin 时每次多退一秒再跳，全部失败后从头开始。onKeep 的约定与 RunAdaptiveSampling 相同。
+template <class Selector, class KeepFn>
+void RunSegmentSampling(IFrameSource& source, Selector& selector, int64_t firstTimestamp, double frameDuration,
+                        int64_t begin, int64_t end, const std::atomic<bool>& stop, KeepFn onKeep,
+                        SamplingStats* stats = NULL) {
+    SamplingStats local;
+    SamplingStats& st = stats ? *stats : local;
+    int64_t timestamp = 0;
+    bool landed = false;        // 跳转落点已经解码，还没有处理
+    if (begin > firstTimestamp) {
+        for (int backoff = 0; ; ++backoff) {
+            int64_t seekTime = backoff <= kSeekRetryCount ? begin - 1 - backoff * (int64_t)10000000 : firstTimestamp;
+            if (seekTime < firstTimestamp) seekTime = firstTimestamp;
+            if (!source.SeekTo(seekTime)) return;
+            st.seeks++;
+            if (!source.Advance(&timestamp)) return;
+            st.decodedFrames++;
+            if (timestamp < begin || seekTime == firstTimestamp) break;
+        }
+        landed = true;
+    }
+    while (!stop) {
+        if (!landed) {
+            if (!source.Advance(&timestamp)) break;
+            st.decodedFrames++;
+        }
+        landed = false;
+        if (timestamp >= end) break;
+        int frameIndex = FrameIndexFromTimestamp(timestamp, firstTimestamp, frameDuration);
+        if (selector.Keep(frameIndex, timestamp - firstTimestamp) && timestamp >= begin) {
+            FrameView view;
+            if (source.LockFrame(&view)) {
+                onKeep(frameIndex, timestamp, view);
+                source.UnlockFrame();
+            }
+        }
+        if (selector.Finished()) break;
+    }
+}
+
+// 按帧索引采样：先用索引中每一帧的时间戳模拟 selector，得到全部要保存的帧；
+// 对每个目标，它之前最近的关键帧比当前位置远出跳转开销时跳到那个关键帧，否则顺序解码过去。
+// 帧序号由解码得到的时间戳查索引，不要求恒定帧率；续传时直接从检查点之后的第一个目标开始。
+// 帧源须位于视频开头。解码到索引中没有的时间戳（索引与视频不符）时停止并返回 false，
+// reached 为此前最后交给 onKeep 的帧（没有时为 resume 或 0），调用方可以从它续传。
+template <class Selector, class KeepFn>
+bool RunIndexedSampling(IFrameSource& source, const FrameIndex& index, Selector& selector,
+                        const std::atomic<bool>& stop, KeepFn onKeep, SamplingStats* stats = NULL,
+                        const SamplingResume* resume = NULL, SamplingResume* reached = NULL) {
+    SamplingStats local;
+    SamplingStats& st = stats ? *stats : local;
+    SamplingResume last = resume ? *resume : SamplingResume();
+    if (reached) *reached = last;
+    if (index.Empty()) return false;
+    st.indexed = true;
+    st.resumed = last.frame > 0;
+
+    std::vector<int> targets;
+    int64_t firstTimestamp = index.Frame(1).timestamp;
+    for (int f = 1; f <= index.Count() && !selector.Finished(); ++f) {
+        if (selector.Keep(f, index.Frame(f).timestamp - firstTimestamp) && f > last.frame) targets.push_back(f);
+    }
+
+    int position = 0;       // 最后解码的帧，下一次 Advance() 得到它之后的帧
+    int64_t timestamp = 0;
+    for (size_t i = 0; i < targets.size() && !stop; ++i) {
+        int target = targets[i];
+        int key = index.KeyFrameAtOrBefore(target);
+        if (key - position - 1 > kSeekOverheadFrames) {
+            if (!source.SeekTo(index.Frame(key).timestamp)) return false;
+            st.seeks++;
+            position = key - 1;
+        }
+        while (position < target && !stop) {
+            if (!source.Advance(&timestamp)) return true;
+            st.decodedFrames++;
+            position = index.FrameAt(timestamp);
+            if (position == 0) return false;
+        }
+        if (stop) break;
+        if (position != target) return false;
+        FrameView view;
+        if (source.LockFrame(&view)) {
+            onKeep(target, timestamp, view);
+            source.UnlockFrame();
+        }
+        last.frame = target;
+        last.timestamp = timestamp;
+        if (reached) *reached = last;
+    }
+    return true;
+}
@@ -0,0 +1,17 @@
+/*
+    SIMD 编译配置：x86 平台检测与指令集头文件
+    SSE2 是 x64 的基线，可以无条件使用；AVX2 函数需加 D2F_TARGET_AVX2 并在运行时检测 CPU。
+*/
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define D2F_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define D2F_TARGET_AVX2
+#else
+#define D2F_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
@@ -0,0 +1,267 @@
+/*
+    合成视频解码后端：按名称注册的虚拟视频，确定性地生成 I420 / NV12 帧，不需要视频文件与解码硬件。
+    用于基准测试与回归测试：画面为移动的渐变与方块纹理加少量噪声，编码器的工作量与真实画面接近。
+    每种尺寸只生成 kSyntheticDistinctFrames 个不同的帧并循环使用，由所有解码器实例共享；
+    LockFrame() 直接返回共享缓冲的视图，"解码"本身几乎没有开销，测得的是引擎其余部分的速度。
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "video_decoder.h"
+
+static const int kSyntheticDistinctFrames = 8;
+
+// 一个虚拟视频
+struct SyntheticClip {
+    std::string name;       // 打开时使用的路径
+    int width;
+    int height;
+    int frames;
+    double fps;
+    int gop;                // 关键帧间隔（帧），跳转只能落在关键帧上
+    int format;             // FRAME_I420 或 FRAME_NV12
+
+    SyntheticClip() : width(0), height(0), frames(0), fps(30.0), gop(30), format(FRAME_I420) {}
+};
+
+// 一帧 YUV 数据的字节数（4:2:0，宽高为奇数时色度向上取整）
+inline size_t SyntheticFrameBytes(int width, int height) {
+    return (size_t)width * height + 2 * (size_t)((width + 1) / 2) * ((height + 1) / 2);
+}
+
+// 生成第 index 帧：亮度为随帧移动的斜向渐变 + 16x16 方块 + 0-3 的噪声，色度为缓慢变化的渐变
+inline void GenerateSyntheticFrame(int width, int height, int index, int format, uint8_t* out) {
+    int chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+    for (int y = 0; y < height; y++) {
+        uint8_t* row = out + (size_t)y * width;
+        for (int x = 0; x < width; x++) {
+            uint32_t h = (uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u ^ (uint32_t)index * 83492791u;
+            h ^= h >> 13;
+            h *= 0x5bd1e995;
+            h ^= h >> 15;
+            int v = 16 + ((x + y * 2 + index * 6) % 180) + ((((x + index * 4) >> 4) ^ (y >> 4)) & 1) * 24 + (int)(h & 3);
+            row[x] = (uint8_t)v;
+        }
+    }
+    uint8_t* u = out + (size_t)width * height;
+    uint8_t* v = u + (size_t)chromaWidth * chromaHeight;
+    for (int y = 0; y < chromaHeight; y++) {
+        for (int x = 0; x < chromaWidth; x++) {
+            uint8_t cu = (uint8_t)(96 + (x + index) % 64);
+            uint8_t cv = (uint8_t)(96 + (y + index / 2) % 64);
+            if (format == FRAME_NV12) {
+                // NV12：U、V 交错存放在同一个平面，每行 chromaWidth * 2 字节
+                uint8_t* uv = u + (size_t)y * chromaWidth * 2 + x * 2;
+                uv[0] = cu;
+                uv[1] = cv;
+            } else {
+                u[(size_t)y * chromaWidth + x] = cu;
+                v[(size_t)y * chromaWidth + x] = cv;
+            }
+        }
+    }
+}
+
+// ==========================================
+// 已注册的虚拟视频；同尺寸同格式的视频共用一份帧数据，首次打开时生成。线程安全。
+// ==========================================
+class SyntheticClipLibrary {
+public:
+    typedef std::shared_ptr<const std::vector<uint8_t>> FrameData;
+
+    SyntheticClipLibrary() {}
+
+    void AddClip(const SyntheticClip& clip) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_clips.push_back(clip);
+    }
+
+    bool HasClip(const std::string& name) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return FindClip(name) != NULL;
+    }
+
+    // 按名称取得虚拟视频及其帧数据（kSyntheticDistinctFrames 帧依次存放）
+    bool Find(const std::string& name, SyntheticClip* clip, FrameData* data) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const SyntheticClip* found = FindClip(name);
+        if (!found) return false;
+        *clip = *found;
+        for (size_t i = 0; i < m_cache.size(); ++i) {
+            const CacheEntry& e = m_cache[i];
+            if (e.width == clip->width && e.height == clip->height && e.format == clip->format) {
+                *data = e.data;
+                return true;
+            }
+        }
+        size_t frameBytes = SyntheticFrameBytes(clip->width, clip->height);
+        std::shared_ptr<std::vector<uint8_t>> frames = std::make_shared<std::vector<uint8_t>>(frameBytes * kSyntheticDistinctFrames);
+        for (int i = 0; i < kSyntheticDistinctFrames; i++) {
+            GenerateSyntheticFrame(clip->width, clip->height, i, clip->format, frames->data() + (size_t)i * frameBytes);
+        }
+        CacheEntry entry;
+        entry.width = clip->width;
+        entry.height = clip->height;
+        entry.format = clip->format;
+        entry.data = frames;
+        m_cache.push_back(entry);
+        *data = frames;
+        return true;
+    }
+
+private:
+    SyntheticClipLibrary(const SyntheticClipLibrary&) = delete;
+    SyntheticClipLibrary& operator=(const SyntheticClipLibrary&) = delete;
+
+    struct CacheEntry {
+        int width;
+        int height;
+        int format;
+        FrameData data;
+    };
+
+    const SyntheticClip* FindClip(const std::string& name) const {
+        for (size_t i = 0; i < m_clips.size(); ++i) {
+            if (m_clips[i].name == name) return &m_clips[i];
+        }
+        return NULL;
+    }
+
+    mutable std::mutex m_mutex;
+    std::vector<SyntheticClip> m_clips;
+    std::vector<CacheEntry> m_cache;
+};
+
+// ==========================================
+// 一个打开的虚拟视频，LockFrame() 返回共享帧数据的视图
+// ==========================================
+class SyntheticDecoder : public IVideoDecoder {
+public:
+    explicit SyntheticDecoder(SyntheticClipLibrary& library) : m_library(library), m_next(0), m_current(-1) {}
+
+    bool Open(const std::string& path) override {
+        Close();
+        if (!m_library.Find(path, &m_clip, &m_data) || m_clip.frames <= 0 || m_clip.gop <= 0) {
+            m_data.reset();
+            return false;
+        }
+        return true;
+    }
+
+    void Close() override {
+        m_data.reset();
+        m_next = 0;
+        m_current = -1;
+    }
+
+    bool GetInfo(VideoProbeInfo* info) override {
+        if (!m_data) return false;
+        *info = VideoProbeInfo();
+        info->width = (uint32_t)m_clip.width;
+        info->height = (uint32_t)m_clip.height;
+        info->fps = m_clip.fps;
+        info->durationHns = (uint64_t)Timestamp(m_clip.frames);
+        info->ok = true;
+        return true;
+    }
+
+    bool Rewind() override {
+        m_next = 0;
+        m_current = -1;
+        return m_data != nullptr;
+    }
+
+    bool Advance(int64_t* timestamp) override {
+        if (!m_data || m_next >= m_clip.frames) return false;
+        m_current = m_next++;
+        if (timestamp) *timestamp = Timestamp(m_current);
+        return true;
+    }
+
+    bool LockFrame(FrameView* view) override {
+        if (m_current < 0) return false;
+        int w = m_clip.width, h = m_clip.height;
+        int chromaWidth = (w + 1) / 2, chromaHeight = (h + 1) / 2;
+        const uint8_t* y = m_data->data() + (size_t)(m_current % kSyntheticDistinctFrames) * SyntheticFrameBytes(w, h);
+        *view = FrameView();
+        view->data = y;
+        view->width = w;
+        view->height = h;
+        view->stride = w;
+        view->format = m_clip.format;
+        view->plane1 = y + (size_t)w * h;
+        if (m_clip.format == FRAME_NV12) {
+            view->stride1 = chromaWidth * 2;
+        } else {
+            view->stride1 = chromaWidth;
+            view->plane2 = view->plane1 + (size_t)chromaWidth * chromaHeight;
+            view->stride2 = chromaWidth;
+        }
+        return true;
+    }
+
+    void UnlockFrame() override {}
+
+    bool IsKeyFrame() const override { return m_current >= 0 && m_current % m_clip.gop == 0; }
+    bool CanSeek() const override { return true; }
+
+    // 偏移按每帧 YUV 数据的大小连续排列计算
+    bool ScanFrames(std::vector<FrameIndexEntry>* entries) override {
+        if (!m_data) return false;
+        entries->resize((size_t)m_clip.frames);
+        for (int i = 0; i < m_clip.frames; ++i) {
+            (*entries)[i].timestamp = Timestamp(i);
+            (*entries)[i].offset = (uint64_t)i * SyntheticFrameBytes(m_clip.width, m_clip.height);
+            (*entries)[i].key = i % m_clip.gop == 0;
+        }
+        return true;
+    }
+
+    // 落在时间戳不晚于 timestamp 的最后一个关键帧
+    bool SeekTo(int64_t timestamp) override {
+        if (!m_data) return false;
+        int frame = 0;
+        while (frame + 1 < m_clip.frames && Timestamp(frame + 1) <= timestamp) frame++;
+        m_next = frame - frame % m_clip.gop;
+        m_current = -1;
+        return true;
+    }
+
+private:
+    SyntheticDecoder(const SyntheticDecoder&) = delete;
+    SyntheticDecoder& operator=(const SyntheticDecoder&) = delete;
+
+    int64_t Timestamp(int frame) const {
+        return (int64_t)(frame * 10000000.0 / m_clip.fps + 0.5);
+    }
+
+    SyntheticClipLibrary& m_library;
+    SyntheticClip m_clip;
+    SyntheticClipLibrary::FrameData m_data;
+    int m_next;
+    int m_current;
+};
+
+// 先用 AddClip() 注册虚拟视频，再以名称作为路径打开
+class SyntheticDecoderBackend : public IDecoderBackend {
+public:
+    const char* Name() const override { return "synthetic"; }
+
+    void AddClip(const SyntheticClip& clip) { m_library.AddClip(clip); }
+
+    bool IsVideoFile(const std::string& path) const override { return m_library.HasClip(path); }
+
+    std::unique_ptr<IVideoDecoder> CreateDecoder() override {
+        return std::unique_ptr<IVideoDecoder>(new SyntheticDecoder(m_library));
+    }
+
+private:
+    SyntheticClipLibrary m_library;
+};
@@ -0,0 +1,252 @@
+/*
+    张量输出：把每个视频保存的 ROI 帧直接写入一个 N×H×W×C 的 uint8 数组文件，
+    供训练程序以 np.load(path, mmap_mode='r') 零拷贝读取，省去 JPEG 编码再解码的往返与画质损失。
+    - NPY：标准 .npy（1.0 版），文件头固定为 128 字节，数据区 64 字节对齐
+    - RAW：只有像素数据，形状与通道顺序写在同名 .json 中
+    另有 <名称>.index.npy（N×2，int64）：每一帧的帧序号与时间戳（100 纳秒）。
+    文件按估计的帧数预分配并内存映射写入，不够时扩大，结束时截断到实际帧数并改写文件头。
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "color_convert.h"
+#include "file_util.h"
+#include "frame_source.h"
+
+enum TensorFormat {
+    TENSOR_NONE = 0,    // 不输出张量，按图像格式编码
+    TENSOR_NPY,
+    TENSOR_RAW
+};
+
+enum ChannelOrder {
+    CHANNELS_RGB = 0,
+    CHANNELS_BGR,
+    CHANNELS_GRAY       // BT.601 亮度，C = 1
+};
+
+static const size_t kNpyHeaderSize = 128;
+
+inline int ChannelCount(int order) { return order == CHANNELS_GRAY ? 1 : 3; }
+
+inline const char* ChannelOrderName(int order) {
+    return order == CHANNELS_GRAY ? "GRAY" : (order == CHANNELS_BGR ? "BGR" : "RGB");
+}
+
+inline const char* TensorExtension(int format) { return format == TENSOR_RAW ? "raw" : "npy"; }
+
+// 生成固定长度的 .npy 1.0 文件头：魔数、版本、头长度与描述字典，空格补齐，以换行结尾
+inline std::string NpyHeader(const char* descr, const std::vector<uint64_t>& shape) {
+    std::string dict = "{'descr': '";
+    dict += descr;
+    dict += "', 'fortran_order': False, 'shape': (";
+    for (size_t i = 0; i < shape.size(); ++i) {
+        char num[32];
+        snprintf(num, sizeof(num), "%llu, ", (unsigned long long)shape[i]);
+        dict += num;
+    }
+    if (shape.size() > 1) dict.resize(dict.size() - 1);     // 多维时去掉末尾的空格；一维必须保留逗号
+    dict += "), }";
+    size_t dictSize = kNpyHeaderSize - 10;
+    if (dict.size() + 1 > dictSize) return std::string();
+    dict.resize(dictSize - 1, ' ');
+    dict += '\n';
+    std::string header("\x93NUMPY\x01\x00", 8);
+    header += (char)(dictSize & 0xFF);
+    header += (char)(dictSize >> 8);
+    return header + dict;
+}
+
+// 把一行 BGRX 像素打包为 RGB / BGR / 灰度
+inline void PackBgrxRow(const uint8_t* src, uint8_t* dst, int width, int order) {
+    if (order == CHANNELS_GRAY) {
+        BgrxRowToGray(src, width, dst);
+    } else if (order == CHANNELS_BGR) {
+        for (int x = 0; x < width; x++, src += 4, dst += 3) {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+        }
+    } else {
+        for (int x = 0; x < width; x++, src += 4, dst += 3) {
+            dst[0] = src[2];
+            dst[1] = src[1];
+            dst[2] = src[0];
+        }
+    }
+}
+
+// ==========================================
+// 每个视频一个实例。解码线程按保存顺序调用 Reserve() 取得槽位，
+// 编码线程并发调用 Write() 把像素写入各自的槽位；扩大映射时独占锁，写入时共享锁。
+// 分段并行解码时槽位不按帧序号分配，Finish() 按帧序号重新排列。
+// ==========================================
+class TensorWriter {
+public:
+    TensorWriter() : m_format(TENSOR_NPY), m_width(0), m_height(0), m_order(CHANNELS_RGB), m_frameBytes(0),
+                     m_dataOffset(0), m_capacity(0), m_failed(false), m_open(false) {}
+    ~TensorWriter() { Finish(); }
+
+    // capacity 为预估的帧数，按此预分配；path 为数组文件路径（UTF-8）
+    bool Open(const std::string& path, int format, int width, int height, int order, size_t capacity) {
+        m_path = path;
+        m_format = format;
+        m_width = width;
+        m_height = height;
+        m_order = order;
+        m_frameBytes = (size_t)width * height * ChannelCount(order);
+        m_dataOffset = format == TENSOR_NPY ? kNpyHeaderSize : 0;
+        m_capacity = capacity < 1 ? 1 : capacity;
+        if (m_frameBytes == 0 || !m_file.Create(path, m_dataOffset + m_capacity * m_frameBytes)) return false;
+        m_open = true;
+        return true;
+    }
+
+    // 为下一帧分配槽位，容量不足时把映射扩大一倍
+    size_t Reserve(int frameIndex, int64_t timestamp) {
+        std::unique_lock<std::shared_timed_mutex> lock(m_mapMutex);
+        size_t slot = m_frames.size() / 2;
+        if (slot >= m_capacity && !m_failed) {
+            size_t capacity = m_capacity * 2;
+            if (m_file.Resize(m_dataOffset + capacity * m_frameBytes)) {
+                m_capacity = capacity;
+            } else {
+                m_failed = true;
+            }
+        }
+        m_frames.push_back(frameIndex);
+        m_frames.push_back(timestamp);
+        return slot;
+    }
+
+    // 把 BGRX 视图按通道顺序写入槽位；灰度张量也可以直接给 GRAY8 视图，逐行复制
+    bool Write(size_t slot, const FrameView& view) {
+        bool gray = view.format == FRAME_GRAY8;
+        if ((view.format != FRAME_BGRX32 && !(gray && m_order == CHANNELS_GRAY)) || view.width != m_width || view.height != m_height) return false;
+        std::shared_lock<std::shared_timed_mutex> lock(m_mapMutex);
+        if (m_failed || slot >= m_capacity) return false;
+        size_t rowBytes = (size_t)m_width * ChannelCount(m_order);
+        uint8_t* dst = m_file.Data() + m_dataOffset + slot * m_frameBytes;
+        for (int y = 0; y < m_height; y++) {
+            const uint8_t* src = view.data + (ptrdiff_t)y * view.stride;
+            if (gray) memcpy(dst + (size_t)y * rowBytes, src, rowBytes);
+            else PackBgrxRow(src, dst + (size_t)y * rowBytes, m_width, m_order);
+        }
+        return true;
+    }
+
+    // 截断到实际帧数，改写文件头并写出帧序号索引与说明文件
+    bool Finish() {
+        std::unique_lock<std::shared_timed_mutex> lock(m_mapMutex);
+        if (!m_open) return !m_failed;
+        m_open = false;
+        uint64_t count = m_failed ? 0 : m_frames.size() / 2;
+        if (count > 1 && m_file.Data()) SortByFrameIndex((size_t)count);
+        if (m_format == TENSOR_NPY && m_file.Data()) {
+            std::string header = NpyHeader("|u1", Shape(count));
+            memcpy(m_file.Data(), header.data(), header.size());
+        }
+        bool ok = m_file.Close(m_dataOffset + count * m_frameBytes) && !m_failed;
+
+        std::string base = m_path.substr(0, m_path.size() - strlen(TensorExtension(m_format)) - 1);
+        std::vector<uint64_t> indexShape;
+        indexShape.push_back(count);
+        indexShape.push_back(2);
+        std::string indexHeader = NpyHeader("<i8", indexShape);
+        FILE* fp = OpenFileUtf8(base + ".index.npy", "wb");
+        if (fp) {
+            // int64 按小端写入，与 '<i8' 一致
+            std::vector<uint8_t> bytes(indexHeader.begin(), indexHeader.end());
+            for (size_t i = 0; i < count * 2; ++i) {
+                uint64_t v = (uint64_t)m_frames[i];
+                for (int b = 0; b < 8; b++) bytes.push_back((uint8_t)(v >> (b * 8)));
+            }
+            ok = fwrite(bytes.data(), 1, bytes.size(), fp) == bytes.size() && ok;
+            ok = (fclose(fp) == 0) && ok;
+        } else {
+            ok = false;
+        }
+
+        if (m_format == TENSOR_RAW) {
+            fp = OpenFileUtf8(base + ".json", "wb");
+            if (fp) {
+                fprintf(fp, "{\"dtype\": \"uint8\", \"shape\": [%llu, %d, %d, %d], \"channels\": \"%s\", \"index\": \"%s\"}\n",
+                    (unsigned long long)count, m_height, m_width, ChannelCount(m_order), ChannelOrderName(m_order),
+                    (base.substr(base.find_last_of("/\\") + 1) + ".index.npy").c_str());
+                ok = (fclose(fp) == 0) && ok;
+            } else {
+                ok = false;
+            }
+        }
+        return ok;
+    }
+
+private:
+    TensorWriter(const TensorWriter&) = delete;
+    TensorWriter& operator=(const TensorWriter&) = delete;
+
+    // 灰度输出为 N×H×W×1，与彩色输出保持相同的维数
+    std::vector<uint64_t> Shape(uint64_t count) const {
+        std::vector<uint64_t> shape;
+        shape.push_back(count);
+        shape.push_back((uint64_t)m_height);
+        shape.push_back((uint64_t)m_width);
+        shape.push_back((uint64_t)ChannelCount(m_order));
+        return shape;
+    }
+
+    // 按帧序号重排槽位与索引：沿置换的环逐帧移动，只需一帧的临时缓冲；已经有序时什么也不做
+    void SortByFrameIndex(size_t count) {
+        std::vector<size_t> order(count);     // 第 i 个位置应放原来第 order[i] 个槽位的帧
+        for (size_t i = 0; i < count; ++i) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return m_frames[a * 2] < m_frames[b * 2]; });
+        size_t first = 0;
+        while (first < count && order[first] == first) first++;
+        if (first == count) return;
+
+        uint8_t* data = m_file.Data() + m_dataOffset;
+        std::vector<uint8_t> temp(m_frameBytes);
+        std::vector<bool> placed(count, false);
+        for (size_t i = first; i < count; ++i) {
+            if (placed[i] || order[i] == i) continue;
+            memcpy(temp.data(), data + i * m_frameBytes, m_frameBytes);
+            size_t j = i;
+            while (order[j] != i) {
+                memcpy(data + j * m_frameBytes, data + order[j] * m_frameBytes, m_frameBytes);
+                placed[j] = true;
+                j = order[j];
+            }
+            memcpy(data + j * m_frameBytes, temp.data(), m_frameBytes);
+            placed[j] = true;
+        }
+        std::vector<int64_t> frames(count * 2);
+        for (size_t i = 0; i < count; ++i) {
+            frames[i * 2] = m_frames[order[i] * 2];
+            frames[i * 2 + 1] = m_frames[order[i] * 2 + 1];
+        }
+        m_frames.swap(frames);
+    }
+
+    std::shared_timed_mutex m_mapMutex;
+    WritableMappedFile m_file;
+    std::string m_path;
+    int m_format;
+    int m_width;
+    int m_height;
+    int m_order;
+    size_t m_frameBytes;
+    size_t m_dataOffset;
+    size_t m_capacity;
+    bool m_failed;
+    bool m_open;
+    std::vector<int64_t> m_frames;      // 每帧两项：帧序号、时间戳
+};
@@ -0,0 +1,158 @@
+/*
+    颜色转换内核的逐位一致性测试：SSE2 / AVX2 与标量版本在奇数宽高、各种行尾长度、奇数 ROI 偏移下输出完全相同，
+    且与逐像素的参考实现一致，不写出目标范围之外的字节。CPU 不支持 AVX2 时跳过 AVX2。
+        g++ -std=c++14 -O2 -I. tests/color_convert_test.cpp -o color_convert_test -pthread
+*/
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "color_convert.h"
+#include "test_util.h"
+
+static const uint8_t kGuard = 0xA5;
+
+// 随机数据中混入大量 0 与 255，覆盖饱和的分支
+static void FillRandom(std::vector<uint8_t>& data) {
+    for (size_t i = 0; i < data.size(); ++i) {
+        int r = rand();
+        data[i] = (r & 7) == 0 ? 0 : ((r & 7) == 1 ? 255 : (uint8_t)(r >> 3));
+    }
+}
+
+static const ColorKernelLevel kLevels[] = { COLOR_KERNEL_SCALAR, COLOR_KERNEL_SSE2, COLOR_KERNEL_AVX2 };
+
+// 行内核：宽度 1-80 以及几个较大的奇数宽度，所有内核与标量版本一致，width * 4 之后的字节不被改写
+static void TestRowKernels() {
+    std::vector<int> widths;
+    for (int w = 1; w <= 80; w++) widths.push_back(w);
+    widths.push_back(127);
+    widths.push_back(333);
+    widths.push_back(1921);
+    for (size_t i = 0; i < widths.size(); ++i) {
+        int w = widths[i];
+        int chroma = (w + 1) / 2;
+        for (int uvStep = 1; uvStep <= 2; uvStep++) {
+            std::vector<uint8_t> y((size_t)w), u((size_t)chroma * 2), v((size_t)chroma);
+            FillRandom(y);
+            FillRandom(u);
+            FillRandom(v);
+            const uint8_t* vp = uvStep == 2 ? u.data() + 1 : v.data();
+            std::vector<uint8_t> expected((size_t)w * 4 + 64, kGuard);
+            for (int x = 0; x < w; x++) YuvToBgrxPixel(y[x], u[(x >> 1) * uvStep], vp[(x >> 1) * uvStep], &expected[(size_t)x * 4]);
+            for (size_t l = 0; l < sizeof(kLevels) / sizeof(kLevels[0]); ++l) {
+                std::vector<uint8_t> out((size_t)w * 4 + 64, kGuard);
+                GetYuvRowKernel(kLevels[l])(y.data(), u.data(), vp, uvStep, w, out.data());
+                CHECK(out == expected);
+            }
+        }
+
+        // 灰度：SSE2 与标量一致，且等于 U = V = 128 时 BGRX 的 G 通道
+        std::vector<uint8_t> y((size_t)w), scalar((size_t)w + 32, kGuard), simd((size_t)w + 32, kGuard);
+        FillRandom(y);
+        GetGrayRowKernel(COLOR_KERNEL_SCALAR)(y.data(), w, scalar.data());
+        GetGrayRowKernel(COLOR_KERNEL_AUTO)(y.data(), w, simd.data());
+        CHECK(scalar == simd);
+        bool luma = true;
+        for (int x = 0; x < w; x++) {
+            uint8_t bgrx[4];
+            YuvToBgrxPixel(y[x], 128, 128, bgrx);
+            if (scalar[x] != bgrx[1]) luma = false;
+        }
+        CHECK(luma);
+    }
+}
+
+// 奇数宽高的 4:2:0 帧，行尾带填充；NV12 的色度为一个交错平面
+struct YuvFrame {
+    std::vector<uint8_t> y, u, v;
+    FrameView view;
+
+    YuvFrame(int width, int height, int format) {
+        int chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+        int yStride = width + 3;
+        int cStride = (format == FRAME_NV12 ? chromaWidth * 2 : chromaWidth) + 5;
+        y.resize((size_t)yStride * height);
+        u.resize((size_t)cStride * chromaHeight);
+        v.resize((size_t)cStride * chromaHeight);
+        FillRandom(y);
+        FillRandom(u);
+        FillRandom(v);
+        view = FrameView();
+        view.data = y.data();
+        view.width = width;
+        view.height = height;
+        view.stride = yStride;
+        view.format = format;
+        view.plane1 = u.data();
+        view.stride1 = cStride;
+        if (format == FRAME_I420) {
+            view.plane2 = v.data();
+            view.stride2 = cStride;
+        }
+    }
+
+    void Pixel(int x, int yy, uint8_t* out) const {
+        const uint8_t* uRow = view.plane1 + (size_t)(yy / 2) * view.stride1;
+        int yv = view.data[(size_t)yy * view.stride + x];
+        if (view.format == FRAME_NV12) YuvToBgrxPixel(yv, uRow[(x / 2) * 2], uRow[(x / 2) * 2 + 1], out);
+        else YuvToBgrxPixel(yv, uRow[x / 2], view.plane2[(size_t)(yy / 2) * view.stride2 + x / 2], out);
+    }
+};
+
+// 整帧与随机 ROI：每个内核级别都与逐像素参考一致，目标行跨度之内、ROI 宽度之外的字节不被改写
+static void TestFrames() {
+    const int sizes[][2] = { { 1, 1 }, { 2, 2 }, { 3, 5 }, { 7, 3 }, { 17, 9 }, { 33, 31 }, { 65, 17 }, { 641, 359 } };
+    const int formats[] = { FRAME_NV12, FRAME_I420 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        for (size_t f = 0; f < 2; ++f) {
+            int w = sizes[s][0], h = sizes[s][1];
+            YuvFrame frame(w, h, formats[f]);
+            for (int trial = 0; trial < 12; trial++) {
+                RoiRect roi = { 0, 0, w, h };
+                if (trial > 0) {
+                    roi.left = rand() % w;
+                    roi.top = rand() % h;
+                    roi.right = roi.left + 1 + rand() % (w - roi.left);
+                    roi.bottom = roi.top + 1 + rand() % (h - roi.top);
+                    if (trial == 1 && w > 1) roi.left |= 1;     // 奇数起始列
+                    if (roi.left >= roi.right) roi.right = roi.left + 1;
+                    if (roi.right > w) { roi.left = w - 1; roi.right = w; }
+                }
+                int rw = roi.right - roi.left, rh = roi.bottom - roi.top;
+                int dstStride = rw * 4 + 8;
+                std::vector<uint8_t> expected((size_t)dstStride * rh, kGuard);
+                for (int yy = 0; yy < rh; yy++) {
+                    for (int x = 0; x < rw; x++) frame.Pixel(roi.left + x, roi.top + yy, &expected[(size_t)yy * dstStride + x * 4]);
+                }
+                std::vector<uint8_t> grayExpected((size_t)(rw + 4) * rh, kGuard);
+                for (int yy = 0; yy < rh; yy++) {
+                    for (int x = 0; x < rw; x++) {
+                        uint8_t bgrx[4];
+                        YuvToBgrxPixel(frame.view.data[(size_t)(roi.top + yy) * frame.view.stride + roi.left + x], 128, 128, bgrx);
+                        grayExpected[(size_t)yy * (rw + 4) + x] = bgrx[1];
+                    }
+                }
+                for (size_t l = 0; l < sizeof(kLevels) / sizeof(kLevels[0]); ++l) {
+                    std::vector<uint8_t> out((size_t)dstStride * rh, kGuard);
+                    CHECK(ConvertRoiToBgrx(frame.view, roi, out.data(), dstStride, kLevels[l]));
+                    CHECK(out == expected);
+                    std::vector<uint8_t> gray((size_t)(rw + 4) * rh, kGuard);
+                    CHECK(ConvertRoiToGray(frame.view, roi, gray.data(), rw + 4, kLevels[l]));
+                    CHECK(gray == grayExpected);
+                }
+            }
+        }
+    }
+}
+
+int main() {
+    srand(12345);
+#ifdef D2F_X86
+    printf("AVX2: %s\n", CpuHasAVX2() ? "测试" : "CPU 不支持，跳过");
+#endif
+    TestRowKernels();
+    TestFrames();
+    return TestSummary("color_convert_test");
+}
@@ -0,0 +1,336 @@
+/*
+    续传的测试：清单的读写往返与截断；清单标记完成的视频直接跳过；
+    在视频中途停止后续传、或清单被截断后重新执行，最终输出（图像与清单）与一次完整执行逐字节相同；
+    启用去重时续传也与完整执行相同（检查点之后的第一帧与上次保存的最后一帧比较）。
+    用合成视频（synthetic_decoder.h）与静止画面的 Y4M 视频，临时文件写在当前目录的 extract_resume_test.tmp 下。
+        g++ -std=c++14 -O2 -I. tests/extract_resume_test.cpp -o extract_resume_test -pthread
+*/
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "extract_engine.h"
+#include "extract_manifest.h"
+#include "synthetic_decoder.h"
+#include "y4m_decoder.h"
+#include "test_util.h"
+
+static const char* const kClips[] = { "clip_a", "clip_b", "clip_c" };
+static const int kClipCount = 3;
+static const int kClipFrames = 240;
+static const int kClipGop = 24;
+
+static bool ReadWholeFile(const std::string& path, std::vector<uint8_t>* data) {
+    FILE* fp = OpenFileUtf8(path, "rb");
+    if (!fp) return false;
+    data->clear();
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) data->insert(data->end(), buf, buf + n);
+    fclose(fp);
+    return true;
+}
+
+// 转发到另一个后端的解码器，所有解码器合计推进 stopAfter 帧后置位 stop（0 表示不停止）
+class StoppingBackend : public IDecoderBackend {
+public:
+    StoppingBackend(IDecoderBackend& inner, std::atomic<bool>& stop, int stopAfter)
+        : m_inner(inner), m_stop(stop), m_stopAfter(stopAfter), m_advanced(0) {}
+
+    const char* Name() const override { return "stopping"; }
+    bool IsVideoFile(const std::string& path) const override { return m_inner.IsVideoFile(path); }
+
+    std::unique_ptr<IVideoDecoder> CreateDecoder() override {
+        return std::unique_ptr<IVideoDecoder>(new Decoder(*this, m_inner.CreateDecoder()));
+    }
+
+private:
+    StoppingBackend(const StoppingBackend&) = delete;
+    StoppingBackend& operator=(const StoppingBackend&) = delete;
+
+    class Decoder : public IVideoDecoder {
+    public:
+        Decoder(StoppingBackend& owner, std::unique_ptr<IVideoDecoder> inner) : m_owner(owner), m_inner(std::move(inner)) {}
+
+        bool Open(const std::string& path) override { return m_inner->Open(path); }
+        void Close() override { m_inner->Close(); }
+        bool GetInfo(VideoProbeInfo* info) override { return m_inner->GetInfo(info); }
+        bool Rewind() override { return m_inner->Rewind(); }
+        bool ScanFrames(std::vector<FrameIndexEntry>* entries) override { return m_inner->ScanFrames(entries); }
+
+        bool Advance(int64_t* timestamp) override {
+            if (m_owner.m_stopAfter > 0 && ++m_owner.m_advanced >= m_owner.m_stopAfter) m_owner.m_stop = true;
+            return m_inner->Advance(timestamp);
+        }
+
+        bool LockFrame(FrameView* view) override { return m_inner->LockFrame(view); }
+        void UnlockFrame() override { m_inner->UnlockFrame(); }
+        bool IsKeyFrame() const override { return m_inner->IsKeyFrame(); }
+        bool CanSeek() const override { return m_inner->CanSeek(); }
+        bool SeekTo(int64_t timestamp) override { return m_inner->SeekTo(timestamp); }
+
+    private:
+        Decoder(const Decoder&) = delete;
+        Decoder& operator=(const Decoder&) = delete;
+
+        StoppingBackend& m_owner;
+        std::unique_ptr<IVideoDecoder> m_inner;
+    };
+
+    IDecoderBackend& m_inner;
+    std::atomic<bool>& m_stop;
+    int m_stopAfter;
+    std::atomic<int> m_advanced;
+};
+
+// 两个输出：整帧 JPEG，与缩小的灰度 PNG（子目录 small），续传检查点取两者中较小的
+static ExtractionJob MakeJob(const std::string& outputDir) {
+    ExtractionJob job;
+    for (int i = 0; i < kClipCount; i++) job.files.push_back(kClips[i]);
+    job.outputDir = outputDir;
+    job.sampling.interval = 2;
+    job.frameIndex = FRAME_INDEX_OFF;   // 虚拟视频没有文件，不写帧索引
+    job.segmentSeconds = 0.0;
+    job.outputs.assign(2, OutputSpec());
+    job.outputs[1].dir = "small";
+    job.outputs[1].width = 16;
+    job.outputs[1].height = 9;
+    job.outputs[1].channels = CHANNELS_GRAY;
+    job.outputs[1].encoder.format = IMAGE_PNG;
+    return job;
+}
+
+static bool RunJob(IDecoderBackend& inner, const ExtractionJob& job, int stopAfter, ExtractionStats* stats) {
+    std::atomic<bool> stop(false);
+    StoppingBackend backend(inner, stop, stopAfter);
+    ExtractionEngine engine(backend);
+    engine.SetThreadCounts(1, 2);
+    std::string error;
+    bool ok = engine.Run(job, stop, stats, &error);
+    if (!ok) fprintf(stderr, "提取失败: %s\n", error.c_str());
+    return ok;
+}
+
+// 输出目录下的全部文件（两个输出中各视频的图像子目录与清单），键为相对路径
+static std::map<std::string, std::vector<uint8_t>> ReadOutputs(const std::string& outputDir,
+                                                               const std::vector<std::string>& clips = std::vector<std::string>(kClips, kClips + kClipCount)) {
+    std::map<std::string, std::vector<uint8_t>> files;
+    const char* const outputs[] = { "", "small" };
+    for (int o = 0; o < 2; o++) {
+        std::vector<std::string> dirs(1, outputs[o]);
+        for (size_t i = 0; i < clips.size(); i++) dirs.push_back(JoinPath(outputs[o], clips[i]));
+        for (size_t d = 0; d < dirs.size(); ++d) {
+            std::vector<std::string> paths;
+            ListFilesUtf8(JoinPath(outputDir, dirs[d]), &paths);
+            for (size_t p = 0; p < paths.size(); ++p) {
+                std::string name = paths[p].substr(outputDir.size() + 1);
+                ReadWholeFile(paths[p], &files[name]);
+            }
+        }
+    }
+    return files;
+}
+
+static bool SameOutputs(const std::map<std::string, std::vector<uint8_t>>& a, const std::map<std::string, std::vector<uint8_t>>& b) {
+    if (a.size() != b.size()) {
+        fprintf(stderr, "  文件数不同: %zu / %zu\n", a.size(), b.size());
+        return false;
+    }
+    for (auto ia = a.begin(), ib = b.begin(); ia != a.end(); ++ia, ++ib) {
+        if (ia->first != ib->first || ia->second != ib->second) {
+            fprintf(stderr, "  不同: %s / %s\n", ia->first.c_str(), ib->first.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+static void TruncateFile(const std::string& path, size_t size) {
+    std::vector<uint8_t> data;
+    if (!ReadWholeFile(path, &data)) return;
+    if (size < data.size()) data.resize(size);
+    WriteFileUtf8(path, data.data(), data.size());
+}
+
+// 清单读写往返；截断在任何位置的清单要么读不出，要么与原来的来源不一致，不会带着错误的检查点被采用
+static void TestManifestRoundTrip(const std::string& work) {
+    ExtractManifest m;
+    m.source = "视频/带 空格\t和制表符 的路径.mp4";
+    m.size = 12345678901ull;
+    m.mtime = -42;
+    m.settings = 0xfedcba9876543210ull;
+    m.lastFrame = 1234;
+    m.lastTimestamp = 411522345;
+    m.complete = true;
+    std::string path = JoinPath(work, "roundtrip.manifest");
+    CHECK(WriteManifest(path, m));
+    ExtractManifest r;
+    CHECK(ReadManifest(path, &r));
+    CHECK(r.Matches(m));
+    CHECK(r.lastFrame == m.lastFrame && r.lastTimestamp == m.lastTimestamp && r.complete == m.complete);
+
+    CHECK(!ReadManifest(JoinPath(work, "missing.manifest"), &r));
+
+    std::vector<uint8_t> full;
+    CHECK(ReadWholeFile(path, &full));
+    std::string cut = JoinPath(work, "cut.manifest");
+    for (size_t size = 0; size < full.size(); ++size) {
+        WriteFileUtf8(cut, full.data(), size);
+        ExtractManifest t;
+        bool adopted = ReadManifest(cut, &t) && t.Matches(m);
+        // 只去掉结尾换行时内容完整
+        if (size + 1 < full.size()) CHECK(!adopted);
+        else CHECK(adopted && t.lastFrame == m.lastFrame && t.complete);
+    }
+}
+
+// 第二次执行时所有视频的清单都已完成：不解码、不写文件，输出不变
+static void TestSkipCompleted(SyntheticDecoderBackend& synthetic, const std::string& work,
+                              const std::map<std::string, std::vector<uint8_t>>& clean) {
+    std::string dir = JoinPath(work, "skip");
+    ExtractionStats stats;
+    CHECK(RunJob(synthetic, MakeJob(dir), 0, &stats));
+    CHECK(stats.filesSkipped == 0);
+    CHECK(RunJob(synthetic, MakeJob(dir), 0, &stats));
+    CHECK(stats.filesSkipped == (size_t)kClipCount);
+    CHECK(stats.framesDecoded == 0);
+    CHECK(stats.filesWritten == 0);
+    CHECK(SameOutputs(ReadOutputs(dir), clean));
+
+    // 设置改变后清单不再匹配，重新提取
+    ExtractionJob changed = MakeJob(dir);
+    changed.sampling.interval = 3;
+    CHECK(RunJob(synthetic, changed, 0, &stats));
+    CHECK(stats.filesSkipped == 0);
+    CHECK(stats.framesDecoded == (uint64_t)kClipCount * kClipFrames);
+}
+
+// 在第 stopAfter 帧停止，之后（可选地把停止处那个视频的清单截断到 truncateTo 字节）续传直到完成
+static void TestInterruptAndResume(SyntheticDecoderBackend& synthetic, const std::string& work,
+                                   const std::map<std::string, std::vector<uint8_t>>& clean, int stopAfter, int truncateTo) {
+    std::string dir = JoinPath(work, "stop_" + std::to_string(stopAfter) + "_" + std::to_string(truncateTo));
+    ExtractionStats stats;
+    CHECK(RunJob(synthetic, MakeJob(dir), stopAfter, &stats));
+    CHECK(stats.framesDecoded < (uint64_t)kClipCount * kClipFrames);
+    // 停止处的视频：第一个清单没有标记完成的视频（停止时还没开始的视频没有清单）
+    int stoppedClip = 0;
+    ExtractManifest before;
+    std::string manifest;
+    for (; stoppedClip < kClipCount; stoppedClip++) {
+        manifest = JoinPath(dir, kClips[stoppedClip]) + "." + kManifestExtension;
+        before = ExtractManifest();
+        if (!ReadManifest(manifest, &before) || !before.complete) break;
+    }
+    CHECK(stoppedClip < kClipCount);
+    if (truncateTo >= 0) {
+        TruncateFile(manifest, (size_t)truncateTo);
+        TruncateFile(JoinPath(JoinPath(dir, "small"), kClips[stoppedClip]) + "." + kManifestExtension, (size_t)truncateTo);
+    }
+
+    CHECK(RunJob(synthetic, MakeJob(dir), 0, &stats));
+    CHECK(stats.filesSkipped == (size_t)stoppedClip);
+    // 清单完好且已有检查点时从检查点继续：只多解码第一帧与检查点所在 GOP 中它之前的帧
+    if (truncateTo < 0 && before.lastFrame > 0) {
+        CHECK(stats.filesResumed == 1);
+        CHECK(stats.framesDecoded <= (uint64_t)((kClipCount - stoppedClip) * kClipFrames - before.lastFrame + kClipGop + 1));
+    }
+    if (truncateTo >= 0) CHECK(stats.filesResumed == 0);
+    CHECK(SameOutputs(ReadOutputs(dir), clean));
+}
+
+// 静止画面的 Y4M 视频：每 kSceneFrames 帧换一个画面，同一画面内的帧完全相同，去重后每个画面只保存第一帧
+static const int kStaticFrames = 120;
+static const int kSceneFrames = 40;
+
+static std::string WriteStaticY4m(const std::string& work) {
+    const int width = 64, height = 48;
+    std::string data = "YUV4MPEG2 W64 H48 F30:1 C420jpeg\n";
+    for (int n = 0; n < kStaticFrames; n++) {
+        data += "FRAME\n";
+        int scene = n / kSceneFrames;
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) data += (char)(uint8_t)(scene == 1 ? 200 - x : 40 + x * 2 + y + scene * 30);
+        }
+        data += std::string(2 * (width / 2) * (height / 2), (char)128);
+    }
+    std::string path = JoinPath(work, "static.y4m");
+    CHECK(WriteFileUtf8(path, data.data(), data.size()));
+    return path;
+}
+
+// 启用去重时在各处停止后续传：检查点之后的帧与上次保存的最后一帧比较，不会多保存同一画面的帧
+static void TestResumeWithDedup(const std::string& work) {
+    Y4mDecoderBackend y4m;
+    ExtractionJob job = MakeJob("");
+    job.files.assign(1, WriteStaticY4m(work));
+    job.sampling.interval = 0;
+    job.dedupThreshold = 1.0;
+    const std::vector<std::string> clips(1, "static");
+
+    job.outputDir = JoinPath(work, "dedup_clean");
+    ExtractionStats stats;
+    CHECK(RunJob(y4m, job, 0, &stats));
+    std::map<std::string, std::vector<uint8_t>> clean = ReadOutputs(job.outputDir, clips);
+    CHECK(clean.erase("dedup_summary.csv") == 1);
+    // 每个画面的第一帧 × 2 个输出，加上每个输出一个清单
+    CHECK(clean.size() == (size_t)2 * (kStaticFrames / kSceneFrames + 1));
+    CHECK(clean.count(JoinPath("static", "static_00001.jpg")) == 1);
+    CHECK(clean.count(JoinPath("static", "static_00041.jpg")) == 1);
+
+    int resumed = 0;
+    const int stops[] = { 2, 20, 41, 45, 60, 81, 100 };
+    for (size_t i = 0; i < sizeof(stops) / sizeof(stops[0]); ++i) {
+        job.outputDir = JoinPath(work, "dedup_stop_" + std::to_string(stops[i]));
+        CHECK(RunJob(y4m, job, stops[i], &stats));
+        CHECK(RunJob(y4m, job, 0, &stats));
+        resumed += (int)stats.filesResumed;
+        // dedup_summary.csv 是本次执行的统计，续传时只计入本次处理的帧，不比较
+        std::map<std::string, std::vector<uint8_t>> outputs = ReadOutputs(job.outputDir, clips);
+        CHECK(outputs.erase("dedup_summary.csv") == 1);
+        CHECK(SameOutputs(outputs, clean));
+    }
+    // 至少有几次是从检查点续传，而不是从头重新提取
+    CHECK(resumed >= 3);
+}
+
+int main() {
+    SyntheticDecoderBackend synthetic;
+    for (int i = 0; i < kClipCount; i++) {
+        SyntheticClip clip;
+        clip.name = kClips[i];
+        clip.width = 48;
+        clip.height = 28;
+        clip.frames = kClipFrames;
+        clip.gop = kClipGop;
+        synthetic.AddClip(clip);
+    }
+
+    // 每次运行用新的子目录，保证一开始没有清单
+    std::string work = JoinPath("extract_resume_test.tmp",
+        std::to_string((long long)std::chrono::steady_clock::now().time_since_epoch().count()));
+    CHECK(CreateDirectoriesUtf8(work));
+    TestManifestRoundTrip(work);
+
+    std::string cleanDir = JoinPath(work, "clean");
+    ExtractionStats stats;
+    CHECK(RunJob(synthetic, MakeJob(cleanDir), 0, &stats));
+    CHECK(stats.framesDecoded == (uint64_t)kClipCount * kClipFrames);
+    std::map<std::string, std::vector<uint8_t>> clean = ReadOutputs(cleanDir);
+    // 每个视频 80 帧 × 2 个输出，加上每个输出每个视频一个清单
+    CHECK(clean.size() == (size_t)kClipCount * 2 * (kClipFrames / 3 + 1));
+
+    TestSkipCompleted(synthetic, work, clean);
+    const int stops[] = { 1, 50, 150, 241, 333, 479, 700 };
+    for (size_t i = 0; i < sizeof(stops) / sizeof(stops[0]); ++i) TestInterruptAndResume(synthetic, work, clean, stops[i], -1);
+    const int truncations[] = { 0, 10, 40, 70, 90 };
+    for (size_t i = 0; i < sizeof(truncations) / sizeof(truncations[0]); ++i) {
+        TestInterruptAndResume(synthetic, work, clean, 333, truncations[i]);
+    }
+    TestResumeWithDedup(work);
+    return TestSummary("extract_resume_test");
+}
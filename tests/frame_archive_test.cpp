@@ -0,0 +1,235 @@
+/*
+    帧归档的测试：写入（打包）后读取与校验，再取出为单独的文件（UnpackFrameArchive），
+    文件名与内容和写入的帧一致；输出目录与多级上级目录不存在时自动创建。
+    提取引擎打包的归档（灰度 PPM 即各帧为 PGM、按时间采样）通过校验，取出的文件与直接输出的文件同名且内容相同。
+    临时文件写在当前目录的 frame_archive_test.tmp 下。
+        g++ -std=c++14 -O2 -I. tests/frame_archive_test.cpp -o frame_archive_test -pthread
+*/
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "extract_engine.h"
+#include "frame_archive.h"
+#include "png_encoder.h"
+#include "synthetic_decoder.h"
+#include "test_util.h"
+
+static bool ReadWholeFile(const std::string& path, std::vector<uint8_t>* data) {
+    FILE* fp = OpenFileUtf8(path, "rb");
+    if (!fp) return false;
+    data->clear();
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) data->insert(data->end(), buf, buf + n);
+    fclose(fp);
+    return true;
+}
+
+// 第 index 帧：小尺寸灰度渐变编码成 PNG，各帧内容不同
+static std::vector<uint8_t> EncodeTestFrame(int index) {
+    int width = 7 + index % 5, height = 5 + index % 3;
+    std::vector<uint8_t> pixels((size_t)width * height);
+    for (size_t i = 0; i < pixels.size(); ++i) pixels[i] = (uint8_t)(i * 13 + index * 29);
+    FrameView view = FrameView();
+    view.data = pixels.data();
+    view.width = width;
+    view.height = height;
+    view.stride = width;
+    view.format = FRAME_GRAY8;
+    PngEncoder encoder(6);
+    std::vector<uint8_t> out;
+    encoder.Encode(view, out);
+    return out;
+}
+
+struct PackedFrame {
+    int frameIndex;
+    int64_t timestamp;
+    std::vector<uint8_t> bytes;
+};
+
+// 按给定顺序打包；归档中按帧序号排序
+static bool Pack(const std::string& path, const std::vector<PackedFrame>& frames) {
+    FrameArchiveWriter writer;
+    if (!writer.Open(path, IMAGE_PNG)) return false;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        if (!writer.Append(frames[i].frameIndex, frames[i].timestamp, frames[i].bytes.data(), frames[i].bytes.size())) return false;
+    }
+    return writer.Finish();
+}
+
+static void TestRoundTrip(const std::string& work) {
+    std::vector<PackedFrame> frames;
+    const int indices[] = { 31, 1, 7, 100000, 2, 15, 99999 };
+    for (size_t i = 0; i < sizeof(indices) / sizeof(indices[0]); ++i) {
+        PackedFrame f;
+        f.frameIndex = indices[i];
+        f.timestamp = (int64_t)indices[i] * 333667;
+        f.bytes = EncodeTestFrame(indices[i]);
+        frames.push_back(f);
+    }
+    std::string archive = JoinPath(work, "frames.d2fpack");
+    CHECK(Pack(archive, frames));
+
+    FrameArchiveReader reader;
+    std::string error;
+    CHECK(reader.Open(archive, &error));
+    CHECK(reader.Verify().empty());
+    CHECK(reader.ImageFormat() == IMAGE_PNG);
+    CHECK(reader.Count() == frames.size());
+    for (size_t n = 1; n < reader.Count(); ++n) CHECK(reader.Entry(n - 1).frameIndex < reader.Entry(n).frameIndex);
+
+    // 输出目录及其上级目录都不存在
+    std::string outDir = JoinPath(JoinPath(JoinPath(work, "unpacked"), "a"), "b");
+    CHECK(!IsDirectoryUtf8(outDir));
+    CHECK(UnpackFrameArchive(reader, outDir, &error));
+    CHECK(IsDirectoryUtf8(outDir));
+    std::vector<std::string> files;
+    CHECK(ListFilesUtf8(outDir, &files));
+    CHECK(files.size() == frames.size());
+    for (size_t i = 0; i < frames.size(); ++i) {
+        char name[32];
+        snprintf(name, sizeof(name), "frames_%05d.png", frames[i].frameIndex);
+        std::vector<uint8_t> bytes;
+        CHECK(ReadWholeFile(JoinPath(outDir, name), &bytes));
+        CHECK(bytes == frames[i].bytes);
+        remove(JoinPath(outDir, name).c_str());
+    }
+
+    // 再次取出到已存在的目录（带结尾分隔符）覆盖旧文件
+    CHECK(UnpackFrameArchive(reader, outDir + kPathSeparator, &error));
+    files.clear();
+    CHECK(ListFilesUtf8(outDir, &files));
+    CHECK(files.size() == frames.size());
+    for (size_t i = 0; i < files.size(); ++i) remove(files[i].c_str());
+
+    // 输出路径是已存在的文件时报告错误
+    CHECK(!UnpackFrameArchive(reader, archive, &error));
+    CHECK(!error.empty());
+    remove(archive.c_str());
+}
+
+static void TestEmptyArchive(const std::string& work) {
+    std::string archive = JoinPath(work, "empty.d2fpack");
+    CHECK(Pack(archive, std::vector<PackedFrame>()));
+    FrameArchiveReader reader;
+    std::string error;
+    CHECK(reader.Open(archive, &error));
+    CHECK(reader.Count() == 0);
+    CHECK(reader.Verify().empty());
+    std::string outDir = JoinPath(JoinPath(work, "empty"), "out");
+    CHECK(UnpackFrameArchive(reader, outDir, &error));
+    CHECK(IsDirectoryUtf8(outDir));
+    remove(archive.c_str());
+}
+
+static bool RunEngine(IDecoderBackend& backend, const ExtractionJob& job) {
+    ExtractionEngine engine(backend);
+    engine.SetThreadCounts(1, 2);
+    std::atomic<bool> stop(false);
+    ExtractionStats stats;
+    std::string error;
+    bool ok = engine.Run(job, stop, &stats, &error);
+    if (!ok) fprintf(stderr, "提取失败: %s\n", error.c_str());
+    return ok;
+}
+
+// 同一个任务分别直接输出与打包，归档通过校验，取出的文件与直接输出的文件同名（视频文件名_帧序号，
+// 按时间采样时附加毫秒时间戳）且逐字节相同。返回打包的归档路径
+static std::string CheckUnpackSameAsDirect(IDecoderBackend& backend, const std::string& work, const std::string& name, ExtractionJob job) {
+    CHECK(CreateDirectoriesUtf8(JoinPath(work, name)));
+    std::string directDir = JoinPath(JoinPath(work, name), "direct");
+    std::string packedDir = JoinPath(JoinPath(work, name), "packed");
+    job.outputDir = directDir;
+    CHECK(RunEngine(backend, job));
+    job.outputs[0].pack = true;
+    job.outputDir = packedDir;
+    CHECK(RunEngine(backend, job));
+
+    std::string archive = JoinPath(packedDir, "clip." + std::string(kArchiveExtension));
+    FrameArchiveReader reader;
+    std::string error;
+    CHECK(reader.Open(archive, &error));
+    CHECK(reader.Verify().empty());
+    std::string outDir = JoinPath(JoinPath(work, name), "unpacked");
+    CHECK(UnpackFrameArchive(reader, outDir, &error));
+
+    std::vector<std::string> direct, unpacked;
+    CHECK(ListFilesUtf8(JoinPath(directDir, "clip"), &direct));
+    CHECK(ListFilesUtf8(outDir, &unpacked));
+    CHECK(direct.size() > 1 && direct.size() == reader.Count() && unpacked.size() == direct.size());
+    for (size_t i = 0; i < direct.size(); ++i) {
+        std::string file = direct[i].substr(direct[i].find_last_of(kPathSeparator) + 1);
+        std::vector<uint8_t> a, b;
+        CHECK(ReadWholeFile(direct[i], &a));
+        bool found = ReadWholeFile(JoinPath(outDir, file), &b);
+        CHECK(found);
+        if (!found) fprintf(stderr, "  %s：取出的文件中没有 %s\n", name.c_str(), file.c_str());
+        CHECK(a == b);
+    }
+    return archive;
+}
+
+// 灰度 PPM 打包：归档记录灰度标志，校验接受 P5，取出为 .pgm；按时间采样的归档取出时文件名附加时间戳
+static void TestUnpackSameAsDirect(const std::string& work) {
+    SyntheticDecoderBackend backend;
+    SyntheticClip clip;
+    clip.name = "clip";
+    clip.width = 32;
+    clip.height = 18;
+    clip.frames = 30;
+    backend.AddClip(clip);
+
+    ExtractionJob job;
+    job.files.push_back(clip.name);
+    job.sampling.interval = 3;
+    job.frameIndex = FRAME_INDEX_OFF;   // 虚拟视频没有文件，不写帧索引
+    job.outputs.assign(1, OutputSpec());
+    job.outputs[0].channels = CHANNELS_GRAY;
+    job.outputs[0].encoder.format = IMAGE_PPM;
+    std::string archive = CheckUnpackSameAsDirect(backend, work, "gray_ppm", job);
+
+    FrameArchiveReader reader;
+    std::string error;
+    CHECK(reader.Open(archive, &error));
+    CHECK(reader.ImageFormat() == IMAGE_PPM);
+    CHECK(reader.Gray() && !reader.TimeNames());
+    CHECK(std::string(reader.Extension()) == "pgm");
+
+    ExtractionJob timed = job;
+    timed.sampling.mode = SAMPLE_SECONDS;
+    timed.sampling.value = 0.25;
+    timed.outputs[0].channels = CHANNELS_RGB;
+    timed.outputs[0].encoder.format = IMAGE_PNG;
+    FrameArchiveReader timedReader;
+    CHECK(timedReader.Open(CheckUnpackSameAsDirect(backend, work, "seconds_png", timed), &error));
+    CHECK(!timedReader.Gray() && timedReader.TimeNames());
+
+    // 没有灰度标志的 PPM 归档不接受 P5 帧
+    std::string colorArchive = JoinPath(work, "color.d2fpack");
+    FrameArchiveWriter writer;
+    size_t length = 0;
+    const uint8_t* data = reader.Frame(0, &length);
+    CHECK(writer.Open(colorArchive, IMAGE_PPM));
+    CHECK(writer.Append(1, 0, data, length));
+    CHECK(writer.Finish());
+    FrameArchiveReader color;
+    CHECK(color.Open(colorArchive, &error));
+    CHECK(!color.Gray());
+    CHECK(!color.Verify().empty());
+}
+
+int main() {
+    // 每次运行用新的子目录，保证输出目录一开始不存在
+    std::string work = JoinPath("frame_archive_test.tmp",
+        std::to_string((long long)std::chrono::steady_clock::now().time_since_epoch().count()));
+    CHECK(CreateDirectoriesUtf8(work));
+    TestRoundTrip(work);
+    TestEmptyArchive(work);
+    TestUnpackSameAsDirect(work);
+    return TestSummary("frame_archive_test");
+}
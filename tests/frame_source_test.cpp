@@ -0,0 +1,157 @@
+/*
+    ROI 跨步视图的测试：ClampRoi 的边界调整、奇数偏移、自下而上（stride 为负）的缓冲，
+    以及从视图复制 / 裁剪得到的像素与源帧逐个一致。
+        g++ -std=c++14 -O2 -I. tests/frame_source_test.cpp -o frame_source_test -pthread
+*/
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "color_convert.h"
+#include "frame_source.h"
+#include "test_util.h"
+
+// 源帧 (x, y) 处第 c 个通道的值，各位置互不相同的概率很高
+static uint8_t PatternValue(int x, int y, int c) {
+    uint32_t h = (uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u ^ (uint32_t)c * 83492791u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    return (uint8_t)(h ^ (h >> 15));
+}
+
+// 按 FrameView 的约定存放的测试帧：bottomUp 时第 0 行在内存的最后，stride 为负
+struct TestFrame {
+    std::vector<uint8_t> memory;
+    FrameView view;
+
+    TestFrame(int width, int height, int format, bool bottomUp, int padding) {
+        int pixelBytes = FramePixelBytes(format);
+        int rowBytes = width * pixelBytes + padding;
+        memory.assign((size_t)rowBytes * height, 0xEE);
+        view = FrameView();
+        view.width = width;
+        view.height = height;
+        view.format = format;
+        view.stride = bottomUp ? -rowBytes : rowBytes;
+        view.data = memory.data() + (bottomUp ? (size_t)rowBytes * (height - 1) : 0);
+        for (int y = 0; y < height; y++) {
+            uint8_t* row = const_cast<uint8_t*>(view.data) + (ptrdiff_t)y * view.stride;
+            for (int x = 0; x < width; x++) {
+                for (int c = 0; c < pixelBytes; c++) row[x * pixelBytes + c] = PatternValue(x, y, c);
+            }
+        }
+    }
+};
+
+static void TestClampRoi() {
+    RoiRect inside = { 3, 5, 40, 30 };
+    CHECK(ClampRoi(inside, 64, 48));
+    CHECK(inside.left == 3 && inside.top == 5 && inside.right == 40 && inside.bottom == 30);
+
+    RoiRect over = { -7, -1, 100, 49 };
+    CHECK(ClampRoi(over, 64, 48));
+    CHECK(over.left == 0 && over.top == 0 && over.right == 64 && over.bottom == 48);
+
+    // 贴着右下边缘的 1x1
+    RoiRect corner = { 63, 47, 64, 48 };
+    CHECK(ClampRoi(corner, 64, 48));
+    CHECK(corner.right - corner.left == 1 && corner.bottom - corner.top == 1);
+
+    RoiRect outside = { 64, 0, 80, 10 };
+    CHECK(!ClampRoi(outside, 64, 48));
+    RoiRect above = { 0, -20, 10, 0 };
+    CHECK(!ClampRoi(above, 64, 48));
+    RoiRect empty = { 10, 10, 10, 20 };
+    CHECK(!ClampRoi(empty, 64, 48));
+    RoiRect inverted = { 20, 20, 10, 30 };
+    CHECK(!ClampRoi(inverted, 64, 48));
+}
+
+// 视图中每个像素都等于源帧 ROI 内对应位置的像素，且视图沿用源 stride
+static void CheckRoiView(const TestFrame& frame, RoiRect roi) {
+    FrameView view = FrameView();
+    RoiRect clamped = roi;
+    bool valid = ClampRoi(clamped, frame.view.width, frame.view.height);
+    CHECK(MakeRoiView(frame.view, roi, &view) == valid);
+    if (!valid) return;
+    int pixelBytes = FramePixelBytes(frame.view.format);
+    CHECK(view.width == clamped.right - clamped.left);
+    CHECK(view.height == clamped.bottom - clamped.top);
+    CHECK(view.stride == frame.view.stride);
+    CHECK(view.format == frame.view.format);
+    bool same = true;
+    for (int y = 0; y < view.height; y++) {
+        const uint8_t* row = view.data + (ptrdiff_t)y * view.stride;
+        for (int x = 0; x < view.width; x++) {
+            for (int c = 0; c < pixelBytes; c++) {
+                if (row[x * pixelBytes + c] != PatternValue(clamped.left + x, clamped.top + y, c)) same = false;
+            }
+        }
+    }
+    CHECK(same);
+
+    // 复制为连续缓冲后仍然一致，且不写出 width 之外的字节
+    int dstStride = view.width * pixelBytes + 3;
+    std::vector<uint8_t> copy((size_t)dstStride * view.height, 0x5A);
+    FrameView copied = CopyFrameView(view, copy.data(), dstStride);
+    CHECK(copied.width == view.width && copied.height == view.height && copied.stride == dstStride);
+    same = true;
+    for (int y = 0; y < view.height; y++) {
+        for (int x = 0; x < view.width; x++) {
+            for (int c = 0; c < pixelBytes; c++) {
+                if (copy[(size_t)y * dstStride + x * pixelBytes + c] != PatternValue(clamped.left + x, clamped.top + y, c)) same = false;
+            }
+        }
+        for (int p = view.width * pixelBytes; p < dstStride; p++) {
+            if (copy[(size_t)y * dstStride + p] != 0x5A) same = false;
+        }
+    }
+    CHECK(same);
+
+    // BGRX 源的 ROI 经 ConvertRoiToBgrx（提取引擎的裁剪路径）得到相同的像素
+    if (frame.view.format == FRAME_BGRX32) {
+        std::vector<uint8_t> cropped((size_t)view.width * 4 * view.height);
+        CHECK(ConvertRoiToBgrx(frame.view, roi, cropped.data(), view.width * 4));
+        same = true;
+        for (int y = 0; y < view.height; y++) {
+            if (memcmp(&cropped[(size_t)y * view.width * 4], &copy[(size_t)y * dstStride], (size_t)view.width * 4) != 0) same = false;
+        }
+        CHECK(same);
+    }
+}
+
+static void TestRoiViews() {
+    const int formats[] = { FRAME_BGRX32, FRAME_GRAY8 };
+    const RoiRect rois[] = {
+        { 0, 0, 37, 23 },       // 整帧
+        { 1, 1, 36, 22 },       // 奇数偏移
+        { 5, 3, 6, 4 },         // 单个像素
+        { 13, 7, 30, 20 },
+        { -5, -3, 11, 9 },      // 超出左上角
+        { 30, 17, 99, 99 },     // 超出右下角
+        { 36, 22, 37, 23 },     // 右下角的像素
+        { 37, 0, 40, 10 },      // 完全在画面外
+        { 8, 8, 8, 12 },        // 宽度为 0
+    };
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f) {
+        for (int bottomUp = 0; bottomUp < 2; bottomUp++) {
+            TestFrame frame(37, 23, formats[f], bottomUp != 0, 5);
+            for (size_t r = 0; r < sizeof(rois) / sizeof(rois[0]); ++r) CheckRoiView(frame, rois[r]);
+        }
+    }
+
+    // YUV 帧不能构造跨步视图
+    FrameView nv12 = FrameView();
+    nv12.format = FRAME_NV12;
+    nv12.width = 16;
+    nv12.height = 16;
+    FrameView view = FrameView();
+    RoiRect roi = { 0, 0, 8, 8 };
+    CHECK(!MakeRoiView(nv12, roi, &view));
+}
+
+int main() {
+    TestClampRoi();
+    TestRoiViews();
+    return TestSummary("frame_source_test");
+}
@@ -0,0 +1,226 @@
+/*
+    一遍缩放的测试：ImageResizer::ResizeRoi() 与先 ConvertRoi() 转换整个 ROI 再 Resize() 的多遍缩放逐位一致。
+    覆盖面积平均与双线性、缩小与放大、BGRX 与灰度输出，源为 I420 / NV12 / BGRX32（含自下而上的缓冲）/ GRAY8，
+    ROI 为奇数偏移、奇数宽高、单行单列与超出画面（调整到画面范围）；各级内核之间也逐位一致，不写出目标范围之外。CPU 不支持 AVX2 时 AVX2 一级退回 SSE2。
+        g++ -std=c++14 -O2 -I. tests/image_resize_test.cpp -o image_resize_test -pthread
+*/
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "image_resize.h"
+#include "test_util.h"
+
+static const uint8_t kGuard = 0xA5;
+
+static const ColorKernelLevel kLevels[] = { COLOR_KERNEL_SCALAR, COLOR_KERNEL_SSE2, COLOR_KERNEL_AVX2 };
+static const char* const kLevelNames[] = { "scalar", "sse2", "avx2" };
+
+// 一个源帧：像素在 pixels 中，行跨度带填充；bottomUp 的 BGRX 帧从最后一行开始、stride 为负
+struct TestFrame {
+    std::vector<uint8_t> pixels;
+    FrameView view;
+};
+
+// 随机数据中混入 0 与 255，覆盖饱和的分支；平滑的渐变让缩放结果不全是噪声
+static uint8_t TestSample(int x, int y, int c) {
+    int r = rand();
+    if ((r & 15) == 0) return 0;
+    if ((r & 15) == 1) return 255;
+    return (uint8_t)(x * 3 + y * 5 + c * 50 + (r >> 4) % 24);
+}
+
+static void MakeFrame(int width, int height, int format, bool bottomUp, TestFrame* frame) {
+    int chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+    FrameView& v = frame->view;
+    v = FrameView();
+    v.width = width;
+    v.height = height;
+    v.format = format;
+    if (format == FRAME_I420 || format == FRAME_NV12) {
+        v.stride = width + 13;
+        v.stride1 = format == FRAME_NV12 ? chromaWidth * 2 + 6 : chromaWidth + 5;
+        v.stride2 = format == FRAME_NV12 ? 0 : chromaWidth + 3;
+        size_t ySize = (size_t)v.stride * height;
+        size_t uSize = (size_t)v.stride1 * chromaHeight;
+        size_t vSize = (size_t)v.stride2 * chromaHeight;
+        frame->pixels.assign(ySize + uSize + vSize, kGuard);
+        uint8_t* base = frame->pixels.data();
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) base[(size_t)y * v.stride + x] = TestSample(x, y, 0);
+        }
+        for (int y = 0; y < chromaHeight; y++) {
+            for (int x = 0; x < chromaWidth; x++) {
+                if (format == FRAME_NV12) {
+                    base[ySize + (size_t)y * v.stride1 + 2 * x] = TestSample(x, y, 1);
+                    base[ySize + (size_t)y * v.stride1 + 2 * x + 1] = TestSample(x, y, 2);
+                }
+                else {
+                    base[ySize + (size_t)y * v.stride1 + x] = TestSample(x, y, 1);
+                    base[ySize + uSize + (size_t)y * v.stride2 + x] = TestSample(x, y, 2);
+                }
+            }
+        }
+        v.data = base;
+        v.plane1 = base + ySize;
+        v.plane2 = format == FRAME_NV12 ? nullptr : base + ySize + uSize;
+        return;
+    }
+    int pixelBytes = FramePixelBytes(format);
+    int stride = width * pixelBytes + 12;
+    frame->pixels.assign((size_t)stride * height, kGuard);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width * pixelBytes; x++) frame->pixels[(size_t)y * stride + x] = TestSample(x / pixelBytes, y, x % pixelBytes);
+    }
+    v.data = frame->pixels.data();
+    v.stride = stride;
+    if (bottomUp) {
+        v.data = frame->pixels.data() + (size_t)(height - 1) * stride;
+        v.stride = -stride;
+    }
+}
+
+// 输出缓冲：每行之后有 9 个保护字节，整个缓冲前后也各有 64 个
+struct OutputBuffer {
+    std::vector<uint8_t> bytes;
+    int stride;
+    int rowBytes;
+    int height;
+
+    OutputBuffer(int width, int h, int format)
+        : stride(width * FramePixelBytes(format) + 9), rowBytes(width * FramePixelBytes(format)), height(h) {
+        bytes.assign((size_t)stride * h + 2 * 64, kGuard);
+    }
+
+    uint8_t* Data() { return bytes.data() + 64; }
+
+    bool GuardsIntact() const {
+        for (size_t i = 0; i < bytes.size(); i++) {
+            size_t offset = i < 64 ? 0 : i - 64;
+            bool inside = i >= 64 && offset < (size_t)stride * height && (int)(offset % stride) < rowBytes;
+            if (!inside && bytes[i] != kGuard) return false;
+        }
+        return true;
+    }
+};
+
+// 多遍缩放：ConvertRoi() 转换整个 ROI 到中间图像，再 Resize()
+static bool MultiPass(const FrameView& frame, RoiRect roi, int dstWidth, int dstHeight, int filter, int format,
+                      ColorKernelLevel level, OutputBuffer* out) {
+    if (!ClampRoi(roi, frame.width, frame.height)) return false;
+    FrameView converted = FrameView();
+    converted.width = roi.right - roi.left;
+    converted.height = roi.bottom - roi.top;
+    converted.format = format;
+    converted.stride = converted.width * FramePixelBytes(format);
+    std::vector<uint8_t> pixels((size_t)converted.stride * converted.height);
+    converted.data = pixels.data();
+    if (!ConvertRoi(frame, roi, format, pixels.data(), converted.stride, level)) return false;
+    ImageResizer resizer;
+    return resizer.Configure(converted.width, converted.height, dstWidth, dstHeight, filter, format) &&
+        resizer.Resize(converted, out->Data(), out->stride, level);
+}
+
+struct ResizeCase {
+    int dstWidth;
+    int dstHeight;
+};
+
+// 缩小（整数与非整数倍、缩到一个像素）、等大与放大，以及只在一个方向缩放
+static const ResizeCase kSizes[] = {
+    { 17, 13 }, { 40, 9 }, { 1, 1 }, { 3, 50 }, { 224, 96 }, { 23, 31 },
+};
+
+// 一个源帧、ROI、输出尺寸、滤波与输出格式：各级内核下一遍与多遍缩放的结果相同，且与标量版本相同。
+// 同一个实例连续缩放两次，行缓存每次重新开始，结果不变。返回比较的次数
+static int CheckFusedCase(const TestFrame& frame, const char* name, RoiRect roi, const ResizeCase& rc, int filter, int format) {
+    RoiRect clamped = roi;
+    ClampRoi(clamped, frame.view.width, frame.view.height);
+    // 灰度源帧只能输出灰度
+    bool supported = frame.view.format != FRAME_GRAY8 || format == FRAME_GRAY8;
+    OutputBuffer scalarOut(rc.dstWidth, rc.dstHeight, format);
+    int compared = 0;
+    for (size_t l = 0; l < sizeof(kLevels) / sizeof(kLevels[0]); l++) {
+        OutputBuffer multi(rc.dstWidth, rc.dstHeight, format);
+        OutputBuffer fused(rc.dstWidth, rc.dstHeight, format);
+        bool multiOk = MultiPass(frame.view, roi, rc.dstWidth, rc.dstHeight, filter, format, kLevels[l], &multi);
+        ImageResizer resizer;
+        CHECK(resizer.Configure(clamped.right - clamped.left, clamped.bottom - clamped.top, rc.dstWidth, rc.dstHeight, filter, format));
+        bool fusedOk = resizer.ResizeRoi(frame.view, roi, fused.Data(), fused.stride, kLevels[l]);
+        CHECK(multiOk == supported);
+        CHECK(fusedOk == supported);
+        if (!supported) break;
+        bool same = multi.bytes == fused.bytes;
+        CHECK(same);
+        if (!same) {
+            fprintf(stderr, "  %s ROI (%d,%d)-(%d,%d) -> %dx%d %s %s %s：一遍与多遍缩放不一致\n", name, roi.left, roi.top, roi.right, roi.bottom,
+                rc.dstWidth, rc.dstHeight, filter == RESIZE_AREA ? "area" : "bilinear", format == FRAME_GRAY8 ? "gray" : "bgrx", kLevelNames[l]);
+        }
+        CHECK(fused.GuardsIntact());
+        std::vector<uint8_t> first = fused.bytes;
+        CHECK(resizer.ResizeRoi(frame.view, roi, fused.Data(), fused.stride, kLevels[l]));
+        CHECK(fused.bytes == first);
+        if (kLevels[l] == COLOR_KERNEL_SCALAR) scalarOut = fused;
+        else CHECK(fused.bytes == scalarOut.bytes);
+        compared++;
+    }
+    return compared;
+}
+
+static void TestFusedSameAsMultiPass() {
+    const int srcFormats[] = { FRAME_I420, FRAME_NV12, FRAME_BGRX32, FRAME_BGRX32, FRAME_GRAY8 };
+    const char* const srcNames[] = { "i420", "nv12", "bgrx", "bgrx（自下而上）", "gray" };
+    const int width = 97, height = 61;
+    // 奇数偏移与奇数宽高（YUV 的色度从奇数列、奇数行开始）、整帧、单列与单行、超出画面的 ROI、右下角一个像素
+    const RoiRect rois[] = {
+        { 3, 5, 88, 60 }, { 0, 0, width, height }, { 1, 1, 2, 61 }, { 11, 30, 96, 31 }, { -7, -3, 50, 200 }, { 96, 60, 97, 61 },
+    };
+    const int filters[] = { RESIZE_AREA, RESIZE_BILINEAR };
+    const int formats[] = { FRAME_BGRX32, FRAME_GRAY8 };
+    int compared = 0;
+    for (size_t s = 0; s < sizeof(srcFormats) / sizeof(srcFormats[0]); s++) {
+        TestFrame frame;
+        MakeFrame(width, height, srcFormats[s], s == 3, &frame);
+        for (size_t r = 0; r < sizeof(rois) / sizeof(rois[0]); r++) {
+            for (size_t d = 0; d < sizeof(kSizes) / sizeof(kSizes[0]); d++) {
+                for (size_t f = 0; f < 2; f++) {
+                    for (size_t o = 0; o < 2; o++) compared += CheckFusedCase(frame, srcNames[s], rois[r], kSizes[d], filters[f], formats[o]);
+                }
+            }
+        }
+    }
+    printf("一遍与多遍缩放比较了 %d 组\n", compared);
+}
+
+// ROI 尺寸与 Configure() 不一致、ROI 完全在画面之外时失败，不写输出
+static void TestRejectsMismatchedRoi() {
+    TestFrame frame;
+    MakeFrame(40, 30, FRAME_I420, false, &frame);
+    ImageResizer resizer;
+    CHECK(resizer.Configure(20, 10, 7, 5, RESIZE_AREA, FRAME_BGRX32));
+    OutputBuffer out(7, 5, FRAME_BGRX32);
+    std::vector<uint8_t> before = out.bytes;
+    RoiRect wrongSize = { 1, 1, 22, 11 };
+    CHECK(!resizer.ResizeRoi(frame.view, wrongSize, out.Data(), out.stride));
+    RoiRect outside = { 50, 40, 70, 50 };
+    CHECK(!resizer.ResizeRoi(frame.view, outside, out.Data(), out.stride));
+    // 超出画面的 ROI 按调整到画面范围之后的尺寸比较：调整后是 15x10 时失败，是 20x10 时可以缩放
+    RoiRect clippedWrong = { 25, 20, 60, 35 };
+    CHECK(!resizer.ResizeRoi(frame.view, clippedWrong, out.Data(), out.stride));
+    CHECK(out.bytes == before);
+    RoiRect clipped = { 20, 20, 45, 35 };
+    CHECK(resizer.ResizeRoi(frame.view, clipped, out.Data(), out.stride));
+    CHECK(out.bytes != before);
+    CHECK(out.GuardsIntact());
+}
+
+int main() {
+    srand(12345);
+#ifdef D2F_X86
+    printf("AVX2: %s\n", CpuHasAVX2() ? "测试" : "CPU 不支持，跳过");
+#endif
+    TestFusedSameAsMultiPass();
+    TestRejectsMismatchedRoi();
+    return TestSummary("image_resize_test");
+}
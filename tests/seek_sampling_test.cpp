@@ -0,0 +1,389 @@
+/*
+    自适应采样的测试：跳转模式与顺序解码选出的帧序号、时间戳与画面完全一致。
+    用合成视频（synthetic_decoder.h），覆盖采样间隔小于与大于 GOP、帧率不是整数、GOP 为 1、
+    帧源不标记关键帧（由跳转落点估计 GOP）的情况。
+    可变帧率：时间戳有间隙、突发与重复时，按时间选帧每个周期恰好保存一帧，长时间运行不漂移。
+    分段解码（PlanSegments / RunSegmentSampling）：按帧数、秒数、帧率与帧列表采样时，各段的输出拼起来与顺序解码相同，
+    没有重复与遗漏，段数多于关键帧数时也是如此。
+        g++ -std=c++14 -O2 -I. tests/seek_sampling_test.cpp -o seek_sampling_test -pthread
+*/
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "frame_list.h"
+#include "seek_sampling.h"
+#include "synthetic_decoder.h"
+#include "test_util.h"
+
+// 一次保存：帧序号、时间戳与画面（合成视频的帧数据共享，同一帧的 view.data 相同）
+struct KeptFrame {
+    int frameIndex;
+    int64_t timestamp;
+    const uint8_t* data;
+
+    bool operator==(const KeptFrame& other) const {
+        return frameIndex == other.frameIndex && timestamp == other.timestamp && data == other.data;
+    }
+};
+
+// 转发到另一个帧源；seekable 为 false 时不能跳转（顺序解码的参照），keyFlags 为 false 时不标记关键帧
+class WrappedSource : public IFrameSource {
+public:
+    WrappedSource(IFrameSource& inner, bool seekable, bool keyFlags)
+        : m_inner(inner), m_seekable(seekable), m_keyFlags(keyFlags) {}
+
+    bool Advance(int64_t* timestamp) override { return m_inner.Advance(timestamp); }
+    bool LockFrame(FrameView* view) override { return m_inner.LockFrame(view); }
+    void UnlockFrame() override { m_inner.UnlockFrame(); }
+    bool IsKeyFrame() const override { return m_keyFlags && m_inner.IsKeyFrame(); }
+    bool CanSeek() const override { return m_seekable && m_inner.CanSeek(); }
+    bool SeekTo(int64_t timestamp) override { return m_seekable && m_inner.SeekTo(timestamp); }
+
+private:
+    WrappedSource(const WrappedSource&) = delete;
+    WrappedSource& operator=(const WrappedSource&) = delete;
+
+    IFrameSource& m_inner;
+    bool m_seekable;
+    bool m_keyFlags;
+};
+
+// 按给定时间戳输出的帧源，每 gop 帧一个关键帧，跳转落在不晚于目标的最后一个关键帧；
+// 不同帧的 view.data 指向帧序号在 m_marks 中的位置，用于核对保存的是哪一帧
+class TimestampListSource : public IFrameSource {
+public:
+    TimestampListSource(const std::vector<int64_t>& timestamps, int gop)
+        : m_timestamps(timestamps), m_gop(gop), m_marks(timestamps.size()), m_next(0), m_current(-1) {}
+
+    bool Advance(int64_t* timestamp) override {
+        if (m_next >= m_timestamps.size()) return false;
+        m_current = (int)m_next++;
+        *timestamp = m_timestamps[m_current];
+        return true;
+    }
+
+    bool LockFrame(FrameView* view) override {
+        if (m_current < 0) return false;
+        *view = FrameView();
+        view->data = &m_marks[m_current];
+        view->width = 1;
+        view->height = 1;
+        view->stride = 1;
+        view->format = FRAME_GRAY8;
+        return true;
+    }
+
+    void UnlockFrame() override {}
+    bool IsKeyFrame() const override { return m_current >= 0 && m_current % m_gop == 0; }
+    bool CanSeek() const override { return true; }
+
+    bool SeekTo(int64_t timestamp) override {
+        size_t frame = 0;
+        while (frame + 1 < m_timestamps.size() && m_timestamps[frame + 1] <= timestamp) frame++;
+        m_next = frame - frame % m_gop;
+        m_current = -1;
+        return true;
+    }
+
+    // 由 view.data 得到帧序号（从 1 开始）
+    int FrameOf(const uint8_t* data) const { return (int)(data - m_marks.data()) + 1; }
+
+private:
+    TimestampListSource(const TimestampListSource&) = delete;
+    TimestampListSource& operator=(const TimestampListSource&) = delete;
+
+    std::vector<int64_t> m_timestamps;
+    size_t m_gop;
+    std::vector<uint8_t> m_marks;
+    size_t m_next;
+    int m_current;
+};
+
+struct SamplingCase {
+    int frames;
+    double fps;
+    int gop;
+};
+
+static const SamplingCase kCases[] = {
+    { 300, 30.0, 30 }, { 257, 30000.0 / 1001.0, 12 }, { 200, 25.0, 1 }, { 181, 60.0, 48 }, { 90, 24.0, 100 },
+};
+
+// 打开合成视频，按 makeSelector() 得到的选帧器采样；seekable / keyFlags 见 WrappedSource
+template <class MakeSelector>
+static std::vector<KeptFrame> Sample(SyntheticDecoderBackend& backend, const std::string& name, bool seekable, bool keyFlags,
+                                     MakeSelector makeSelector, SamplingStats* stats, int* lastFrame) {
+    std::vector<KeptFrame> kept;
+    std::unique_ptr<IVideoDecoder> decoder = backend.CreateDecoder();
+    if (!decoder->Open(name)) return kept;
+    WrappedSource source(*decoder, seekable, keyFlags);
+    auto selector = makeSelector();
+    std::atomic<bool> stop(false);
+    *lastFrame = RunAdaptiveSampling(source, selector, 0.0, stop, [&](int frameIndex, int64_t timestamp, const FrameView& view) {
+        KeptFrame k = { frameIndex, timestamp, view.data };
+        kept.push_back(k);
+    }, stats);
+    return kept;
+}
+
+// 同一个视频与选帧器：顺序解码与跳转（标记 / 不标记关键帧）的结果相同，返回跳转模式是否省下了解码
+template <class MakeSelector>
+static bool CheckSameAsLinear(SyntheticDecoderBackend& backend, const std::string& name, int frames, MakeSelector makeSelector) {
+    SamplingStats linearStats;
+    int linearLast = 0;
+    std::vector<KeptFrame> linear = Sample(backend, name, false, true, makeSelector, &linearStats, &linearLast);
+    CHECK(!linear.empty());
+    CHECK(linearLast == frames);
+    CHECK(linearStats.decodedFrames == frames);
+    CHECK(linearStats.seeks == 0);
+    for (size_t i = 1; i < linear.size(); ++i) CHECK(linear[i].frameIndex > linear[i - 1].frameIndex);
+
+    bool saved = false;
+    for (int keyFlags = 1; keyFlags >= 0; keyFlags--) {
+        SamplingStats stats;
+        int last = 0;
+        std::vector<KeptFrame> seek = Sample(backend, name, true, keyFlags != 0, makeSelector, &stats, &last);
+        CHECK(seek == linear);
+        if (seek != linear) {
+            fprintf(stderr, "  %s 关键帧标记=%d：顺序解码保存 %zu 帧，跳转模式保存 %zu 帧\n", name.c_str(), keyFlags,
+                linear.size(), seek.size());
+        }
+        if (stats.sparse && stats.decodedFrames < frames) saved = true;
+    }
+    return saved;
+}
+
+// 按帧数间隔：间隔从 0 到 GOP 的数倍，覆盖不跳转、刚好一个 GOP 与跳转的情况
+static void TestFrameInterval(SyntheticDecoderBackend& backend) {
+    for (size_t c = 0; c < sizeof(kCases) / sizeof(kCases[0]); ++c) {
+        const SamplingCase& sc = kCases[c];
+        std::string name = "frames_" + std::to_string(c);
+        const int intervals[] = { 0, 1, 3, sc.gop - 1, sc.gop, sc.gop + 1, sc.gop + kSeekOverheadFrames + 1, 2 * sc.gop + 7, 97, sc.frames };
+        for (size_t i = 0; i < sizeof(intervals) / sizeof(intervals[0]); ++i) {
+            int interval = intervals[i] < 0 ? 0 : intervals[i];
+            bool saved = CheckSameAsLinear(backend, name, sc.frames, [interval] { return FrameIntervalSelector(interval); });
+            // 间隔远大于 GOP 时一定会跳转并少解码
+            if (interval > 2 * sc.gop + 2 * kSeekOverheadFrames && interval < sc.frames) CHECK(saved);
+        }
+    }
+}
+
+// 按时间间隔：周期短于一帧、不是帧时长的整数倍、短于与长于 GOP 的时长
+static void TestTimeInterval(SyntheticDecoderBackend& backend) {
+    for (size_t c = 0; c < sizeof(kCases) / sizeof(kCases[0]); ++c) {
+        const SamplingCase& sc = kCases[c];
+        std::string name = "frames_" + std::to_string(c);
+        double frameHns = 10000000.0 / sc.fps;
+        double gopHns = frameHns * sc.gop;
+        const int64_t periods[] = {
+            (int64_t)(frameHns / 3), (int64_t)frameHns, (int64_t)(frameHns * 2.5), (int64_t)(gopHns / 2),
+            (int64_t)gopHns, (int64_t)(gopHns * 1.7 + frameHns * 5), 10000000, 25000000, 33333333,
+        };
+        for (size_t i = 0; i < sizeof(periods) / sizeof(periods[0]); ++i) {
+            int64_t period = periods[i];
+            bool saved = CheckSameAsLinear(backend, name, sc.frames, [period] { return TimeIntervalSelector(period); });
+            if (period > (gopHns + frameHns * kSeekOverheadFrames) * 2 && period < frameHns * sc.frames / 2) CHECK(saved);
+        }
+    }
+}
+
+// 可变帧率的时间戳：约 30 帧每秒加抖动，夹杂突发（1ms 内多帧）、间隙（几个周期没有帧）与重复的时间戳
+static std::vector<int64_t> MakeVfrTimestamps(int count, int64_t start, unsigned seed) {
+    srand(seed);
+    std::vector<int64_t> timestamps;
+    int64_t t = start;
+    while ((int)timestamps.size() < count) {
+        int kind = rand() % 100;
+        if (kind < 3) {
+            for (int i = 0; i < 2 + rand() % 6 && (int)timestamps.size() < count; i++) {
+                timestamps.push_back(t);
+                t += 1 + rand() % 10000;
+            }
+        } else if (kind < 5) {
+            t += 10000000 + rand() % 40000000;
+            timestamps.push_back(t);
+        } else if (kind < 8) {
+            timestamps.push_back(t);
+            timestamps.push_back(t);
+        } else {
+            timestamps.push_back(t);
+        }
+        t += 250000 + rand() % 166667;
+    }
+    timestamps.resize(count);
+    return timestamps;
+}
+
+// 参照：保存每个周期 [k * period, (k + 1) * period) 内的第一帧（时间从第一帧起算），返回帧序号
+static std::vector<int> ExpectedVfrFrames(const std::vector<int64_t>& timestamps, int64_t period) {
+    std::vector<int> frames;
+    int64_t lastPeriod = -1;
+    for (size_t i = 0; i < timestamps.size(); ++i) {
+        int64_t k = (timestamps[i] - timestamps[0]) / period;
+        if (k > lastPeriod) {
+            frames.push_back((int)i + 1);
+            lastPeriod = k;
+        }
+    }
+    return frames;
+}
+
+// 可变帧率：直接调用选帧器与经 RunAdaptiveSampling（时间戳对不上帧计数，应退回顺序解码）都与参照相同；
+// 保存的帧各在不同的周期里，且不早于周期的起点，长时间运行不累积误差
+static void TestVariableFrameRate() {
+    const int64_t periods[] = { 1, 333667, 1000000, 10000000, 30000000 };
+    for (unsigned seed = 1; seed <= 4; ++seed) {
+        int count = seed == 4 ? 200000 : 3000;
+        std::vector<int64_t> timestamps = MakeVfrTimestamps(count, seed == 2 ? 0 : 123456789 * (int64_t)seed, seed);
+        for (size_t p = 0; p < sizeof(periods) / sizeof(periods[0]); ++p) {
+            int64_t period = periods[p];
+            std::vector<int> expected = ExpectedVfrFrames(timestamps, period);
+
+            TimeIntervalSelector selector(period);
+            std::vector<int> kept;
+            for (size_t i = 0; i < timestamps.size(); ++i) {
+                if (selector.Keep((int)i + 1, timestamps[i] - timestamps[0])) kept.push_back((int)i + 1);
+            }
+            CHECK(kept == expected);
+            bool ordered = true;
+            for (size_t i = 0; i < kept.size(); ++i) {
+                int64_t elapsed = timestamps[kept[i] - 1] - timestamps[0];
+                int64_t k = elapsed / period;
+                // 周期 k 内的第一帧：前一帧在更早的周期（重复时间戳的第二帧不会再保存）
+                if (kept[i] > 1 && (timestamps[kept[i] - 2] - timestamps[0]) / period >= k) ordered = false;
+                if (i > 0 && (timestamps[kept[i - 1] - 1] - timestamps[0]) / period >= k) ordered = false;
+            }
+            CHECK(ordered);
+
+            TimestampListSource source(timestamps, 30);
+            TimeIntervalSelector adaptiveSelector(period);
+            std::atomic<bool> stop(false);
+            SamplingStats stats;
+            std::vector<int> adaptive;
+            bool framesMatch = true;
+            int last = RunAdaptiveSampling(source, adaptiveSelector, 0.0, stop, [&](int frameIndex, int64_t timestamp, const FrameView& view) {
+                adaptive.push_back(frameIndex);
+                if (source.FrameOf(view.data) != frameIndex || timestamps[frameIndex - 1] != timestamp) framesMatch = false;
+            }, &stats);
+            CHECK(last == count);
+            CHECK(adaptive == expected);
+            CHECK(framesMatch);
+            CHECK(!stats.sparse);
+            CHECK(stats.decodedFrames == count);
+        }
+    }
+}
+
+// 分段解码：PlanSegments 切出的各段分别用新的解码器与选帧器解码（与引擎中各解码线程相同），
+// 按段的顺序拼起来与顺序解码逐帧相同；每段只输出自己时间范围内的帧。返回实际的段数
+template <class MakeSelector>
+static size_t CheckSegmentsSameAsLinear(SyntheticDecoderBackend& backend, const std::string& name, int count, MakeSelector makeSelector) {
+    SamplingStats linearStats;
+    int linearLast = 0;
+    std::vector<KeptFrame> linear = Sample(backend, name, false, true, makeSelector, &linearStats, &linearLast);
+
+    std::unique_ptr<IVideoDecoder> planner = backend.CreateDecoder();
+    VideoProbeInfo info;
+    if (!planner->Open(name) || !planner->GetInfo(&info)) {
+        CHECK(false);
+        return 0;
+    }
+    double frameDuration = 10000000.0 / info.fps;
+    int64_t firstTimestamp = 0;
+    std::vector<int64_t> bounds;
+    if (!PlanSegments(*planner, frameDuration, info.durationHns, count, &firstTimestamp, &bounds)) {
+        // 只剩一段（只有一个关键帧）时不分段
+        CHECK(bounds.size() <= 1);
+        return bounds.size();
+    }
+
+    std::vector<KeptFrame> segmented;
+    bool inRange = true;
+    for (size_t k = 0; k < bounds.size(); ++k) {
+        int64_t begin = bounds[k];
+        int64_t end = k + 1 < bounds.size() ? bounds[k + 1] : INT64_MAX;
+        std::unique_ptr<IVideoDecoder> decoder = backend.CreateDecoder();
+        CHECK(decoder->Open(name));
+        auto selector = makeSelector();
+        std::atomic<bool> stop(false);
+        RunSegmentSampling(*decoder, selector, firstTimestamp, frameDuration, begin, end, stop,
+            [&](int frameIndex, int64_t timestamp, const FrameView& view) {
+                if (timestamp < begin || timestamp >= end) inRange = false;
+                KeptFrame kept = { frameIndex, timestamp, view.data };
+                segmented.push_back(kept);
+            });
+    }
+    CHECK(inRange);
+    CHECK(segmented == linear);
+    if (segmented != linear) {
+        fprintf(stderr, "  %s 分 %zu 段：顺序解码保存 %zu 帧，分段解码保存 %zu 帧\n", name.c_str(), bounds.size(),
+            linear.size(), segmented.size());
+    }
+    return bounds.size();
+}
+
+// 分段解码与顺序解码相同：段数从 2 到远多于关键帧数（分界落到同一个关键帧，段数随之减少）
+static void TestSegments(SyntheticDecoderBackend& backend) {
+    for (size_t c = 0; c < sizeof(kCases) / sizeof(kCases[0]); ++c) {
+        const SamplingCase& sc = kCases[c];
+        std::string name = "frames_" + std::to_string(c);
+        int keyFrames = (sc.frames + sc.gop - 1) / sc.gop;
+        double frameHns = 10000000.0 / sc.fps;
+
+        FrameList list;
+        const int listFrames[] = { 1, 2, sc.gop, sc.gop + 1, sc.frames / 2, sc.frames - 1, sc.frames, sc.frames + 5 };
+        list.frames.assign(listFrames, listFrames + sizeof(listFrames) / sizeof(listFrames[0]));
+        const int64_t listTimes[] = { 0, (int64_t)(frameHns * 3.4), (int64_t)(frameHns * (sc.frames * 2 / 3)), (int64_t)(frameHns * sc.frames * 2) };
+        list.times.assign(listTimes, listTimes + sizeof(listTimes) / sizeof(listTimes[0]));
+        list.Normalize();
+
+        const int counts[] = { 2, 3, 7, keyFrames, keyFrames + 1, 4 * keyFrames + 3, sc.frames + 10 };
+        for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i) {
+            int count = counts[i];
+            const int intervals[] = { 0, 2, sc.gop + 1 };
+            for (size_t n = 0; n < sizeof(intervals) / sizeof(intervals[0]); ++n) {
+                int interval = intervals[n];
+                size_t segments = CheckSegmentsSameAsLinear(backend, name, count, [interval] { return FrameIntervalSelector(interval); });
+                CHECK(segments <= (size_t)keyFrames);
+                // 等分点比 GOP 密得多时每个关键帧都是一段的起点
+                if (count > 3 * keyFrames) CHECK(segments == (size_t)keyFrames);
+            }
+            // 按秒数与按帧率：都是按时间间隔选帧，周期分别为帧时长的非整数倍与短于一帧
+            SamplingOptions seconds;
+            seconds.mode = SAMPLE_SECONDS;
+            seconds.value = 0.37;
+            SamplingOptions fps;
+            fps.mode = SAMPLE_FPS;
+            fps.value = sc.fps * 1.5;
+            const SamplingOptions* options[] = { &seconds, &fps };
+            for (size_t o = 0; o < 2; ++o) {
+                int64_t period = options[o]->PeriodHns();
+                CheckSegmentsSameAsLinear(backend, name, count, [period] { return TimeIntervalSelector(period); });
+            }
+            CheckSegmentsSameAsLinear(backend, name, count, [&list] { return FrameListSelector(list); });
+        }
+    }
+}
+
+int main() {
+    SyntheticDecoderBackend backend;
+    for (size_t c = 0; c < sizeof(kCases) / sizeof(kCases[0]); ++c) {
+        SyntheticClip clip;
+        clip.name = "frames_" + std::to_string(c);
+        clip.width = 32;
+        clip.height = 18;
+        clip.frames = kCases[c].frames;
+        clip.fps = kCases[c].fps;
+        clip.gop = kCases[c].gop;
+        backend.AddClip(clip);
+    }
+    TestFrameInterval(backend);
+    TestTimeInterval(backend);
+    TestVariableFrameRate();
+    TestSegments(backend);
+    return TestSummary("seek_sampling_test");
+}
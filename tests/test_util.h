@@ -0,0 +1,29 @@
+/*
+    测试程序共用的检查宏：每个测试是独立的程序，检查失败时打印位置并继续，结束时按失败数返回。
+    在仓库根目录构建与运行，例如：
+        g++ -std=c++14 -O2 -I. tests/frame_source_test.cpp -o frame_source_test -pthread && ./frame_source_test
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <atomic>
+#include <cstdio>
+
+// 工作线程中也可以使用 CHECK
+static std::atomic<int> g_testChecks(0);
+static std::atomic<int> g_testFailures(0);
+
+#define CHECK(cond) \
+    do { \
+        g_testChecks++; \
+        if (!(cond)) { \
+            g_testFailures++; \
+            fprintf(stderr, "%s:%d: 检查失败: %s\n", __FILE__, __LINE__, #cond); \
+        } \
+    } while (0)
+
+// 打印检查次数与失败数，返回 main 的退出码
+inline int TestSummary(const char* name) {
+    printf("%s: %d 项检查，%d 项失败\n", name, g_testChecks.load(), g_testFailures.load());
+    return g_testFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,215 @@
+/*
+    有界队列与工作线程池的压力测试：多生产者多消费者下每一项恰好送达一次、队列满时生产者等待（背压），
+    以及在生产者或消费者阻塞时 Close()：不死锁，Push 成功的项都能被取出。
+    超过 kWatchdogSeconds 秒没有完成视为死锁，直接以失败退出。
+        g++ -std=c++14 -O2 -I. tests/work_queue_test.cpp -o work_queue_test -pthread
+*/
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "work_queue.h"
+#include "test_util.h"
+
+static const int kWatchdogSeconds = 60;
+
+// 整个测试的超时：main 结束前没有 Cancel() 时打印并退出
+class Watchdog {
+public:
+    explicit Watchdog(int seconds) : m_done(false) {
+        m_thread = std::thread([this, seconds] {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!m_cond.wait_for(lock, std::chrono::seconds(seconds), [this] { return m_done; })) {
+                fprintf(stderr, "超过 %d 秒没有完成，可能死锁\n", seconds);
+                std::_Exit(2);
+            }
+        });
+    }
+
+    void Cancel() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done = true;
+        }
+        m_cond.notify_all();
+        m_thread.join();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_done;
+    std::thread m_thread;
+};
+
+// 每个生产者放入 [p * count, (p + 1) * count) 的编号；delivered 统计每个编号被取出的次数
+static void RunProducersConsumers(BoundedQueue<int>& queue, int producers, int consumers, int count,
+                                  std::vector<int>* delivered, std::vector<char>* accepted, int closeAfter) {
+    delivered->assign((size_t)producers * count, 0);
+    accepted->assign((size_t)producers * count, 0);
+    std::vector<std::vector<int>> received(consumers);
+    std::atomic<int> pushed(0);
+    std::atomic<bool> overCapacity(false);
+
+    WorkerPool consumerPool;
+    consumerPool.Start(consumers, [&](size_t worker) {
+        int item;
+        while (queue.Pop(item)) {
+            if (queue.Size() > queue.Capacity()) overCapacity = true;
+            received[worker].push_back(item);
+        }
+    });
+    WorkerPool producerPool;
+    producerPool.Start(producers, [&](size_t worker) {
+        for (int i = 0; i < count; i++) {
+            int item = (int)worker * count + i;
+            if (!queue.Push(item)) break;
+            (*accepted)[item] = 1;
+            if (++pushed == closeAfter) queue.Close();
+        }
+    });
+    producerPool.Join();
+    queue.Close();
+    consumerPool.Join();
+
+    CHECK(!overCapacity);
+    for (int c = 0; c < consumers; c++) {
+        for (size_t i = 0; i < received[c].size(); ++i) (*delivered)[received[c][i]]++;
+    }
+}
+
+static void TestExactlyOnce() {
+    const int producers = 4, consumers = 4, count = 20000;
+    BoundedQueue<int> queue(8);
+    std::vector<int> delivered;
+    std::vector<char> accepted;
+    RunProducersConsumers(queue, producers, consumers, count, &delivered, &accepted, -1);
+    bool once = true;
+    for (size_t i = 0; i < delivered.size(); ++i) {
+        if (delivered[i] != 1 || !accepted[i]) once = false;
+    }
+    CHECK(once);
+    CHECK(queue.Size() == 0);
+}
+
+// 生产与消费进行中关闭：关闭之后 Push 返回 false，关闭之前接受的项都恰好送达一次
+static void TestCloseDuringFlow() {
+    for (int round = 0; round < 20; round++) {
+        BoundedQueue<int> queue(1 + round % 5);
+        std::vector<int> delivered;
+        std::vector<char> accepted;
+        RunProducersConsumers(queue, 3, 2, 5000, &delivered, &accepted, 1000 + round * 300);
+        bool consistent = true;
+        int acceptedCount = 0;
+        for (size_t i = 0; i < delivered.size(); ++i) {
+            if (delivered[i] != (accepted[i] ? 1 : 0)) consistent = false;
+            if (accepted[i]) acceptedCount++;
+        }
+        CHECK(consistent);
+        CHECK(acceptedCount >= 1000 + round * 300);
+        CHECK(acceptedCount < 15000);
+    }
+}
+
+// 队列满时 Push 等待，取走一项后才返回
+static void TestBackpressure() {
+    BoundedQueue<int> queue(4);
+    for (int i = 0; i < 4; i++) CHECK(queue.Push(i));
+    std::atomic<bool> done(false);
+    std::thread producer([&] {
+        CHECK(queue.Push(4));
+        done = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK(!done);
+    CHECK(queue.Size() == 4);
+    int item = -1;
+    CHECK(queue.Pop(item) && item == 0);
+    producer.join();
+    CHECK(done);
+    CHECK(queue.Size() == 4);
+    for (int i = 1; i <= 4; i++) CHECK(queue.Pop(item) && item == i);
+}
+
+// 没有消费者、生产者都阻塞在满队列上时关闭：生产者全部返回，关闭前接受的项仍可取出，取完后 Pop 返回 false
+static void TestCloseWithBlockedProducers() {
+    BoundedQueue<int> queue(2);
+    std::atomic<int> accepted(0), rejected(0);
+    WorkerPool producers;
+    producers.Start(4, [&](size_t worker) {
+        for (int i = 0; i < 100; i++) {
+            if (queue.Push((int)worker * 100 + i)) accepted++;
+            else rejected++;
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK(accepted == 2);
+    queue.Close();
+    producers.Join();
+    CHECK(accepted == 2);
+    CHECK(rejected == 398);
+    CHECK(!queue.Push(-1));
+    std::vector<bool> seen(400, false);
+    int item, drained = 0;
+    while (queue.Pop(item)) {
+        CHECK(item >= 0 && item < 400 && !seen[item]);
+        seen[item] = true;
+        drained++;
+    }
+    CHECK(drained == 2);
+    CHECK(!queue.Pop(item));
+}
+
+// 消费者都阻塞在空队列上时关闭：全部返回 false
+static void TestCloseWithBlockedConsumers() {
+    BoundedQueue<int> queue(4);
+    std::atomic<int> popped(0), finished(0);
+    WorkerPool consumers;
+    consumers.Start(4, [&](size_t) {
+        int item;
+        while (queue.Pop(item)) popped++;
+        finished++;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(finished == 0);
+    queue.Close();
+    consumers.Join();
+    CHECK(finished == 4);
+    CHECK(popped == 0);
+}
+
+static void TestWorkerPool() {
+    WorkerPool pool;
+    std::vector<std::atomic<int>> calls(6);
+    for (size_t i = 0; i < calls.size(); ++i) calls[i] = 0;
+    pool.Start(6, [&](size_t worker) { calls[worker]++; });
+    CHECK(pool.Size() == 6);
+    pool.Join();
+    CHECK(pool.Size() == 0);
+    for (size_t i = 0; i < calls.size(); ++i) CHECK(calls[i] == 1);
+    pool.Join();
+
+    // 线程数为 0 时至少启动一个
+    std::atomic<int> count(0);
+    pool.Start(0, [&](size_t worker) { count += (int)worker + 1; });
+    CHECK(pool.Size() == 1);
+    pool.Join();
+    CHECK(count == 1);
+    CHECK(WorkerPool::DefaultThreadCount() >= 1);
+}
+
+int main() {
+    Watchdog watchdog(kWatchdogSeconds);
+    TestExactlyOnce();
+    TestCloseDuringFlow();
+    TestBackpressure();
+    TestCloseWithBlockedProducers();
+    TestCloseWithBlockedConsumers();
+    TestWorkerPool();
+    watchdog.Cancel();
+    return TestSummary("work_queue_test");
+}
@@ -0,0 +1,160 @@
+/*
+    Y4M 解码后端的测试：8 位 4:2:0（各种色度位置）与灰度可以打开，帧数、尺寸与像素和写入的一致；
+    高位深与其他色度采样、缺少帧率的头部打开失败并给出原因，提取引擎通过 OnFileError 报告该原因。
+    临时文件写在当前目录的 y4m_decoder_test.tmp 下。
+        g++ -std=c++14 -O2 -I. tests/y4m_decoder_test.cpp -o y4m_decoder_test -pthread
+*/
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "extract_engine.h"
+#include "y4m_decoder.h"
+#include "test_util.h"
+
+static const int kWidth = 7;
+static const int kHeight = 5;
+static const int kFrames = 3;
+
+// 写一个 Y4M 文件：header 为 "YUV4MPEG2" 之后的参数，每帧 frameBytes 字节，第 n 帧的样本为 n * 40 + 偏移
+static std::string WriteY4m(const std::string& work, const std::string& name, const std::string& header, size_t frameBytes) {
+    std::string data = "YUV4MPEG2 " + header + "\n";
+    for (int n = 0; n < kFrames; n++) {
+        data += "FRAME\n";
+        for (size_t i = 0; i < frameBytes; i++) data += (char)(uint8_t)(n * 40 + i % 7);
+    }
+    std::string path = JoinPath(work, name);
+    CHECK(WriteFileUtf8(path, data.data(), data.size()));
+    return path;
+}
+
+static size_t I420Bytes() {
+    return (size_t)kWidth * kHeight + 2 * (size_t)((kWidth + 1) / 2) * ((kHeight + 1) / 2);
+}
+
+static void TestAccepted(const std::string& work) {
+    const char* colorspaces[] = { "", " C420", " C420jpeg", " C420paldv", " C420mpeg2", " Cmono" };
+    for (size_t c = 0; c < sizeof(colorspaces) / sizeof(colorspaces[0]); c++) {
+        bool mono = std::string(colorspaces[c]) == " Cmono";
+        std::string header = "W7 H5 F30000:1001 Ip A1:1" + std::string(colorspaces[c]);
+        std::string path = WriteY4m(work, "ok" + std::to_string((int)c) + ".y4m", header, mono ? (size_t)kWidth * kHeight : I420Bytes());
+        Y4mDecoder decoder;
+        CHECK(decoder.Open(path));
+        CHECK(decoder.OpenError().empty());
+        VideoProbeInfo info;
+        CHECK(decoder.GetInfo(&info));
+        CHECK(info.width == (uint32_t)kWidth && info.height == (uint32_t)kHeight);
+        int frames = 0;
+        int64_t timestamp = 0;
+        while (decoder.Advance(&timestamp)) {
+            FrameView view = FrameView();
+            CHECK(decoder.LockFrame(&view));
+            CHECK(view.data[0] == (uint8_t)(frames * 40));
+            CHECK(view.data[kWidth] == (uint8_t)(frames * 40 + kWidth % 7));
+            if (mono) CHECK(view.plane1[0] == 128 && view.plane2[0] == 128);
+            decoder.UnlockFrame();
+            frames++;
+        }
+        CHECK(frames == kFrames);
+    }
+}
+
+struct RejectedCase {
+    const char* header;
+    size_t frameBytes;
+    const char* reason;     // 原因中应出现的文字
+};
+
+// 10 位的帧长是 8 位的两倍：按 8 位计算会把一帧错切成两帧，必须拒绝
+static const RejectedCase kRejected[] = {
+    { "W7 H5 F25:1 C420p10", 2 * 59, "C420p10" },
+    { "W7 H5 F25:1 C420p16", 2 * 59, "C420p16" },
+    { "W7 H5 F25:1 C444", 3 * 35, "C444" },
+    { "W7 H5 F25:1 C422", 35 + 2 * 4 * 5, "C422" },
+    { "W7 H5 F25:1 Cmono16", 2 * 35, "Cmono16" },
+    { "W7 H5 C420jpeg", 59, "帧率" },
+    { "W0 H5 F25:1", 59, "宽" },
+};
+
+static void TestRejected(const std::string& work) {
+    CHECK(I420Bytes() == 59);
+    for (size_t c = 0; c < sizeof(kRejected) / sizeof(kRejected[0]); c++) {
+        std::string path = WriteY4m(work, "bad" + std::to_string((int)c) + ".y4m", kRejected[c].header, kRejected[c].frameBytes);
+        Y4mDecoder decoder;
+        CHECK(!decoder.Open(path));
+        CHECK(decoder.OpenError().find(kRejected[c].reason) != std::string::npos);
+        VideoProbeInfo info;
+        CHECK(!decoder.GetInfo(&info));
+        // 之后打开正常的文件时清除原因
+        std::string good = WriteY4m(work, "good.y4m", "W7 H5 F25:1 C420", I420Bytes());
+        CHECK(decoder.Open(good));
+        CHECK(decoder.OpenError().empty());
+    }
+
+    Y4mDecoder decoder;
+    CHECK(!decoder.Open(JoinPath(work, "missing.y4m")));
+    CHECK(!decoder.OpenError().empty());
+    std::string notY4m = JoinPath(work, "not.y4m");
+    CHECK(WriteFileUtf8(notY4m, "RIFF....AVI \n", 13));
+    CHECK(!decoder.Open(notY4m));
+    CHECK(decoder.OpenError().find("YUV4MPEG2") != std::string::npos);
+    // 唯一的一帧不完整
+    std::string truncated = JoinPath(work, "short.y4m");
+    std::string data = "YUV4MPEG2 W7 H5 F25:1 C420\nFRAME\n" + std::string(I420Bytes() - 1, '\x10');
+    CHECK(WriteFileUtf8(truncated, data.data(), data.size()));
+    CHECK(!decoder.Open(truncated));
+    CHECK(decoder.OpenError().find("帧") != std::string::npos);
+}
+
+// 记录引擎报告的打开失败
+class ErrorObserver : public IExtractionObserver {
+public:
+    void OnFileError(size_t index, const std::string& message) override {
+        indices.push_back(index);
+        messages.push_back(message);
+    }
+    void OnFileFinished(size_t index, bool ok, int kept, int dropped) override {
+        (void)kept; (void)dropped;
+        if (!ok) failed.push_back(index);
+    }
+
+    std::vector<size_t> indices;
+    std::vector<std::string> messages;
+    std::vector<size_t> failed;
+};
+
+static void TestEngineReportsReason(const std::string& work) {
+    ExtractionJob job;
+    job.files.push_back(WriteY4m(work, "engine_ok.y4m", "W7 H5 F25:1 C420jpeg", I420Bytes()));
+    job.files.push_back(WriteY4m(work, "engine_p10.y4m", "W7 H5 F25:1 C420p10", 2 * I420Bytes()));
+    job.outputDir = JoinPath(work, "out");
+    job.frameIndex = FRAME_INDEX_OFF;
+    job.outputs.assign(1, OutputSpec());
+
+    Y4mDecoderBackend backend;
+    ExtractionEngine engine(backend);
+    ErrorObserver observer;
+    engine.SetObserver(&observer);
+    engine.SetThreadCounts(1, 1);
+    std::atomic<bool> stop(false);
+    ExtractionStats stats;
+    std::string error;
+    CHECK(engine.Run(job, stop, &stats, &error));
+    CHECK(stats.filesFailed == 1);
+    CHECK(observer.failed.size() == 1 && observer.failed[0] == 1);
+    CHECK(observer.indices.size() == 1 && observer.indices[0] == 1);
+    CHECK(observer.messages.size() == 1 && observer.messages[0].find("C420p10") != std::string::npos);
+}
+
+int main() {
+    std::string work = JoinPath("y4m_decoder_test.tmp",
+        std::to_string((long long)std::chrono::steady_clock::now().time_since_epoch().count()));
+    CHECK(CreateDirectoriesUtf8(work));
+    TestAccepted(work);
+    TestRejected(work);
+    TestEngineReportsReason(work);
+    return TestSummary("y4m_decoder_test");
+}
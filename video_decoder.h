@@ -0,0 +1,82 @@
+/*
+    解码后端接口
+    提取引擎只通过这里的接口打开视频、读取元数据与帧，不依赖具体的解码库：
+    Windows 上使用 Media Foundation（mf_decoder.h），其他平台可使用可移植的 Y4M 后端（y4m_decoder.h）。
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "frame_index.h"
+#include "frame_source.h"
+
+// 单个视频的探测结果
+struct VideoProbeInfo {
+    uint32_t width;
+    uint32_t height;
+    uint64_t durationHns;   // 100 纳秒
+    double fps;
+    bool ok;                // 是否成功打开并读取到视频信息
+
+    VideoProbeInfo() : width(0), height(0), durationHns(0), fps(0.0), ok(false) {}
+};
+
+// ==========================================
+// 一个打开的视频：在帧源接口之上增加打开、元数据与回到开头。
+// 每个实例只由一个线程使用。
+// ==========================================
+class IVideoDecoder : public IFrameSource {
+public:
+    // path 为 UTF-8
+    virtual bool Open(const std::string& path) = 0;
+    virtual void Close() = 0;
+
+    // 可见画面尺寸、时长与帧率；未知的项为 0
+    virtual bool GetInfo(VideoProbeInfo* info) = 0;
+
+    // 回到视频开头，之后的 Advance() 从第一帧开始
+    virtual bool Rewind() = 0;
+
+    // 上一次 Open() 失败的原因（例如不支持的像素格式），没有说明时为空
+    virtual std::string OpenError() const { return std::string(); }
+
+    // 只读取压缩数据包、不解码，得到每一帧的时间戳、关键帧标记与偏移（顺序任意），用于建立帧索引。
+    // 不影响当前的读取位置；不支持时返回 false，由调用方顺序解码建立（BuildFrameIndexByDecoding）
+    virtual bool ScanFrames(std::vector<FrameIndexEntry>* entries) { (void)entries; return false; }
+};
+
+// ==========================================
+// 解码后端：创建解码器实例，并声明能处理的文件类型。
+// 引擎在每个使用解码器或编码器的工作线程开始与结束时调用 ThreadInit / ThreadExit（例如 COM 初始化）。
+// ==========================================
+class IDecoderBackend {
+public:
+    virtual ~IDecoderBackend() {}
+
+    virtual const char* Name() const = 0;
+
+    // 按扩展名判断是否为该后端能打开的视频文件（目录扫描时使用）
+    virtual bool IsVideoFile(const std::string& path) const = 0;
+
+    virtual std::unique_ptr<IVideoDecoder> CreateDecoder() = 0;
+
+    virtual void ThreadInit() {}
+    virtual void ThreadExit() {}
+};
+
+// 打开并读取一个视频的元数据，失败时 info->ok 为 false
+inline bool ProbeVideo(IDecoderBackend& backend, const std::string& path, VideoProbeInfo* info) {
+    *info = VideoProbeInfo();
+    std::unique_ptr<IVideoDecoder> decoder = backend.CreateDecoder();
+    if (!decoder || !decoder->Open(path)) return false;
+    VideoProbeInfo probed;
+    if (decoder->GetInfo(&probed) && probed.width > 0 && probed.height > 0) {
+        *info = probed;
+        info->ok = true;
+    }
+    return info->ok;
+}
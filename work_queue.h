@@ -0,0 +1,111 @@
+/*
+    有界阻塞队列与工作线程池
+    用于在解码阶段与编码阶段之间传递帧。与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// ==========================================
+// 有界阻塞队列：队列满时 Push 阻塞（对生产者形成背压），空时 Pop 阻塞
+// ==========================================
+template <class T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity)
+        : m_capacity(capacity < 1 ? 1 : capacity), m_closed(false) {}
+
+    // 放入一项，队列已关闭时返回 false
+    bool Push(T item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [this] { return m_closed || m_items.size() < m_capacity; });
+        if (m_closed) return false;
+        m_items.push_back(std::move(item));
+        lock.unlock();
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    // 取出一项，队列已关闭且为空时返回 false
+    bool Pop(T& item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [this] { return m_closed || !m_items.empty(); });
+        if (m_items.empty()) return false;
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        lock.unlock();
+        m_notFull.notify_one();
+        return true;
+    }
+
+    // 关闭队列：不再接受新项，已有项仍可被取出
+    void Close() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_notFull.notify_all();
+        m_notEmpty.notify_all();
+    }
+
+    size_t Size() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_items.size();
+    }
+
+    size_t Capacity() const { return m_capacity; }
+
+private:
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_notFull;
+    std::condition_variable m_notEmpty;
+    std::deque<T> m_items;
+    size_t m_capacity;
+    bool m_closed;
+};
+
+// ==========================================
+// 工作线程池：启动 N 个线程执行同一个函数，fn(workerIndex)
+// ==========================================
+class WorkerPool {
+public:
+    WorkerPool() {}
+    ~WorkerPool() { Join(); }
+
+    // 默认线程数为 CPU 核心数
+    static size_t DefaultThreadCount() {
+        unsigned n = std::thread::hardware_concurrency();
+        return n > 0 ? n : 1;
+    }
+
+    void Start(size_t count, std::function<void(size_t)> fn) {
+        if (count < 1) count = 1;
+        for (size_t i = 0; i < count; ++i) {
+            m_threads.emplace_back(fn, i);
+        }
+    }
+
+    void Join() {
+        for (std::thread& t : m_threads) {
+            if (t.joinable()) t.join();
+        }
+        m_threads.clear();
+    }
+
+    size_t Size() const { return m_threads.size(); }
+
+private:
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    std::vector<std::thread> m_threads;
+};
@@ -0,0 +1,240 @@
+/*
+    异步写出阶段：编码线程把编码结果放进内存缓冲交给写出线程，自己马上继续编码下一帧，
+    网络共享或慢速磁盘上文件的创建、写入与关闭不再拖慢编码和解码。
+    写出线程每次从队列取走一批文件依次写出，写完后把缓冲连同路径字符串一起归还重用，稳定之后不再分配内存。
+    队列按字节数限额，超过时提交方等待（反压）；待写数据同时计入提取任务的内存预算（可选）。
+    文件写入经由 IFileSink，测试时可换成限速的实现。
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "extract_manifest.h"
+#include "file_util.h"
+#include "memory_budget.h"
+#include "pipeline_trace.h"
+#include "work_queue.h"
+
+// 写出的持久性
+enum WriteDurability {
+    DURABILITY_NONE = 0,    // 交给系统缓存即可
+    DURABILITY_FSYNC        // 每个文件关闭前 fsync，返回时数据已落盘
+};
+
+static const size_t kWriteBatchFiles = 16;                      // 写出线程一次最多取走的文件数
+static const size_t kDefaultWriteBufferBytes = 64 << 20;        // 队列中待写数据的默认上限
+
+// 整个文件一次写出
+class IFileSink {
+public:
+    virtual ~IFileSink() {}
+    virtual bool WriteFile(const std::string& path, const uint8_t* data, size_t size, int durability) = 0;
+};
+
+class DiskFileSink : public IFileSink {
+public:
+    bool WriteFile(const std::string& path, const uint8_t* data, size_t size, int durability) override {
+        FILE* fp = OpenFileUtf8(path, "wb");
+        if (!fp) return false;
+        bool ok = fwrite(data, 1, size, fp) == size;
+        if (ok && durability == DURABILITY_FSYNC) ok = SyncFile(fp);
+        return (fclose(fp) == 0) && ok;
+    }
+};
+
+// 模拟慢速存储：每个文件固定延迟，再按带宽折算写入时间（bytesPerSecond 为 0 表示不限带宽）
+class ThrottledFileSink : public IFileSink {
+public:
+    ThrottledFileSink(IFileSink& inner, double latencySeconds, double bytesPerSecond)
+        : m_inner(inner), m_latency(latencySeconds), m_bytesPerSecond(bytesPerSecond) {}
+
+    bool WriteFile(const std::string& path, const uint8_t* data, size_t size, int durability) override {
+        double delay = m_latency + (m_bytesPerSecond > 0.0 ? size / m_bytesPerSecond : 0.0);
+        std::this_thread::sleep_for(std::chrono::duration<double>(delay));
+        return m_inner.WriteFile(path, data, size, durability);
+    }
+
+private:
+    ThrottledFileSink(const ThrottledFileSink&) = delete;
+    ThrottledFileSink& operator=(const ThrottledFileSink&) = delete;
+
+    IFileSink& m_inner;
+    double m_latency;
+    double m_bytesPerSecond;
+};
+
+// 一个待写的文件；由 Acquire() 取得，填好后 Submit()，不用时 Recycle()
+struct WriteRequest {
+    std::string path;
+    std::vector<uint8_t> bytes;
+    std::shared_ptr<ManifestTracker> manifest;     // 写出后通知检查点，可以为空
+    int frameIndex;
+
+    WriteRequest() : frameIndex(0) {}
+};
+
+// ==========================================
+// 写出队列与写出线程
+// ==========================================
+class WriteBehindQueue {
+public:
+    // budget 非空时待写数据从提交到写完计入预算
+    WriteBehindQueue(IFileSink& sink, int durability, size_t maxQueuedBytes, MemoryBudget* budget = nullptr)
+        : m_sink(sink), m_durability(durability), m_maxQueuedBytes(maxQueuedBytes < 1 ? 1 : maxQueuedBytes), m_budget(budget),
+          m_writerCount(1), m_queuedBytes(0), m_inFlight(0), m_closed(false), m_peakDepth(0), m_filesWritten(0), m_bytesWritten(0),
+          m_failures(0), m_busyNs(0) {}
+
+    ~WriteBehindQueue() { Close(); }
+
+    // 启动 writers 个写出线程；tracer 非空时记录每个文件的写出耗时与队列深度
+    void Start(size_t writers, PipelineTracer* tracer = nullptr) {
+        m_writerCount = std::max<size_t>(1, writers);
+        m_writers.Start(writers, [this, tracer](size_t worker) {
+            WriterLoop(tracer ? tracer->RegisterThread("writer", worker) : nullptr);
+        });
+    }
+
+    // 取一个空闲的请求，缓冲与路径保留上次使用的容量
+    WriteRequest* Acquire() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_free.empty()) {
+            m_owned.push_back(std::unique_ptr<WriteRequest>(new WriteRequest()));
+            return m_owned.back().get();
+        }
+        WriteRequest* request = m_free.back();
+        m_free.pop_back();
+        return request;
+    }
+
+    void Recycle(WriteRequest* request) {
+        request->manifest.reset();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free.push_back(request);
+    }
+
+    // 交给写出线程；待写数据超过上限时等待（队列为空时总能放入，单个大文件也不会卡住）
+    void Submit(WriteRequest* request) {
+        if (m_budget) m_budget->Charge(request->bytes.size());
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_spaceCond.wait(lock, [this] { return m_queue.empty() || m_queuedBytes < m_maxQueuedBytes || m_closed; });
+        m_queue.push_back(request);
+        m_queuedBytes += request->bytes.size();
+        if (m_queue.size() > m_peakDepth) m_peakDepth = m_queue.size();
+        m_workCond.notify_one();
+    }
+
+    // 等待已提交的文件全部写完
+    void Flush() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_idleCond.wait(lock, [this] { return m_queue.empty() && m_inFlight == 0; });
+    }
+
+    // 写完剩余的文件后结束写出线程
+    void Close() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_workCond.notify_all();
+        m_spaceCond.notify_all();
+        m_writers.Join();
+    }
+
+    size_t Depth() const { std::lock_guard<std::mutex> lock(m_mutex); return m_queue.size(); }
+    size_t PeakDepth() const { std::lock_guard<std::mutex> lock(m_mutex); return m_peakDepth; }
+    uint64_t FilesWritten() const { std::lock_guard<std::mutex> lock(m_mutex); return m_filesWritten; }
+    uint64_t BytesWritten() const { std::lock_guard<std::mutex> lock(m_mutex); return m_bytesWritten; }
+    uint64_t Failures() const { std::lock_guard<std::mutex> lock(m_mutex); return m_failures; }
+
+    // 写出线程实际写文件的时间之和（秒），BytesWritten() / BusySeconds() 为单个写出线程的平均写入速度
+    double BusySeconds() const { std::lock_guard<std::mutex> lock(m_mutex); return m_busyNs / 1e9; }
+
+private:
+    WriteBehindQueue(const WriteBehindQueue&) = delete;
+    WriteBehindQueue& operator=(const WriteBehindQueue&) = delete;
+
+    void WriterLoop(TraceBuffer* trace) {
+        std::vector<WriteRequest*> batch;
+        std::vector<bool> results;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_workCond.wait(lock, [this] { return !m_queue.empty() || m_closed; });
+                if (m_queue.empty()) return;
+                // 多个写出线程时按线程数分摊，避免一个线程取走全部
+                size_t take = std::min(kWriteBatchFiles, (m_queue.size() + m_writerCount - 1) / m_writerCount);
+                for (size_t i = 0; i < take; ++i) {
+                    batch.push_back(m_queue.front());
+                    m_queuedBytes -= m_queue.front()->bytes.size();
+                    m_queue.pop_front();
+                }
+                m_inFlight += batch.size();
+                if (trace) trace->Counter(TRACE_COUNTER_WRITE_QUEUE, (int64_t)m_queue.size());
+            }
+            m_spaceCond.notify_all();
+
+            uint64_t start = TraceNow();
+            results.assign(batch.size(), false);
+            for (size_t i = 0; i < batch.size(); ++i) {
+                WriteRequest* request = batch[i];
+                TraceScope scope(trace, TRACE_WRITE);
+                results[i] = m_sink.WriteFile(request->path, request->bytes.data(), request->bytes.size(), m_durability);
+                if (request->manifest) request->manifest->Done(request->frameIndex, results[i]);
+                request->manifest.reset();
+                if (m_budget) m_budget->Release(request->bytes.size());
+            }
+            uint64_t busy = TraceNow() - start;
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (size_t i = 0; i < batch.size(); ++i) {
+                if (results[i]) {
+                    m_filesWritten++;
+                    m_bytesWritten += batch[i]->bytes.size();
+                } else {
+                    m_failures++;
+                }
+                m_free.push_back(batch[i]);
+            }
+            m_busyNs += busy;
+            m_inFlight -= batch.size();
+            batch.clear();
+            if (m_queue.empty() && m_inFlight == 0) m_idleCond.notify_all();
+        }
+    }
+
+    IFileSink& m_sink;
+    int m_durability;
+    size_t m_maxQueuedBytes;
+    MemoryBudget* m_budget;
+    size_t m_writerCount;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_workCond;     // 有文件待写或已关闭
+    std::condition_variable m_spaceCond;    // 队列有空间
+    std::condition_variable m_idleCond;     // 全部写完
+    std::deque<WriteRequest*> m_queue;
+    std::vector<WriteRequest*> m_free;
+    std::vector<std::unique_ptr<WriteRequest>> m_owned;
+    size_t m_queuedBytes;
+    size_t m_inFlight;
+    bool m_closed;
+
+    size_t m_peakDepth;
+    uint64_t m_filesWritten;
+    uint64_t m_bytesWritten;
+    uint64_t m_failures;
+    uint64_t m_busyNs;
+
+    WorkerPool m_writers;
+};
@@ -0,0 +1,221 @@
+/*
+    可移植的解码后端：YUV4MPEG2（.y4m）
+    未压缩的 8 位 4:2:0 或灰度视频，ffmpeg 可以直接输出（ffmpeg -i in.mp4 -pix_fmt yuv420p out.y4m）；
+    高位深（C420p10 等）与其他色度采样（C422、C444）打开失败，OpenError() 给出原因。
+    用于在没有 Media Foundation 的平台上运行提取引擎。
+    整个文件内存映射，打开时建立帧偏移索引；LockFrame() 直接返回映射内的 I420 视图，不拷贝。
+    每一帧都是关键帧，可以直接跳转到任意帧。
+    与平台无关，可在 Linux 上编译运行。
+*/
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "file_util.h"
+#include "video_decoder.h"
+
+class Y4mDecoder : public IVideoDecoder {
+public:
+    Y4mDecoder() : m_width(0), m_height(0), m_rateNum(0), m_rateDen(1), m_mono(false), m_next(0), m_current(-1) {}
+
+    bool Open(const std::string& path) override {
+        Close();
+        if (!m_file.Open(path)) return Fail("无法读取文件");
+        const uint8_t* base = m_file.Data();
+        size_t size = m_file.Size();
+        const size_t kMaxHeader = 1024;
+        size_t headerEnd = 0;
+        while (headerEnd < size && headerEnd < kMaxHeader && base[headerEnd] != '\n') headerEnd++;
+        if (headerEnd >= size || headerEnd < 9 || memcmp(base, "YUV4MPEG2", 9) != 0) return Fail("不是 YUV4MPEG2 文件");
+        std::string error;
+        if (!ParseHeader(std::string((const char*)base + 9, headerEnd - 9), &error)) return Fail(error);
+
+        // 帧偏移索引：每帧以 "FRAME" 开头，参数之后换行，然后是固定长度的像素数据；不完整的最后一帧忽略
+        size_t frameBytes = FrameBytes();
+        size_t pos = headerEnd + 1;
+        while (pos + 5 <= size && memcmp(base + pos, "FRAME", 5) == 0) {
+            size_t lineEnd = pos + 5;
+            while (lineEnd < size && lineEnd - pos < kMaxHeader && base[lineEnd] != '\n') lineEnd++;
+            if (lineEnd >= size || base[lineEnd] != '\n' || size - (lineEnd + 1) < frameBytes) break;
+            m_frames.push_back(lineEnd + 1);
+            pos = lineEnd + 1 + frameBytes;
+        }
+        if (m_frames.empty()) return Fail("没有完整的帧");
+        if (m_mono) m_neutralChroma.assign((size_t)(m_width + 1) / 2, 128);
+        return true;
+    }
+
+    void Close() override {
+        m_error.clear();
+        m_file.Close();
+        m_frames.clear();
+        m_width = m_height = 0;
+        m_next = 0;
+        m_current = -1;
+    }
+
+    std::string OpenError() const override { return m_error; }
+
+    bool GetInfo(VideoProbeInfo* info) override {
+        if (m_frames.empty()) return false;
+        *info = VideoProbeInfo();
+        info->width = (uint32_t)m_width;
+        info->height = (uint32_t)m_height;
+        info->fps = (double)m_rateNum / m_rateDen;
+        info->durationHns = (uint64_t)FrameTimestamp((int64_t)m_frames.size());
+        info->ok = true;
+        return true;
+    }
+
+    bool Rewind() override {
+        m_next = 0;
+        m_current = -1;
+        return !m_frames.empty();
+    }
+
+    bool Advance(int64_t* timestamp) override {
+        if (m_next >= (int64_t)m_frames.size()) return false;
+        m_current = m_next++;
+        if (timestamp) *timestamp = FrameTimestamp(m_current);
+        return true;
+    }
+
+    bool LockFrame(FrameView* view) override {
+        if (m_current < 0) return false;
+        const uint8_t* y = m_file.Data() + m_frames[(size_t)m_current];
+        *view = FrameView();
+        view->data = y;
+        view->width = m_width;
+        view->height = m_height;
+        view->stride = m_width;
+        view->format = FRAME_I420;
+        if (m_mono) {
+            // 灰度视频：色度平面指向一行中性值，行跨度为 0
+            view->plane1 = view->plane2 = m_neutralChroma.data();
+            view->stride1 = view->stride2 = 0;
+        }
+        else {
+            int chromaWidth = (m_width + 1) / 2, chromaHeight = (m_height + 1) / 2;
+            view->plane1 = y + (size_t)m_width * m_height;
+            view->stride1 = chromaWidth;
+            view->plane2 = view->plane1 + (size_t)chromaWidth * chromaHeight;
+            view->stride2 = chromaWidth;
+        }
+        return true;
+    }
+
+    void UnlockFrame() override {}
+
+    bool IsKeyFrame() const override { return true; }
+    bool CanSeek() const override { return true; }
+
+    // 打开时已经建立了帧偏移，直接转换（偏移为帧头 "FRAME" 之后的像素数据）
+    bool ScanFrames(std::vector<FrameIndexEntry>* entries) override {
+        if (m_frames.empty()) return false;
+        entries->resize(m_frames.size());
+        for (size_t i = 0; i < m_frames.size(); ++i) {
+            (*entries)[i].timestamp = FrameTimestamp((int64_t)i);
+            (*entries)[i].offset = m_frames[i];
+            (*entries)[i].key = true;
+        }
+        return true;
+    }
+
+    // 每帧都是关键帧：落在时间戳不晚于 timestamp 的最后一帧
+    bool SeekTo(int64_t timestamp) override {
+        if (m_frames.empty()) return false;
+        int64_t frame = timestamp <= 0 ? 0 : (int64_t)((double)timestamp * m_rateNum / (10000000.0 * m_rateDen));
+        while (frame > 0 && FrameTimestamp(frame) > timestamp) frame--;
+        while (frame + 1 < (int64_t)m_frames.size() && FrameTimestamp(frame + 1) <= timestamp) frame++;
+        m_next = std::min<int64_t>(frame, (int64_t)m_frames.size());
+        m_current = -1;
+        return true;
+    }
+
+private:
+    Y4mDecoder(const Y4mDecoder&) = delete;
+    Y4mDecoder& operator=(const Y4mDecoder&) = delete;
+
+    bool Fail(const std::string& message) {
+        Close();
+        m_error = message;
+        return false;
+    }
+
+    // 头部参数：W 宽、H 高、F 帧率 num:den、C 色彩空间；其他参数忽略。
+    // 只接受 8 位的 4:2:0（C420 与各种色度位置 C420jpeg / C420paldv / C420mpeg2）与灰度 Cmono：
+    // 帧长按每个样本 1 字节计算，高位深的帧会被错切成几帧
+    bool ParseHeader(const std::string& header, std::string* error) {
+        std::string colorspace = "420jpeg";
+        size_t pos = 0;
+        while (pos < header.size()) {
+            while (pos < header.size() && header[pos] == ' ') pos++;
+            size_t end = header.find(' ', pos);
+            if (end == std::string::npos) end = header.size();
+            if (end > pos) {
+                std::string token = header.substr(pos, end - pos);
+                const char* value = token.c_str() + 1;
+                switch (token[0]) {
+                case 'W': m_width = atoi(value); break;
+                case 'H': m_height = atoi(value); break;
+                case 'F': if (sscanf(value, "%d:%d", &m_rateNum, &m_rateDen) != 2) m_rateNum = 0; break;
+                case 'C': colorspace = value; break;
+                default: break;
+                }
+            }
+            pos = end;
+        }
+        m_mono = colorspace == "mono";
+        bool is420 = colorspace == "420" || colorspace == "420jpeg" || colorspace == "420paldv" || colorspace == "420mpeg2";
+        if (!is420 && !m_mono) {
+            *error = "不支持的色彩空间 C" + colorspace + "，只支持 8 位的 4:2:0 与灰度（ffmpeg -pix_fmt yuv420p 或 gray）";
+            return false;
+        }
+        if (m_width <= 0 || m_height <= 0 || m_rateNum <= 0 || m_rateDen <= 0) {
+            *error = "头部缺少有效的宽、高或帧率";
+            return false;
+        }
+        return true;
+    }
+
+    size_t FrameBytes() const {
+        size_t luma = (size_t)m_width * m_height;
+        if (m_mono) return luma;
+        return luma + 2 * (size_t)((m_width + 1) / 2) * ((m_height + 1) / 2);
+    }
+
+    int64_t FrameTimestamp(int64_t frame) const {
+        return (int64_t)(frame * 10000000.0 * m_rateDen / m_rateNum + 0.5);
+    }
+
+    MappedFile m_file;
+    std::string m_error;                // 上一次 Open() 失败的原因
+    std::vector<size_t> m_frames;       // 每帧像素数据在文件中的偏移
+    std::vector<uint8_t> m_neutralChroma;
+    int m_width;
+    int m_height;
+    int m_rateNum;
+    int m_rateDen;
+    bool m_mono;
+    int64_t m_next;                     // 下一次 Advance() 输出的帧
+    int64_t m_current;                  // 当前帧，-1 表示尚未读取
+};
+
+class Y4mDecoderBackend : public IDecoderBackend {
+public:
+    const char* Name() const override { return "y4m"; }
+
+    bool IsVideoFile(const std::string& path) const override {
+        return FileExtension(path) == ".y4m";
+    }
+
+    std::unique_ptr<IVideoDecoder> CreateDecoder() override {
+        return std::unique_ptr<IVideoDecoder>(new Y4mDecoder());
+    }
+};